@@ -0,0 +1,251 @@
+#include <assets/KGEModelImporter.h>
+#include <assets/KGEPackage.h>
+#include <graphic/KGEVulkan.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+* Сборщик пакетов ресурсов (.kgepak)
+* Импортирует модели (с оптимизацией и уровнями детализации), упаковывает геометрию в формат буферов устройства,
+* строит мип-уровни текстур и записывает все в один пакет, который рендерер загружает без разбора (см. KGEVulkanCore::LoadPackagedModel)
+*
+* Использование: kgecook <пакет.kgepak> [--full] <модель> [<модель> ...]
+* --full - формат вершин VertexLayoutFull (по умолчанию VertexLayoutCompact, как у рендерера)
+*/
+
+/**
+* Добавить данные в конец блока с выравниванием начала
+* @return uint64_t - смещение данных от начала блока
+*/
+static uint64_t AppendAligned(std::vector<unsigned char> &blob, const void* data, std::size_t size)
+{
+    uint64_t offset = kge::pak::Align(blob.size());
+    blob.resize(static_cast<std::size_t>(offset) + size);
+    if (size > 0) {
+        memcpy(blob.data() + offset, data, size);
+    }
+    return offset;
+}
+
+/**
+* Блок геометрии одного уровня детализации
+*/
+static std::vector<unsigned char> CookMesh(const kge::assets::MeshLevelData &level, VERTEX_LAYOUT layout)
+{
+    if (level.vertices.empty()) {
+        throw std::runtime_error("Cooker: Empty mesh level");
+    }
+
+    kge::pak::MeshBlob header;
+
+    // Границы по исходным (не упакованным) позициям - как при регистрации в реестре геометрии
+    glm::vec3 boundsMin = level.vertices[0].position;
+    glm::vec3 boundsMax = level.vertices[0].position;
+    for (const kge::vkstructs::Vertex &vertex : level.vertices) {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+
+    glm::vec3 boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    for (const kge::vkstructs::Vertex &vertex : level.vertices) {
+        header.boundingRadius = glm::max(header.boundingRadius, glm::length(vertex.position - boundsCenter));
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        header.boundsMin[axis] = boundsMin[axis];
+        header.boundsMax[axis] = boundsMax[axis];
+    }
+
+    // Позиции упаковываются относительно границ - рендерер восстановит ту же распаковку по границам из заголовка
+    std::vector<unsigned char> vertexBytes;
+    std::vector<unsigned char> indexBytes;
+    kge::vkutility::EncodeVertices(level.vertices, layout, kge::vkutility::PositionDequantization(boundsMin, boundsMax, layout), vertexBytes);
+    VkIndexType indexType = kge::vkutility::EncodeIndices(level.indices, static_cast<uint32_t>(level.vertices.size()), indexBytes);
+
+    header.vertexCount = static_cast<uint32_t>(level.vertices.size());
+    header.indexCount = static_cast<uint32_t>(level.indices.size());
+    header.vertexLayout = static_cast<uint32_t>(layout);
+    header.indexSize = indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+    header.vertexBytes = vertexBytes.size();
+    header.indexBytes = indexBytes.size();
+    header.geometricError = level.geometricError;
+
+    std::vector<unsigned char> blob(sizeof(header));
+    header.vertexOffset = AppendAligned(blob, vertexBytes.data(), vertexBytes.size());
+    header.indexOffset = AppendAligned(blob, indexBytes.data(), indexBytes.size());
+    memcpy(blob.data(), &header, sizeof(header));
+
+    return blob;
+}
+
+/**
+* Блок текстуры с цепочкой мип-уровней (фильтр 2x2, у нечетных размеров последний столбец/строка повторяется)
+*/
+static std::vector<unsigned char> CookTexture(const kge::assets::TextureData &texture)
+{
+    kge::pak::TextureBlob header;
+    header.width = texture.width;
+    header.height = texture.height;
+
+    std::vector<unsigned char> blob(sizeof(header));
+
+    std::vector<unsigned char> level = texture.pixels;
+    uint32_t width = texture.width;
+    uint32_t height = texture.height;
+
+    while (header.mipLevels < KGE_PACKAGE_MIP_MAX_LEVELS) {
+        header.mipOffsets[header.mipLevels] = AppendAligned(blob, level.data(), level.size());
+        header.mipBytes[header.mipLevels] = level.size();
+        header.mipLevels++;
+
+        if (width == 1 && height == 1) {
+            break;
+        }
+
+        uint32_t nextWidth = std::max(1u, width / 2);
+        uint32_t nextHeight = std::max(1u, height / 2);
+        std::vector<unsigned char> next(static_cast<std::size_t>(nextWidth) * nextHeight * 4);
+
+        for (uint32_t y = 0; y < nextHeight; y++) {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < nextWidth; x++) {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                for (uint32_t c = 0; c < 4; c++) {
+                    uint32_t sum = level[(static_cast<std::size_t>(y0) * width + x0) * 4 + c] +
+                                   level[(static_cast<std::size_t>(y0) * width + x1) * 4 + c] +
+                                   level[(static_cast<std::size_t>(y1) * width + x0) * 4 + c] +
+                                   level[(static_cast<std::size_t>(y1) * width + x1) * 4 + c];
+                    next[(static_cast<std::size_t>(y) * nextWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+
+        level.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    memcpy(blob.data(), &header, sizeof(header));
+    return blob;
+}
+
+/**
+* Добавить модель в пакет: блоки геометрии всех уровней, блоки текстур и блок описания модели (с именем = путь к файлу)
+*/
+static void CookModel(const kge::assets::ModelData &model, VERTEX_LAYOUT layout, KGEPackageWriter &writer)
+{
+    // Текстуры (не декодированные при импорте пропускаются, индексы сдвигаются)
+    std::vector<uint64_t> textureHashes;
+    std::vector<int32_t> textureIndices(model.textures.size(), -1);
+    for (std::size_t i = 0; i < model.textures.size(); i++) {
+        if (model.textures[i].pixels.empty()) {
+            continue;
+        }
+
+        std::string name = model.file + "#tex" + std::to_string(i);
+        writer.Add(name, kge::pak::BlobTexture, CookTexture(model.textures[i]));
+        textureIndices[i] = static_cast<int32_t>(textureHashes.size());
+        textureHashes.push_back(kge::pak::HashName(name));
+    }
+
+    std::vector<kge::pak::ModelMeshRecord> records;
+    for (std::size_t i = 0; i < model.meshes.size(); i++) {
+        const kge::assets::MeshData &mesh = model.meshes[i];
+
+        kge::pak::ModelMeshRecord record;
+        record.texture = mesh.texture >= 0 ? textureIndices[mesh.texture] : -1;
+        record.levelCount = static_cast<uint32_t>(std::min<std::size_t>(mesh.levels.size(), KGE_PACKAGE_LOD_MAX_LEVELS));
+
+        for (uint32_t level = 0; level < record.levelCount; level++) {
+            std::string name = model.file + "#mesh" + std::to_string(i) + "#lod" + std::to_string(level);
+            writer.Add(name, kge::pak::BlobMesh, CookMesh(mesh.levels[level], layout));
+            record.levels[level] = kge::pak::HashName(name);
+        }
+
+        records.push_back(record);
+    }
+
+    // Узлы ссылаются на сетки по индексу (сетка нескольких узлов записывается один раз)
+    std::vector<kge::pak::ModelNodeRecord> nodes;
+    for (const kge::vkstructs::ModelNode &node : model.nodes) {
+        kge::pak::ModelNodeRecord record;
+        record.mesh = node.mesh;
+        for (int axis = 0; axis < 3; axis++) {
+            record.position[axis] = node.position[axis];
+            record.rotation[axis] = node.rotation[axis];
+            record.scale[axis] = node.scale[axis];
+        }
+        nodes.push_back(record);
+    }
+
+    kge::pak::ModelBlob header;
+    header.meshCount = static_cast<uint32_t>(records.size());
+    header.textureCount = static_cast<uint32_t>(textureHashes.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+
+    std::size_t recordsBytes = records.size() * sizeof(kge::pak::ModelMeshRecord);
+    std::size_t hashesBytes = textureHashes.size() * sizeof(uint64_t);
+    std::vector<unsigned char> blob(sizeof(header) + recordsBytes + hashesBytes + nodes.size() * sizeof(kge::pak::ModelNodeRecord));
+    memcpy(blob.data(), &header, sizeof(header));
+    memcpy(blob.data() + sizeof(header), records.data(), recordsBytes);
+    memcpy(blob.data() + sizeof(header) + recordsBytes, textureHashes.data(), hashesBytes);
+    memcpy(blob.data() + sizeof(header) + recordsBytes + hashesBytes, nodes.data(), nodes.size() * sizeof(kge::pak::ModelNodeRecord));
+
+    writer.Add(model.file, kge::pak::BlobModel, std::move(blob));
+}
+
+int main(int argc, char* argv[])
+{
+    std::string output;
+    std::vector<std::string> files;
+    VERTEX_LAYOUT layout = VertexLayoutCompact;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--full") {
+            layout = VertexLayoutFull;
+        }
+        else if (output.empty()) {
+            output = argument;
+        }
+        else {
+            files.push_back(argument);
+        }
+    }
+
+    if (output.empty() || files.empty()) {
+        std::cerr << "Usage: kgecook <package.kgepak> [--full] <model> [<model> ...]" << std::endl;
+        return 1;
+    }
+
+    try {
+        KGEJobSystem jobSystem;
+        KGEModelImporter importer(&jobSystem);
+        std::vector<kge::assets::ModelData> models = importer.Import(files);
+
+        KGEPackageWriter writer;
+        for (const kge::assets::ModelData &model : models) {
+            CookModel(model, layout, writer);
+            std::cout << "Cooked " << model.file << " (" << model.meshes.size() << " meshes, " << model.nodes.size() << " nodes, " << model.textures.size() << " textures)" << std::endl;
+        }
+
+        if (!writer.Write(output)) {
+            std::cerr << "Can't write " << output << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Package " << output << " written" << std::endl;
+    return 0;
+}
@@ -0,0 +1,145 @@
+#ifndef KGEASSETHOTRELOAD_H
+#define KGEASSETHOTRELOAD_H
+
+#include <graphic/KGEVulkanCore.h>
+#include <assets/KGEModelImporter.h>
+#include <io/KGEFileWatcher.h>
+#include <jobs/KGEJobSystem.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+* Горячая перезагрузка ресурсов
+* Следит за каталогом шейдеров и за файлами загруженных через него моделей и их текстур (см. KGEFileWatcher).
+* Измененный ресурс импортируется заново в рабочих потоках системы задач, а ресурс устройства заменяется в Update
+* основного потока - между кадрами. Заменяется только то, что зависит от измененного файла: шейдер - графические
+* конвейеры, текстура - изображение на месте (примитивы ссылаются на ту же текстуру), модель - геометрия и текстуры
+* ее примитивов (хендлы примитивов остаются действительными)
+*/
+class KGEAssetHotReload
+{
+public:
+    /**
+    * @param KGEVulkanCore* renderer - рендерер
+    * @param KGEJobSystem* jobSystem - система задач (импорт и декодирование измененных файлов)
+    * @note - бросает исключение, если слежение за файлами недоступно
+    */
+    KGEAssetHotReload(KGEVulkanCore* renderer, KGEJobSystem* jobSystem);
+
+    /**
+    * @note - дожидается незавершенного импорта (его результат отбрасывается)
+    */
+    ~KGEAssetHotReload();
+
+    KGEAssetHotReload(const KGEAssetHotReload&) = delete;
+    KGEAssetHotReload& operator=(const KGEAssetHotReload&) = delete;
+
+    /**
+    * Следить за каталогом шейдеров (изменение любого файла .spv пересоздает графические конвейеры)
+    * @param const std::string &directory - каталог скомпилированных шейдеров
+    */
+    void WatchShaders(const std::string &directory = SHADERS_DIRECTORY);
+
+    /**
+    * Загрузка модели (с ожиданием) и добавление ее примитивов, далее - слежение за файлом модели и файлами ее текстур
+    * @param const std::string &file - путь к файлу модели
+    * @param glm::vec3 position - положение относительно глобального центра
+    * @param glm::vec3 rotaton - вращение вокруг локального центра
+    * @return unsigned int - идентификатор модели
+    * @note - бросает исключение, если модель не загрузилась
+    */
+    unsigned int LoadModel(const std::string &file, glm::vec3 position, glm::vec3 rotaton);
+
+    /**
+    * Хендлы примитивов модели (в порядке узлов модели)
+    * @param unsigned int model - идентификатор модели
+    */
+    const std::vector<kge::vkstructs::PrimitiveHandle>& primitives(unsigned int model) const;
+
+    /**
+    * Применение изменений: запуск импорта измененных файлов и замена ресурсов, импорт которых завершился
+    * @note - вызывается основным потоком раз в кадр, до KGEVulkanCore::Update
+    */
+    void Update();
+
+private:
+    /**
+    * Модель под наблюдением
+    */
+    struct ModelRecord
+    {
+        std::string file;                                       // Путь к файлу (канонический)
+        glm::vec3 position = {};
+        glm::vec3 rotation = {};
+        kge::vkstructs::Model model;
+        std::vector<kge::vkstructs::PrimitiveHandle> primitives;
+        unsigned int version = 0;                               // Растет при каждой замене модели (устаревшие текстуры отбрасываются)
+        bool reloading = false;                                 // Идет импорт
+        bool changedWhileReloading = false;                     // Файл изменился во время импорта - импортировать еще раз
+    };
+
+    /**
+    * Текстура модели, читаемая из отдельного файла
+    */
+    struct TextureRecord
+    {
+        unsigned int model = 0;
+        std::size_t texture = 0;                                // Индекс в Model::textures (NO_TEXTURE - текстура не загрузилась)
+        std::string name;                                       // Имя текстуры в файле модели (путь относительно каталога модели)
+    };
+
+    /**
+    * Незавершенный импорт модели
+    */
+    struct PendingModel
+    {
+        unsigned int model = 0;
+        kge::assets::ModelData data;
+        kge::jobs::Counter counter;
+    };
+
+    /**
+    * Незавершенное декодирование текстуры
+    */
+    struct PendingTexture
+    {
+        unsigned int model = 0;
+        unsigned int version = 0;                               // Версия модели на момент запуска
+        std::size_t texture = 0;
+        kge::assets::TextureData data;
+        kge::jobs::Counter counter;
+    };
+
+    static constexpr std::size_t NO_TEXTURE = static_cast<std::size_t>(-1);
+
+    KGEVulkanCore* m_renderer;
+    KGEJobSystem* m_jobSystem;
+    KGEModelImporter m_importer;
+    KGEFileWatcher m_watcher;
+
+    std::unordered_set<std::string> m_watchedDirectories;
+    bool m_watchShaders = false;
+
+    std::vector<std::unique_ptr<ModelRecord>> m_models;                     // Адреса записей не меняются при добавлении моделей
+    std::unordered_map<std::string, unsigned int> m_modelFiles;             // Модель по пути к файлу
+    std::unordered_multimap<std::string, TextureRecord> m_textureFiles;     // Текстуры по пути к файлу (файл может быть общим для нескольких моделей)
+
+    std::vector<std::unique_ptr<PendingModel>> m_pendingModels;
+    std::vector<std::unique_ptr<PendingTexture>> m_pendingTextures;
+
+    void Watch(const std::string &directory);
+    void RegisterTextures(unsigned int model, const kge::assets::ModelData &data);
+    void StartModelReload(unsigned int model);
+    void StartTextureReload(const TextureRecord &texture);
+    void ApplyModel(PendingModel &pending);
+    void ApplyTexture(PendingTexture &pending);
+
+    static std::string CanonicalPath(const std::string &path);
+};
+
+#endif // KGEASSETHOTRELOAD_H
@@ -0,0 +1,118 @@
+#ifndef KGEMODELIMPORTER_H
+#define KGEMODELIMPORTER_H
+
+#include <graphic/KGEVulkan.h>
+#include <jobs/KGEJobSystem.h>
+
+#include <string>
+#include <vector>
+
+// Во сколько раз каждый следующий уровень детализации меньше предыдущего (по кол-ву треугольников)
+#define MODEL_IMPORT_LOD_REDUCTION 0.5f
+
+// Наибольшее отклонение уровня детализации (доля радиуса описанной сферы сетки)
+#define MODEL_IMPORT_LOD_MAX_ERROR 0.05f
+
+// Уровень, уменьшивший кол-во треугольников меньше чем на эту долю, не сохраняется (упрощение уперлось в границы сетки)
+#define MODEL_IMPORT_LOD_MIN_GAIN 0.1f
+
+namespace kge
+{
+    namespace assets
+    {
+        /**
+        * Уровень детализации сетки (уровень 0 - исходная геометрия)
+        */
+        struct MeshLevelData
+        {
+            std::vector<kge::vkstructs::Vertex> vertices;
+            std::vector<unsigned int> indices;
+            float geometricError = 0.0f;            // Отклонение от исходной геометрии (в единицах модели)
+        };
+
+        /**
+        * Сетка модели в собственном пространстве (преобразование узла - в ModelData::nodes)
+        */
+        struct MeshData
+        {
+            std::string name;
+            std::vector<MeshLevelData> levels;
+            int32_t texture = -1;                   // Индекс в ModelData::textures (-1 - без текстуры)
+        };
+
+        /**
+        * Декодированная текстура (RGBA, 4 байта на пиксель)
+        */
+        struct TextureData
+        {
+            std::string name;                       // Путь к файлу либо "*N" для встроенной в файл модели
+            std::vector<unsigned char> pixels;
+            uint32_t width = 0;
+            uint32_t height = 0;
+
+            // Сжатые данные встроенной текстуры (декодируются в рабочем потоке, после декодирования очищаются)
+            std::vector<unsigned char> encoded;
+        };
+
+        /**
+        * Модель, загруженная в память хоста и готовая к загрузке в память устройства (см. KGEVulkanCore::UploadModel)
+        */
+        struct ModelData
+        {
+            std::string file;
+            std::vector<MeshData> meshes;
+            std::vector<kge::vkstructs::ModelNode> nodes;   // Узлы сцены со ссылками на сетки (по одному примитиву на узел)
+            std::vector<TextureData> textures;
+            std::string error;                      // Описание ошибки (пусто если модель загружена)
+        };
+    }
+}
+
+/**
+* Импорт моделей через Assimp
+* Файлы разбираются в рабочих потоках системы задач (у каждой задачи свой Assimp::Importer - он не потокобезопасен),
+* после чего оптимизация и построение уровней детализации каждой сетки и декодирование каждой текстуры идут
+* отдельными задачами. Vulkan не используется - результат загружается в память устройства основным потоком
+*/
+class KGEModelImporter
+{
+public:
+    /**
+    * @param KGEJobSystem* jobSystem - система задач
+    * @param uint32_t lodLevels - кол-во строящихся уровней детализации, включая исходный (1 - не строить)
+    */
+    KGEModelImporter(KGEJobSystem* jobSystem, uint32_t lodLevels = kge::vkstructs::MESH_LOD_MAX_LEVELS);
+
+    /**
+    * Поставить загрузку модели в очередь
+    * @param const std::string &file - путь к файлу модели
+    * @param kge::assets::ModelData &model - результат (должен существовать до обнуления счетчика)
+    * @param kge::jobs::Counter* signal - счетчик, обнуляемый по завершении загрузки (включая все порожденные задачи)
+    * @note - ошибки не бросаются из рабочих потоков, а записываются в model.error
+    */
+    void ImportAsync(const std::string &file, kge::assets::ModelData &model, kge::jobs::Counter* signal);
+
+    /**
+    * Загрузка набора моделей (параллельно) с ожиданием завершения
+    * @param const std::vector<std::string> &files - пути к файлам моделей
+    * @return std::vector<kge::assets::ModelData> - модели в порядке файлов
+    * @note - бросает исключение, если хотя бы одну модель загрузить не удалось
+    */
+    std::vector<kge::assets::ModelData> Import(const std::vector<std::string> &files);
+
+    /**
+    * Декодирование текстуры (файл по пути texture.name относительно каталога модели либо встроенные сжатые данные)
+    * @param kge::assets::TextureData &texture - текстура (уже декодированная не меняется)
+    * @param const std::string &directory - каталог файла модели
+    * @note - не обращается к Vulkan, может выполняться в рабочем потоке (напр. при перезагрузке измененной текстуры)
+    */
+    static void DecodeTexture(kge::assets::TextureData &texture, const std::string &directory);
+
+private:
+    KGEJobSystem* m_jobSystem;
+    uint32_t m_lodLevels;
+
+    void ProcessMesh(kge::assets::MeshData &mesh) const;
+};
+
+#endif // KGEMODELIMPORTER_H
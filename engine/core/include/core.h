@@ -3,12 +3,17 @@
 
 #include <graphic/KGEVulkanApp.h>
 #include <application/KGEAppData.h>
+#include <jobs/KGEJobSystem.h>
 
 class Core
 {
+    std::string m_profileTrace;         // Файл трассы профилировщика (пустая строка - профилирование выключено)
+    KGEJobSystem m_kgeJobSystem;
     KGEAppData m_kgeAppData;
     KGEVulkanApp m_kgeAppication;
 
+    static std::string StartProfiling();
+
 public:
     Core();
     ~Core();
@@ -4,9 +4,16 @@
 
 #include <iostream>
 #include <vector>
+#include <functional>
 #include <vulkan/vulkan.h>
 #include <glm/glm/glm.hpp>
 #include <glm/glm/gtc/matrix_transform.hpp>
+#include <glm/glm/gtc/packing.hpp>
+#include <scene/KGESceneGraph.h>
+#include <handles/KGEHandlePool.h>
+#include <log/KGELogger.h>
+#include <profile/KGEProfiler.h>
+#include <memory/KGEMemoryTracker.h>
 
 #include <string>
 #include <fstream>
@@ -25,11 +32,63 @@
 #define LOG_FILENAME "log.txt"
 #endif
 
+// Сообщения журнала движка с отложенным форматированием (формат - литерал, "{}" - место аргумента, см. KGELogger).
+// Вызовы ниже KGE_LOG_MIN_LEVEL удаляются при компиляции, остальные фильтруются уровнем журнала во время работы
+#define KGE_LOG_DEBUG(...) KGE_LOG_WRITE(kge::tools::Logger(), kge::log::LevelDebug, __VA_ARGS__)
+#define KGE_LOG_INFO(...) KGE_LOG_WRITE(kge::tools::Logger(), kge::log::LevelInfo, __VA_ARGS__)
+#define KGE_LOG_WARNING(...) KGE_LOG_WRITE(kge::tools::Logger(), kge::log::LevelWarning, __VA_ARGS__)
+#define KGE_LOG_ERROR(...) KGE_LOG_WRITE(kge::tools::Logger(), kge::log::LevelError, __VA_ARGS__)
+
+// Каталог скомпилированных шейдеров (SPIR-V), за ним следит горячая перезагрузка.
+// Задается сборкой (engine/core/CMakeLists.txt), без нее - относительно рабочего каталога
+#ifndef SHADERS_DIRECTORY
+#define SHADERS_DIRECTORY "shaders/"
+#endif
+
+// Учет памяти драйвера Vulkan через VkAllocationCallbacks (0 - драйвер выделяет память сам, учитывается только память устройства)
+#ifndef KGE_VULKAN_HOST_CALLBACKS
+#define KGE_VULKAN_HOST_CALLBACKS 1
+#endif
+
+// Интервал вывода отчета о памяти в журнал, секунды (0 - отчет только при завершении)
+#ifndef KGE_MEMORY_REPORT_INTERVAL
+#define KGE_MEMORY_REPORT_INTERVAL 30
+#endif
+
+// Бюджет кучи без VK_EXT_memory_budget - доля ее размера (остальное оставляется драйверу и другим процессам)
+#ifndef KGE_MEMORY_BUDGET_FALLBACK
+#define KGE_MEMORY_BUDGET_FALLBACK 0.8
+#endif
+
 #define KGE_MAKE_VERSION(major, minor, patch) \
     (((major) << 22) | ((minor) << 12) | (patch))
 
+// Формат вершин в буферах устройства (один на весь рендерер, от него зависят конвейеры и реестр геометрии)
+typedef enum
+{
+    VertexLayoutFull,           // kge::vkstructs::Vertex как есть (36 байт, float)
+    VertexLayoutCompact         // kge::vkstructs::VertexCompact (16 байт: snorm16 позиция относительно границ, half-float текстурные координаты, unorm8 цвет)
+}VERTEX_LAYOUT;
+
 namespace kge
 {
+    namespace vkutility
+    {
+        /**
+        * Обработчики выделения памяти хоста для объектов Vulkan (память учитывается в kge::memory::TagVulkan)
+        * @return const VkAllocationCallbacks* - передается в каждый vkCreate* / vkDestroy* (nullptr, если учет выключен)
+        * @note - объект уничтожается с теми же обработчиками, с которыми был создан
+        */
+        const VkAllocationCallbacks* HostAllocator();
+
+        /**
+        * Освобождение памяти устройства, выделенной AllocateMemory (со снятием с учета кучи)
+        * @param VkDevice logicalDevice - логическое устройство
+        * @param VkDeviceMemory memory - память (nullptr допускается)
+        */
+        void FreeMemory(VkDevice logicalDevice, VkDeviceMemory memory);
+    }
+
     namespace vkstructs
     {
         /**
@@ -45,25 +104,29 @@ namespace kge
             VkImageView vkImageView = nullptr;
             VkFormat format = {};
             VkExtent3D extent = {};
+            uint32_t mipLevels = 1;
+            VkDeviceSize memorySize = 0;    // Размер выделенной памяти (с учетом требований выравнивания)
 
             // Деинициализация (очистка памяти)
             void Deinit(VkDevice logicalDevice) {
 
                 this->format = {};
                 this->extent = {};
+                this->mipLevels = 1;
+                this->memorySize = 0;
 
                 if (this->vkImageView != nullptr) {
-                    vkDestroyImageView(logicalDevice, this->vkImageView, nullptr);
+                    vkDestroyImageView(logicalDevice, this->vkImageView, kge::vkutility::HostAllocator());
                     this->vkImageView = nullptr;
                 }
 
                 if (this->vkImage != nullptr) {
-                    vkDestroyImage(logicalDevice, this->vkImage, nullptr);
+                    vkDestroyImage(logicalDevice, this->vkImage, kge::vkutility::HostAllocator());
                     this->vkImage = nullptr;
                 }
 
                 if (this->vkDeviceMemory != nullptr) {
-                    vkFreeMemory(logicalDevice, this->vkDeviceMemory, nullptr);
+                    kge::vkutility::FreeMemory(logicalDevice, this->vkDeviceMemory);
                     this->vkDeviceMemory = nullptr;
                 }
             }
@@ -109,6 +172,14 @@ namespace kge
                 VkQueue present = nullptr;
             } queues;
 
+            // Возможности косвенной отрисовки (используются GPU-отсечением)
+            bool multiDrawIndirect = false;                                              // drawCount > 1 в одной косвенной команде
+            bool drawIndirectFirstInstance = false;                                      // firstInstance != 0 в косвенных командах
+            PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;  // VK_KHR_draw_indirect_count (nullptr если не поддерживается)
+
+            // Бюджет куч памяти: VK_EXT_memory_budget (nullptr если не поддерживается, см. vkutility::GetHeapBudgets)
+            PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+
             VkPhysicalDeviceProperties GetProperties() const {
 
                 VkPhysicalDeviceProperties properties = {};
@@ -132,7 +203,7 @@ namespace kge
                     if(vkDeviceWaitIdle(logicalDevice) != VK_SUCCESS){
                         throw std::runtime_error("Vulkan: Logical device suspend error");
                     }
-                    vkDestroyDevice(logicalDevice, nullptr);
+                    vkDestroyDevice(logicalDevice, kge::vkutility::HostAllocator());
                     logicalDevice = nullptr;
                 }
 
@@ -140,6 +211,11 @@ namespace kge
                 queues.graphics = nullptr;
                 queues.present  = nullptr;
                 queueFamilies   = {};
+
+                multiDrawIndirect = false;
+                drawIndirectFirstInstance = false;
+                cmdDrawIndexedIndirectCount = nullptr;
+                getMemoryProperties2 = nullptr;
             }
 
             // Получить выравнивание памяти для конкретного типа даныз учитывая аппаратные лимиты физического устройства
@@ -277,6 +353,7 @@ namespace kge
         struct IndexBuffer : Buffer
         {
             uint32_t count = 0;
+            VkIndexType type = VK_INDEX_TYPE_UINT32;    // 16-битные индексы, если кол-во вершин позволяет
         };
 
         /**
@@ -292,6 +369,21 @@ namespace kge
             // Указатель на размеченную память буфера
             void * pMapped = nullptr;
 
+            // Размер одной области буфера и кол-во областей (буфер делится на области - по одной на каждое изображение swap-chain,
+            // чтобы хост не перезаписывал данные, которые в этот момент еще может читать устройство)
+            VkDeviceSize regionSize = 0;
+            unsigned int regionCount = 1;
+
+            // Смещение области от начала буфера (используется в качестве динамического смещения при привязке дескрипторов)
+            uint32_t regionOffset(unsigned int regionIndex) const {
+                return static_cast<uint32_t>(regionIndex * this->regionSize);
+            }
+
+            // Указатель на размеченную память области
+            void * region(unsigned int regionIndex) const {
+                return static_cast<unsigned char*>(this->pMapped) + regionIndex * this->regionSize;
+            }
+
             // Разметить память (после этого указатель pMapped будет указывать на нее)
             VkResult map(VkDevice device, VkDeviceSize size = 64, VkDeviceSize offset = 0){
                 return vkMapMemory(device, this->vkDeviceMemory, offset, size, 0, &(this->pMapped));
@@ -344,13 +436,29 @@ namespace kge
         };
 
         /**
-        * Структура с набором примтивов синхронизации (семафоры)
+        * Сжатая вершина (формат VertexLayoutCompact), получается из Vertex при загрузке в буфер устройства
+        * Конвейер распаковывает атрибуты в те же vec3/vec3/vec2 (location 0-2), позиция приводится к пространству модели
+        * в вершинном шейдере (см. kge::vkutility::PositionDequantization)
+        */
+        struct VertexCompact
+        {
+            glm::uint64 position;       // R16G16B16A16_SNORM, в границах геометрии (w = 1)
+            glm::uint32 color;          // R8G8B8A8_UNORM (a = 1)
+            glm::uint32 texCoord;       // R16G16_SFLOAT
+        };
+
+        /**
+        * Структура с набором примтивов синхронизации (семафоры и заборы)
         * Используется для синхронизации команд рендеринга и запросов показа изображения
+        * Семафоры и заборы кадров создаются по одному на каждый кадр "в полете" (кадр отправленный, но еще не выполненный устройством)
         */
         struct Synchronization
         {
-            VkSemaphore readyToRender = nullptr;
-            VkSemaphore readyToPresent = nullptr;
+            std::vector<VkSemaphore> readyToRender;
+            std::vector<VkSemaphore> readyToPresent;
+            std::vector<VkFence> frameFences;       // Заборы кадров (сигнализируются по завершении выполнения команд кадра)
+            std::vector<VkFence> imageFences;       // Забор кадра, последним использовавшего изображение swap-chain (не владеет хендлом)
+            unsigned int currentFrame = 0;          // Индекс текущего кадра (по модулю кол-ва кадров "в полете")
         };
 
         /**
@@ -426,21 +534,340 @@ namespace kge
         };
 
         /**
-        * Стурктура описывающая примитив (набор вершин)
-        * Содержит хендлы буферов вершин и индексов, а так же параметры положеняи примитива
-        * - Позиция в глобальном пространстве
-        * - Повторот относительно локального (своего) центра
-        * - Масштаб (размер)
+        * Хендл текстуры (ячейка и поколение в пуле текстур рендерера, см. KGEVulkanCore::CreateTextures)
+        * Текстурами владеет рендерер, примитивы и модели хранят только хендлы
+        */
+        struct TextureTag;
+        typedef kge::handles::Handle<TextureTag> TextureHandle;
+        const TextureHandle INVALID_TEXTURE_HANDLE = {};
+
+        /**
+        * Мип-уровень источника текстуры (RGBA8, плотно упакованные строки)
         */
-        struct Primitive
+        struct TextureMip
+        {
+            const void* data = nullptr;
+            VkDeviceSize size = 0;
+        };
+
+        /**
+        * Источник текстуры для загрузки в память устройства (см. KGEVulkanCore::CreateTextures)
+        * Уровни от большего к меньшему, размер уровня N - max(1, width >> N) x max(1, height >> N)
+        */
+        struct TextureSource
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<TextureMip> mips;
+        };
+
+        /**
+        * Загрузка, отправленная без ожидания очереди (см. KGEVulkanCore::CollectUploads)
+        * Командный и промежуточный буферы освобождаются, когда сигнализирован забор отправки
+        */
+        struct PendingUpload
+        {
+            VkFence fence = nullptr;
+            VkCommandBuffer commandBuffer = nullptr;
+            Buffer staging = {};                    // Может отсутствовать (копирование между изображениями)
+            std::function<void()> completed;        // Вызывается после сигнала забора
+        };
+
+        /**
+        * Хендл геометрии (ячейка и поколение в пуле реестра геометрии KGEVkMeshRegistry)
+        */
+        struct MeshTag;
+        typedef kge::handles::Handle<MeshTag> MeshHandle;
+        const MeshHandle INVALID_MESH_HANDLE = {};
+
+        /**
+        * Геометрия (буферы вершин и индексов), общая для всех использующих ее примитивов
+        * Регистрируется один раз, дедуплицируется по хешу содержимого, освобождается когда счетчик ссылок станет нулевым
+        */
+        struct Mesh
         {
             bool drawIndexed = true;
             vkstructs::VertexBuffer vertexBuffer;
             vkstructs::IndexBuffer indexBuffer;
-            const vkstructs::Texture * texture;
+            uint64_t hash = 0;              // Хеш содержимого (вершины и индексы)
+            unsigned int refCount = 0;      // Кол-во ссылок
+
+            // Границы в локальном пространстве (AABB и описанная сфера с центром в центре AABB)
+            glm::vec3 boundsMin = {};
+            glm::vec3 boundsMax = {};
+            float boundingRadius = 0.0f;
+
+            // Распаковка позиций вершин в пространство модели (передается шейдеру push-константой при привязке геометрии)
+            glm::vec4 positionDequantization = { 0.0f, 0.0f, 0.0f, 1.0f };
+        };
+
+        /**
+        * Геометрия, уже упакованная в формат буферов устройства (см. KGEVkMeshRegistry::RegisterEncoded)
+        * Данные не копируются в промежуточные массивы - указатели могут ссылаться, например, на отображенный в память пакет
+        */
+        struct EncodedMesh
+        {
+            const void* vertexData = nullptr;
+            VkDeviceSize vertexBytes = 0;
+            uint32_t vertexCount = 0;
+            const void* indexData = nullptr;
+            VkDeviceSize indexBytes = 0;
+            uint32_t indexCount = 0;        // 0 - неиндексированная геометрия
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+            glm::vec3 boundsMin = {};
+            glm::vec3 boundsMax = {};
+            float boundingRadius = 0.0f;
+        };
+
+        /**
+        * Хендл примитива - позиция в таблице примитивов (она же индекс матрицы модели, сферы отсечения и т.д.) и поколение позиции
+        * Удаленная позиция отдается новому примитиву с другим поколением, поэтому старые хендлы становятся недействительными
+        */
+        struct PrimitiveHandle
+        {
+            uint32_t slot = UINT32_MAX;
+            uint32_t generation = 0;
+
+            bool operator==(const PrimitiveHandle &other) const { return slot == other.slot && generation == other.generation; }
+            bool operator!=(const PrimitiveHandle &other) const { return !(*this == other); }
+        };
+
+        /**
+        * Примитив - сущность ECS (см. KGEEcsWorld) с набором компонентов. Данные разнесены по назначению, поэтому
+        * проход по преобразованиям не читает данные отрисовки и наоборот:
+        * - Transform - положение, поворот, масштаб и узел в иерархии преобразований сцены
+        * - Renderable - геометрия, текстура и индекс примитива
+        * - Bounds - границы в глобальном пространстве (AABB и ограничивающая сфера), используются при отсечении
+        * - Animation - (необязательный) параметры анимации
+        */
+
+        /**
+        * Преобразование примитива
+        * - Позиция относительно родителя (либо глобального центра)
+        * - Повторот относительно локального (своего) центра
+        * - Масштаб (размер)
+        */
+        struct Transform
+        {
             glm::vec3 position = {};
             glm::vec3 rotation = {};
             glm::vec3 scale = {};
+            kge::scene::NodeId node = kge::scene::INVALID_NODE;
+
+            // Подготовить матрицу модели (локальную, относительно родителя): перенос * поворот (X, Y, Z) * масштаб
+            glm::mat4 MakeModelMatrix() const {
+                glm::mat4 result = glm::translate(glm::mat4(), this->position);
+                result = glm::rotate(result, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+                result = glm::rotate(result, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+                result = glm::rotate(result, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+                result = glm::scale(result, this->scale);
+                return result;
+            }
+
+            // Разложить матрицу на перенос, поворот и масштаб (обратно MakeModelMatrix, отражение - отрицательный масштаб по X)
+            // @return bool - false, если матрицу так не представить (сдвиг либо вырожденный масштаб) - преобразование не меняется
+            bool Decompose(const glm::mat4 &matrix) {
+                glm::vec3 axes[3] = { glm::vec3(matrix[0]), glm::vec3(matrix[1]), glm::vec3(matrix[2]) };
+                glm::vec3 newScale = { glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]) };
+                const float epsilon = 1e-4f;
+                if (newScale.x < epsilon || newScale.y < epsilon || newScale.z < epsilon) {
+                    return false;
+                }
+                for (int axis = 0; axis < 3; axis++) {
+                    axes[axis] /= newScale[axis];
+                }
+                if (glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0.0f) {
+                    newScale.x = -newScale.x;
+                    axes[0] = -axes[0];
+                }
+                if (glm::abs(glm::dot(axes[0], axes[1])) > epsilon || glm::abs(glm::dot(axes[0], axes[2])) > epsilon ||
+                        glm::abs(glm::dot(axes[1], axes[2])) > epsilon) {
+                    return false;
+                }
+
+                // Поворот Rx * Ry * Rz: axes[столбец][строка]
+                glm::vec3 angles = {};
+                float cosY = glm::length(glm::vec2(axes[0].x, axes[1].x));
+                angles.y = glm::atan(axes[2].x, cosY);
+                if (cosY > 1e-6f) {
+                    angles.x = glm::atan(-axes[2].y, axes[2].z);
+                    angles.z = glm::atan(-axes[1].x, axes[0].x);
+                }
+                else {
+                    // Складывание рамок - поворот вокруг Z неотличим от поворота вокруг X
+                    angles.x = glm::atan(axes[1].z, axes[1].y);
+                }
+
+                this->position = glm::vec3(matrix[3]);
+                this->rotation = glm::degrees(angles);
+                this->scale = newScale;
+                return true;
+            }
+        };
+
+        /**
+        * Данные отрисовки примитива
+        */
+        struct Renderable
+        {
+            vkstructs::MeshHandle mesh = INVALID_MESH_HANDLE;
+            vkstructs::TextureHandle texture = INVALID_TEXTURE_HANDLE;
+            uint32_t slot = 0;      // Позиция примитива (область матрицы в массиве моделей, индекс сферы отсечения)
+        };
+
+        /**
+        * Границы примитива в глобальном пространстве
+        */
+        struct Bounds
+        {
+            glm::vec3 aabbMin = {};
+            glm::vec3 aabbMax = {};
+            glm::vec3 sphereCenter = {};
+            float sphereRadius = 0.0f;
+
+            // Пересчитать границы в глобальном пространстве по локальным границам геометрии и мировой матрице
+            void Update(const vkstructs::Mesh &meshData, const glm::mat4 &model) {
+                glm::vec3 localCenter = (meshData.boundsMin + meshData.boundsMax) * 0.5f;
+                glm::vec3 localExtent = (meshData.boundsMax - meshData.boundsMin) * 0.5f;
+
+                // Центр переносится матрицей, полуразмеры - модулем ее поворотной части
+                glm::vec3 center = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+                glm::vec3 extent = {};
+                for (int axis = 0; axis < 3; axis++) {
+                    extent += glm::abs(glm::vec3(model[axis])) * localExtent[axis];
+                }
+
+                this->aabbMin = center - extent;
+                this->aabbMax = center + extent;
+                this->sphereCenter = center;
+                this->sphereRadius = meshData.boundingRadius * glm::max(glm::length(glm::vec3(model[0])),
+                                                                        glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            }
+        };
+
+        /**
+        * Статистика записи команд отрисовки примитивов
+        */
+        struct DrawStats
+        {
+            uint32_t draws = 0;                 // Кол-во команд отрисовки
+            uint32_t descriptorSetBinds = 0;    // Кол-во привязок наборов дескрипторов
+            uint32_t bufferBinds = 0;           // Кол-во привязок буферов вершин и индексов
+            uint32_t bindsAvoided = 0;          // Кол-во пропущенных повторных привязок (текстура либо геометрия не сменились)
+            uint32_t triangles = 0;             // Кол-во треугольников (без косвенной отрисовки)
+        };
+
+        /**
+        * Анимация примитива (вращение с постоянной скоростью)
+        */
+        struct Animation
+        {
+            glm::vec3 angularVelocity = {};     // Скорость вращения вокруг осей (градусов в секунду)
+        };
+
+        // Максимальное кол-во уровней детализации примитива (вместе с исходной геометрией)
+        const uint32_t MESH_LOD_MAX_LEVELS = 4;
+
+        /**
+        * Уровень детализации - упрощенная геометрия и ее наибольшее отклонение от исходной
+        */
+        struct MeshLodLevel
+        {
+            vkstructs::MeshHandle mesh = INVALID_MESH_HANDLE;
+            float geometricError = 0.0f;        // Отклонение в единицах пространства модели
+        };
+
+        /**
+        * Уровни детализации примитива (0 - исходная геометрия, далее по возрастанию отклонения)
+        */
+        struct MeshLod
+        {
+            MeshLodLevel levels[MESH_LOD_MAX_LEVELS];
+            uint32_t levelCount = 0;
+            uint32_t level = 0;                 // Текущий уровень (его геометрия - в Renderable::mesh)
+        };
+
+        /**
+        * Сетка модели в памяти устройства: геометрия, ее уровни детализации и индекс текстуры в Model::textures (-1 - без текстуры)
+        */
+        struct ModelMesh
+        {
+            MeshHandle mesh = INVALID_MESH_HANDLE;
+            std::vector<MeshLodLevel> lods;
+            int32_t texture = -1;
+        };
+
+        /**
+        * Узел сцены модели - сетка и ее преобразование относительно начала модели
+        * Сетку, на которую ссылаются несколько узлов, все они разделяют (одна геометрия в реестре)
+        */
+        struct ModelNode
+        {
+            uint32_t mesh = 0;                  // Индекс в Model::meshes
+            glm::vec3 position = {};
+            glm::vec3 rotation = {};            // Градусы, порядок как в Transform::MakeModelMatrix
+            glm::vec3 scale = { 1.0f, 1.0f, 1.0f };
+        };
+
+        /**
+        * Модель в памяти устройства (см. KGEVulkanCore::UploadModel). Владеет одной ссылкой на каждую сетку
+        * и своими текстурами (сетки освобождает KGEVulkanCore::ReleaseModel, текстуры - KGEVulkanCore::ReleaseTextures)
+        */
+        struct Model
+        {
+            std::vector<ModelMesh> meshes;
+            std::vector<ModelNode> nodes;       // Примитивы модели (по одному на узел)
+            std::vector<TextureHandle> textures;
+        };
+
+        /**
+        * Экземпляризированный примитив - одна геометрия, отрисовываемая несколько раз одной командой
+        * Матрицы моделей экземпляров передаются через буфер экземпляров (вершинный буфер с шагом "на экземпляр")
+        */
+        struct InstancedPrimitive
+        {
+            vkstructs::MeshHandle mesh = INVALID_MESH_HANDLE;
+            vkstructs::TextureHandle texture = INVALID_TEXTURE_HANDLE;
+            std::vector<glm::mat4> instances;   // Матрицы моделей экземпляров
+            uint32_t firstInstance = 0;         // Индекс первого экземпляра в области буфера экземпляров
+        };
+
+        /**
+        * Описание объекта для GPU-отсечения (элемент буфера хранилища, раскладка std430 - см. shaders/cull.comp)
+        * Сфера задана в локальном пространстве, матрица модели берется из буфера экземпляров по индексу firstInstance
+        */
+        struct GpuCullObject
+        {
+            glm::vec4 sphere = {};          // Центр (xyz) и радиус (w) ограничивающей сферы геометрии
+            uint32_t indexCount = 0;        // Кол-во индексов геометрии
+            uint32_t batch = 0;             // Индекс пакета отрисовки (счетчик команд пакета)
+            uint32_t commandSlot = 0;       // Ячейка команды (начало пакета при уплотнении, либо собственная ячейка объекта)
+            uint32_t firstInstance = 0;     // Индекс матрицы модели в области буфера экземпляров
+        };
+
+        /**
+        * Пакет косвенной отрисовки - примитивы с одинаковой геометрией и текстурой
+        * Команды пакета лежат в буфере команд подряд, начиная с commandOffset
+        */
+        struct GpuDrawBatch
+        {
+            vkstructs::MeshHandle mesh = INVALID_MESH_HANDLE;
+            vkstructs::TextureHandle texture = INVALID_TEXTURE_HANDLE;
+            uint32_t commandOffset = 0;     // Индекс первой команды пакета
+            uint32_t commandCapacity = 0;   // Кол-во примитивов в пакете (максимальное кол-во команд)
+        };
+
+        /**
+        * Бюджет кучи памяти устройства (см. vkutility::GetHeapBudgets)
+        * Без VK_EXT_memory_budget бюджет - доля размера кучи (KGE_MEMORY_BUDGET_FALLBACK), потребление - по учету памяти движка
+        */
+        struct HeapBudget
+        {
+            VkDeviceSize size = 0;          // Размер кучи
+            VkDeviceSize budget = 0;        // Сколько процесс может занять без потери производительности (с учетом других процессов)
+            VkDeviceSize usage = 0;         // Сколько процесс занимает сейчас
+            bool deviceLocal = false;       // Локальная память устройства
         };
     }
 
@@ -483,7 +910,37 @@ namespace kge
         * @note - данный метод используется, например, при создании буферов
         */
         int GetMemoryTypeIndex(VkPhysicalDevice physicalDevice, unsigned int typeFlags,
-                               VkMemoryPropertyFlags properties);
+                               VkMemoryPropertyFlags properties, VkMemoryHeapFlags excludedHeapFlags = 0);
+
+        /**
+        * Регистрация куч памяти устройства в учете памяти (размеры и тип - для отчетов)
+        * @param VkPhysicalDevice physicalDevice - физическое устройство
+        */
+        void RegisterMemoryHeaps(VkPhysicalDevice physicalDevice);
+
+        /**
+        * Выделение памяти устройства с учетом по кучам (обертка vkAllocateMemory)
+        * @param const vkstructs::Device &device - устройство
+        * @param const VkMemoryAllocateInfo &allocateInfo - параметры выделения
+        * @param VkDeviceMemory* memory - результат
+        * @return VkResult - результат vkAllocateMemory
+        * @note - освобождать через FreeMemory
+        */
+        VkResult AllocateMemory(const vkstructs::Device &device, const VkMemoryAllocateInfo &allocateInfo, VkDeviceMemory* memory);
+
+        /**
+        * Куча, из которой выделена память (AllocateMemory)
+        * @param VkDeviceMemory memory - память
+        * @return uint32_t - индекс кучи (UINT32_MAX - память выделена в обход AllocateMemory)
+        */
+        uint32_t MemoryHeap(VkDeviceMemory memory);
+
+        /**
+        * Текущие бюджеты и потребление куч памяти устройства
+        * @param const vkstructs::Device &device - устройство
+        * @param std::vector<vkstructs::HeapBudget> &budgets - результат (по куче на элемент)
+        */
+        void GetHeapBudgets(const vkstructs::Device &device, std::vector<vkstructs::HeapBudget> &budgets);
 
         /**
         * Создание буфера
@@ -492,13 +949,15 @@ namespace kge
         * @param VkBufferUsageFlags usage - как буфер будет использован (например, как вершинный - VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
         * @param VkMemoryPropertyFlags properties - свойства памяти буфера (память устройства, память хоста, для "кого" память видима и т.д.)
         * @param VkSharingMode sharingMode - настройка доступа к памяти буфера для очередей (VK_SHARING_MODE_EXCLUSIVE - с буфером работает одна очередь)
+        * @param VkMemoryHeapFlags excludedHeapFlags - кучи с этими флагами не используются (напр. VK_MEMORY_HEAP_DEVICE_LOCAL_BIT - только память хоста)
         * @return vkstructs::Buffer - структура содержающая хендл буфера, хендл памяти а так же размер буфера
         */
         vkstructs::Buffer CreateBuffer(const vkstructs::Device &device,
                                        VkDeviceSize size,
                                        VkBufferUsageFlags usage,
                                        VkMemoryPropertyFlags properties,
-                                       VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE);
+                                       VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                       VkMemoryHeapFlags excludedHeapFlags = 0);
         /**
         * Создание простого однослойного изображения
         * @param vkstructs::Device &device - устройство в памяти которого, либо с доступном для которого, будет создаваться изображение
@@ -508,6 +967,7 @@ namespace kge
         * @param VkImageUsageFlags usage - использование изображения (в качестве чего, назначение)
         * @param VkImageAspectFlags subresourceRangeAspect - использование области подресурса (???)
         * @param VkSharingMode sharingMode - настройка доступа к памяти изображения для очередей (VK_SHARING_MODE_EXCLUSIVE - с буфером работает одна очередь)
+        * @param uint32_t mipLevels - кол-во мип-уровней (view-объект охватывает все уровни)
         */
         vkstructs::Image CreateImageSingle(const vkstructs::Device &device,
                                            VkImageType imageType,
@@ -518,28 +978,77 @@ namespace kge
                                            VkImageLayout initialLayout,
                                            VkMemoryPropertyFlags memoryProperties,
                                            VkImageTiling tiling,
-                                           VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE);
+                                           VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                           uint32_t mipLevels = 1);
 
         /**
         * Получить описание привязок вершинных данных к конвейеру
         * @param unsigned int bindingIndex - индекс привязки буфера вершин к конвейеру
+        * @param VERTEX_LAYOUT layout - формат вершин в буфере
         * @return std::vector<VkVertexInputBindingDescription> - массив описаний привязок
         *
         * @note - при привязывании буфера вершин к конвейеру, указывается индекс привязки. Нужно получить информацию
         * для конкретной привязки, о том как конвейер будет интерпретировать привязываемый буфер, какого размера
         * один элемент (вершина) в буфере, как переходить к следующему и тд. Вся информация в этой структуре
         */
-        std::vector<VkVertexInputBindingDescription> GetVertexInputBindingDescriptions(unsigned int bindingIndex);
+        std::vector<VkVertexInputBindingDescription> GetVertexInputBindingDescriptions(unsigned int bindingIndex, VERTEX_LAYOUT layout);
 
         /**
         * Получить описание аттрибутов привязываемых к конвейеру вершин
         * @param unsigned int bindingIndex - индекс привязки буфера вершин к конвейеру
+        * @param VERTEX_LAYOUT layout - формат вершин в буфере
         * @return std::vector<VkVertexInputAttributeDescription> - массив описаний атрибутов передаваемых вершин
         *
         * @note - конвейеру нужно знать как интерпретировать данные о вершинах. Какие у каждой вершины, в привязываемом буфере,
         * есть параметры (аттрибуты). В какой последовательности они идут, какого типа каждый аттрибут.
         */
-        std::vector<VkVertexInputAttributeDescription> GetVertexInputAttributeDescriptions(unsigned int bindingIndex);
+        std::vector<VkVertexInputAttributeDescription> GetVertexInputAttributeDescriptions(unsigned int bindingIndex, VERTEX_LAYOUT layout);
+
+        /**
+        * Распаковка позиций вершин в пространство модели (позиция = упакованная * w + xyz)
+        * @param const glm::vec3 &boundsMin - нижняя граница геометрии
+        * @param const glm::vec3 &boundsMax - верхняя граница геометрии
+        * @param VERTEX_LAYOUT layout - формат вершин в буфере
+        * @return glm::vec4 - центр границ (xyz) и масштаб (w), для VertexLayoutFull - (0, 0, 0, 1)
+        */
+        glm::vec4 PositionDequantization(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, VERTEX_LAYOUT layout);
+
+        /**
+        * Упаковка вершин в формат буфера устройства
+        * @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+        * @param VERTEX_LAYOUT layout - формат вершин в буфере
+        * @param const glm::vec4 &positionDequantization - распаковка позиций (см. PositionDequantization)
+        * @param std::vector<unsigned char> &result - байты для буфера вершин
+        */
+        void EncodeVertices(const std::vector<kge::vkstructs::Vertex> &vertices,
+                            VERTEX_LAYOUT layout,
+                            const glm::vec4 &positionDequantization,
+                            std::vector<unsigned char> &result);
+
+        /**
+        * Упаковка индексов в формат буфера устройства (16 бит, если все индексы меньше 65536)
+        * @param const std::vector<unsigned int> &indices - массив индексов
+        * @param uint32_t vertexCount - кол-во вершин
+        * @param std::vector<unsigned char> &result - байты для буфера индексов
+        * @return VkIndexType - тип индексов в буфере
+        */
+        VkIndexType EncodeIndices(const std::vector<unsigned int> &indices, uint32_t vertexCount, std::vector<unsigned char> &result);
+
+        /**
+        * Получить описание привязки буфера экземпляров к конвейеру (шаг - одна матрица, переход к следующей - на каждый экземпляр)
+        * @param unsigned int bindingIndex - индекс привязки буфера экземпляров к конвейеру
+        * @return std::vector<VkVertexInputBindingDescription> - массив описаний привязок
+        */
+        std::vector<VkVertexInputBindingDescription> GetInstanceInputBindingDescriptions(unsigned int bindingIndex);
+
+        /**
+        * Получить описание аттрибутов экземпляра (матрица модели передается четырьмя столбцами vec4)
+        * @param unsigned int bindingIndex - индекс привязки буфера экземпляров к конвейеру
+        * @param unsigned int firstLocation - location первого столбца матрицы в шейдере (занимает 4 location подряд)
+        * @return std::vector<VkVertexInputAttributeDescription> - массив описаний атрибутов
+        */
+        std::vector<VkVertexInputAttributeDescription> GetInstanceInputAttributeDescriptions(unsigned int bindingIndex,
+                                                                                             unsigned int firstLocation);
 
         /**
         * Загрузка шейдерного модуля из файла
@@ -598,6 +1107,17 @@ namespace kge
                                           VkCommandBuffer commandBuffer,
                                           VkQueue queue);
 
+        /**
+        * Отправить команды на исполнение без ожидания
+        * @param const vkstructs::Device &device - устройство
+        * @param VkCommandBuffer commandBuffer - командный буфер (освобождается вызывающим после сигнала забора)
+        * @param VkQueue queue - очередь
+        * @return VkFence - забор, сигнализируемый по завершении команд (удаляется вызывающим)
+        */
+        VkFence SubmitSingleTimeCommandBuffer(const vkstructs::Device &device,
+                                              VkCommandBuffer commandBuffer,
+                                              VkQueue queue);
+
 
     }
 
@@ -631,20 +1151,32 @@ namespace kge
         */
         std::string TimeToStr(const std::time_t & time, const char * format);
 
+        /**
+        * Журнал движка (файл LOG_FILENAME в рабочем каталоге и консоль). Создается при первом обращении
+        * @note - для сообщений с аргументами предпочтительнее макросы KGE_LOG_* - строка собирается потоком журнала
+        */
+        KGELogger& Logger();
+
         /**
         * Логирование. Пишет в файл и консоль (если она еть) строку со временем и указанным сообщением
         * @param std::string message - строка с соощением
         * @param bool printTime - выводить ли время
+        * @note - запись асинхронная (см. KGELogger), сообщение длиннее KGE_LOG_TEXT_BYTES обрезается
         */
         void LogMessage(std::string message, bool printTime = true);
 
         /**
-        * То же что и LogMessage, с той разницей что перед сообщением будет добавляться слово "ERROR!"
+        * То же что и LogMessage, но с уровнем ошибки (перед сообщением выводится метка "[ERROR]")
         * @param std::string message - строка с соощением
         * @param bool printTime - выводить ли время
         */
         void LogError(std::string message, bool printTime = true);
 
+        /**
+        * Отчет о памяти в журнал: текущее и пиковое потребление подсистем хоста и куч устройства
+        */
+        void LogMemoryUsage();
+
         /**
         * Конвертация из обычной string-строки в "широкую" wstring
         * @param const std::string& str - исходная string строка
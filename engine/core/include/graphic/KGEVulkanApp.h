@@ -2,6 +2,7 @@
 
 #include "VulkanWindowControl/IVulkanWindowControl.h"
 #include <graphic/KGEVulkanCore.h>
+#include <assets/KGEAssetHotReload.h>
 
 #include <vector>
 #include <string>
@@ -64,7 +65,7 @@ struct
 class KGEVulkanApp
 {
 public:
-    KGEVulkanApp(uint32_t width, uint32_t heigh, std::string applicationName);
+    KGEVulkanApp(uint32_t width, uint32_t heigh, std::string applicationName, KGEJobSystem* jobSystem);
     ~KGEVulkanApp();
 
     void Init();
@@ -75,11 +76,14 @@ private:
     uint32_t m_appHeigh{};
     std::string m_applicationName;
     IVulkanWindowControl *m_windowControl{};
+    KGEJobSystem *m_jobSystem{};
     KGEVulkanCore *m_KGEVulkanCore{};
+    KGEAssetHotReload *m_assetHotReload{};   // Горячая перезагрузка ресурсов (nullptr если слежение за файлами недоступно)
     std::vector<const char *> m_instanceExtensions{};
     std::vector<const char *> m_deviceExtensions{};
     std::vector<const char *> m_validationLayersExtensions{};
 
     // Время последнего кадра (точнее последней итерации)
     time_point<high_resolution_clock> lastFrameTime;
+    time_point<high_resolution_clock> lastMemoryReportTime;     // Время последнего отчета о памяти
 };
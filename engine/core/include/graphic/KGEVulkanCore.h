@@ -3,9 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <graphic/KGEVulkan.h>
 #include <graphic/VulkanWindowControl/IVulkanWindowControl.h>
+#include <jobs/KGEJobSystem.h>
+#include <math/KGEFrustumCuller.h>
+#include <math/KGEBvh.h>
+#include <ecs/KGEEcs.h>
 
 #include <graphic/VulkanCoreModules/KGEVkInstance.h>
 #include <graphic/VulkanCoreModules/KGEVkReportCallBack.h>
@@ -25,12 +30,49 @@
 #include <graphic/VulkanCoreModules/KGEVkDescriptorSet.h>
 #include <graphic/VulkanCoreModules/KGEVkUboModels.h>
 #include <graphic/VulkanCoreModules/KGEVkSynchronization.h>
+#include <graphic/VulkanCoreModules/KGEVkInstanceBuffer.h>
+#include <graphic/VulkanCoreModules/KGEVkMeshRegistry.h>
+#include <graphic/VulkanCoreModules/KGEVkGpuCulling.h>
+#include <graphic/VulkanCoreModules/KGEVkDeletionQueue.h>
+#include <graphic/VulkanCoreModules/KGEVkResidency.h>
+#include <assets/KGEModelImporter.h>
+#include <assets/KGEPackage.h>
 
 // Параметры камеры по умолчанию (угол обзора, границы отсечения)
 #define DEFAULT_FOV 60.0f
 #define DEFAULT_NEAR 0.1f
 #define DEFAULT_FAR 256.0f
 
+// Кол-во кадров "в полете" - сколько кадров хост может отправить на выполнение не дожидаясь их завершения устройством
+#define MAX_FRAMES_IN_FLIGHT 2
+
+// Максимальное кол-во экземпляров (суммарно для всех экземпляризированных примитивов)
+#define INSTANCES_MAX_COUNT 4096
+
+// Максимальное кол-во текстур (размер дескрипторного пула текстурных наборов)
+#define TEXTURES_MAX_COUNT 256
+
+// Допустимое отклонение упрощенной геометрии на экране (в пикселях) по умолчанию
+#define LOD_PIXEL_ERROR 1.0f
+
+// Гистерезис смены уровня детализации: к более грубому уровню примитив переходит, только когда отклонение
+// меньше допустимого на эту долю (иначе примитив на границе переключался бы каждый кадр)
+#define LOD_HYSTERESIS 0.25f
+
+// Способ передачи матрицы модели в вершинный шейдер
+typedef enum
+{
+    ModelDataDynamicUbo,        // Динамический uniform-буфер: перепривязка дескрипторов со смещением на каждую отрисовку, команды записываются заранее
+    ModelDataPushConstants      // Push-константы: 64 байта на отрисовку без перепривязки дескрипторов, команды изображения записываются каждый кадр
+}MODEL_DATA_PATH;
+
+// Способ отсечения примитивов по пирамиде видимости
+typedef enum
+{
+    CullingCpu,                 // На хосте (SIMD), командные буферы перезаписываются при изменении набора видимых примитивов
+    CullingGpu                  // Вычислительным шейдером, который пишет команды косвенной отрисовки (командные буферы не перезаписываются)
+}CULLING_MODE;
+
 // Интервал значений глубины в OpenGL от -1 до 1. В Vulkan - от 0 до 1 (как в DirectX)
 // Данный символ "сообщит" GLM что нужно использовать интервал от 0 до 1, что скажется
 // на построении матриц проекции, которые используются в шейдере
@@ -43,10 +85,14 @@ public:
                   uint32_t heigh,
                   std::string applicationName,
                   IVulkanWindowControl* windowControl,
-                  unsigned int primitivesMaxCount,
+                  KGEJobSystem* jobSystem,
+                  unsigned int primitivesInitialCapacity,
                   std::vector <const char*> instanceExtensionsRequired,
                   std::vector <const char*> deviceExtensionsRequired,
-                  std::vector <const char*> validationLayersRequired);
+                  std::vector <const char*> validationLayersRequired,
+                  MODEL_DATA_PATH modelDataPath = ModelDataDynamicUbo,
+                  CULLING_MODE cullingMode = CullingCpu,
+                  VERTEX_LAYOUT vertexLayout = VertexLayoutCompact);
 
 
     /**
@@ -102,44 +148,277 @@ public:
     */
     void SetCameraRotation(float x, float y, float z);
 
+    /**
+    * Регистрация геометрии (одинаковая геометрия загружается в память устройства один раз)
+    * @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+    * @param const std::vector<unsigned int> &indices - массив индексов
+    * @return kge::vkstructs::MeshHandle - хендл геометрии (вызывающий владеет одной ссылкой, см. ReleaseMesh)
+    */
+    kge::vkstructs::MeshHandle RegisterMesh(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                            const std::vector<unsigned int> &indices);
+
+    /**
+    * Освобождение ссылки на геометрию (геометрия удаляется когда на нее не ссылается ни вызывающий, ни один примитив)
+    * @param kge::vkstructs::MeshHandle mesh - хендл геометрии
+    */
+    void ReleaseMesh(kge::vkstructs::MeshHandle mesh);
+
     /**
     * Добавление нового примитива
+    * @param kge::vkstructs::MeshHandle mesh - хендл зарегистрированной геометрии
+    * @param kge::vkstructs::TextureHandle texture - хендл текстуры (INVALID_TEXTURE_HANDLE - без текстуры)
+    * @param glm::vec3 position - положение относительно глобального центра
+    * @param glm::vec3 rotaton - вращение вокруг локального центра
+    * @param glm::vec3 scale - масштаб
+    * @return kge::vkstructs::PrimitiveHandle - хендл примитива
+    */
+    kge::vkstructs::PrimitiveHandle AddPrimitive(
+            kge::vkstructs::MeshHandle mesh,
+            kge::vkstructs::TextureHandle texture,
+            glm::vec3 position,
+            glm::vec3 rotaton,
+            glm::vec3 scale = { 1.0f,1.0f,1.0f });
+
+    /**
+    * Добавление нового примитива (геометрия регистрируется автоматически)
     * @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
     * @param const std::vector<unsigned int> &indices - массив индексов
     * @param glm::vec3 position - положение относительно глобального центра
     * @param glm::vec3 rotaton - вращение вокруг локального центра
     * @param glm::vec3 scale - масштаб
-    * @return unsigned int - индекс примитива
+    * @return kge::vkstructs::PrimitiveHandle - хендл примитива
     */
-    unsigned int AddPrimitive(
+    kge::vkstructs::PrimitiveHandle AddPrimitive(
             const std::vector<kge::vkstructs::Vertex> &vertices,
             const std::vector<unsigned int> &indices,
-            const kge::vkstructs::Texture *texture,
+            kge::vkstructs::TextureHandle texture,
             glm::vec3 position,
             glm::vec3 rotaton,
             glm::vec3 scale = { 1.0f,1.0f,1.0f });
 
+    /**
+    * Удаление примитива
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива (после удаления недействителен)
+    * @note - позиция примитива отдается следующему добавленному. Потомки примитива в иерархии становятся корневыми
+    */
+    void RemovePrimitive(kge::vkstructs::PrimitiveHandle primitive);
+
+    /**
+    * Существует ли примитив (хендл не устарел)
+    */
+    bool PrimitiveAlive(kge::vkstructs::PrimitiveHandle primitive) const;
+
+    /**
+    * Добавление нового экземпляризированного примитива (одна геометрия, N экземпляров, одна команда отрисовки)
+    * @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+    * @param const std::vector<unsigned int> &indices - массив индексов
+    * @param kge::vkstructs::TextureHandle texture - хендл текстуры (общей для всех экземпляров)
+    * @param const std::vector<glm::mat4> &instances - матрицы моделей экземпляров
+    * @return unsigned int - индекс экземпляризированного примитива
+    */
+    unsigned int AddInstancedPrimitive(
+            const std::vector<kge::vkstructs::Vertex> &vertices,
+            const std::vector<unsigned int> &indices,
+            kge::vkstructs::TextureHandle texture,
+            const std::vector<glm::mat4> &instances);
+
+    /**
+    * Добавление нового экземпляризированного примитива по хендлу зарегистрированной геометрии
+    */
+    unsigned int AddInstancedPrimitive(
+            kge::vkstructs::MeshHandle mesh,
+            kge::vkstructs::TextureHandle texture,
+            const std::vector<glm::mat4> &instances);
+
+    /**
+    * Обновление матриц экземпляров
+    * @param unsigned int instancedPrimitiveIndex - индекс экземпляризированного примитива
+    * @param const std::vector<glm::mat4> &instances - новые матрицы моделей экземпляров
+    * @note - если кол-во экземпляров не изменилось, командные буферы не перезаписываются (матрицы попадут в буфер экземпляров в Draw)
+    */
+    void SetInstanceTransforms(unsigned int instancedPrimitiveIndex,
+                               const std::vector<glm::mat4> &instances);
+
+    /**
+    * Перемещение примитива
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+    * @param glm::vec3 position - положение относительно родителя (либо глобального центра)
+    * @param glm::vec3 rotaton - вращение вокруг локального центра
+    * @note - командные буферы не перезаписываются, матрицы примитива и его потомков попадут в uniform-буфер в ближайшем Update
+    */
+    void SetPrimitiveTransform(kge::vkstructs::PrimitiveHandle primitive,
+                               glm::vec3 position,
+                               glm::vec3 rotaton);
+
+    /**
+    * Смена родителя примитива в иерархии преобразований
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+    * @param kge::vkstructs::PrimitiveHandle parent - хендл родительского примитива (хендл по умолчанию - сделать примитив корневым)
+    */
+    void SetPrimitiveParent(kge::vkstructs::PrimitiveHandle primitive, kge::vkstructs::PrimitiveHandle parent = {});
+
+    /**
+    * Вращение примитива с постоянной скоростью
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+    * @param glm::vec3 angularVelocity - скорость вращения вокруг осей (градусов в секунду), нулевая - остановить
+    */
+    void SetPrimitiveAnimation(kge::vkstructs::PrimitiveHandle primitive, glm::vec3 angularVelocity);
+
+    /**
+    * Задание уровней детализации примитива
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+    * @param const std::vector<kge::vkstructs::MeshLodLevel> &levels - упрощенная геометрия по возрастанию отклонения
+    * (исходная геометрия примитива - уровень 0), пустой массив - отключить уровни детализации
+    * @note - уровень выбирается в каждом Update по отклонению, спроецированному на экран. Примитив берет ссылки на геометрию
+    * новых уровней до освобождения ссылок прежних, поэтому цепочку с общей геометрией можно задавать повторно
+    */
+    void SetPrimitiveLods(kge::vkstructs::PrimitiveHandle primitive, const std::vector<kge::vkstructs::MeshLodLevel> &levels);
+
+    /**
+    * Допустимое отклонение упрощенной геометрии на экране
+    * @param float pixels - отклонение в пикселях (больше - грубее геометрия и меньше треугольников)
+    */
+    void SetLodPixelError(float pixels);
+
+    /**
+    * Статистика записи команд отрисовки (последний записанный командный буфер)
+    * @return const kge::vkstructs::DrawStats& - кол-во отрисовок, треугольников, привязок и пропущенных повторных привязок
+    */
+    const kge::vkstructs::DrawStats& drawStats() const;
+
+    /**
+    * Поиск ближайшего примитива, пересекаемого лучом (по AABB примитивов)
+    * @param const glm::vec3 &origin - начало луча
+    * @param const glm::vec3 &direction - направление луча
+    * @return kge::vkstructs::PrimitiveHandle - хендл примитива (хендл по умолчанию если пересечений нет)
+    */
+    kge::vkstructs::PrimitiveHandle PickPrimitive(const glm::vec3 &origin, const glm::vec3 &direction);
+
+    /**
+    * Примитивы, чьи AABB пересекаются с заданной областью
+    * @param const glm::vec3 &min - минимальная точка области
+    * @param const glm::vec3 &max - максимальная точка области
+    * @return std::vector<kge::vkstructs::PrimitiveHandle> - хендлы примитивов
+    */
+    std::vector<kge::vkstructs::PrimitiveHandle> QueryPrimitives(const glm::vec3 &min, const glm::vec3 &max);
+
     /**
     * Создание текстуры по данным о пикселях
     * @param const unsigned char* pixels - пиксели загруженные из файла
-    * @return kge::vkstructs::Texture - структура с набором хендлов изображения и дескриптора
+    * @return kge::vkstructs::TextureHandle - хендл текстуры (текстурой владеет рендерер, см. ReleaseTexture)
     *
     * @note - при загрузке используется временный буфер (временное изображение) для перемещения
     * в буфер распологающийся в памяти устройства. Нельзя сразу создать буфер в памяти устройства и переместить
     * в него данные. Это можно сделать только пр помощи команды копирования (из памяти доступной хосту в память
     * доступную только устройству)
     */
-    kge::vkstructs::Texture CreateTexture(const unsigned char* pixels,
-                                          uint32_t width,
-                                          uint32_t height,
-                                          uint32_t channels,
-                                          uint32_t bpp = 4);
+    kge::vkstructs::TextureHandle CreateTexture(const unsigned char* pixels,
+                                                uint32_t width,
+                                                uint32_t height,
+                                                uint32_t channels,
+                                                uint32_t bpp = 4);
+
+    /**
+    * Загрузка импортированной модели в память устройства (см. KGEModelImporter)
+    * @param const kge::assets::ModelData &model - модель в памяти хоста
+    * @return kge::vkstructs::Model - хендлы геометрии (с уровнями детализации), узлы и текстуры модели
+    * @note - все текстуры модели загружаются одной отправкой команд через общий промежуточный буфер
+    */
+    kge::vkstructs::Model UploadModel(const kge::assets::ModelData &model);
+
+    /**
+    * Загрузка модели из пакета ресурсов (.kgepak, см. сборщик пакетов kgecook)
+    * @param const KGEPackage &package - открытый пакет
+    * @param const std::string &name - имя модели в пакете (путь к файлу модели, переданный сборщику)
+    * @return kge::vkstructs::Model - хендлы геометрии (с уровнями детализации) и текстуры модели
+    * @note - бросает исключение, если модели нет в пакете либо пакет собран для другого формата вершин
+    */
+    kge::vkstructs::Model LoadPackagedModel(const KGEPackage &package, const std::string &name);
+
+    /**
+    * Добавление примитивов модели (по одному на узел, с уровнями детализации; узлы с одной сеткой разделяют геометрию)
+    * @param const kge::vkstructs::Model &model - загруженная модель
+    * @param glm::vec3 position - положение относительно глобального центра
+    * @param glm::vec3 rotaton - вращение вокруг локального центра
+    * @return std::vector<kge::vkstructs::PrimitiveHandle> - хендлы примитивов в порядке узлов модели
+    */
+    std::vector<kge::vkstructs::PrimitiveHandle> AddModel(const kge::vkstructs::Model &model,
+                                                          glm::vec3 position,
+                                                          glm::vec3 rotaton);
+
+    /**
+    * Добавление примитива одного узла модели (см. AddModel)
+    * @param const kge::vkstructs::Model &model - загруженная модель
+    * @param std::size_t node - индекс в model.nodes
+    * @param glm::vec3 position - положение модели относительно глобального центра
+    * @param glm::vec3 rotaton - вращение модели вокруг ее начала
+    * @return kge::vkstructs::PrimitiveHandle - хендл примитива
+    */
+    kge::vkstructs::PrimitiveHandle AddModelNode(const kge::vkstructs::Model &model,
+                                                 std::size_t node,
+                                                 glm::vec3 position,
+                                                 glm::vec3 rotaton);
+
+    /**
+    * Освобождение ссылок модели на геометрию (геометрия удаляется когда на нее не ссылается ни один примитив)
+    * @param kge::vkstructs::Model &model - модель (после вызова без сеток; текстуры остаются - на них ссылаются примитивы)
+    */
+    void ReleaseModel(kge::vkstructs::Model &model);
+
+    /**
+    * Замена геометрии и текстуры примитива (преобразование, место в иерархии и анимация сохраняются)
+    * @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+    * @param kge::vkstructs::MeshHandle mesh - новая геометрия (уровни детализации примитива сбрасываются)
+    * @param kge::vkstructs::TextureHandle texture - хендл новой текстуры
+    * @note - ссылки на прежнюю геометрию освобождаются после перезаписи командных буферов
+    */
+    void SetPrimitiveMesh(kge::vkstructs::PrimitiveHandle primitive,
+                          kge::vkstructs::MeshHandle mesh,
+                          kge::vkstructs::TextureHandle texture);
+
+    /**
+    * Замена содержимого текстуры на месте (примитивы, ссылающиеся на текстуру, получают новое изображение)
+    * @param kge::vkstructs::TextureHandle texture - хендл заменяемой текстуры (остается действительным)
+    * @param const kge::vkstructs::TextureSource &source - новые пиксели (RGBA)
+    * @note - прежние изображение и набор дескрипторов удаляются, когда устройство завершит кадры, которые их читают
+    */
+    void ReplaceTexture(kge::vkstructs::TextureHandle texture, const kge::vkstructs::TextureSource &source);
+
+    /**
+    * Удаление текстуры, на которую более не ссылается ни один примитив
+    * @param kge::vkstructs::TextureHandle texture - хендл текстуры (после удаления устаревает)
+    * @note - ресурсы устройства удаляются, когда устройство завершит кадры, которые их читают
+    */
+    void ReleaseTexture(kge::vkstructs::TextureHandle texture);
+
+    /**
+    * Удаление текстур, на которые более не ссылается ни один примитив
+    * @param std::vector<kge::vkstructs::TextureHandle> &textures - хендлы текстур (после вызова массив пуст)
+    */
+    void ReleaseTextures(std::vector<kge::vkstructs::TextureHandle> &textures);
+
+    /**
+    * Существует ли текстура (хендл не устарел)
+    */
+    bool TextureAlive(kge::vkstructs::TextureHandle texture) const;
+
+    /**
+    * Перезагрузка шейдеров (пересоздание графических конвейеров из файлов SHADERS_DIRECTORY)
+    * @return bool - false если шейдер не загрузился либо конвейер не создался (прежние конвейеры остаются в работе)
+    * @note - прежние конвейеры удаляются после перезаписи командных буферов, ожидания очередей нет
+    */
+    bool ReloadShaders();
     ~KGEVulkanCore();
 private:
 
     bool m_isReady;                      // Состояние готовности к рендерингу
     bool m_isRendering;                  // В процессе ли рендеринг
-    unsigned int m_primitivesMaxCount;   // Максимальное кол-во примитивов (необходимо для аллокации динамического UBO буфера)
+    unsigned int m_primitivesCapacity;   // Вместимость массива матриц моделей и динамического UBO буфера (растет вдвое при нехватке)
+    KGEJobSystem* m_jobSystem;           // Система задач (параллельное обновление матриц и т.д.)
+    MODEL_DATA_PATH m_modelDataPath;     // Способ передачи матрицы модели в шейдер
+    CULLING_MODE m_cullingMode;          // Способ отсечения (CullingGpu заменяется на CullingCpu если устройство не поддерживает косвенную отрисовку)
+    VERTEX_LAYOUT m_vertexLayout;        // Формат вершин в буферах геометрии (общий для всех конвейеров)
+    float m_lodPixelError = LOD_PIXEL_ERROR;  // Допустимое отклонение упрощенной геометрии на экране (в пикселях)
 
     uint32_t m_width;
     uint32_t m_heigh;
@@ -172,8 +451,8 @@ private:
     //Аллокация глобального uniform-буфера
     KGEVkUniformBufferWorld m_kgeVkUniformBufferWorld;
 
-    // Аллокация uniform-буфера отдельных объектов (динамический буфер)
-    KGEVkUniformBufferModels m_kgeVkUniformBufferModels;
+    // Аллокация uniform-буфера отдельных объектов (динамический буфер, пересоздается при росте кол-ва примитивов)
+    std::unique_ptr<KGEVkUniformBufferModels> m_kgeVkUniformBufferModels;
 
     // Создание дескрипторного пула для выделения текстурного набора (текстурные семплеры)
     KGEVkDescriptorPool m_kgeVkDescriptorPoolMain;
@@ -181,6 +460,10 @@ private:
     // Создание дескрипторного пула для выделения текстурного набора (текстурные семплеры)
     KGEVkDescriptorPool m_kgeVkDescriptorPoolTextures;
 
+    /* Deferred deletion */
+    // Удаляется раньше пулов, командного пула и устройства - освобожденные ресурсы еще могут ссылаться на них
+    KGEVkDeletionQueue m_kgeVkDeletionQueue;
+
     /* Descriptor set layout*/
     KGEVkDescriptorSetLayout m_kgeVkDescriptorSetLayoutMain;
 
@@ -190,7 +473,7 @@ private:
     KGEVkSampler m_kgeVkSampler;
 
     /* Descriptor Set*/
-    KGEVkDescriptorSet m_kgeVkDescriptorSet;
+    std::unique_ptr<KGEVkDescriptorSet> m_kgeVkDescriptorSet;
 
     /* Pipeline Layout */
     KGEVkPipelineLayout m_kgeVkPipelineLayout;
@@ -206,7 +489,62 @@ private:
     kge::vkstructs::Synchronization m_sync;                 // Примитивы синхронизации
     KGEVkSynchronization m_kgeVkSynchronization;
 
-    std::vector<kge::vkstructs::Primitive> m_primitives;     // Набор геометр. примитивов для отображения
+    /* Instancing */
+    std::unique_ptr<KGEVkInstanceBuffer> m_kgeVkInstanceBuffer;              // Буфер матриц экземпляров (пересоздается при росте)
+    std::unique_ptr<KGEVkGraphicsPipeline> m_kgeVkGraphicsPipelineInstanced; // Конвейер экземпляризированной отрисовки (создается при первом использовании)
+    std::vector<kge::vkstructs::InstancedPrimitive> m_instancedPrimitives;  // Набор экземпляризированных примитивов
+
+    /* Meshes */
+    KGEVkMeshRegistry m_kgeVkMeshRegistry;                   // Реестр геометрии (общие буферы вершин и индексов)
+
+    /* Residency */
+    KGEVkResidency m_kgeVkResidency;                         // Бюджеты куч памяти и последнее использование текстур и геометрии
+
+    /* Textures */
+    KGEHandlePool<kge::vkstructs::Texture, kge::vkstructs::TextureTag> m_textures;  // Текстуры (удаляются в деструкторе рендерера, до пулов дескрипторов)
+
+    /* Entities */
+    KGEEcsWorld m_ecsWorld;                                  // Сущности сцены (компоненты примитивов хранятся по архетипам)
+    std::vector<kge::ecs::Entity> m_primitives;              // Сущности геометр. примитивов для отображения (по позиции, у свободных - хендл по умолчанию)
+    std::vector<uint32_t> m_primitiveGenerations;            // Поколения позиций (растут при удалении примитива)
+    std::vector<uint32_t> m_freePrimitiveSlots;              // Свободные позиции (занимаются в первую очередь)
+    std::chrono::steady_clock::time_point m_lastUpdateTime = std::chrono::steady_clock::now();  // Время предыдущего Update (для анимации)
+    KGESceneGraph m_sceneGraph;                              // Иерархия преобразований (узел на каждый примитив)
+
+    /* Culling */
+    KGEFrustumCuller m_frustumCuller;                        // Ограничивающие сферы примитивов (индекс сферы = позиция примитива)
+    std::vector<uint32_t> m_visiblePrimitives;               // Позиции примитивов прошедших отсечение (список отрисовки)
+    std::vector<uint32_t> m_visibleSet;                      // Те же позиции по возрастанию (набор видимых, для сравнения)
+    std::vector<uint32_t> m_cullResult;                      // Результат отсечения текущего кадра (для сравнения с предыдущим)
+    unsigned int m_drawListVersion = 0;                      // Версия списка отрисовки (растет при его изменении)
+    unsigned int m_sortedDrawListVersion = 0;                // Версия списка, с которой он отсортирован
+    std::vector<unsigned int> m_recordedDrawListVersion;     // Версия списка, с которой записан командный буфер каждого изображения
+    kge::math::Frustum m_frustum;                            // Пирамида видимости текущего кадра
+
+    /* Draw order */
+    std::vector<uint64_t> m_drawSortKeys;                    // Ключи сортировки списка отрисовки
+    std::vector<uint64_t> m_drawSortKeysScratch;             // Временные массивы поразрядной сортировки
+    std::vector<uint32_t> m_drawSortScratch;
+    kge::vkstructs::DrawStats m_drawStats;                   // Статистика последней записи команд
+    KGEBvh m_bvh;                                            // Иерархия AABB примитивов (для пространственных запросов)
+    bool m_bvhDirty = true;                                  // Иерархию нужно перестроить (добавлены либо удалены примитивы)
+    std::vector<uint32_t> m_bvhObjectSlots;                  // Позиция примитива по индексу объекта иерархии
+    std::vector<uint32_t> m_slotBvhObjects;                  // Индекс объекта иерархии по позиции примитива
+
+    /* Retired resources */
+    std::vector<uint64_t> m_frameSerials;                    // Номер отправки (см. KGEVkDeletionQueue) последнего кадра каждого набора семафоров
+    uint64_t m_modelBufferSerial = 0;                        // Номер последнего отправленного кадра при создании буфера матриц моделей
+    std::vector<kge::vkstructs::PendingUpload> m_pendingUploads;  // Загрузки, отправленные без ожидания (см. CollectUploads)
+
+    /* GPU culling */
+    std::unique_ptr<KGEVkGpuCulling> m_kgeVkGpuCulling;                 // Проход GPU-отсечения (только в режиме CullingGpu)
+    std::vector<kge::vkstructs::GpuCullObject> m_gpuCullObjects;        // Описания индексированных примитивов для прохода отсечения
+    std::vector<kge::vkstructs::GpuDrawBatch> m_gpuDrawBatches;         // Пакеты косвенной отрисовки (геометрия + текстура)
+    unsigned int m_gpuCullObjectsVersion = 0;                           // Версия описаний (растет при их изменении)
+    bool m_gpuDrawBatchesDirty = false;                                 // Пакеты нужно пересобрать до ближайшей записи команд
+    std::vector<unsigned int> m_uploadedGpuCullObjectsVersion;          // Версия описаний в области каждого изображения
+    uint32_t m_primitiveInstanceOffset = 0;                             // Начало матриц обычных примитивов в области буфера экземпляров
+
     kge::vkstructs::UboWorld m_uboWorld;                     // Структура с матрицами для общих преобразований сцены (данный объект буедт передаваться в буфер формы сцены)
 
     /**
@@ -217,7 +555,7 @@ private:
     * @param VkDescriptorSet descriptorSet - хендл набор дескрипторов, исппользуется при привязке дескрипторов
     * @param VkPipeline pipeline - хендл конвейера, используется при привязке конвейера
     * @param const kge::vkstructs::Swapchain &swapchain - свопчейн, используется при конфигурации начала прохода (в.ч. для указания фрейм-буфера)
-    * @param const std::vector<kge::vkstructs::Primitive> &primitives - массив примитивов (привязка буферов вершин, буферов индексов для каждого и т.д)
+    * @param const std::vector<kge::ecs::Entity> &primitives - сущности примитивов (привязка буферов вершин, буферов индексов для каждого и т.д)
     *
     * @note - данную операцию нет нужды выполнять при каждом обновлении кадра, набор команд как правило относительно неизменный. Метод лишь заполняет
     * буферы команд, а сама отправка происходть в draw. При изменении кол-ва примитивов следует сбросить командные буферы и заново их заполнить
@@ -229,7 +567,22 @@ private:
                              VkDescriptorSet descriptorSetMain,
                              VkPipeline pipeline,
                              const kge::vkstructs::Swapchain &swapchain,
-                             const std::vector<kge::vkstructs::Primitive> &primitives);
+                             const std::vector<kge::ecs::Entity> &primitives);
+
+    /**
+    * Запись команд отрисовки в один командный буфер
+    * @param VkCommandBuffer commandBuffer - хендл командного буфера
+    * @param unsigned int imageIndex - индекс изображения swap-chain (фрейм-буфер и области uniform-буферов)
+    * @note - остальные параметры аналогичны PrepareDrawCommands
+    */
+    void RecordDrawCommands(VkCommandBuffer commandBuffer,
+                            unsigned int imageIndex,
+                            VkRenderPass renderPass,
+                            VkPipelineLayout pipelineLayout,
+                            VkDescriptorSet descriptorSetMain,
+                            VkPipeline pipeline,
+                            const kge::vkstructs::Swapchain &swapchain,
+                            const std::vector<kge::ecs::Entity> &primitives);
 
     /**
     * Сброс командных буферов (для перезаписи)
@@ -239,6 +592,116 @@ private:
     void ResetCommandBuffers(const kge::vkstructs::Device &device,
                              std::vector<VkCommandBuffer> commandBuffers);
 
+    /**
+    * Распределение экземпляров по буферу экземпляров (вычисление firstInstance каждого экземпляризированного примитива)
+    */
+    void LayoutInstances();
+
+    /**
+    * Создание конвейера экземпляризированной отрисовки (если он еще не создан)
+    */
+    void CreateInstancedPipeline();
+
+    /**
+    * Выделение и заполнение текстурного набора дескрипторов (изображение текстуры уже в размещении для чтения шейдером)
+    */
+    void AllocateTextureDescriptorSet(kge::vkstructs::Texture &texture);
+
+    /**
+    * Освобождение командных и промежуточных буферов завершенных загрузок (заборы опрашиваются без ожидания)
+    */
+    void CollectUploads();
+
+    /**
+    * Отправка команд загрузки без ожидания очереди (буферы освобождаются в CollectUploads)
+    */
+    void SubmitUpload(VkCommandBuffer commandBuffer, const kge::vkstructs::Buffer &staging, std::function<void()> completed);
+
+    /**
+    * Создание набора текстур одной отправкой команд (общий промежуточный буфер, копирование буфер -> изображение)
+    * @param const std::vector<kge::vkstructs::TextureSource> &sources - текстуры (RGBA, с мип-уровнями либо без)
+    * @return std::vector<kge::vkstructs::TextureHandle> - хендлы текстур в порядке источников
+    */
+    std::vector<kge::vkstructs::TextureHandle> CreateTextures(const std::vector<kge::vkstructs::TextureSource> &sources);
+
+    /**
+    * Регистрация геометрии из блока пакета
+    * @param const KGEPackage &package - пакет
+    * @param uint64_t nameHash - хеш имени блока геометрии
+    * @param float* geometricError - отклонение уровня детализации (может быть nullptr)
+    * @return kge::vkstructs::MeshHandle - хендл геометрии
+    */
+    kge::vkstructs::MeshHandle RegisterPackagedMesh(const KGEPackage &package, uint64_t nameHash, float* geometricError);
+
+    /**
+    * Группировка индексированных примитивов в пакеты косвенной отрисовки и подготовка описаний для GPU-отсечения
+    */
+    void RebuildGpuDrawBatches();
+
+    /**
+    * Сортировка списка отрисовки по ключам (конвейер, текстура, геометрия, глубина)
+    * @param std::vector<uint32_t> &drawList - индексы примитивов
+    */
+    void SortDrawList(std::vector<uint32_t> &drawList);
+
+    /**
+    * Вытеснение давно не использовавшихся текстур и геометрии, когда локальная куча устройства подходит к бюджету
+    */
+    void EnforceMemoryBudget();
+
+    /**
+    * Отбрасывание верхнего мип-уровня текстур (изображение вдвое меньше по каждой стороне, без нового чтения источника)
+    * @param const std::vector<kge::vkstructs::TextureHandle> &textures - хендлы текстур
+    */
+    void DropTextureMips(const std::vector<kge::vkstructs::TextureHandle> &textures);
+
+    /**
+    * Подготовка иерархии AABB к запросам (перестроение после добавления примитивов либо уточнение границ перемещенных)
+    */
+    void SyncBvh();
+
+    /**
+    * Сущность примитива по хендлу
+    * @note - бросает исключение, если хендл недействителен
+    */
+    kge::ecs::Entity PrimitiveEntity(kge::vkstructs::PrimitiveHandle primitive) const;
+
+    /**
+    * Увеличение вместимости массива матриц моделей и uniform-буфера моделей
+    * @param unsigned int capacity - новая вместимость (кол-во матриц)
+    */
+    void GrowModelBuffer(unsigned int capacity);
+
+    /**
+    * Увеличение вместимости буфера экземпляров и буферов прохода GPU-отсечения
+    * @param std::size_t requiredInstances - необходимое кол-во матриц в буфере экземпляров
+    */
+    void GrowInstanceBuffers(std::size_t requiredInstances);
+
+    /**
+    * Выбор уровней детализации примитивов по отклонению, спроецированному на экран
+    */
+    void SelectLods();
+
+    /**
+    * Запись косвенной отрисовки пакетов (команды пишет проход GPU-отсечения)
+    * @param VkCommandBuffer commandBuffer - хендл командного буфера (внутри прохода рендеринга)
+    * @param unsigned int imageIndex - индекс изображения swap-chain
+    * @param VkPipelineLayout pipelineLayout - хендл размещения конвейера
+    * @param VkDescriptorSet descriptorSetMain - основной набор дескрипторов
+    */
+    void RecordGpuDrawBatches(VkCommandBuffer commandBuffer,
+                              unsigned int imageIndex,
+                              VkPipelineLayout pipelineLayout,
+                              VkDescriptorSet descriptorSetMain);
+
+    /**
+    * Копирование подготовленных в Update данных (матрицы сцены и моделей) в области uniform-буферов
+    * @param unsigned int regionIndex - индекс области (совпадает с индексом изображения swap-chain)
+    * @note - вызывается только после ожидания забора кадра, последним использовавшего эту область
+    */
+    void UploadUniformRegion(unsigned int regionIndex);
+
     kge::vkstructs::CameraSettings m_camera;
 };
 
@@ -0,0 +1,44 @@
+#ifndef KGEVKDELETIONQUEUE_H
+#define KGEVKDELETIONQUEUE_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <graphic/KGEVulkan.h>
+
+class KGEVkDeletionQueue
+{
+    struct Entry
+    {
+        uint64_t frame;                     // Номер последнего отправленного кадра на момент освобождения
+        std::function<void()> destroy;
+    };
+
+    const kge::vkstructs::Device* m_device;
+    std::deque<Entry> m_entries;            // Номера кадров не убывают - освобождается префикс очереди
+    uint64_t m_submittedFrame;              // Номер последнего отправленного кадра
+    uint64_t m_completedFrame;              // Номер последнего завершенного кадра
+
+    void Push(std::function<void()> destroy);
+public:
+    KGEVkDeletionQueue(const kge::vkstructs::Device* device);
+    ~KGEVkDeletionQueue();
+    KGEVkDeletionQueue(const KGEVkDeletionQueue&) = delete;
+    KGEVkDeletionQueue& operator=(const KGEVkDeletionQueue&) = delete;
+
+    void DestroyBuffer(const kge::vkstructs::Buffer &buffer);
+    void DestroyImage(const kge::vkstructs::Image &image);
+    void DestroyImageView(VkImageView imageView);
+    void FreeDescriptorSet(VkDescriptorPool descriptorPool, VkDescriptorSet descriptorSet);
+    void DestroyPipeline(VkPipeline pipeline);
+    void DestroyTexture(const kge::vkstructs::Texture &texture, VkDescriptorPool descriptorPool);
+    void Release(std::shared_ptr<void> object);
+    void Defer(std::function<void()> destroy);
+
+    uint64_t FrameSubmitted();
+    void FrameCompleted(uint64_t frame);
+    void Flush();
+    std::size_t pendingCount() const;
+};
+
+#endif // KGEVKDELETIONQUEUE_H
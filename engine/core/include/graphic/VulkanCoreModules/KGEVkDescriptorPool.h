@@ -3,6 +3,9 @@
 
 #include <graphic/KGEVulkan.h>
 
+// Кол-во основных наборов дескрипторов: текущий и наборы, ожидающие освобождения после роста буфера матриц моделей
+#define DESCRIPTOR_SETS_MAIN_MAX_COUNT 4
+
 class KGEVkDescriptorPool
 {
     VkDescriptorPool m_descriptorPool;
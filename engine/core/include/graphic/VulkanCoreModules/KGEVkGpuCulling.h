@@ -0,0 +1,51 @@
+#ifndef KGEVKGPUCULLING_H
+#define KGEVKGPUCULLING_H
+
+#include <graphic/KGEVulkan.h>
+#include <math/KGEFrustumCuller.h>
+
+class KGEVkGpuCulling
+{
+    const kge::vkstructs::Device* m_device;
+    unsigned int m_maxObjects;
+
+    kge::vkstructs::Buffer m_objectsBuffer;     // Описания объектов (хост-когерентный, по области на изображение)
+    void* m_objectsMapped;
+    VkDeviceSize m_objectsRegionSize;
+
+    kge::vkstructs::Buffer m_frustumBuffer;     // Плоскости пирамиды видимости (uniform, хост-когерентный, по области на изображение)
+    void* m_frustumMapped;
+    VkDeviceSize m_frustumRegionSize;
+
+    kge::vkstructs::Buffer m_commandsBuffer;    // Команды косвенной отрисовки (память устройства)
+    VkDeviceSize m_commandsRegionSize;
+
+    kge::vkstructs::Buffer m_countsBuffer;      // Кол-ва команд пакетов (память устройства)
+    VkDeviceSize m_countsRegionSize;
+
+    VkDescriptorSetLayout m_descriptorSetLayout;
+    VkDescriptorPool m_descriptorPool;
+    std::vector<VkDescriptorSet> m_descriptorSets;
+    VkPipelineLayout m_pipelineLayout;
+    VkPipeline m_pipeline;
+
+    VkDeviceSize AlignStorage(VkDeviceSize size) const;
+    VkDeviceSize AlignUniform(VkDeviceSize size) const;
+public:
+    KGEVkGpuCulling(const kge::vkstructs::Device* device,
+                    unsigned int maxObjects,
+                    unsigned int regionCount,
+                    VkBuffer instanceBuffer,
+                    VkDeviceSize instanceRegionSize);
+    ~KGEVkGpuCulling();
+    void UploadObjects(unsigned int regionIndex, const std::vector<kge::vkstructs::GpuCullObject> &objects);
+    void UploadFrustum(unsigned int regionIndex, const kge::math::Frustum &frustum);
+    void RecordCull(VkCommandBuffer commandBuffer, unsigned int regionIndex, unsigned int objectCount, unsigned int batchCount, bool compact);
+    unsigned int maxObjects() const;
+    VkBuffer commandsBuffer() const;
+    VkDeviceSize commandsRegionOffset(unsigned int regionIndex) const;
+    VkBuffer countsBuffer() const;
+    VkDeviceSize countsRegionOffset(unsigned int regionIndex) const;
+};
+
+#endif // KGEVKGPUCULLING_H
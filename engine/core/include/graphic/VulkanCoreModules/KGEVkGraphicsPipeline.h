@@ -11,9 +11,17 @@ public:
     KGEVkGraphicsPipeline(const kge::vkstructs::Device* device,
                           VkPipelineLayout pipelineLayout,
                           const kge::vkstructs::Swapchain &swapchain,
-                          VkRenderPass renderPass);
+                          VkRenderPass renderPass,
+                          VERTEX_LAYOUT vertexLayout,
+                          std::string vertexShaderFile = "vert.spv",
+                          bool instanced = false);
     ~KGEVkGraphicsPipeline();
     VkPipeline pipeline() const;
+
+    /**
+    * Обмен хендлами с другим конвейером (замена конвейера на месте, напр. при перезагрузке шейдеров)
+    */
+    void Swap(KGEVkGraphicsPipeline &other);
 };
 
 #endif // KGEVKGRAPHICSPIPELINE_H
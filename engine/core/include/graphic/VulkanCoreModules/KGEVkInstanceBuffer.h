@@ -0,0 +1,25 @@
+#ifndef KGEVKINSTANCEBUFFER_H
+#define KGEVKINSTANCEBUFFER_H
+
+#include <graphic/KGEVulkan.h>
+
+class KGEVkInstanceBuffer
+{
+    const kge::vkstructs::Device* m_device;
+    kge::vkstructs::Buffer m_instanceBuffer;
+    void* m_pMapped;
+    VkDeviceSize m_regionSize;
+    unsigned int m_maxInstances;
+public:
+    KGEVkInstanceBuffer(const kge::vkstructs::Device* device,
+                        unsigned int maxInstances,
+                        unsigned int regionCount);
+    ~KGEVkInstanceBuffer();
+    VkBuffer instanceBuffer() const;
+    unsigned int maxInstances() const;
+    VkDeviceSize regionSize() const;
+    VkDeviceSize regionOffset(unsigned int regionIndex) const;
+    glm::mat4* region(unsigned int regionIndex) const;
+};
+
+#endif // KGEVKINSTANCEBUFFER_H
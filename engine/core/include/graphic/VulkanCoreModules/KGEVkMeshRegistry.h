@@ -0,0 +1,41 @@
+#ifndef KGEVKMESHREGISTRY_H
+#define KGEVKMESHREGISTRY_H
+
+#include <unordered_map>
+#include <graphic/KGEVulkan.h>
+#include <graphic/VulkanCoreModules/KGEVkDeletionQueue.h>
+
+class KGEVkMeshRegistry
+{
+    const kge::vkstructs::Device* m_device;
+    VERTEX_LAYOUT m_vertexLayout;                                            // Формат вершин в буферах
+    KGEVkDeletionQueue* m_deletionQueue;                                     // Очередь удаления буферов освобожденной геометрии
+    bool m_hostHeapAvailable;                                                // Есть доступная хосту память вне локальных куч устройства (см. Demote)
+    KGEHandlePool<kge::vkstructs::Mesh, kge::vkstructs::MeshTag> m_meshes;   // Загруженная геометрия (плотно, доступ по хендлу)
+    std::unordered_multimap<uint64_t, kge::vkstructs::MeshHandle> m_hashIndex; // Хеш содержимого -> хендл
+
+    std::vector<unsigned char> m_vertexBytes;                                // Упакованные вершины и индексы регистрируемой геометрии
+    std::vector<unsigned char> m_indexBytes;                                 // (хранятся между вызовами, чтобы не аллоцировать заново)
+
+    void CreateBuffers(kge::vkstructs::Mesh &mesh,
+                       const kge::vkstructs::EncodedMesh &encoded);
+    void DestroyBuffers(kge::vkstructs::Mesh &mesh);
+    bool ContentEquals(const kge::vkstructs::Mesh &mesh,
+                       const kge::vkstructs::EncodedMesh &encoded) const;
+public:
+    KGEVkMeshRegistry(const kge::vkstructs::Device* device, VERTEX_LAYOUT vertexLayout, KGEVkDeletionQueue* deletionQueue);
+    ~KGEVkMeshRegistry();
+    kge::vkstructs::MeshHandle Register(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                        const std::vector<unsigned int> &indices);
+    kge::vkstructs::MeshHandle RegisterEncoded(const kge::vkstructs::EncodedMesh &encoded);
+    void AddRef(kge::vkstructs::MeshHandle handle);
+    void Release(kge::vkstructs::MeshHandle handle);
+    const kge::vkstructs::Mesh& mesh(kge::vkstructs::MeshHandle handle) const;
+    unsigned int meshCount() const;
+    VkDeviceSize memoryUsed() const;
+    std::vector<kge::vkstructs::MeshHandle> handles() const;
+    VkDeviceSize Demote(kge::vkstructs::MeshHandle handle);
+    VERTEX_LAYOUT vertexLayout() const;
+};
+
+#endif // KGEVKMESHREGISTRY_H
@@ -8,7 +8,8 @@ class KGEVkPipelineLayout
     VkPipelineLayout m_pipelineLayout;
 public:
     KGEVkPipelineLayout(const kge::vkstructs::Device* device,
-                        std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+                        std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                        std::vector<VkPushConstantRange> pushConstantRanges = {});
     ~KGEVkPipelineLayout();
     VkPipelineLayout pipelineLayout() const;
 };
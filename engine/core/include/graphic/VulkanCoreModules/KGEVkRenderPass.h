@@ -14,6 +14,11 @@ public:
                     VkFormat depthStencilFormat);
     ~KGEVkRenderPass();
     VkRenderPass renderPass() const;
+
+    /**
+    * Обмен хендлами с другим проходом рендеринга (пересоздание на месте, напр. при смене разрешения)
+    */
+    void Swap(KGEVkRenderPass &other);
 };
 
 #endif // KGEVKRENDERPASS_H
@@ -0,0 +1,53 @@
+#ifndef KGEVKRESIDENCY_H
+#define KGEVKRESIDENCY_H
+
+#include <graphic/KGEVulkan.h>
+
+// Доля бюджета кучи, выше которой начинается вытеснение (запас до превышения бюджета)
+#define RESIDENCY_BUDGET_TARGET 0.9f
+
+// Сколько кадров ресурс не должен использоваться, чтобы его можно было вытеснить
+#define RESIDENCY_IDLE_FRAMES 120
+
+// Минимальный интервал между проходами вытеснения в кадрах (бюджет драйвера обновляется с задержкой)
+#define RESIDENCY_EVICTION_INTERVAL 30
+
+// Наибольшая сторона текстуры, до которой отбрасываются верхние мип-уровни
+#define RESIDENCY_MIN_TEXTURE_SIZE 64
+
+class KGEVkResidency
+{
+    /**
+    * Последнее использование ресурса (по ячейке пула; хендл - чтобы распознать новый ресурс в той же ячейке)
+    */
+    struct Use
+    {
+        uint32_t handle = 0;
+        uint64_t frame = 0;
+    };
+
+    const kge::vkstructs::Device* m_device;
+    float m_budgetTarget;                                  // Доля бюджета, выше которой начинается вытеснение
+    uint64_t m_frame;                                      // Номер текущего кадра
+    uint64_t m_evictionFrame;                              // Кадр последнего прохода вытеснения
+    std::vector<kge::vkstructs::HeapBudget> m_heaps;       // Бюджеты куч текущего кадра
+    std::vector<Use> m_textureUses;                        // По ячейке пула текстур
+    std::vector<Use> m_meshUses;                           // По ячейке пула геометрии
+
+    void Touch(std::vector<Use> &uses, uint32_t handle, uint32_t slot);
+    uint64_t LastUse(std::vector<Use> &uses, uint32_t handle, uint32_t slot);
+public:
+    KGEVkResidency(const kge::vkstructs::Device* device, float budgetTarget = RESIDENCY_BUDGET_TARGET);
+    ~KGEVkResidency();
+    void BeginFrame();
+    void TouchTexture(kge::vkstructs::TextureHandle texture);
+    void TouchMesh(kge::vkstructs::MeshHandle mesh);
+    bool TextureIdle(kge::vkstructs::TextureHandle texture, uint64_t* lastUse);
+    bool MeshIdle(kge::vkstructs::MeshHandle mesh, uint64_t* lastUse);
+    VkDeviceSize Overcommit(uint32_t heap) const;
+    bool EvictionDue() const;
+    void EvictionDone();
+    const std::vector<kge::vkstructs::HeapBudget>& heaps() const;
+};
+
+#endif // KGEVKRESIDENCY_H
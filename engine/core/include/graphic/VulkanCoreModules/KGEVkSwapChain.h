@@ -14,9 +14,14 @@ public:
                    VkFormat depthStencilFormat,
                    VkRenderPass renderPass,
                    unsigned int bufferCount,
-                   kge::vkstructs::Swapchain * oldSwapchain = nullptr);
+                   const kge::vkstructs::Swapchain * oldSwapchain = nullptr);
     ~KGEVkSwapChain();
     const kge::vkstructs::Swapchain& swapchain();
+
+    /**
+    * Обмен хендлами с другим swap-chain (пересоздание на месте, напр. при смене разрешения)
+    */
+    void Swap(KGEVkSwapChain &other);
 };
 
 #endif // KGEVKSWAPCHAIN_H
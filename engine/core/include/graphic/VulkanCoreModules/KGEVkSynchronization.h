@@ -9,7 +9,9 @@ class KGEVkSynchronization
     const kge::vkstructs::Device* m_device;
 public:
     KGEVkSynchronization(kge::vkstructs::Synchronization* sync,
-                         const kge::vkstructs::Device* device);
+                         const kge::vkstructs::Device* device,
+                         unsigned int framesInFlight,
+                         unsigned int imageCount);
     ~KGEVkSynchronization();
 };
 
@@ -7,11 +7,14 @@ class KGEVkUboModels
 {
     kge::vkstructs::UboModelArray* m_uboModels; // Массив матриц (указатель на него) для отдельный объектов (матрицы модели, передаются в буфер формы объектов)
     const kge::vkstructs::Device* m_device;
+    unsigned int m_maxObjects;                  // Вместимость массива (кол-во матриц)
 public:
     KGEVkUboModels(kge::vkstructs::UboModelArray* uboModels,
                    const kge::vkstructs::Device* device,
                    unsigned int maxObjects);
     ~KGEVkUboModels();
+    void Resize(unsigned int maxObjects);
+    unsigned int maxObjects() const;
 };
 
 #endif // KGEVKUBOMODELS_H
@@ -9,7 +9,8 @@ class KGEVkUniformBufferModels
 public:
     kge::vkstructs::UniformBuffer m_uniformBufferModels;
     KGEVkUniformBufferModels(const kge::vkstructs::Device* device,
-                             unsigned int maxObjects);
+                             unsigned int maxObjects,
+                             unsigned int regionCount);
     ~KGEVkUniformBufferModels();
 //    kge::vkstructs::UniformBuffer &uniformBufferModels();
 };
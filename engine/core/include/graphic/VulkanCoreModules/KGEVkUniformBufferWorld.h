@@ -8,7 +8,8 @@ class KGEVkUniformBufferWorld
     const kge::vkstructs::Device* m_device;
     kge::vkstructs::UniformBuffer m_uniformBufferWorld;
 public:
-    KGEVkUniformBufferWorld(const kge::vkstructs::Device* device);
+    KGEVkUniformBufferWorld(const kge::vkstructs::Device* device,
+                            unsigned int regionCount);
     ~KGEVkUniformBufferWorld();
     kge::vkstructs::UniformBuffer *uniformBufferWorld();
 };
@@ -0,0 +1,309 @@
+#include "assets/KGEAssetHotReload.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+KGEAssetHotReload::KGEAssetHotReload(KGEVulkanCore* renderer, KGEJobSystem* jobSystem):
+    m_renderer{renderer},
+    m_jobSystem{jobSystem},
+    m_importer{jobSystem}
+{
+    if (!m_watcher.available()) {
+        throw std::runtime_error("HotReload: File watching is not supported on this platform");
+    }
+}
+
+KGEAssetHotReload::~KGEAssetHotReload()
+{
+    // Рабочие потоки пишут в данные незавершенных задач - освобождать их можно только после завершения
+    for (std::unique_ptr<PendingModel> &pending : m_pendingModels) {
+        m_jobSystem->Wait(&pending->counter);
+    }
+    for (std::unique_ptr<PendingTexture> &pending : m_pendingTextures) {
+        m_jobSystem->Wait(&pending->counter);
+    }
+}
+
+void KGEAssetHotReload::WatchShaders(const std::string &directory)
+{
+    Watch(CanonicalPath(directory));
+    m_watchShaders = true;
+}
+
+unsigned int KGEAssetHotReload::LoadModel(const std::string &file, glm::vec3 position, glm::vec3 rotaton)
+{
+    KGE_PROFILE_ZONE("KGEAssetHotReload::LoadModel");
+    std::string path = CanonicalPath(file);
+
+    kge::assets::ModelData data = std::move(m_importer.Import({ path })[0]);
+
+    std::unique_ptr<ModelRecord> record = std::make_unique<ModelRecord>();
+    record->file = path;
+    record->position = position;
+    record->rotation = rotaton;
+    record->model = m_renderer->UploadModel(data);
+    record->primitives = m_renderer->AddModel(record->model, position, rotaton);
+
+    unsigned int model = static_cast<unsigned int>(m_models.size());
+    m_models.push_back(std::move(record));
+    m_modelFiles[path] = model;
+
+    Watch(std::filesystem::path(path).parent_path().string());
+    RegisterTextures(model, data);
+
+    return model;
+}
+
+const std::vector<kge::vkstructs::PrimitiveHandle>& KGEAssetHotReload::primitives(unsigned int model) const
+{
+    return m_models.at(model)->primitives;
+}
+
+/**
+* Применение изменений
+* @note - изменения шейдеров применяются сразу (конвейеры создаются за время одного кадра), модели и текстуры -
+* по завершении импорта, не дожидаясь его (Update не блокирует основной поток)
+*/
+void KGEAssetHotReload::Update()
+{
+    KGE_PROFILE_ZONE("KGEAssetHotReload::Update");
+    bool shadersChanged = false;
+
+    for (const std::string &path : m_watcher.Poll()) {
+        if (m_watchShaders && std::filesystem::path(path).extension() == ".spv") {
+            shadersChanged = true;
+            continue;
+        }
+
+        auto model = m_modelFiles.find(path);
+        if (model != m_modelFiles.end()) {
+            StartModelReload(model->second);
+            continue;
+        }
+
+        // Копия записей - перезагрузка модели перестраивает таблицу текстур
+        std::vector<TextureRecord> textures;
+        auto range = m_textureFiles.equal_range(path);
+        for (auto it = range.first; it != range.second; ++it) {
+            textures.push_back(it->second);
+        }
+
+        for (const TextureRecord &texture : textures) {
+            // Текстура, которая не загрузилась с моделью, не имеет места в модели - модель загружается заново
+            if (texture.texture == NO_TEXTURE) {
+                StartModelReload(texture.model);
+            }
+            else {
+                StartTextureReload(texture);
+            }
+        }
+    }
+
+    if (shadersChanged) {
+        m_renderer->ReloadShaders();
+    }
+
+    // Замена модели может запустить ее повторный импорт (список незавершенных пополняется) - завершенные забираются заранее
+    std::vector<std::unique_ptr<PendingModel>> completed;
+    for (auto it = m_pendingModels.begin(); it != m_pendingModels.end();) {
+        if ((*it)->counter.IsDone()) {
+            completed.push_back(std::move(*it));
+            it = m_pendingModels.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (std::unique_ptr<PendingModel> &pending : completed) {
+        ApplyModel(*pending);
+    }
+
+    for (auto it = m_pendingTextures.begin(); it != m_pendingTextures.end();) {
+        if ((*it)->counter.IsDone()) {
+            ApplyTexture(**it);
+            it = m_pendingTextures.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+/**
+* Слежение за каталогом (каждый каталог - один раз)
+*/
+void KGEAssetHotReload::Watch(const std::string &directory)
+{
+    if (m_watchedDirectories.insert(directory).second) {
+        m_watcher.WatchDirectory(directory);
+    }
+}
+
+/**
+* Запоминание файлов текстур модели (встроенные в файл модели текстуры перезагружаются вместе с моделью)
+* @note - индексы в Model::textures сдвинуты на кол-во предшествующих текстур, которые не загрузились (см. KGEVulkanCore::UploadModel)
+*/
+void KGEAssetHotReload::RegisterTextures(unsigned int model, const kge::assets::ModelData &data)
+{
+    for (auto it = m_textureFiles.begin(); it != m_textureFiles.end();) {
+        if (it->second.model == model) {
+            it = m_textureFiles.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    std::filesystem::path directory = std::filesystem::path(m_models[model]->file).parent_path();
+    std::size_t uploaded = 0;
+
+    for (const kge::assets::TextureData &texture : data.textures) {
+        TextureRecord record;
+        record.model = model;
+        record.texture = texture.pixels.empty() ? NO_TEXTURE : uploaded++;
+        record.name = texture.name;
+
+        if (texture.name.empty() || texture.name[0] == '*') {
+            continue;
+        }
+
+        std::string path = CanonicalPath((directory / texture.name).string());
+        Watch(std::filesystem::path(path).parent_path().string());
+        m_textureFiles.emplace(path, std::move(record));
+    }
+}
+
+void KGEAssetHotReload::StartModelReload(unsigned int model)
+{
+    ModelRecord &record = *m_models[model];
+    if (record.reloading) {
+        record.changedWhileReloading = true;
+        return;
+    }
+
+    record.reloading = true;
+
+    std::unique_ptr<PendingModel> pending = std::make_unique<PendingModel>();
+    pending->model = model;
+    m_importer.ImportAsync(record.file, pending->data, &pending->counter);
+    m_pendingModels.push_back(std::move(pending));
+}
+
+void KGEAssetHotReload::StartTextureReload(const TextureRecord &texture)
+{
+    std::unique_ptr<PendingTexture> pending = std::make_unique<PendingTexture>();
+    pending->model = texture.model;
+    pending->version = m_models[texture.model]->version;
+    pending->texture = texture.texture;
+    pending->data.name = texture.name;
+
+    std::string directory = std::filesystem::path(m_models[texture.model]->file).parent_path().string();
+    kge::assets::TextureData* data = &pending->data;
+    m_jobSystem->Run([data, directory]() { KGEModelImporter::DecodeTexture(*data, directory); }, &pending->counter);
+
+    m_pendingTextures.push_back(std::move(pending));
+}
+
+/**
+* Замена модели импортированной заново
+* @note - примитивы модели (по одному на узел) получают новую геометрию на месте (преобразования, иерархия и анимация
+* сохраняются). Если узлов стало больше - недостающие примитивы добавляются относительно положения, с которым модель
+* была загружена, если меньше - лишние удаляются. Примитивы, удаленные пользователем, не восстанавливаются
+*/
+void KGEAssetHotReload::ApplyModel(PendingModel &pending)
+{
+    KGE_PROFILE_ZONE("KGEAssetHotReload::ApplyModel");
+    ModelRecord &record = *m_models[pending.model];
+    record.reloading = false;
+
+    if (record.changedWhileReloading) {
+        // Результат уже устарел
+        record.changedWhileReloading = false;
+        StartModelReload(pending.model);
+        return;
+    }
+
+    if (!pending.data.error.empty()) {
+        KGE_LOG_WARNING("HotReload: {}. Previous version of the model is kept", pending.data.error);
+        return;
+    }
+
+    kge::vkstructs::Model previous = std::move(record.model);
+    record.model = m_renderer->UploadModel(pending.data);
+
+    std::vector<kge::vkstructs::PrimitiveHandle> primitives;
+    for (std::size_t i = 0; i < record.model.nodes.size(); i++) {
+        if (i >= record.primitives.size()) {
+            primitives.push_back(m_renderer->AddModelNode(record.model, i, record.position, record.rotation));
+            continue;
+        }
+
+        kge::vkstructs::PrimitiveHandle primitive = record.primitives[i];
+        primitives.push_back(primitive);
+        if (!m_renderer->PrimitiveAlive(primitive)) {
+            continue;
+        }
+
+        const kge::vkstructs::ModelMesh &mesh = record.model.meshes[record.model.nodes[i].mesh];
+        kge::vkstructs::TextureHandle texture = mesh.texture >= 0 ? record.model.textures[mesh.texture] : kge::vkstructs::INVALID_TEXTURE_HANDLE;
+        m_renderer->SetPrimitiveMesh(primitive, mesh.mesh, texture);
+        if (!mesh.lods.empty()) {
+            m_renderer->SetPrimitiveLods(primitive, mesh.lods);
+        }
+    }
+
+    for (std::size_t i = record.model.nodes.size(); i < record.primitives.size(); i++) {
+        if (m_renderer->PrimitiveAlive(record.primitives[i])) {
+            m_renderer->RemovePrimitive(record.primitives[i]);
+        }
+    }
+
+    record.primitives = std::move(primitives);
+    record.version++;
+
+    // На прежние сетки и текстуры больше не ссылается ни один примитив
+    m_renderer->ReleaseModel(previous);
+    m_renderer->ReleaseTextures(previous.textures);
+
+    RegisterTextures(pending.model, pending.data);
+
+    KGE_LOG_INFO("HotReload: Model {} reloaded", record.file);
+}
+
+void KGEAssetHotReload::ApplyTexture(PendingTexture &pending)
+{
+    KGE_PROFILE_ZONE("KGEAssetHotReload::ApplyTexture");
+    ModelRecord &record = *m_models[pending.model];
+
+    // Модель заменена после запуска декодирования - у новой модели свои текстуры
+    if (pending.version != record.version) {
+        return;
+    }
+
+    if (pending.data.pixels.empty()) {
+        KGE_LOG_WARNING("HotReload: Can't decode texture {}. Previous version is kept", pending.data.name);
+        return;
+    }
+
+    kge::vkstructs::TextureSource source;
+    source.width = pending.data.width;
+    source.height = pending.data.height;
+    source.mips.push_back({ pending.data.pixels.data(), static_cast<VkDeviceSize>(pending.data.pixels.size()) });
+
+    m_renderer->ReplaceTexture(record.model.textures[pending.texture], source);
+
+    KGE_LOG_INFO("HotReload: Texture {} reloaded", pending.data.name);
+}
+
+/**
+* Путь в том виде, в котором его сообщает наблюдатель (абсолютный, без "." и ".." - наблюдение ставится на такие же пути)
+*/
+std::string KGEAssetHotReload::CanonicalPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(path), error);
+    return error ? path : canonical.string();
+}
@@ -0,0 +1,363 @@
+#include "assets/KGEModelImporter.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <mesh/KGEMeshOptimizer.h>
+#include <KGEutilityl.h>
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+    // Смещение позиции внутри вершины (для оптимизатора сеток)
+    const std::size_t POSITION_OFFSET = offsetof(kge::vkstructs::Vertex, position);
+
+    const float* Positions(const std::vector<kge::vkstructs::Vertex> &vertices)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(vertices.data()) + POSITION_OFFSET);
+    }
+
+    // Матрица Assimp (по строкам) в матрицу glm (по столбцам)
+    glm::mat4 ToMatrix(const aiMatrix4x4 &matrix)
+    {
+        return glm::mat4(matrix.a1, matrix.b1, matrix.c1, matrix.d1,
+                         matrix.a2, matrix.b2, matrix.c2, matrix.d2,
+                         matrix.a3, matrix.b3, matrix.c3, matrix.d3,
+                         matrix.a4, matrix.b4, matrix.c4, matrix.d4);
+    }
+
+    /**
+    * Перевод сетки Assimp в вершины и индексы движка
+    * @note - преобразование применяется к позициям (нормали шейдерами пока не используются), для разделяемых сеток
+    * оно единичное. Грани, не являющиеся треугольниками (точки и линии остаются после aiProcess_Triangulate), отбрасываются
+    */
+    void ConvertMesh(const aiMesh* source,
+                     const aiMatrix4x4 &transform,
+                     const glm::vec3 &materialColor,
+                     int32_t texture,
+                     kge::assets::MeshData &mesh)
+    {
+        mesh.name = source->mName.C_Str();
+        mesh.texture = texture;
+        mesh.levels.resize(1);
+
+        kge::assets::MeshLevelData &level = mesh.levels[0];
+        level.vertices.resize(source->mNumVertices);
+        for (unsigned int i = 0; i < source->mNumVertices; i++) {
+            kge::vkstructs::Vertex &vertex = level.vertices[i];
+
+            aiVector3D position = transform * source->mVertices[i];
+            vertex.position = glm::vec3(position.x, position.y, position.z);
+
+            if (source->HasVertexColors(0)) {
+                const aiColor4D &color = source->mColors[0][i];
+                vertex.color = glm::vec3(color.r, color.g, color.b);
+            }
+            else {
+                vertex.color = materialColor;
+            }
+
+            if (source->HasTextureCoords(0)) {
+                vertex.texCoord = glm::vec2(source->mTextureCoords[0][i].x, source->mTextureCoords[0][i].y);
+            }
+            else {
+                vertex.texCoord = glm::vec2(0.0f, 0.0f);
+            }
+
+            vertex.textureUsed = texture >= 0 ? 1 : 0;
+        }
+
+        level.indices.reserve(static_cast<std::size_t>(source->mNumFaces) * 3);
+        for (unsigned int i = 0; i < source->mNumFaces; i++) {
+            const aiFace &face = source->mFaces[i];
+            if (face.mNumIndices == 3) {
+                level.indices.insert(level.indices.end(), face.mIndices, face.mIndices + 3);
+            }
+        }
+    }
+
+    /**
+    * Текстура материала (диффузная). Одинаковые пути в пределах модели дают одну текстуру
+    * @return int32_t - индекс в model.textures (-1 если у материала нет текстуры)
+    */
+    int32_t MaterialTexture(const aiScene* scene,
+                            const aiMaterial* material,
+                            std::unordered_map<std::string, int32_t> &texturesByName,
+                            kge::assets::ModelData &model)
+    {
+        aiString path;
+        if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) != AI_SUCCESS) {
+            return -1;
+        }
+
+        std::string name = path.C_Str();
+        auto found = texturesByName.find(name);
+        if (found != texturesByName.end()) {
+            return found->second;
+        }
+
+        kge::assets::TextureData texture;
+        texture.name = name;
+
+        // Встроенная в файл модели текстура ("*N" - индекс в aiScene::mTextures)
+        if (!name.empty() && name[0] == '*') {
+            unsigned int embeddedIndex = static_cast<unsigned int>(std::atoi(name.c_str() + 1));
+            if (embeddedIndex >= scene->mNumTextures) {
+                return -1;
+            }
+
+            const aiTexture* embedded = scene->mTextures[embeddedIndex];
+
+            // mHeight == 0 - сжатые данные (png, jpg...) размером mWidth байт, иначе - пиксели в формате BGRA
+            if (embedded->mHeight == 0) {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(embedded->pcData);
+                texture.encoded.assign(bytes, bytes + embedded->mWidth);
+            }
+            else {
+                texture.width = embedded->mWidth;
+                texture.height = embedded->mHeight;
+                texture.pixels.resize(static_cast<std::size_t>(texture.width) * texture.height * 4);
+                for (std::size_t i = 0; i < static_cast<std::size_t>(texture.width) * texture.height; i++) {
+                    texture.pixels[i * 4 + 0] = embedded->pcData[i].r;
+                    texture.pixels[i * 4 + 1] = embedded->pcData[i].g;
+                    texture.pixels[i * 4 + 2] = embedded->pcData[i].b;
+                    texture.pixels[i * 4 + 3] = embedded->pcData[i].a;
+                }
+            }
+        }
+
+        int32_t index = static_cast<int32_t>(model.textures.size());
+        model.textures.push_back(std::move(texture));
+        texturesByName.emplace(name, index);
+        return index;
+    }
+}
+
+KGEModelImporter::KGEModelImporter(KGEJobSystem* jobSystem, uint32_t lodLevels):
+    m_jobSystem{jobSystem},
+    m_lodLevels{std::max(1u, std::min(lodLevels, kge::vkstructs::MESH_LOD_MAX_LEVELS))}
+{
+}
+
+/**
+* Загрузка модели
+* @note - задача разбора файла порождает задачи обработки сеток и текстур с тем же счетчиком, поэтому счетчик
+* обнуляется только после завершения всех этапов. Порожденные задачи ссылаются на элементы model.meshes и model.textures,
+* поэтому массивы заполняются полностью до их постановки
+*/
+void KGEModelImporter::ImportAsync(const std::string &file, kge::assets::ModelData &model, kge::jobs::Counter* signal)
+{
+    m_jobSystem->Run([this, file, &model, signal]() {
+        KGE_PROFILE_ZONE("KGEModelImporter::ImportAsync read scene");
+        model.file = file;
+
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(file, ASSIMP_LOAD_FLAGS);
+        if (scene == nullptr || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || scene->mRootNode == nullptr) {
+            model.error = "Importer: Can't load model " + file + ". " + importer.GetErrorString();
+            return;
+        }
+
+        // Материалы - цвет (для вершин без цвета) и текстура
+        std::unordered_map<std::string, int32_t> texturesByName;
+        std::vector<glm::vec3> materialColors(scene->mNumMaterials, glm::vec3(1.0f, 1.0f, 1.0f));
+        std::vector<int32_t> materialTextures(scene->mNumMaterials, -1);
+        for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+            aiColor3D diffuse(1.0f, 1.0f, 1.0f);
+            if (scene->mMaterials[i]->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == AI_SUCCESS) {
+                materialColors[i] = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+            }
+            materialTextures[i] = MaterialTexture(scene, scene->mMaterials[i], texturesByName, model);
+        }
+
+        // Перевод сетки с заданным преобразованием (-1 - в сетке нет треугольников)
+        auto addMesh = [&](const aiMesh* source, const aiMatrix4x4 &transform) -> int32_t {
+            model.meshes.emplace_back();
+            ConvertMesh(source,
+                        transform,
+                        materialColors[source->mMaterialIndex],
+                        materialTextures[source->mMaterialIndex],
+                        model.meshes.back());
+
+            if (model.meshes.back().levels[0].indices.empty()) {
+                model.meshes.pop_back();
+                return -1;
+            }
+            return static_cast<int32_t>(model.meshes.size() - 1);
+        };
+
+        // Обход иерархии узлов с накоплением преобразований. Сетка переводится один раз и разделяется всеми узлами,
+        // которые на нее ссылаются - преобразование узла остается на примитиве. В вершины оно запекается, только если
+        // его не представить переносом, поворотом и масштабом (сдвиг) - тогда у узла своя копия сетки
+        std::vector<int32_t> sharedMeshes(scene->mNumMeshes, -1);
+        std::vector<bool> converted(scene->mNumMeshes, false);
+        std::vector<std::pair<const aiNode*, aiMatrix4x4>> stack = { { scene->mRootNode, scene->mRootNode->mTransformation } };
+        while (!stack.empty()) {
+            const aiNode* node = stack.back().first;
+            aiMatrix4x4 transform = stack.back().second;
+            stack.pop_back();
+
+            kge::vkstructs::Transform placement;
+            bool representable = placement.Decompose(ToMatrix(transform));
+
+            for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+                unsigned int sourceIndex = node->mMeshes[i];
+                const aiMesh* source = scene->mMeshes[sourceIndex];
+                if ((source->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
+                    continue;
+                }
+
+                kge::vkstructs::ModelNode instance;
+                if (representable) {
+                    if (!converted[sourceIndex]) {
+                        sharedMeshes[sourceIndex] = addMesh(source, aiMatrix4x4());
+                        converted[sourceIndex] = true;
+                    }
+                    if (sharedMeshes[sourceIndex] < 0) {
+                        continue;
+                    }
+                    instance.mesh = static_cast<uint32_t>(sharedMeshes[sourceIndex]);
+                    instance.position = placement.position;
+                    instance.rotation = placement.rotation;
+                    instance.scale = placement.scale;
+                }
+                else {
+                    int32_t baked = addMesh(source, transform);
+                    if (baked < 0) {
+                        continue;
+                    }
+                    instance.mesh = static_cast<uint32_t>(baked);
+                }
+                model.nodes.push_back(instance);
+            }
+
+            for (unsigned int i = 0; i < node->mNumChildren; i++) {
+                stack.emplace_back(node->mChildren[i], transform * node->mChildren[i]->mTransformation);
+            }
+        }
+
+        // Тяжелая обработка - отдельными задачами (сцена Assimp им уже не нужна)
+        std::string directory = std::filesystem::path(file).parent_path().string();
+        for (kge::assets::MeshData &mesh : model.meshes) {
+            m_jobSystem->Run([this, &mesh]() { ProcessMesh(mesh); }, signal);
+        }
+        for (kge::assets::TextureData &texture : model.textures) {
+            m_jobSystem->Run([&texture, directory]() { DecodeTexture(texture, directory); }, signal);
+        }
+    }, signal);
+}
+
+std::vector<kge::assets::ModelData> KGEModelImporter::Import(const std::vector<std::string> &files)
+{
+    KGE_PROFILE_ZONE("KGEModelImporter::Import");
+    std::vector<kge::assets::ModelData> models(files.size());
+
+    kge::jobs::Counter counter;
+    for (std::size_t i = 0; i < files.size(); i++) {
+        ImportAsync(files[i], models[i], &counter);
+    }
+    m_jobSystem->Wait(&counter);
+
+    for (const kge::assets::ModelData &model : models) {
+        if (!model.error.empty()) {
+            throw std::runtime_error(model.error);
+        }
+    }
+
+    return models;
+}
+
+/**
+* Оптимизация сетки и построение уровней детализации
+* @note - каждый уровень упрощается из исходной геометрии (ошибки не накапливаются), затем оптимизируется
+* и сжимается до используемых вершин - реестр геометрии хранит уровни как независимые сетки
+*/
+void KGEModelImporter::ProcessMesh(kge::assets::MeshData &mesh) const
+{
+    KGE_PROFILE_ZONE("KGEModelImporter::ProcessMesh");
+    mesh.levels.reserve(m_lodLevels);
+
+    kge::assets::MeshLevelData &base = mesh.levels[0];
+    kge::mesh::OptimizeMesh(base.vertices, base.indices, POSITION_OFFSET);
+
+    if (m_lodLevels < 2) {
+        return;
+    }
+
+    // Радиус описанной сферы (допустимое отклонение задается относительно размера сетки)
+    glm::vec3 boundsMin = base.vertices[0].position;
+    glm::vec3 boundsMax = base.vertices[0].position;
+    for (const kge::vkstructs::Vertex &vertex : base.vertices) {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    float maxError = glm::length(boundsMax - boundsMin) * 0.5f * MODEL_IMPORT_LOD_MAX_ERROR;
+
+    const uint32_t vertexCount = static_cast<uint32_t>(base.vertices.size());
+    std::size_t previousCount = base.indices.size();
+    for (uint32_t level = 1; level < m_lodLevels; level++) {
+        std::size_t targetCount = static_cast<std::size_t>(previousCount * MODEL_IMPORT_LOD_REDUCTION) / 3 * 3;
+        if (targetCount < 3) {
+            break;
+        }
+
+        kge::assets::MeshLevelData lod;
+        lod.geometricError = kge::mesh::Simplify(base.indices, Positions(base.vertices), sizeof(kge::vkstructs::Vertex),
+                                                 vertexCount, targetCount, maxError, lod.indices);
+
+        if (lod.indices.empty() || lod.indices.size() > previousCount * (1.0f - MODEL_IMPORT_LOD_MIN_GAIN)) {
+            break;
+        }
+
+        lod.vertices = base.vertices;
+        kge::mesh::OptimizeMesh(lod.vertices, lod.indices, POSITION_OFFSET);
+
+        previousCount = lod.indices.size();
+        mesh.levels.push_back(std::move(lod));
+    }
+}
+
+/**
+* Декодирование текстуры (файл рядом с моделью либо встроенные сжатые данные)
+* @note - текстура, которую не удалось декодировать, остается пустой (сетки с ней рисуются без текстуры)
+*/
+void KGEModelImporter::DecodeTexture(kge::assets::TextureData &texture, const std::string &directory)
+{
+    KGE_PROFILE_ZONE("KGEModelImporter::DecodeTexture");
+    if (!texture.pixels.empty()) {
+        return;
+    }
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char* pixels = nullptr;
+
+    if (!texture.encoded.empty()) {
+        pixels = stbi_load_from_memory(texture.encoded.data(), static_cast<int>(texture.encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+        texture.encoded.clear();
+        texture.encoded.shrink_to_fit();
+    }
+    else {
+        std::filesystem::path path = std::filesystem::path(directory) / texture.name;
+        pixels = stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    }
+
+    if (pixels == nullptr) {
+        KGE_LOG_WARNING("Importer: Can't decode texture {}", texture.name);
+        return;
+    }
+
+    texture.width = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+    texture.pixels.assign(pixels, pixels + static_cast<std::size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+}
@@ -1,11 +1,16 @@
 #include <core.h>
 
+#include <cstdlib>
+
 Core::Core():
+    m_profileTrace{StartProfiling()},
+    m_kgeJobSystem{},
     m_kgeAppData{},
     m_kgeAppication{
         m_kgeAppData.applicationWidth(),
         m_kgeAppData.applicationHeight(),
-        m_kgeAppData.applicationName()
+        m_kgeAppData.applicationName(),
+        &m_kgeJobSystem
         }
 {
     m_kgeAppication.Init();
@@ -15,4 +20,35 @@ Core::Core():
     }
 }
 
-Core::~Core() {}
+Core::~Core()
+{
+    if (m_profileTrace.empty()) {
+        return;
+    }
+
+    try {
+        KGEProfiler::Instance().ExportChromeTrace(m_profileTrace);
+        KGE_LOG_INFO("Profiler: Trace written to {}", m_profileTrace);
+    }
+    catch (const std::exception &ex) {
+        KGE_LOG_ERROR("{}", ex.what());
+    }
+}
+
+/**
+* Включение профилировщика, если задана переменная окружения KGE_PROFILE_TRACE (путь к файлу трассы)
+* @return std::string - путь к файлу трассы (трасса записывается при завершении, включая инициализацию)
+* @note - вызывается до создания остальных членов, поэтому в трассу попадает и запуск
+*/
+std::string Core::StartProfiling()
+{
+    KGEProfiler::Instance().SetThreadName("Main");
+
+    const char* trace = std::getenv("KGE_PROFILE_TRACE");
+    if (trace == nullptr || trace[0] == '\0') {
+        return "";
+    }
+
+    KGEProfiler::Instance().Enable(true);
+    return trace;
+}
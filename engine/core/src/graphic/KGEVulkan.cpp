@@ -2,10 +2,53 @@
 #include <filesystem>
 #include <cstring>
 #include <ctime>
+#include <mutex>
 #include <pwd.h>
 #include <unistd.h>
+#include <unordered_map>
 namespace fs = std::filesystem;
 
+namespace
+{
+    /**
+    * Выделение памяти устройства (куча и размер нужны при освобождении - vkFreeMemory их не сообщает)
+    */
+    struct DeviceAllocation
+    {
+        uint32_t heap;
+        VkDeviceSize size;
+    };
+
+    std::mutex deviceAllocationsMutex;
+    std::unordered_map<VkDeviceMemory, DeviceAllocation> deviceAllocations;
+
+    VKAPI_ATTR void* VKAPI_CALL HostAllocation(void*, size_t size, size_t alignment, VkSystemAllocationScope)
+    {
+        return KGEMemoryTracker::Allocate(kge::memory::TagVulkan, size, alignment);
+    }
+
+    VKAPI_ATTR void* VKAPI_CALL HostReallocation(void*, void* original, size_t size, size_t alignment, VkSystemAllocationScope)
+    {
+        return KGEMemoryTracker::Reallocate(kge::memory::TagVulkan, original, size, alignment);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL HostFree(void*, void* memory)
+    {
+        KGEMemoryTracker::Free(memory);
+    }
+
+    // Уведомления о памяти, которую драйвер выделил сам (напр. исполняемый код конвейеров)
+    VKAPI_ATTR void VKAPI_CALL HostInternalAllocation(void*, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+    {
+        KGEMemoryTracker::Track(kge::memory::TagVulkan, size);
+    }
+
+    VKAPI_ATTR void VKAPI_CALL HostInternalFree(void*, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+    {
+        KGEMemoryTracker::Untrack(kge::memory::TagVulkan, size);
+    }
+}
+
 /**
 * Проверка поддержки расширений устройства
 * @param deviceExtensionsNames - масив c-строчек содержащих имена расширений
@@ -325,10 +368,11 @@ kge::vkstructs::SurfaceInfo kge::vkutility::GetSurfaceInfo(VkPhysicalDevice phys
 * @param physicalDevice - хендл физического устройства информацю о возможных типах памяти которого нужно получить
 * @param unsigned int typeFlags - побитовая маска с флагами типов запрашиваемой памяти
 * @param VkMemoryPropertyFlags properties - параметры запрашиваемой памяти
+* @param VkMemoryHeapFlags excludedHeapFlags - типы памяти из куч с этими флагами пропускаются
 * @return int - возвращает индекс типа памяти, который соответствует всем условиям
 * @note - данный метод используется, например, при создании буферов
 */
-int kge::vkutility::GetMemoryTypeIndex(VkPhysicalDevice physicalDevice, unsigned int typeFlags, VkMemoryPropertyFlags properties)
+int kge::vkutility::GetMemoryTypeIndex(VkPhysicalDevice physicalDevice, unsigned int typeFlags, VkMemoryPropertyFlags properties, VkMemoryHeapFlags excludedHeapFlags)
 {
     // Получить настройки памяти физического устройства
     VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
@@ -338,7 +382,8 @@ int kge::vkutility::GetMemoryTypeIndex(VkPhysicalDevice physicalDevice, unsigned
     // Для опредения нужного индекса типа памяти использются побитовые операции, подробнее о побитовых операциях - https://ravesli.com/urok-45-pobitovye-operatory/
     for (unsigned int i = 0; i < deviceMemoryProperties.memoryTypeCount; i++)
     {
-        if ((typeFlags & (1 << i)) && (deviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        if ((typeFlags & (1 << i)) && (deviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties &&
+                (deviceMemoryProperties.memoryHeaps[deviceMemoryProperties.memoryTypes[i].heapIndex].flags & excludedHeapFlags) == 0)
         {
             return i;
         }
@@ -348,6 +393,150 @@ int kge::vkutility::GetMemoryTypeIndex(VkPhysicalDevice physicalDevice, unsigned
     return -1;
 }
 
+/**
+* Обработчики выделения памяти хоста для объектов Vulkan
+* @return const VkAllocationCallbacks* - обработчики (общие для всех объектов) либо nullptr, если учет выключен
+*/
+const VkAllocationCallbacks* kge::vkutility::HostAllocator()
+{
+#if KGE_VULKAN_HOST_CALLBACKS
+    static const VkAllocationCallbacks callbacks = {
+        nullptr,
+        HostAllocation,
+        HostReallocation,
+        HostFree,
+        HostInternalAllocation,
+        HostInternalFree
+    };
+    return &callbacks;
+#else
+    return nullptr;
+#endif
+}
+
+/**
+* Регистрация куч памяти устройства в учете памяти
+* @param VkPhysicalDevice physicalDevice - физическое устройство
+*/
+void kge::vkutility::RegisterMemoryHeaps(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        KGEMemoryTracker::SetDeviceHeap(i,
+                                        memoryProperties.memoryHeaps[i].size,
+                                        (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0);
+    }
+}
+
+/**
+* Выделение памяти устройства с учетом по кучам
+* @param const vkstructs::Device &device - устройство
+* @param const VkMemoryAllocateInfo &allocateInfo - параметры выделения
+* @param VkDeviceMemory* memory - результат
+* @return VkResult - результат vkAllocateMemory
+*
+* @note - куча определяется по типу памяти; выделение запоминается, чтобы снять его с учета при освобождении
+*/
+VkResult kge::vkutility::AllocateMemory(const kge::vkstructs::Device &device, const VkMemoryAllocateInfo &allocateInfo, VkDeviceMemory* memory)
+{
+    VkResult result = vkAllocateMemory(device.logicalDevice, &allocateInfo, vkutility::HostAllocator(), memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(device.physicalDevice, &memoryProperties);
+    uint32_t heap = memoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].heapIndex;
+
+    {
+        std::lock_guard<std::mutex> lock(deviceAllocationsMutex);
+        deviceAllocations[*memory] = { heap, allocateInfo.allocationSize };
+    }
+    KGEMemoryTracker::TrackDevice(heap, allocateInfo.allocationSize);
+
+    return result;
+}
+
+/**
+* Освобождение памяти устройства со снятием с учета кучи
+* @param VkDevice logicalDevice - логическое устройство
+* @param VkDeviceMemory memory - память (nullptr допускается)
+*/
+void kge::vkutility::FreeMemory(VkDevice logicalDevice, VkDeviceMemory memory)
+{
+    if (memory == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(deviceAllocationsMutex);
+        auto found = deviceAllocations.find(memory);
+        if (found != deviceAllocations.end()) {
+            KGEMemoryTracker::UntrackDevice(found->second.heap, found->second.size);
+            deviceAllocations.erase(found);
+        }
+    }
+
+    vkFreeMemory(logicalDevice, memory, vkutility::HostAllocator());
+}
+
+/**
+* Куча, из которой выделена память
+* @param VkDeviceMemory memory - память
+* @return uint32_t - индекс кучи (UINT32_MAX - память выделена в обход AllocateMemory)
+*/
+uint32_t kge::vkutility::MemoryHeap(VkDeviceMemory memory)
+{
+    std::lock_guard<std::mutex> lock(deviceAllocationsMutex);
+    auto found = deviceAllocations.find(memory);
+    return found != deviceAllocations.end() ? found->second.heap : UINT32_MAX;
+}
+
+/**
+* Текущие бюджеты и потребление куч памяти устройства
+* @param const vkstructs::Device &device - устройство
+* @param std::vector<vkstructs::HeapBudget> &budgets - результат (по куче на элемент)
+*
+* @note - с VK_EXT_memory_budget значения сообщает драйвер (бюджет учитывает память, занятую другими процессами,
+* и обновляется с задержкой). Без расширения бюджет - доля размера кучи KGE_MEMORY_BUDGET_FALLBACK, а потребление -
+* память, выделенная через AllocateMemory
+*/
+void kge::vkutility::GetHeapBudgets(const kge::vkstructs::Device &device, std::vector<kge::vkstructs::HeapBudget> &budgets)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    if (device.getMemoryProperties2 != nullptr) {
+        VkPhysicalDeviceMemoryProperties2KHR memoryProperties2 = {};
+        memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        memoryProperties2.pNext = &budgetProperties;
+        device.getMemoryProperties2(device.physicalDevice, &memoryProperties2);
+        memoryProperties = memoryProperties2.memoryProperties;
+    }
+    else {
+        vkGetPhysicalDeviceMemoryProperties(device.physicalDevice, &memoryProperties);
+    }
+
+    budgets.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        vkstructs::HeapBudget &budget = budgets[i];
+        budget.size = memoryProperties.memoryHeaps[i].size;
+        budget.deviceLocal = (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+        if (device.getMemoryProperties2 != nullptr) {
+            budget.budget = budgetProperties.heapBudget[i];
+            budget.usage = budgetProperties.heapUsage[i];
+        }
+        else {
+            budget.budget = static_cast<VkDeviceSize>(static_cast<double>(budget.size) * KGE_MEMORY_BUDGET_FALLBACK);
+            budget.usage = KGEMemoryTracker::deviceHeap(i).usage.current;
+        }
+    }
+}
+
 /**
 * Создание буфера
 * @param vkstructs::Device &device - устройство в памяти которого, либо с доступном для которого, будет создаваться буфер
@@ -361,7 +550,8 @@ kge::vkstructs::Buffer kge::vkutility::CreateBuffer(const kge::vkstructs::Device
                                                     VkDeviceSize size,
                                                     VkBufferUsageFlags usage,
                                                     VkMemoryPropertyFlags properties,
-                                                    VkSharingMode sharingMode)
+                                                    VkSharingMode sharingMode,
+                                                    VkMemoryHeapFlags excludedHeapFlags)
 {
     // Объект буфера что будет отдан функцией
     vkstructs::Buffer resultBuffer;
@@ -378,7 +568,7 @@ kge::vkstructs::Buffer kge::vkutility::CreateBuffer(const kge::vkstructs::Device
     bufferInfo.flags = 0;
 
     // Попытка создания буфера
-    if (vkCreateBuffer(device.logicalDevice, &bufferInfo, nullptr, &(resultBuffer.vkBuffer)) != VK_SUCCESS)
+    if (vkCreateBuffer(device.logicalDevice, &bufferInfo, kge::vkutility::HostAllocator(), &(resultBuffer.vkBuffer)) != VK_SUCCESS)
     {
         throw std::runtime_error("Vulkan: Error while creating buffer. Can't create!");
     }
@@ -388,7 +578,7 @@ kge::vkstructs::Buffer kge::vkutility::CreateBuffer(const kge::vkstructs::Device
     vkGetBufferMemoryRequirements(device.logicalDevice, resultBuffer.vkBuffer, &memRequirements);
 
     // Получить индекс типа памяти соответствующего требованиям буфера
-    int memoryTypeIndex = vkutility::GetMemoryTypeIndex(device.physicalDevice, memRequirements.memoryTypeBits, properties);
+    int memoryTypeIndex = vkutility::GetMemoryTypeIndex(device.physicalDevice, memRequirements.memoryTypeBits, properties, excludedHeapFlags);
     if (memoryTypeIndex < 0)
     {
         throw std::runtime_error("Vulkan: Error while creating buffer. Can't find suitable memory type!");
@@ -401,7 +591,7 @@ kge::vkstructs::Buffer kge::vkutility::CreateBuffer(const kge::vkstructs::Device
     memoryAllocateInfo.memoryTypeIndex = static_cast<unsigned int>(memoryTypeIndex);
 
     // Выделение памяти для буфера
-    if (vkAllocateMemory(device.logicalDevice, &memoryAllocateInfo, nullptr, &(resultBuffer.vkDeviceMemory)) != VK_SUCCESS)
+    if (vkutility::AllocateMemory(device, memoryAllocateInfo, &(resultBuffer.vkDeviceMemory)) != VK_SUCCESS)
     {
         throw std::runtime_error("Vulkan: Error while allocating buffer memory!");
     }
@@ -422,6 +612,7 @@ kge::vkstructs::Buffer kge::vkutility::CreateBuffer(const kge::vkstructs::Device
 * @param VkImageUsageFlags usage - использование изображения (в качестве чего, назначение)
 * @param VkImageAspectFlags subresourceRangeAspect - использование области подресурса (???)
 * @param VkSharingMode sharingMode - настройка доступа к памяти изображения для очередей (VK_SHARING_MODE_EXCLUSIVE - с буфером работает одна очередь)
+* @param uint32_t mipLevels - кол-во мип-уровней (view-объект охватывает все уровни)
 */
 kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::Device &device,
                                                         VkImageType imageType,
@@ -432,12 +623,14 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
                                                         VkImageLayout initialLayout,
                                                         VkMemoryPropertyFlags memoryProperties,
                                                         VkImageTiling tiling,
-                                                        VkSharingMode sharingMode)
+                                                        VkSharingMode sharingMode,
+                                                        uint32_t mipLevels)
 {
     // Результирующий объект изображения
     vkstructs::Image resultImage;
     resultImage.extent = extent;
     resultImage.format = format;
+    resultImage.mipLevels = mipLevels;
 
     // Конфигурация изображения
     VkImageCreateInfo imageInfo = {};
@@ -446,7 +639,7 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
     imageInfo.imageType = imageType;
     imageInfo.format = format;
     imageInfo.extent = extent;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.tiling = tiling;
@@ -455,7 +648,7 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
     imageInfo.initialLayout = initialLayout;
 
     // Создание изображения
-    if (vkCreateImage(device.logicalDevice, &imageInfo, nullptr, &(resultImage.vkImage)) != VK_SUCCESS)
+    if (vkCreateImage(device.logicalDevice, &imageInfo, kge::vkutility::HostAllocator(), &(resultImage.vkImage)) != VK_SUCCESS)
     {
         throw std::runtime_error("Vulkan: Error while creating image");
     }
@@ -470,9 +663,10 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
     memoryAllocInfo.allocationSize = memReqs.size;
     memoryAllocInfo.memoryTypeIndex = static_cast<uint32_t>(vkutility::GetMemoryTypeIndex(device.physicalDevice, memReqs.memoryTypeBits, memoryProperties));
     memoryAllocInfo.pNext = nullptr;
+    resultImage.memorySize = memReqs.size;
 
     // Аллоцировать
-    if (vkAllocateMemory(device.logicalDevice, &memoryAllocInfo, nullptr, &(resultImage.vkDeviceMemory)) != VK_SUCCESS)
+    if (vkutility::AllocateMemory(device, memoryAllocInfo, &(resultImage.vkDeviceMemory)) != VK_SUCCESS)
     {
         throw std::runtime_error("Vulkan: Error while allocating memory for image");
     }
@@ -502,13 +696,13 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
     imageViewInfo.subresourceRange = {};
     imageViewInfo.subresourceRange.aspectMask = subresourceRangeAspect;
     imageViewInfo.subresourceRange.baseMipLevel = 0;
-    imageViewInfo.subresourceRange.levelCount = 1;
+    imageViewInfo.subresourceRange.levelCount = mipLevels;
     imageViewInfo.subresourceRange.baseArrayLayer = 0;
     imageViewInfo.subresourceRange.layerCount = 1;
     imageViewInfo.image = resultImage.vkImage;
 
     // Создание view-обхекта
-    if (vkCreateImageView(device.logicalDevice, &imageViewInfo, nullptr, &(resultImage.vkImageView)) != VK_SUCCESS)
+    if (vkCreateImageView(device.logicalDevice, &imageViewInfo, kge::vkutility::HostAllocator(), &(resultImage.vkImageView)) != VK_SUCCESS)
     {
         throw std::runtime_error("Vulkan: Error while creating image view");
     }
@@ -519,18 +713,19 @@ kge::vkstructs::Image kge::vkutility::CreateImageSingle(const kge::vkstructs::De
 /**
 * Получить описание привязок вершинных данных к конвейеру
 * @param unsigned int bindingIndex - индекс привязки буфера вершин к конвейеру
+* @param VERTEX_LAYOUT layout - формат вершин в буфере
 * @return std::vector<VkVertexInputBindingDescription> - массив описаний привязок
 *
 * @note - при привязывании буфера вершин к конвейеру, указывается индекс привязки. Нужно получить информацию
 * для конкретной привязки, о том как конвейер будет интерпретировать привязываемый буфер, какого размера
 * один элемент (вершина) в буфере, как переходить к следующему и тд. Вся информация в этой структуре
 */
-std::vector<VkVertexInputBindingDescription> kge::vkutility::GetVertexInputBindingDescriptions(unsigned int bindingIndex)
+std::vector<VkVertexInputBindingDescription> kge::vkutility::GetVertexInputBindingDescriptions(unsigned int bindingIndex, VERTEX_LAYOUT layout)
 {
     return {
         {
             bindingIndex,                   // Индекс привязки вершинных буферов
-            sizeof(kge::vkstructs::Vertex), // Размерность шага
+            layout == VertexLayoutCompact ? sizeof(kge::vkstructs::VertexCompact) : sizeof(kge::vkstructs::Vertex), // Размерность шага
             VK_VERTEX_INPUT_RATE_VERTEX     // Правила перехода к следующим
         }};
 }
@@ -563,6 +758,41 @@ void kge::vkutility::FlushSingleTimeCommandBuffer(const kge::vkstructs::Device &
     vkFreeCommandBuffers(device.logicalDevice, commandPool, 1, &commandBuffer);
 }
 
+/**
+* Отправить команды на исполнение без ожидания
+* @param const kge::vkstructs::Device &device - устройство
+* @param VkCommandBuffer commandBuffer - командный буфер (освобождается вызывающим после сигнала забора)
+* @param VkQueue queue - очередь
+* @return VkFence - забор, сигнализируемый по завершении команд (удаляется вызывающим)
+*/
+VkFence kge::vkutility::SubmitSingleTimeCommandBuffer(const kge::vkstructs::Device &device,
+                                                      VkCommandBuffer commandBuffer,
+                                                      VkQueue queue)
+{
+    // Завершаем наполнение командного буффера
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence = nullptr;
+    if (vkCreateFence(device.logicalDevice, &fenceInfo, kge::vkutility::HostAllocator(), &fence) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while creating fence for single time commands");
+    }
+
+    // Отправка команд в очередь (забор сигнализируется по их завершении)
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        vkDestroyFence(device.logicalDevice, fence, kge::vkutility::HostAllocator());
+        throw std::runtime_error("Vulkan: Error. Can't submit single time commands");
+    }
+
+    return fence;
+}
+
 /**
 * Создать буфер одиночных команд
 * @param const kge::vkstructs::Device &device - устройство
@@ -682,6 +912,15 @@ void kge::vkutility::CmdImageLayoutTransition(VkCommandBuffer cmdBuffer,
         imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
         break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        // Изображение читали шейдеры ранее отправленных кадров (барьер ждет и их - та же очередь)
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        srcStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        break;
     default:
         std::cout << "WARNING!_133: default switch" << std::endl;
         break;
@@ -697,7 +936,9 @@ void kge::vkutility::CmdImageLayoutTransition(VkCommandBuffer cmdBuffer,
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         break;
     case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        // Изображение читают шейдеры кадров, отправленных в ту же очередь позже (загрузка без ожидания очереди)
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        destStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         break;
     default:
         std::cout << "WARNING!_134: default switch" << std::endl;
@@ -750,7 +991,7 @@ VkShaderModule kge::vkutility::LoadSPIRVShader(std::filesystem::path shaderFileP
 
     // Создать шейдерный модуль
     VkShaderModule shaderModule;
-    if (vkCreateShaderModule(logicalDevice, &moduleCreateInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    if (vkCreateShaderModule(logicalDevice, &moduleCreateInfo, kge::vkutility::HostAllocator(), &shaderModule) != VK_SUCCESS)
     {
         std::string msg = *(&"Vulkan: Error whiler creating shader module from file " + *shaderFilePath.c_str());
         throw std::runtime_error(msg);
@@ -766,13 +1007,33 @@ VkShaderModule kge::vkutility::LoadSPIRVShader(std::filesystem::path shaderFileP
 /**
 * Получить описание аттрибутов привязываемых к конвейеру вершин
 * @param unsigned int bindingIndex - индекс привязки буфера вершин к конвейеру
+* @param VERTEX_LAYOUT layout - формат вершин в буфере
 * @return std::vector<VkVertexInputAttributeDescription> - массив описаний атрибутов передаваемых вершин
 *
 * @note - конвейеру нужно знать как интерпретировать данные о вершинах. Какие у каждой вершины, в привязываемом буфере,
 * есть параметры (аттрибуты). В какой последовательности они идут, какого типа каждый аттрибут.
+* Сжатые атрибуты (snorm16, half-float, unorm8) распаковываются при выборке, шейдер получает те же vec3/vec2.
+* Флаг textureUsed шейдерами не читается, поэтому в сжатом формате его нет
 */
-std::vector<VkVertexInputAttributeDescription> kge::vkutility::GetVertexInputAttributeDescriptions(unsigned int bindingIndex)
+std::vector<VkVertexInputAttributeDescription> kge::vkutility::GetVertexInputAttributeDescriptions(unsigned int bindingIndex, VERTEX_LAYOUT layout)
 {
+    if (layout == VertexLayoutCompact) {
+        return {
+            {0,
+             bindingIndex,
+             VK_FORMAT_R16G16B16A16_SNORM,  // Лишняя компонента w отбрасывается (в шейдере vec3)
+             offsetof(vkstructs::VertexCompact, position)},
+            {1,
+             bindingIndex,
+             VK_FORMAT_R8G8B8A8_UNORM,
+             offsetof(vkstructs::VertexCompact, color)},
+            {2,
+             bindingIndex,
+             VK_FORMAT_R16G16_SFLOAT,
+             offsetof(vkstructs::VertexCompact, texCoord)},
+        };
+    }
+
     return {
         {
             0,                                    // Индекс аттрибута (location в шейдере)
@@ -795,6 +1056,124 @@ std::vector<VkVertexInputAttributeDescription> kge::vkutility::GetVertexInputAtt
     };
 }
 
+/**
+* Распаковка позиций вершин в пространство модели
+* @param const glm::vec3 &boundsMin - нижняя граница геометрии
+* @param const glm::vec3 &boundsMax - верхняя граница геометрии
+* @param VERTEX_LAYOUT layout - формат вершин в буфере
+* @return glm::vec4 - центр границ (xyz) и масштаб (w): позиция = упакованная * w + xyz
+*
+* @note - масштаб один на все оси (половина наибольшей стороны границ), поэтому распаковка - равномерное масштабирование
+* и перенос. Зависит только от границ, поэтому сборщик пакетов и реестр геометрии получают одинаковую распаковку
+*/
+glm::vec4 kge::vkutility::PositionDequantization(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, VERTEX_LAYOUT layout)
+{
+    if (layout == VertexLayoutFull) {
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+    float scale = glm::max(halfExtent.x, glm::max(halfExtent.y, halfExtent.z));
+    return glm::vec4((boundsMin + boundsMax) * 0.5f, scale > 0.0f ? scale : 1.0f);
+}
+
+/**
+* Упаковка вершин в формат буфера устройства
+* @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+* @param VERTEX_LAYOUT layout - формат вершин в буфере
+* @param const glm::vec4 &positionDequantization - распаковка позиций (см. PositionDequantization)
+* @param std::vector<unsigned char> &result - байты для буфера вершин
+*
+* @note - позиции хранятся в snorm16 относительно границ геометрии (шаг - 1/32767 половины наибольшей стороны границ),
+* поэтому точность не зависит от удаленности геометрии от начала координат модели
+*/
+void kge::vkutility::EncodeVertices(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                    VERTEX_LAYOUT layout,
+                                    const glm::vec4 &positionDequantization,
+                                    std::vector<unsigned char> &result)
+{
+    if (layout == VertexLayoutFull) {
+        result.resize(vertices.size() * sizeof(kge::vkstructs::Vertex));
+        memcpy(result.data(), vertices.data(), result.size());
+        return;
+    }
+
+    result.resize(vertices.size() * sizeof(kge::vkstructs::VertexCompact));
+    kge::vkstructs::VertexCompact* compact = reinterpret_cast<kge::vkstructs::VertexCompact*>(result.data());
+    for (std::size_t i = 0; i < vertices.size(); i++) {
+        glm::vec3 position = (vertices[i].position - glm::vec3(positionDequantization)) / positionDequantization.w;
+        compact[i].position = glm::packSnorm4x16(glm::vec4(position, 1.0f));
+        compact[i].color = glm::packUnorm4x8(glm::vec4(vertices[i].color, 1.0f));
+        compact[i].texCoord = glm::packHalf2x16(vertices[i].texCoord);
+    }
+}
+
+/**
+* Упаковка индексов в формат буфера устройства
+* @param const std::vector<unsigned int> &indices - массив индексов
+* @param uint32_t vertexCount - кол-во вершин
+* @param std::vector<unsigned char> &result - байты для буфера индексов
+* @return VkIndexType - тип индексов в буфере (VK_INDEX_TYPE_UINT16, если все вершины адресуются 16 битами)
+*/
+VkIndexType kge::vkutility::EncodeIndices(const std::vector<unsigned int> &indices, uint32_t vertexCount, std::vector<unsigned char> &result)
+{
+    if (vertexCount > 65536) {
+        result.resize(indices.size() * sizeof(uint32_t));
+        memcpy(result.data(), indices.data(), result.size());
+        return VK_INDEX_TYPE_UINT32;
+    }
+
+    result.resize(indices.size() * sizeof(uint16_t));
+    uint16_t* shortIndices = reinterpret_cast<uint16_t*>(result.data());
+    for (std::size_t i = 0; i < indices.size(); i++) {
+        shortIndices[i] = static_cast<uint16_t>(indices[i]);
+    }
+    return VK_INDEX_TYPE_UINT16;
+}
+
+/**
+* Получить описание привязки буфера экземпляров к конвейеру
+* @param unsigned int bindingIndex - индекс привязки буфера экземпляров к конвейеру
+* @return std::vector<VkVertexInputBindingDescription> - массив описаний привязок
+*
+* @note - в отличии от буфера вершин, переход к следующему элементу буфера происходит не для каждой вершины,
+* а для каждого экземпляра (VK_VERTEX_INPUT_RATE_INSTANCE)
+*/
+std::vector<VkVertexInputBindingDescription> kge::vkutility::GetInstanceInputBindingDescriptions(unsigned int bindingIndex)
+{
+    return {
+        {
+            bindingIndex,                   // Индекс привязки буфера экземпляров
+            sizeof(glm::mat4),              // Размерность шага (одна матрица модели)
+            VK_VERTEX_INPUT_RATE_INSTANCE   // Правила перехода к следующим (на каждый экземпляр)
+        }};
+}
+
+/**
+* Получить описание аттрибутов экземпляра
+* @param unsigned int bindingIndex - индекс привязки буфера экземпляров к конвейеру
+* @param unsigned int firstLocation - location первого столбца матрицы в шейдере
+* @return std::vector<VkVertexInputAttributeDescription> - массив описаний атрибутов
+*
+* @note - атрибут вершины не может быть больше vec4, поэтому матрица mat4 занимает 4 location подряд (по столбцу на каждый)
+*/
+std::vector<VkVertexInputAttributeDescription> kge::vkutility::GetInstanceInputAttributeDescriptions(unsigned int bindingIndex,
+                                                                                                     unsigned int firstLocation)
+{
+    std::vector<VkVertexInputAttributeDescription> attributes;
+
+    for (unsigned int column = 0; column < 4; column++) {
+        attributes.push_back({
+                                 firstLocation + column,                             // Индекс аттрибута (location в шейдере)
+                                 bindingIndex,                                       // Индекс привязки буфера экземпляров
+                                 VK_FORMAT_R32G32B32A32_SFLOAT,                      // Тип аттрибута (соответствует vec4 у шейдера)
+                                 static_cast<uint32_t>(sizeof(glm::vec4) * column)   // Cдвиг столбца в матрице
+                             });
+    }
+
+    return attributes;
+}
+
 /**
 * Путь к рабочему каталогу
 * @return std::string - строка содержащая путь к директории
@@ -841,6 +1220,17 @@ std::string kge::tools::TimeToStr(const std::time_t &time, const char *format)
     return strTime;
 }
 
+/**
+* Журнал движка
+* @return KGELogger& - журнал (файл открывается один раз, запись - в фоновом потоке журнала)
+* @note - статический объект: создается при первом сообщении, при завершении программы дописывает оставшиеся сообщения
+*/
+KGELogger& kge::tools::Logger()
+{
+    static KGELogger logger{ tools::WorkingDir().concat(LOG_FILENAME).string() };
+    return logger;
+}
+
 /**
 * Логирование. Пишет в файл и консоль (если она еть) строку со временем и указанным сообщением
 * @param std::string message - строка с соощением
@@ -848,44 +1238,59 @@ std::string kge::tools::TimeToStr(const std::time_t &time, const char *format)
 */
 void kge::tools::LogMessage(std::string message, bool printTime)
 {
-    std::string result = "";
-
-    if (printTime)
-    {
-        time_t time = tools::CurrentTime();
-        result += tools::TimeToStr(time, "[%Y-%m-%d %H:%M:%S] ");
+    if (printTime) {
+        tools::Logger().Write(kge::log::LevelInfo, "{}", message);
     }
-
-    result += message + '\n';
-    std::cout << result;
-
-    try
-    {
-        std::filesystem::path filePath = std::string("/home/vxuser/GitHub/KitevaGameEngine/") + LOG_FILENAME;
-
-        std::fstream fs;
-        fs.exceptions(std::ios::failbit | std::ios::badbit);
-        fs.open(filePath, std::ios_base::app);
-
-        fs << result;
-        fs.close();
-    }
-    catch (const std::exception &ex)
-    {
-        std::cout << ex.what() << std::endl;
+    else {
+        tools::Logger().WriteUntimed(kge::log::LevelInfo, "{}", message);
     }
 }
 
 /**
-* То же что и LogMessage, с той разницей что перед сообщением будет добавляться слово "ERROR!"
+* То же что и LogMessage, но с уровнем ошибки (перед сообщением выводится метка "[ERROR]")
 * @param std::string message - строка с соощением
 * @param bool printTime - выводить ли время
 */
 void kge::tools::LogError(std::string message, bool printTime)
 {
-    std::string newMessage = "ERROR! ";
-    newMessage += message;
-    tools::LogMessage(message, printTime);
+    if (printTime) {
+        tools::Logger().Write(kge::log::LevelError, "{}", message);
+    }
+    else {
+        tools::Logger().WriteUntimed(kge::log::LevelError, "{}", message);
+    }
+}
+
+/**
+* Отчет о памяти в журнал (строка на подсистему и на кучу устройства, размеры в КиБ)
+*/
+void kge::tools::LogMemoryUsage()
+{
+    KGE_LOG_INFO("Memory: Usage report (current / peak KiB, live allocations)");
+
+    for (uint8_t tag = 0; tag < kge::memory::TagCount; tag++) {
+        kge::memory::Usage usage = KGEMemoryTracker::usage(static_cast<kge::memory::Tag>(tag));
+        KGE_LOG_INFO("Memory:   Host {} - {} / {} KiB, {}",
+                     KGEMemoryTracker::TagName(static_cast<kge::memory::Tag>(tag)),
+                     usage.current / 1024,
+                     usage.peak / 1024,
+                     usage.allocations);
+    }
+
+    for (uint32_t heap = 0; heap < KGE_MEMORY_DEVICE_HEAPS; heap++) {
+        kge::memory::DeviceHeap deviceHeap = KGEMemoryTracker::deviceHeap(heap);
+        if (deviceHeap.size == 0) {
+            continue;
+        }
+
+        KGE_LOG_INFO("Memory:   Device heap {} ({}, {} MiB) - {} / {} KiB, {}",
+                     heap,
+                     deviceHeap.deviceLocal ? "device local" : "host",
+                     deviceHeap.size / (1024 * 1024),
+                     deviceHeap.usage.current / 1024,
+                     deviceHeap.usage.peak / 1024,
+                     deviceHeap.usage.allocations);
+    }
 }
 
 /**
@@ -9,6 +9,10 @@
 #include "X11/Xlib.h"
 #include "vulkan/vulkan_xcb.h"
 #include <stdio.h>
+// Декодированные изображения - в учете памяти (подсистема текстур)
+#define STBI_MALLOC(size) KGEMemoryTracker::Allocate(kge::memory::TagTextures, size)
+#define STBI_REALLOC(pointer, size) KGEMemoryTracker::Reallocate(kge::memory::TagTextures, pointer, size)
+#define STBI_FREE(pointer) KGEMemoryTracker::Free(pointer)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 #include <filesystem>
@@ -20,14 +24,27 @@ const bool IS_VK_DEBUG = false;
 #else
 const bool IS_VK_DEBUG = true;
 #endif
-// Метод вернет структуру с хендлами текстуры и дескриптора
-kge::vkstructs::Texture LoadTextureVk(KGEVulkanCore * renderer, std::filesystem::__cxx11::path pPath);
+// Декодированное изображение (пиксели в памяти хоста)
+struct DecodedImage
+{
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+// Декодирование файла изображения (не обращается к Vulkan, может выполняться в рабочем потоке)
+DecodedImage DecodeImageFile(std::filesystem::path pPath);
+
+// Метод вернет хендл текстуры (текстурой владеет рендерер)
+kge::vkstructs::TextureHandle LoadTextureVk(KGEVulkanCore * renderer, DecodedImage &image);
 
-KGEVulkanApp::KGEVulkanApp(uint32_t width, uint32_t heigh, std::string applicationName):
+KGEVulkanApp::KGEVulkanApp(uint32_t width, uint32_t heigh, std::string applicationName, KGEJobSystem* jobSystem):
     m_appWidth{width},
     m_appHeigh{heigh},
     m_applicationName{applicationName},
     m_windowControl{nullptr},
+    m_jobSystem{jobSystem},
     m_KGEVulkanCore{nullptr}
 {
 
@@ -98,14 +115,23 @@ void KGEVulkanApp::Init()
                                         m_appHeigh,
                                         m_applicationName,
                                         m_windowControl,
+                                        m_jobSystem,
                                         4,
                                         m_instanceExtensions,
                                         m_deviceExtensions,
                                         m_validationLayersExtensions);
 
-    // Загрузка текстур
-    kge::vkstructs::Texture groundTexture = LoadTextureVk(m_KGEVulkanCore, "ground.jpg");
-    kge::vkstructs::Texture cubeTexture = LoadTextureVk(m_KGEVulkanCore, "cube.jpg");
+    // Декодирование изображений текстур (параллельно, в рабочих потоках)
+    DecodedImage groundImage;
+    DecodedImage cubeImage;
+    kge::jobs::Counter decodeCounter;
+    m_jobSystem->Run([&groundImage]() { groundImage = DecodeImageFile("ground.jpg"); }, &decodeCounter);
+    m_jobSystem->Run([&cubeImage]() { cubeImage = DecodeImageFile("cube.jpg"); }, &decodeCounter);
+    m_jobSystem->Wait(&decodeCounter);
+
+    // Загрузка текстур в память устройства (Vulkan - только из основного потока)
+    kge::vkstructs::TextureHandle groundTexture = LoadTextureVk(m_KGEVulkanCore, groundImage);
+    kge::vkstructs::TextureHandle cubeTexture = LoadTextureVk(m_KGEVulkanCore, cubeImage);
 
 /*
     // Пол
@@ -115,7 +141,7 @@ void KGEVulkanApp::Init()
                                       { { 5.0f,  0.0f,  -5.0f },{ 1.0f, 1.0f, 1.0f },{ 20.0f, 20.0f } },
                                       { { 5.0f,  0.0f,  5.0f },{ 1.0f, 1.0f, 1.0f },{ 0.0f, 20.0f } },
 
-                                  }, { 0,1,2,2,3,0 }, &groundTexture, { 0.0f,-0.5f,0.0f }, { 0.0f,0.0f,0.0f });
+                                  }, { 0,1,2,2,3,0 }, groundTexture, { 0.0f,-0.5f,0.0f }, { 0.0f,0.0f,0.0f });
 
     // Куб
     m_KGEVulkanCore->AddPrimitive({
@@ -149,7 +175,7 @@ void KGEVulkanApp::Init()
                                       { { -0.2f, -0.2f, -0.2f },{ 1.0f, 1.0f, 1.0f },{ 1.0f, 1.0f } },
                                       { { -0.2f, -0.2f,  0.2f },{ 1.0f, 1.0f, 1.0f },{ 0.0f, 1.0f } },
 
-                                  }, { 0,1,2,2,3,0, 4,5,6,6,7,4, 8,9,10,10,11,8, 12,13,14,14,15,12, 16,17,18,18,19,16, 20,21,22,22,23,20 }, &cubeTexture, { 0.0f,-0.3f,-2.0f }, { 0.0f,45.0f,0.0f });
+                                  }, { 0,1,2,2,3,0, 4,5,6,6,7,4, 8,9,10,10,11,8, 12,13,14,14,15,12, 16,17,18,18,19,16, 20,21,22,22,23,20 }, cubeTexture, { 0.0f,-0.3f,-2.0f }, { 0.0f,45.0f,0.0f });
 
     // Куб
     m_KGEVulkanCore->AddPrimitive({
@@ -185,15 +211,27 @@ void KGEVulkanApp::Init()
 
                                   },
     { 0,1,2,2,3,0, 4,5,6,6,7,4, 8,9,10,10,11,8, 12,13,14,14,15,12, 16,17,18,18,19,16, 20,21,22,22,23,20 },
-                                  &cubeTexture,
+                                  cubeTexture,
     { 1.0f,-0.3f,-3.0f }, { 0.0f,0.0f,0.0f });
 */
 
+    // Горячая перезагрузка шейдеров (и моделей, загруженных через m_assetHotReload->LoadModel)
+    try {
+        m_assetHotReload = new KGEAssetHotReload(m_KGEVulkanCore, m_jobSystem);
+        m_assetHotReload->WatchShaders();
+    }
+    catch (const std::exception &ex) {
+        KGE_LOG_WARNING("{}. Hot reload is disabled", ex.what());
+        delete m_assetHotReload;
+        m_assetHotReload = nullptr;
+    }
+
     // Конфигурация перспективы
     m_KGEVulkanCore->SetCameraPerspectiveSettings(60.0f, 0.1f, 256.0f);
 
     // Время последнего кадра - время начала цикла
     lastFrameTime = high_resolution_clock::now();
+    lastMemoryReportTime = lastFrameTime;
 }
 
 void KGEVulkanApp::Run()
@@ -239,45 +277,65 @@ void KGEVulkanApp::Run()
             // Обновить рендерер и отрисовать кадр
             m_KGEVulkanCore->SetCameraPosition(camera.position.x, camera.position.y, camera.position.z);
             m_KGEVulkanCore->SetCameraRotation(camera.rotation.x, camera.rotation.y, camera.rotation.z);
+            if (m_assetHotReload) {
+                m_assetHotReload->Update();
+            }
             m_KGEVulkanCore->Update();
             m_KGEVulkanCore->Draw();
+
+            // Периодический отчет о памяти
+            if (KGE_MEMORY_REPORT_INTERVAL > 0 &&
+                currentFrameTime - lastMemoryReportTime >= std::chrono::seconds(KGE_MEMORY_REPORT_INTERVAL)) {
+                kge::tools::LogMemoryUsage();
+                lastMemoryReportTime = currentFrameTime;
+            }
         }
     }
 
-    // Уничтожить рендерер
+    // Уничтожить рендерер (горячая перезагрузка ссылается на него)
+    delete m_assetHotReload;
     delete m_KGEVulkanCore;
 
+    // Итоговый отчет (после уничтожения рендерера текущие значения показывают утечки)
+    kge::tools::LogMemoryUsage();
+
     // Выход с кодом 0
     kge::tools::LogMessage("Application closed successfully\n");
 
 }
 
-// Загрузка текстуры
-// Метод вернет структуру с хендлами текстуры и дескриптора
-kge::vkstructs::Texture LoadTextureVk(KGEVulkanCore * renderer, std::filesystem::path pPath)
+// Декодирование файла изображения
+// Метод вернет пиксели в формате RGBA (их нужно освободить после загрузки текстуры)
+DecodedImage DecodeImageFile(std::filesystem::path pPath)
 {
-
-    int width;        // Ширина загруженного изображения
-    int height;       // Высота загруженного изображения
-    int channels;     // Кол-во каналов
-    int bpp = 4;      // Байт на пиксель
+    DecodedImage result;
 
     // Путь к файлу
     std::filesystem::path filename = kge::tools::WorkingDir().concat("textures/" + pPath.string());
 
     // Получить пиксели (массив байт)
-    unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    result.pixels = stbi_load(filename.c_str(), &result.width, &result.height, &result.channels, STBI_rgb_alpha);
+
+    return result;
+}
+
+// Загрузка текстуры
+// Метод вернет хендл текстуры (текстурой владеет рендерер)
+kge::vkstructs::TextureHandle LoadTextureVk(KGEVulkanCore * renderer, DecodedImage &image)
+{
+    int bpp = 4;      // Байт на пиксель
 
     // Создать текстуру (загрузить пиксели в память устройства)
-    kge::vkstructs::Texture result = renderer->CreateTexture(
-                pixels,
-                static_cast<uint32_t>(width),
-                static_cast<uint32_t>(height),
-                static_cast<uint32_t>(channels),
+    kge::vkstructs::TextureHandle result = renderer->CreateTexture(
+                image.pixels,
+                static_cast<uint32_t>(image.width),
+                static_cast<uint32_t>(image.height),
+                static_cast<uint32_t>(image.channels),
                 static_cast<uint32_t>(bpp));
 
     // Очистить массив байт
-    stbi_image_free(pixels);
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
 
     return result;
 }
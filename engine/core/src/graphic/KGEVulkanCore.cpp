@@ -1,27 +1,67 @@
 #include "graphic/KGEVulkanCore.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <sort/KGERadixSort.h>
+
+/**
+* Раскладка 64-битного ключа сортировки отрисовки (по старшинству): текстура, геометрия, глубина
+* @note - конвейер в ключ не входит: все примитивы списка рисуются одним конвейером
+*/
+#define DRAW_KEY_TEXTURE_SHIFT 44
+#define DRAW_KEY_TEXTURE_MASK 0xFFFFull
+#define DRAW_KEY_MESH_SHIFT 24
+#define DRAW_KEY_MESH_MASK 0xFFFFFull
+#define DRAW_KEY_DEPTH_MASK 0xFFFFFFull
+
+/**
+* AABB примитива в глобальном пространстве (в виде, принимаемом иерархией AABB)
+*/
+static kge::math::Aabb PrimitiveAabb(const kge::vkstructs::Bounds &primitiveBounds)
+{
+    kge::math::Aabb bounds;
+    for (int axis = 0; axis < 3; axis++) {
+        bounds.min[axis] = primitiveBounds.aabbMin[axis];
+        bounds.max[axis] = primitiveBounds.aabbMax[axis];
+    }
+    return bounds;
+}
 /**
 * Конструктор рендерера
 * @param uint32_t width
 * @param uint32_t heigh
 * @param IVulkanWindowControl* windowControl
-* @param int primitivesMaxCount - максимальное кол-во отдельных объектов для отрисовки
+* @param KGEJobSystem* jobSystem - система задач, используется для распараллеливания обновления сцены
+* @param unsigned int primitivesInitialCapacity - начальная вместимость буфера матриц моделей (при нехватке растет вдвое)
 * @param std::vector <const char*> instanceExtensionsRequired
 * @param std::vector <const char*> deviceExtensionsRequired
 * @param std::vector <const char*> validationLayersRequired
+* @param MODEL_DATA_PATH modelDataPath - способ передачи матрицы модели в шейдер (динамический UBO либо push-константы)
+* @param CULLING_MODE cullingMode - способ отсечения примитивов (на хосте либо вычислительным шейдером)
+* @param VERTEX_LAYOUT vertexLayout - формат вершин в буферах геометрии (по умолчанию сжатый, 16 байт на вершину)
 * @note - конструктор запистит инициализацию всех необходимых компоненстов Vulkan
 */
 KGEVulkanCore::KGEVulkanCore(uint32_t width,
                              uint32_t heigh,
                              std::string applicationName,
                              IVulkanWindowControl* windowControl,
-                             unsigned int primitivesMaxCount,
+                             KGEJobSystem* jobSystem,
+                             unsigned int primitivesInitialCapacity,
                              std::vector <const char*> instanceExtensionsRequired,
                              std::vector <const char*> deviceExtensionsRequired,
-                             std::vector <const char*> validationLayersRequired) :
+                             std::vector <const char*> validationLayersRequired,
+                             MODEL_DATA_PATH modelDataPath,
+                             CULLING_MODE cullingMode,
+                             VERTEX_LAYOUT vertexLayout) :
     m_isReady(false),
     m_isRendering(true),
-    m_primitivesMaxCount(primitivesMaxCount),
+    m_primitivesCapacity(std::max(primitivesInitialCapacity, 1u)),
+    m_jobSystem(jobSystem),
+    m_modelDataPath(modelDataPath),
+    m_cullingMode(cullingMode),
+    m_vertexLayout(vertexLayout),
 
     // Ширина и высота
     m_width(width),
@@ -51,16 +91,18 @@ KGEVulkanCore::KGEVulkanCore(uint32_t width,
     m_kgeVkCommandBuffer{m_kgeVkDevice.device(), &m_kgeVkCommandPool.commandPool(), static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size())},
     //Аллокация глобального uniform-буфера
     ////m_uniformBufferWorld{},
-    m_kgeVkUniformBufferWorld{m_kgeVkDevice.device()},
+    m_kgeVkUniformBufferWorld{m_kgeVkDevice.device(), static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size())},
     // Аллокация uniform-буфера отдельных объектов (динамический буфер)
     ////m_uniformBufferModels{},
-    m_kgeVkUniformBufferModels{m_kgeVkDevice.device(), m_primitivesMaxCount},
+    m_kgeVkUniformBufferModels{std::make_unique<KGEVkUniformBufferModels>(m_kgeVkDevice.device(), m_primitivesCapacity, static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size()))},
     // Создание дескрипторного пула для выделения основного набора (для unform-буфера)
     ////m_descriptorPoolMain{},
     m_kgeVkDescriptorPoolMain{m_kgeVkDevice.device()},
     // Создание дескрипторного пула для выделения текстурного набора (текстурные семплеры)
     //m_descriptorPoolTextures{},
-    m_kgeVkDescriptorPoolTextures{m_kgeVkDevice.device(), 2},
+    m_kgeVkDescriptorPoolTextures{m_kgeVkDevice.device(), TEXTURES_MAX_COUNT},
+    // Очередь отложенного удаления (ресурсы удаляются по завершении кадров, которые могли их читать)
+    m_kgeVkDeletionQueue{m_kgeVkDevice.device()},
     // Инициализация размещения основного дескрипторного набора
     //m_descriptorSetLayoutMain{},
     m_kgeVkDescriptorSetLayoutMain{m_kgeVkDevice.device(), SetLayoutMain},
@@ -72,30 +114,64 @@ KGEVulkanCore::KGEVulkanCore(uint32_t width,
     m_kgeVkSampler{m_kgeVkDevice.device()},
     // Инициализация дескрипторного набора
     //m_descriptorSetMain{},
-    m_kgeVkDescriptorSet{m_kgeVkDevice.device(), &m_kgeVkDescriptorPoolMain.descriptorPool(), &m_kgeVkDescriptorSetLayoutMain.descriptorSetLayout(), m_kgeVkUniformBufferWorld.uniformBufferWorld(), &m_kgeVkUniformBufferModels.m_uniformBufferModels},
+    m_kgeVkDescriptorSet{std::make_unique<KGEVkDescriptorSet>(m_kgeVkDevice.device(), &m_kgeVkDescriptorPoolMain.descriptorPool(), &m_kgeVkDescriptorSetLayoutMain.descriptorSetLayout(), m_kgeVkUniformBufferWorld.uniformBufferWorld(), &m_kgeVkUniformBufferModels->m_uniformBufferModels)},
     // Инициализация размещения графического конвейера
     //m_pipelineLayout{},
-    m_kgeVkPipelineLayout{m_kgeVkDevice.device(), { m_kgeVkDescriptorSetLayoutMain.descriptorSetLayout(), m_kgeVkDescriptorSetLayoutTextures.descriptorSetLayout()}},
+    // (push-константы вершинного шейдера: матрица модели в режиме push-констант и распаковка позиций привязанной геометрии за ней)
+    m_kgeVkPipelineLayout{m_kgeVkDevice.device(),
+                          { m_kgeVkDescriptorSetLayoutMain.descriptorSetLayout(), m_kgeVkDescriptorSetLayoutTextures.descriptorSetLayout()},
+                          std::vector<VkPushConstantRange>{ { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) + sizeof(glm::vec4) } }},
     // Инициализация графического конвейера
     //m_pipeline{},
-    m_kgeVkGraphicsPipeline{m_kgeVkDevice.device(), m_kgeVkPipelineLayout.pipelineLayout(), m_kgeSwapChain.swapchain(), m_kgeRenderPass.renderPass()},
+    m_kgeVkGraphicsPipeline{m_kgeVkDevice.device(), m_kgeVkPipelineLayout.pipelineLayout(), m_kgeSwapChain.swapchain(), m_kgeRenderPass.renderPass(), m_vertexLayout, m_modelDataPath == ModelDataPushConstants ? "vert_push.spv" : "vert.spv"},
     // Аллокация памяти массива ubo-объектов отдельных примитивов
     //m_uboModels{},
-    m_kgeUboModels{&m_uboModels, m_kgeVkDevice.device(), m_primitivesMaxCount},
+    m_kgeUboModels{&m_uboModels, m_kgeVkDevice.device(), m_primitivesCapacity},
     // Примитивы синхронизации
     //m_sync{},
-    m_kgeVkSynchronization{&m_sync, m_kgeVkDevice.device()}
+    m_kgeVkSynchronization{&m_sync, m_kgeVkDevice.device(), MAX_FRAMES_IN_FLIGHT, static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size())},
+    // Буфер матриц экземпляров
+    // В режиме GPU-отсечения в нем же лежат матрицы обычных примитивов (буфер растет вместе с массивом матриц, см. GrowInstanceBuffers)
+    m_kgeVkInstanceBuffer{std::make_unique<KGEVkInstanceBuffer>(m_kgeVkDevice.device(), INSTANCES_MAX_COUNT + (cullingMode == CullingGpu ? m_primitivesCapacity : 0), static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size()))},
+    m_kgeVkMeshRegistry{m_kgeVkDevice.device(), m_vertexLayout, &m_kgeVkDeletionQueue},
+    // Бюджеты куч памяти и последнее использование ресурсов (для вытеснения)
+    m_kgeVkResidency{m_kgeVkDevice.device()}
 {
+    KGE_PROFILE_ZONE("KGEVulkanCore::KGEVulkanCore");
     // Присвоить параметры камеры по умолчанию
     m_camera.fFar  = DEFAULT_FOV;
     m_camera.fFar  = DEFAULT_FAR;
     m_camera.fNear = DEFAULT_NEAR;
 
+    // Ни один набор семафоров еще не отправлялся
+    m_frameSerials.assign(m_sync.frameFences.size(), 0);
+
+    // GPU-отсечению нужна косвенная отрисовка нескольких команд за вызов и с ненулевым firstInstance
+    if (m_cullingMode == CullingGpu) {
+        const kge::vkstructs::Device* device = m_kgeVkDevice.device();
+        if (device->multiDrawIndirect && device->drawIndirectFirstInstance) {
+            unsigned int imageCount = static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size());
+            m_kgeVkGpuCulling = std::make_unique<KGEVkGpuCulling>(device,
+                                                                  m_primitivesCapacity,
+                                                                  imageCount,
+                                                                  m_kgeVkInstanceBuffer->instanceBuffer(),
+                                                                  m_kgeVkInstanceBuffer->regionSize());
+            m_uploadedGpuCullObjectsVersion.assign(imageCount, m_gpuCullObjectsVersion);
+
+            // Косвенные команды рисуются конвейером экземпляризированной отрисовки (матрица модели из буфера экземпляров)
+            CreateInstancedPipeline();
+        }
+        else {
+            m_cullingMode = CullingCpu;
+            kge::tools::LogMessage("Vulkan: Indirect draw features are not supported, CPU culling will be used");
+        }
+    }
+
     PrepareDrawCommands(
                 m_kgeVkCommandBuffer.commandBuffersDraw(),
                 m_kgeRenderPass.renderPass(),
                 m_kgeVkPipelineLayout.pipelineLayout(),
-                m_kgeVkDescriptorSet.descriptorSet(),
+                m_kgeVkDescriptorSet->descriptorSet(),
                 m_kgeVkGraphicsPipeline.pipeline(),
                 m_kgeSwapChain.swapchain(),
                 m_primitives);
@@ -111,9 +187,14 @@ KGEVulkanCore::KGEVulkanCore(uint32_t width,
 */
 void KGEVulkanCore::Pause()
 {
+    KGE_PROFILE_ZONE("KGEVulkanCore::Pause");
     // Ожидание завершения всех возможных процессов
     if (m_kgeVkDevice.device()->logicalDevice != nullptr) {
         vkDeviceWaitIdle(m_kgeVkDevice.device()->logicalDevice);
+
+        // Все отправленные кадры и загрузки завершены - освобожденные ресурсы (в т.ч. завершением загрузок) можно удалить
+        CollectUploads();
+        m_kgeVkDeletionQueue.Flush();
     }
 
     m_isRendering = false;
@@ -134,32 +215,44 @@ void KGEVulkanCore::Continue()
 */
 void KGEVulkanCore::VideoSettingsChanged()
 {
-    // Оставноить выполнение команд
+    KGE_PROFILE_ZONE("KGEVulkanCore::VideoSettingsChanged");
+    // Оставноить выполнение команд (изображения swap-chain заменяются целиком - здесь ожидание устройства оправдано)
     Pause();
-    m_kgeVkCommandBuffer.~KGEVkCommandBuffer();
-    m_kgeVkGraphicsPipeline.~KGEVkGraphicsPipeline();// DeinitGraphicsPipeline(m_device, &m_pipeline);
-    m_kgeRenderPass.~KGEVkRenderPass();
-    m_kgeRenderPass = { m_kgeVkDevice.device(), m_kgeVkSurface.surface(), VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_D32_SFLOAT_S8_UINT};
 
-    // Ре-инициализация swap-cahin.
-    // В начале получаем старый swap-chain
-    kge::vkstructs::Swapchain oldSwapChain = m_kgeSwapChain.swapchain();
-    m_kgeSwapChain.~KGEVkSwapChain();
+    // Новые объекты создаются рядом с прежними и обмениваются с ними хендлами, прежние хендлы удаляются деструкторами
+    // локальных объектов при выходе из метода (устройство простаивает)
+    KGEVkRenderPass renderPass{m_kgeVkDevice.device(), m_kgeVkSurface.surface(), VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_D32_SFLOAT_S8_UINT};
+    m_kgeRenderPass.Swap(renderPass);
+
+    // Ре-инициализация swap-cahin (прежний передается для более эффективного пересоздания)
+    KGEVkSwapChain swapChain{m_kgeVkDevice.device(), m_kgeVkSurface.surface(), {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }, VK_FORMAT_D32_SFLOAT_S8_UINT, m_kgeRenderPass.renderPass(), 3, &m_kgeSwapChain.swapchain()};
+    m_kgeSwapChain.Swap(swapChain);
+
+    // Области uniform-буферов соответствуют изображениям swap-chain, их кол-во не должно измениться
+    if (m_kgeSwapChain.swapchain().framebuffers.size() != m_kgeVkUniformBufferModels->m_uniformBufferModels.regionCount) {
+        throw std::runtime_error("Vulkan: Error. Swap-chain image count changed, uniform buffer regions can't be reused");
+    }
 
-    // Инициализируем обновленный
-    m_kgeSwapChain = { m_kgeVkDevice.device(), m_kgeVkSurface.surface(), {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }, VK_FORMAT_D32_SFLOAT_S8_UINT, m_kgeRenderPass.renderPass(), 3, &oldSwapChain};
+    // Устройство простаивает, старые связи изображений с кадрами более не актуальны
+    m_sync.imageFences.assign(m_sync.imageFences.size(), nullptr);
 
     // Инициализация графического конвейера
-    m_kgeVkGraphicsPipeline = {m_kgeVkDevice.device(), m_kgeVkPipelineLayout.pipelineLayout(), m_kgeSwapChain.swapchain(), m_kgeRenderPass.renderPass()};
-    // Аллокация командных буферов (получение хендлов)
-    m_kgeVkCommandBuffer = {m_kgeVkDevice.device(), &m_kgeVkCommandPool.commandPool(), static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size())};
+    KGEVkGraphicsPipeline pipeline{m_kgeVkDevice.device(), m_kgeVkPipelineLayout.pipelineLayout(), m_kgeSwapChain.swapchain(), m_kgeRenderPass.renderPass(), m_vertexLayout, m_modelDataPath == ModelDataPushConstants ? "vert_push.spv" : "vert.spv"};
+    m_kgeVkGraphicsPipeline.Swap(pipeline);
+    m_kgeVkGraphicsPipelineInstanced.reset();
+    if (!m_instancedPrimitives.empty() || m_kgeVkGpuCulling) {
+        CreateInstancedPipeline();
+    }
+
+    // Кол-во изображений не изменилось - командные буферы остаются прежними, их достаточно сбросить и перезаписать
+    ResetCommandBuffers(*m_kgeVkDevice.device(), m_kgeVkCommandBuffer.commandBuffersDraw());
 
     // Подготовка базовых комманд
     PrepareDrawCommands(
                 m_kgeVkCommandBuffer.commandBuffersDraw(),
                 m_kgeRenderPass.renderPass(),
                 m_kgeVkPipelineLayout.pipelineLayout(),
-                m_kgeVkDescriptorSet.descriptorSet(),
+                m_kgeVkDescriptorSet->descriptorSet(),
                 m_kgeVkGraphicsPipeline.pipeline(),
                 m_kgeSwapChain.swapchain(),
                 m_primitives);
@@ -177,6 +270,7 @@ void KGEVulkanCore::VideoSettingsChanged()
 */
 void KGEVulkanCore::Draw()
 {
+    KGE_PROFILE_ZONE("KGEVulkanCore::Draw");
     std::cout << "--DRAW--" << std::endl;
     // Ничего не делать если не готово или приостановлено
     if (!m_isReady || !m_isRendering) {
@@ -186,12 +280,27 @@ void KGEVulkanCore::Draw()
     // Индекс доступного изображения
     unsigned int imageIndex;
 
+    // Текущий кадр "в полете" (набор семафоров и забор)
+    unsigned int frame = m_sync.currentFrame;
+
+    // Дождаться завершения кадра, который ранее использовал этот же набор семафоров
+    {
+        KGE_PROFILE_ZONE("KGEVulkanCore::Draw wait frame fence");
+        vkWaitForFences(m_kgeVkDevice.device()->logicalDevice, 1, &m_sync.frameFences[frame], VK_TRUE, UINT64_MAX);
+    }
+
+    // Этот кадр (а значит и все отправленные до него) завершен - удалить ресурсы, освобожденные до его отправки
+    m_kgeVkDeletionQueue.FrameCompleted(m_frameSerials[frame]);
+
+    // Завершенные загрузки текстур (по их заборам)
+    CollectUploads();
+
     // Получить индекс доступного изображения из swap-chain и "включить" семафор сигнализирующий о доступности изображения для рендеринга
     VkResult acquireStatus = vkAcquireNextImageKHR(
                 m_kgeVkDevice.device()->logicalDevice,
                 m_kgeSwapChain.swapchain().vkSwapchain,
-                1000,
-                m_sync.readyToRender,
+                UINT64_MAX,
+                m_sync.readyToRender[frame],
                 nullptr,
                 &imageIndex);
 
@@ -201,21 +310,47 @@ void KGEVulkanCore::Draw()
         throw std::runtime_error("Vulkan: Error. Can't acquire swap-chain image");
     }
 
+    // Если изображение (а значит и его командный буфер и области uniform-буферов) еще используется другим кадром - дождаться его
+    if (m_sync.imageFences[imageIndex] != nullptr) {
+        KGE_PROFILE_ZONE("KGEVulkanCore::Draw wait image fence");
+        vkWaitForFences(m_kgeVkDevice.device()->logicalDevice, 1, &m_sync.imageFences[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+    m_sync.imageFences[imageIndex] = m_sync.frameFences[frame];
+
+    // Пакеты GPU-отсечения пересобираются не чаще раза за кадр (добавление и удаление примитивов лишь помечают их)
+    if (m_gpuDrawBatchesDirty) {
+        RebuildGpuDrawBatches();
+        m_drawListVersion++;
+    }
+
+    // Теперь устройство не читает области изображения - можно записать в них данные кадра
+    UploadUniformRegion(imageIndex);
+
+    // Push-константы хранятся в самом командном буфере - перезаписать буфер изображения с актуальными матрицами
+    // Так же буфер перезаписывается если после его записи изменился список видимых примитивов
+    if (m_modelDataPath == ModelDataPushConstants || m_recordedDrawListVersion[imageIndex] != m_drawListVersion) {
+        m_recordedDrawListVersion[imageIndex] = m_drawListVersion;
+        RecordDrawCommands(m_kgeVkCommandBuffer.commandBuffersDraw()[imageIndex],
+                           imageIndex,
+                           m_kgeRenderPass.renderPass(),
+                           m_kgeVkPipelineLayout.pipelineLayout(),
+                           m_kgeVkDescriptorSet->descriptorSet(),
+                           m_kgeVkGraphicsPipeline.pipeline(),
+                           m_kgeSwapChain.swapchain(),
+                           m_primitives);
+    }
+
     // Данные семафоры будут ожидаться на определенных стадиях ковейера
-    std::vector<VkSemaphore> waitSemaphores = { m_sync.readyToRender };
+    std::vector<VkSemaphore> waitSemaphores = { m_sync.readyToRender[frame] };
 
     // Данные семафоры будут "включаться" на определенных стадиях ковейера
-    std::vector<VkSemaphore> signalSemaphores = { m_sync.readyToPresent };
+    std::vector<VkSemaphore> signalSemaphores = { m_sync.readyToPresent[frame] };
 
     // Стадии конвейера на которых будет происходить одидание семафоров (на i-ой стадии включения i-ого семафора из waitSemaphores)
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-    VkFenceCreateInfo fenceInfo;
-    VkFence drawFence;
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.pNext = nullptr;
-    fenceInfo.flags = 0;
-    vkCreateFence(m_kgeVkDevice.device()->logicalDevice, &fenceInfo, nullptr, &drawFence);
+    // Забор кадра будет включен по завершении выполнения команд
+    vkResetFences(m_kgeVkDevice.device()->logicalDevice, 1, &m_sync.frameFences[frame]);
 
     // Информация об отправке команд в буфер
     VkSubmitInfo submitInfo[1] = {};
@@ -231,12 +366,15 @@ void KGEVulkanCore::Draw()
 
 
     // Инициировать отправку команд в очередь (на рендеринг)
-    VkResult result = vkQueueSubmit(m_kgeVkDevice.device()->queues.graphics, 1, submitInfo, drawFence);
+    VkResult result = vkQueueSubmit(m_kgeVkDevice.device()->queues.graphics, 1, submitInfo, m_sync.frameFences[frame]);
     std::cout << "----" << std::endl;
     if (result != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error. Can't submit commands");
     }
 
+    // Ресурсы, освобожденные после этой отправки, будут удалены по ее завершении (см. KGEVkDeletionQueue)
+    m_frameSerials[frame] = m_kgeVkDeletionQueue.FrameSubmitted();
+
     // Настройка представления (отображение того что отдал конвейер)
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -248,12 +386,19 @@ void KGEVulkanCore::Draw()
     presentInfo.pResults = nullptr;
 
     // Инициировать представление
-    VkResult presentStatus = vkQueuePresentKHR(m_kgeVkDevice.device()->queues.present, &presentInfo);
+    VkResult presentStatus;
+    {
+        KGE_PROFILE_ZONE("KGEVulkanCore::Draw present");
+        presentStatus = vkQueuePresentKHR(m_kgeVkDevice.device()->queues.present, &presentInfo);
+    }
 
     // Представление могло не выполниться если поверхность изменилась или swap-chain более ей не соответствует
     if (presentStatus != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error. Failed to present!");
     }
+
+    // Следующий кадр
+    m_sync.currentFrame = (frame + 1) % static_cast<unsigned int>(m_sync.frameFences.size());
 }
 
 /**
@@ -262,7 +407,11 @@ void KGEVulkanCore::Draw()
 */
 void KGEVulkanCore::Update()
 {
+    KGE_PROFILE_ZONE("KGEVulkanCore::Update");
     std::cout  << "--UPDATE--" << std::endl;
+    // Бюджеты куч памяти текущего кадра (использованные кадром ресурсы отмечаются ниже)
+    m_kgeVkResidency.BeginFrame();
+
     // Соотношение сторон (используем размеры поверхности определенные при создании swap-chain)
     m_camera.aspectRatio = static_cast<float>(m_kgeSwapChain.swapchain().imageExtent.width) /m_kgeSwapChain.swapchain().imageExtent.height;
 
@@ -279,39 +428,158 @@ void KGEVulkanCore::Update()
     // Позволяет осуществлять глобальные преобразования всей сцены (пока что не используется)
     m_uboWorld.worldMatrix = glm::mat4();
 
-    // Копировать данные в uniform-буфер
-    memcpy(m_kgeVkUniformBufferWorld.uniformBufferWorld()->pMapped,
-           &m_uboWorld,
-           static_cast<size_t>(m_kgeVkUniformBufferWorld.uniformBufferWorld()->size));
-
-    // Теперь необходимо обновить динамический буфер формы объектов (если они есть)
+    // Теперь необходимо обновить массив матриц объектов (если они есть)
+    // В uniform-буферы данные попадут в Draw, когда станет известна свободная область (см. UploadUniformRegion)
     if (!m_primitives.empty()) {
 
         // Динамическое выравнивание для одного элемента массива
         VkDeviceSize dynamicAlignment = m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>();
 
-        // Пройтись по всем объектам
-        for (unsigned int i = 0; i < m_primitives.size(); i++) {
+        // Время, прошедшее с предыдущего обновления
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        float deltaTime = std::chrono::duration<float>(now - m_lastUpdateTime).count();
+        m_lastUpdateTime = now;
+
+        // Анимация (только сущности с компонентом анимации)
+        m_ecsWorld.Each<kge::vkstructs::Transform, kge::vkstructs::Animation>([this, deltaTime](kge::ecs::Entity, kge::vkstructs::Transform &transform, kge::vkstructs::Animation &animation) {
+            transform.rotation = glm::mod(transform.rotation + animation.angularVelocity * deltaTime, 360.0f);
+            glm::mat4 local = transform.MakeModelMatrix();
+            m_sceneGraph.SetLocalTransform(transform.node, &local[0][0]);
+        });
+
+        // Пересчет мировых матриц (только поддеревья иерархии, в которых что-то изменилось)
+        m_sceneGraph.Update();
+
+        // Пройтись по всем объектам (поблочно, параллельно в рабочих потоках системы задач)
+        // Матрицы остальных примитивов остались в массиве с прошлых кадров, поэтому копируются только изменившиеся
+        // Каждый элемент массива выравнен, поэтому потоки пишут в разные участки памяти
+        m_ecsWorld.ParallelEach<kge::vkstructs::Transform, kge::vkstructs::Renderable, kge::vkstructs::Bounds>(m_jobSystem,
+                [this, dynamicAlignment](kge::ecs::Entity, kge::vkstructs::Transform &transform, kge::vkstructs::Renderable &renderable, kge::vkstructs::Bounds &bounds) {
+            if (!m_sceneGraph.changed(transform.node)) {
+                return;
+            }
+
+            // Мировая матрица узла (раскладка совпадает с glm::mat4)
+            const glm::mat4 &world = *reinterpret_cast<const glm::mat4*>(m_sceneGraph.worldTransform(transform.node).m);
 
             // Используя выравнивание получить указатель на нужный элемент массива
-            glm::mat4* modelMat = (glm::mat4*)(((uint64_t)(m_uboModels) + (i * dynamicAlignment)));
+            glm::mat4* modelMat = (glm::mat4*)(((uint64_t)(m_uboModels) + (renderable.slot * dynamicAlignment)));
 
             // Вписать данные матрицы в элемент
-            *modelMat = glm::translate(glm::mat4(), m_primitives[i].position);
-            *modelMat = glm::rotate(*modelMat, glm::radians(m_primitives[i].rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            *modelMat = glm::rotate(*modelMat, glm::radians(m_primitives[i].rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            *modelMat = glm::rotate(*modelMat, glm::radians(m_primitives[i].rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+            *modelMat = world;
+
+            // Границы для отсечения
+            bounds.Update(m_kgeVkMeshRegistry.mesh(renderable.mesh), world);
+            m_frustumCuller.Set(renderable.slot, bounds.sphereCenter.x, bounds.sphereCenter.y, bounds.sphereCenter.z, bounds.sphereRadius);
+        });
+
+        // Границы перемещенных примитивов в иерархии AABB (уточнятся при ближайшем запросе)
+        if (!m_bvhDirty) {
+            m_ecsWorld.Each<kge::vkstructs::Transform, kge::vkstructs::Renderable, kge::vkstructs::Bounds>(
+                    [this](kge::ecs::Entity, kge::vkstructs::Transform &transform, kge::vkstructs::Renderable &renderable, kge::vkstructs::Bounds &bounds) {
+                if (m_sceneGraph.changed(transform.node)) {
+                    m_bvh.Update(m_slotBvhObjects[renderable.slot], PrimitiveAabb(bounds));
+                }
+            });
+        }
+
+        // Уровни детализации (до отсечения - ключи сортировки списка отрисовки зависят от геометрии)
+        SelectLods();
+
+        glm::mat4 viewProjection = m_uboWorld.projectionMatrix * m_uboWorld.viewMatrix * m_uboWorld.worldMatrix;
+        m_frustum = kge::math::ExtractFrustum(&viewProjection[0][0]);
+
+        // Отсечение по пирамиде видимости камеры (ограничивающие сферы примитивов, по 4 за раз)
+        // Если набор видимых примитивов изменился - командные буферы будут перезаписаны в Draw
+        // В режиме GPU-отсечения пирамида уходит в проход отсечения (см. UploadUniformRegion)
+        if (m_cullingMode == CullingCpu) {
+            m_frustumCuller.Cull(m_frustum, m_cullResult);
+
+            // Наборы сравниваются без глубины (результат отсечения упорядочен по позициям), поэтому движение камеры
+            // без смены видимости не перезаписывает командные буферы. Список пересортировывается вместе со сменой набора
+            // и при любом другом изменении списка отрисовки (уровни детализации, замена геометрии или текстуры)
+            if (m_cullResult != m_visibleSet || m_sortedDrawListVersion != m_drawListVersion) {
+                m_visibleSet.swap(m_cullResult);
+                m_visiblePrimitives = m_visibleSet;
+                SortDrawList(m_visiblePrimitives);
+                m_drawListVersion++;
+                m_sortedDrawListVersion = m_drawListVersion;
+            }
+
+            // Ресурсы видимых примитивов используются этим кадром (не вытесняются)
+            for (uint32_t primitiveIndex : m_visiblePrimitives) {
+                const kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(m_primitives[primitiveIndex]);
+                m_kgeVkResidency.TouchMesh(renderable.mesh);
+                if (renderable.texture.valid()) {
+                    m_kgeVkResidency.TouchTexture(renderable.texture);
+                }
+            }
+        }
+        // Видимость определяется на устройстве - используемыми считаются ресурсы всех примитивов
+        else {
+            m_ecsWorld.Each<kge::vkstructs::Renderable>([this](kge::ecs::Entity, kge::vkstructs::Renderable &renderable) {
+                m_kgeVkResidency.TouchMesh(renderable.mesh);
+                if (renderable.texture.valid()) {
+                    m_kgeVkResidency.TouchTexture(renderable.texture);
+                }
+            });
+        }
+    }
+
+    // Экземпляризированные примитивы не отсекаются
+    for (const kge::vkstructs::InstancedPrimitive &primitive : m_instancedPrimitives) {
+        m_kgeVkResidency.TouchMesh(primitive.mesh);
+        if (primitive.texture.valid()) {
+            m_kgeVkResidency.TouchTexture(primitive.texture);
+        }
+    }
+
+    EnforceMemoryBudget();
+}
+
+/**
+* Копирование подготовленных в Update данных (матрицы сцены и моделей) в области uniform-буферов
+* @param unsigned int regionIndex - индекс области (совпадает с индексом изображения swap-chain)
+* @note - память буферов хост-когерентна, явный сброс (vkFlushMappedMemoryRanges) не требуется.
+* Копируются только матрицы существующих примитивов, а не вся область. Матрицы экземпляров копируются в область буфера экземпляров
+*/
+void KGEVulkanCore::UploadUniformRegion(unsigned int regionIndex)
+{
+    // Матрицы сцены
+    memcpy(m_kgeVkUniformBufferWorld.uniformBufferWorld()->region(regionIndex),
+           &m_uboWorld,
+           sizeof(kge::vkstructs::UboWorld));
+
+    // Матрицы моделей
+    if (!m_primitives.empty()) {
+        VkDeviceSize dynamicAlignment = m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>();
+        memcpy(m_kgeVkUniformBufferModels->m_uniformBufferModels.region(regionIndex),
+               m_uboModels,
+               static_cast<size_t>(dynamicAlignment * m_primitives.size()));
+    }
+
+    // Матрицы экземпляров
+    glm::mat4* instanceRegion = m_kgeVkInstanceBuffer->region(regionIndex);
+    for (const kge::vkstructs::InstancedPrimitive &primitive : m_instancedPrimitives) {
+        memcpy(instanceRegion + primitive.firstInstance,
+               primitive.instances.data(),
+               sizeof(glm::mat4) * primitive.instances.size());
+    }
+
+    // Данные прохода GPU-отсечения: матрицы обычных примитивов (вслед за экземплярами), пирамида видимости, описания объектов
+    if (m_kgeVkGpuCulling) {
+        VkDeviceSize dynamicAlignment = m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>();
+        glm::mat4* primitiveMatrices = instanceRegion + m_primitiveInstanceOffset;
+        for (std::size_t i = 0; i < m_primitives.size(); i++) {
+            primitiveMatrices[i] = *reinterpret_cast<const glm::mat4*>(reinterpret_cast<const unsigned char*>(m_uboModels) + i * dynamicAlignment);
         }
 
-        // Копировать данные в uniform-буфер
-        memcpy(m_kgeVkUniformBufferModels.m_uniformBufferModels.pMapped, m_uboModels, m_kgeVkUniformBufferModels.m_uniformBufferModels.size);
+        m_kgeVkGpuCulling->UploadFrustum(regionIndex, m_frustum);
 
-        // Гарантировать видимость обновленной памяти устройством
-        VkMappedMemoryRange memoryRange = {};
-        memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        memoryRange.memory = m_kgeVkUniformBufferModels.m_uniformBufferModels.vkDeviceMemory;
-        memoryRange.size = m_kgeVkUniformBufferModels.m_uniformBufferModels.size;
-        vkFlushMappedMemoryRanges(m_kgeVkDevice.device()->logicalDevice, 1, &memoryRange);
+        if (m_uploadedGpuCullObjectsVersion[regionIndex] != m_gpuCullObjectsVersion) {
+            m_kgeVkGpuCulling->UploadObjects(regionIndex, m_gpuCullObjects);
+            m_uploadedGpuCullObjectsVersion[regionIndex] = m_gpuCullObjectsVersion;
+        }
     }
 }
 
@@ -351,413 +619,2130 @@ void KGEVulkanCore::SetCameraRotation(float x, float y, float z)
 }
 
 /**
-* Добавление нового примитива
-* @param const std::vector<vktoolkit::Vertex> &vertices - массив вершин
+* Регистрация геометрии (одинаковая геометрия загружается в память устройства один раз)
+* @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
 * @param const std::vector<unsigned int> &indices - массив индексов
-* @param glm::vec3 position - положение относительно глобального центра
-* @param glm::vec3 rotaton - вращение вокруг локального центра
-* @param glm::vec3 scale - масштаб
-* @return unsigned int - индекс примитива
+* @return kge::vkstructs::MeshHandle - хендл геометрии
 */
-unsigned int KGEVulkanCore::AddPrimitive(const std::vector<kge::vkstructs::Vertex> &vertices,
-                                         const std::vector<unsigned int> &indices,
-                                         const kge::vkstructs::Texture *texture,
-                                         glm::vec3 position,
-                                         glm::vec3 rotaton,
-                                         glm::vec3 scale)
+kge::vkstructs::MeshHandle KGEVulkanCore::RegisterMesh(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                                      const std::vector<unsigned int> &indices)
 {
-    // Новый примитив
-    kge::vkstructs::Primitive primitive;
-    primitive.position = position;
-    primitive.rotation = rotaton;
-    primitive.scale = scale;
-    primitive.texture = texture;
-    primitive.drawIndexed = !indices.empty();
-
-    // Буфер вершин (временный)
-    std::vector<kge::vkstructs::Vertex> vertexBuffer = vertices;
-    VkDeviceSize vertexBufferSize = (static_cast<unsigned int>(vertexBuffer.size())) * sizeof(kge::vkstructs::Vertex);
-    unsigned int vertexCount = static_cast<unsigned int>(vertexBuffer.size());
-
-    // Создать буфер вершин в памяти хоста
-    kge::vkstructs::Buffer tmp = kge::vkutility::CreateBuffer(*m_kgeVkDevice.device(), vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    primitive.vertexBuffer.vkBuffer = tmp.vkBuffer;
-    primitive.vertexBuffer.vkDeviceMemory = tmp.vkDeviceMemory;
-    primitive.vertexBuffer.size = tmp.size;
-    primitive.vertexBuffer.count = vertexCount;
-
-    // Разметить память буфера вершин и скопировать в него данные, после чего убрать разметку
-    void * verticesMemPtr;
-    vkMapMemory(m_kgeVkDevice.device()->logicalDevice, primitive.vertexBuffer.vkDeviceMemory, 0, vertexBufferSize, 0, &verticesMemPtr);
-    memcpy(verticesMemPtr, vertexBuffer.data(), static_cast<size_t>(vertexBufferSize));
-    vkUnmapMemory(m_kgeVkDevice.device()->logicalDevice, primitive.vertexBuffer.vkDeviceMemory);
-
-    // Если необходимо рисовать индексированную геометрию
-    if (primitive.drawIndexed) {
-
-        // Буфер индексов (временный)
-        std::vector<unsigned int> indexBuffer = indices;
-        VkDeviceSize indexBufferSize = (static_cast<unsigned int>(indexBuffer.size())) * sizeof(unsigned int);
-        unsigned int indexCount = static_cast<unsigned int>(indexBuffer.size());
-
-        // Cоздать буфер индексов в памяти хоста
-        tmp = kge::vkutility::CreateBuffer(*m_kgeVkDevice.device(),
-                                           indexBufferSize,
-                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        primitive.indexBuffer.vkBuffer = tmp.vkBuffer;
-        primitive.indexBuffer.vkDeviceMemory = tmp.vkDeviceMemory;
-        primitive.indexBuffer.size = tmp.size;
-        primitive.indexBuffer.count = indexCount;
-
-        // Разметить память буфера индексов и скопировать в него данные, после чего убрать разметку
-        void * indicesMemPtr;
-        vkMapMemory(m_kgeVkDevice.device()->logicalDevice, primitive.indexBuffer.vkDeviceMemory, 0, indexBufferSize, 0, &indicesMemPtr);
-        memcpy(indicesMemPtr, indexBuffer.data(), static_cast<size_t>(indexBufferSize));
-        vkUnmapMemory(m_kgeVkDevice.device()->logicalDevice, primitive.indexBuffer.vkDeviceMemory);
-    }
-
-
-    // Впихнуть новый примитив в массив
-    m_primitives.push_back(primitive);
-
-    // Обновить командный буфер
-    ResetCommandBuffers(*m_kgeVkDevice.device(),
-                        m_kgeVkCommandBuffer.commandBuffersDraw());
-
-    PrepareDrawCommands(m_kgeVkCommandBuffer.commandBuffersDraw(),
-                        m_kgeRenderPass.renderPass(),
-                        m_kgeVkPipelineLayout.pipelineLayout(),
-                        m_kgeVkDescriptorSet.descriptorSet(),
-                        m_kgeVkGraphicsPipeline.pipeline(),
-                        m_kgeSwapChain.swapchain(),
-                        m_primitives);
+    return m_kgeVkMeshRegistry.Register(vertices, indices);
+}
 
-    // Вернуть индекс
-    return static_cast<unsigned int>(m_primitives.size() - 1);
+/**
+* Освобождение ссылки на геометрию
+* @param kge::vkstructs::MeshHandle mesh - хендл геометрии
+*/
+void KGEVulkanCore::ReleaseMesh(kge::vkstructs::MeshHandle mesh)
+{
+    m_kgeVkMeshRegistry.Release(mesh);
 }
 
 /**
-* Создание текстуры по данным о пикселях
-* @param const unsigned char* pixels - пиксели загруженные из файла
-* @return vktoolkit::Texture - структура с набором хендлов изображения и дескриптора
+* Добавление нового примитива
+* @param kge::vkstructs::MeshHandle mesh - хендл зарегистрированной геометрии
+* @param glm::vec3 position - положение относительно глобального центра
+* @param glm::vec3 rotaton - вращение вокруг локального центра
+* @param glm::vec3 scale - масштаб
+* @return kge::vkstructs::PrimitiveHandle - хендл примитива
 *
-* @note - при загрузке используется временный буфер (временное изображение) для перемещения
-* в буфер распологающийся в памяти устройства. Нельзя сразу создать буфер в памяти устройства и переместить
-* в него данные. Это можно сделать только пр помощи команды копирования (из памяти доступной хосту в память
-* доступную только устройству)
+* @note - командные буферы не перезаписываются сразу (с ожиданием устройства), а лишь помечаются устаревшими -
+* каждый из них будет перезаписан в Draw, когда его изображение освободится. На хосте примитив попадает в список
+* отрисовки при ближайшем отсечении в Update
 */
-kge::vkstructs::Texture KGEVulkanCore::CreateTexture(const unsigned char *pixels,
-                                                     uint32_t width,
-                                                     uint32_t height,
-                                                     uint32_t channels,
-                                                     uint32_t bpp)
+kge::vkstructs::PrimitiveHandle KGEVulkanCore::AddPrimitive(kge::vkstructs::MeshHandle mesh,
+                                                            kge::vkstructs::TextureHandle texture,
+                                                            glm::vec3 position,
+                                                            glm::vec3 rotaton,
+                                                            glm::vec3 scale)
 {
-    // Приостановить выполнение основных команд (если какие-либо в процессе)
-    this->Pause();
-
-    // Результат
-    kge::vkstructs::Texture resultTexture = {};
-
-    // Размер изображения (ожидаем по умолчанию 4 байта на пиксель, в режиме RGBA)
-    VkDeviceSize size = static_cast<VkDeviceSize>(width * height * bpp);
-
-    // Если данных не обнаружено
-    if (!pixels) {
-        throw std::runtime_error("Vulkan: Error while creating texture. Empty pixel buffer recieved");
+    // Позиция примитива: свободная (после удаления) либо новая в конце таблицы
+    uint32_t slot;
+    if (!m_freePrimitiveSlots.empty()) {
+        slot = m_freePrimitiveSlots.back();
+        m_freePrimitiveSlots.pop_back();
     }
-
-    // Создать промежуточное изображение
-    kge::vkstructs::Image stagingImage = kge::vkutility::CreateImageSingle(*m_kgeVkDevice.device(),
-                                                                           VK_IMAGE_TYPE_2D,
-                                                                           VK_FORMAT_R8G8B8A8_UNORM,
-                                                                           { width,height,1 },
-                                                                           VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                                                           VK_IMAGE_ASPECT_COLOR_BIT,
-                                                                           VK_IMAGE_LAYOUT_PREINITIALIZED,
-                                                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                                           VK_IMAGE_TILING_LINEAR);
-
-    // Выбрать подресурс изображения (мип-уровень 0, слой - 0)
-    VkImageSubresource subresource = {};
-    subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subresource.mipLevel = 0;
-    subresource.arrayLayer = 0;
-
-    // Размещение байт в подресурсе
-    VkSubresourceLayout stagingImageSubresourceLayout = {};
-    vkGetImageSubresourceLayout(m_kgeVkDevice.device()->logicalDevice, stagingImage.vkImage, &subresource, &stagingImageSubresourceLayout);
-
-    // Разметить память под изображение
-    void* data;
-    vkMapMemory(m_kgeVkDevice.device()->logicalDevice, stagingImage.vkDeviceMemory, 0, size, 0, &data);
-
-    // Если "ширина строки" равна кол-ву пиксилей по ширине помноженному на bpp - можно исользовать обычный memcpy
-    if (stagingImageSubresourceLayout.rowPitch == width * bpp) {
-        memcpy(data, pixels, static_cast<unsigned int>(size));
-    }
-    // Если нет (например размер изображения не кратен степени двойки) - перебираем байты со смещением и копируем каждую стороку
     else {
-        unsigned char* dataBytes = reinterpret_cast<unsigned char*>(data);
-        for (unsigned int y = 0; y < height; y++) {
-            memcpy(&dataBytes[y * (stagingImageSubresourceLayout.rowPitch)],
-                    &pixels[y * width * bpp],
-                    width * bpp
-                    );
+        slot = static_cast<uint32_t>(m_primitives.size());
+
+        // Массив матриц заполнен - увеличить вдвое (в среднем O(1) на добавление)
+        if (slot >= m_primitivesCapacity) {
+            GrowModelBuffer(m_primitivesCapacity * 2);
         }
+
+        m_primitives.emplace_back();
+        m_primitiveGenerations.push_back(0);
     }
 
-    // Убрать разметку памяти
-    vkUnmapMemory(m_kgeVkDevice.device()->logicalDevice, stagingImage.vkDeviceMemory);
+    // Примитив держит свою ссылку на геометрию
+    m_kgeVkMeshRegistry.AddRef(mesh);
 
-    // Создать финальное изображение (в памяти устройства)
-    resultTexture.image = kge::vkutility::CreateImageSingle(
-                *m_kgeVkDevice.device(),
-                VK_IMAGE_TYPE_2D,
-                VK_FORMAT_R8G8B8A8_UNORM,
-    { width,height, 1 },
-                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                VK_IMAGE_ASPECT_COLOR_BIT,
-                VK_IMAGE_LAYOUT_PREINITIALIZED,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                VK_IMAGE_TILING_OPTIMAL);
+    // Компоненты нового примитива
+    kge::vkstructs::Transform transform;
+    transform.position = position;
+    transform.rotation = rotaton;
+    transform.scale = scale;
 
+    kge::vkstructs::Renderable renderable;
+    renderable.texture = texture;
+    renderable.mesh = mesh;
+    renderable.slot = slot;
 
-    // Создать командный буфер для команд перевода размещения изображений
-    VkCommandBuffer transitionCmdBuffer = kge::vkutility::CreateSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool());
+    // Узел иерархии (новый примитив - корневой, мировая матрица совпадает с локальной)
+    glm::mat4 local = transform.MakeModelMatrix();
+    transform.node = m_sceneGraph.CreateNode();
+    m_sceneGraph.SetLocalTransform(transform.node, &local[0][0]);
 
-    // Подресурс подвергающийся смере размещения в изображениях (описываем его)
-    VkImageSubresourceRange subresourceRange = {};
-    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subresourceRange.baseMipLevel = 0;
-    subresourceRange.levelCount = 1;
-    subresourceRange.baseArrayLayer = 0;
-    subresourceRange.layerCount = 1;
+    kge::vkstructs::Bounds bounds;
+    bounds.Update(m_kgeVkMeshRegistry.mesh(mesh), local);
 
-    // Сменить размещение памяти промежуточного изображения в VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-    kge::vkutility::CmdImageLayoutTransition(transitionCmdBuffer, stagingImage.vkImage, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, subresourceRange);
+    // Создать сущность и занять ею позицию
+    m_primitives[slot] = m_ecsWorld.Create(transform, renderable, bounds);
 
-    // Сменить размещение памяти целевого изображения в VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-    kge::vkutility::CmdImageLayoutTransition(transitionCmdBuffer, resultTexture.image.vkImage, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+    // Матрица модели (в занятой повторно позиции до ближайшего Update осталась бы матрица удаленного примитива)
+    VkDeviceSize dynamicAlignment = m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>();
+    *reinterpret_cast<glm::mat4*>(reinterpret_cast<unsigned char*>(m_uboModels) + slot * dynamicAlignment) = local;
 
-    // Выполнить команды перевода размещения
-    kge::vkutility::FlushSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool(), transitionCmdBuffer, m_kgeVkDevice.device()->queues.graphics);
+    // Ограничивающая сфера для отсечения
+    if (slot < m_frustumCuller.count()) {
+        m_frustumCuller.Set(slot, bounds.sphereCenter.x, bounds.sphereCenter.y, bounds.sphereCenter.z, bounds.sphereRadius);
+    }
+    else {
+        m_frustumCuller.Add(bounds.sphereCenter.x, bounds.sphereCenter.y, bounds.sphereCenter.z, bounds.sphereRadius);
+    }
 
-    // Создать командный буфер для копирования изображения
-    VkCommandBuffer copyCmdBuffer = kge::vkutility::CreateSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool());
+    // Иерархия AABB перестроится при ближайшем запросе
+    m_bvhDirty = true;
 
-    // Копирование из промежуточной картинки в основную
-    kge::vkutility::CmdImageCopy(copyCmdBuffer, stagingImage.vkImage, resultTexture.image.vkImage, width, height);
+    // В режиме GPU-отсечения индексированные примитивы рисуются косвенными командами (см. RebuildGpuDrawBatches),
+    // на хосте остаются только неиндексированные
+    if (m_cullingMode == CullingGpu) {
+        if (!m_kgeVkMeshRegistry.mesh(mesh).drawIndexed) {
+            m_visiblePrimitives.push_back(slot);
+            m_drawListVersion++;
+        }
+        LayoutInstances();
+    }
 
-    // Выполнить команды копирования
-    kge::vkutility::FlushSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool(), copyCmdBuffer, m_kgeVkDevice.device()->queues.graphics);
+    return { slot, m_primitiveGenerations[slot] };
+}
 
-    // Очистить промежуточное изображение
-    stagingImage.Deinit(m_kgeVkDevice.device()->logicalDevice);
+/**
+* Добавление нового примитива
+* @param const std::vector<vktoolkit::Vertex> &vertices - массив вершин
+* @param const std::vector<unsigned int> &indices - массив индексов
+* @param glm::vec3 position - положение относительно глобального центра
+* @param glm::vec3 rotaton - вращение вокруг локального центра
+* @param glm::vec3 scale - масштаб
+* @return kge::vkstructs::PrimitiveHandle - хендл примитива
+*
+* @note - геометрия регистрируется в реестре, повторная загрузка одинаковой геометрии не создает новых буферов
+*/
+kge::vkstructs::PrimitiveHandle KGEVulkanCore::AddPrimitive(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                                            const std::vector<unsigned int> &indices,
+                                                            kge::vkstructs::TextureHandle texture,
+                                                            glm::vec3 position,
+                                                            glm::vec3 rotaton,
+                                                            glm::vec3 scale)
+{
+    kge::vkstructs::MeshHandle mesh = m_kgeVkMeshRegistry.Register(vertices, indices);
+    kge::vkstructs::PrimitiveHandle primitive = AddPrimitive(mesh, texture, position, rotaton, scale);
 
+    // Ссылка регистрации больше не нужна - геометрией владеет примитив
+    m_kgeVkMeshRegistry.Release(mesh);
 
-    // Получить новый набор дескрипторов из дескриптороного пула
-    VkDescriptorSetAllocateInfo descriptorSetAllocInfo = {};
-    descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocInfo.descriptorPool = m_kgeVkDescriptorPoolTextures.descriptorPool();
-    descriptorSetAllocInfo.descriptorSetCount = 1;
-    descriptorSetAllocInfo.pSetLayouts = &(m_kgeVkDescriptorSetLayoutTextures.descriptorSetLayout());
+    return primitive;
+}
 
-    if (vkAllocateDescriptorSets(m_kgeVkDevice.device()->logicalDevice, &descriptorSetAllocInfo, &(resultTexture.descriptorSet)) != VK_SUCCESS) {
-        throw std::runtime_error("Vulkan: Error in vkAllocateDescriptorSets. Can't allocate descriptor set for texture");
+/**
+* Удаление примитива
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+*
+* @note - O(1): сущность и узел иерархии удаляются, позиция уходит в список свободных. Ссылки примитива на геометрию
+* освобождаются сразу - отправленные кадры еще могут ее читать, поэтому буферы геометрии удаляются через очередь
+* отложенного удаления (см. KGEVkDeletionQueue), а командные буферы перезаписываются до следующей отправки
+*/
+void KGEVulkanCore::RemovePrimitive(kge::vkstructs::PrimitiveHandle primitive)
+{
+    kge::ecs::Entity entity = PrimitiveEntity(primitive);
+    uint32_t slot = primitive.slot;
+
+    // Примитив держит ссылки на геометрию всех уровней детализации (либо только на свою геометрию)
+    std::vector<kge::vkstructs::MeshHandle> meshes;
+    if (const kge::vkstructs::MeshLod* lod = m_ecsWorld.Get<kge::vkstructs::MeshLod>(entity)) {
+        for (uint32_t i = 0; i < lod->levelCount; i++) {
+            meshes.push_back(lod->levels[i].mesh);
+        }
+    }
+    else {
+        meshes.push_back(m_ecsWorld.Get<kge::vkstructs::Renderable>(entity)->mesh);
     }
 
-    // Информация о передаваемом изображении
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = resultTexture.image.vkImageView;
-    imageInfo.sampler = m_kgeVkSampler.sampler();
+    m_sceneGraph.DestroyNode(m_ecsWorld.Get<kge::vkstructs::Transform>(entity)->node);
+    m_ecsWorld.Destroy(entity);
 
-    // Конфигурация добавляемых в набор дескрипторов
-    std::vector<VkWriteDescriptorSet> writes =
-    {
-        {
-            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,      // Тип структуры
-            nullptr,                                     // pNext
-            resultTexture.descriptorSet,                 // Целевой набор дескрипторов
-            0,                                           // Точка привязки (у шейдера)
-            0,                                           // Элемент массив (массив не используется)
-            1,                                           // Кол-во дескрипторов
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,   // Тип дескриптора
-            &imageInfo,                                  // Информация о параметрах изображения
-            nullptr,
-            nullptr
-        }
-    };
+    // Освободить позицию (новое поколение делает недействительными выданные хендлы)
+    m_primitives[slot] = kge::ecs::Entity();
+    m_primitiveGenerations[slot]++;
+    m_freePrimitiveSlots.push_back(slot);
 
-    // Обновить наборы дескрипторов
-    vkUpdateDescriptorSets(m_kgeVkDevice.device()->logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    // Сфера с отрицательно бесконечным радиусом никогда не проходит отсечение
+    m_frustumCuller.Set(slot, 0.0f, 0.0f, 0.0f, -std::numeric_limits<float>::infinity());
+
+    // Иерархия AABB перестроится при ближайшем запросе
+    m_bvhDirty = true;
 
-    // Исполнение основых команд снова возможно
-    this->Continue();
+    // На хосте удаленная позиция остается в списке отрисовки до ближайшего отсечения (запись команд ее пропускает),
+    // в режиме GPU-отсечения список не пересчитывается, поэтому позиция убирается сразу
+    if (m_cullingMode == CullingGpu) {
+        m_visiblePrimitives.erase(std::remove(m_visiblePrimitives.begin(), m_visiblePrimitives.end(), slot), m_visiblePrimitives.end());
+        m_gpuDrawBatchesDirty = true;
+    }
 
-    // Вернуть результат
-    return resultTexture;
+    m_drawListVersion++;
+    for (kge::vkstructs::MeshHandle mesh : meshes) {
+        m_kgeVkMeshRegistry.Release(mesh);
+    }
 }
 
-KGEVulkanCore::~KGEVulkanCore()
+/**
+* Существует ли примитив
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @return bool - позиция занята примитивом того же поколения
+*/
+bool KGEVulkanCore::PrimitiveAlive(kge::vkstructs::PrimitiveHandle primitive) const
 {
-    Pause();
-    m_isReady = false;
-    // Сброс буферов команд
-    ResetCommandBuffers(*m_kgeVkDevice.device(), m_kgeVkCommandBuffer.commandBuffersDraw());
+    return primitive.slot < m_primitives.size() && m_primitiveGenerations[primitive.slot] == primitive.generation;
 }
 
 /**
-* Подготовка команд, заполнение командных буферов
-* @param std::vector<VkCommandBuffer> commandBuffers - массив хендлов командных буферов
-* @param VkRenderPass renderPass - хендл прохода рендеринга, используется при привязке прохода
-* @param VkPipelineLayout pipelineLayout - хендл размещения конвейра, исппользуется при привязке дескрипторов
-* @param VkDescriptorSet descriptorSet - хендл набор дескрипторов, исппользуется при привязке дескрипторов
-* @param VkPipeline pipeline - хендл конвейера, используется при привязке конвейера
-* @param const vktoolkit::Swapchain &swapchain - свопчейн, используется при конфигурации начала прохода (в.ч. для указания фрейм-буфера)
-* @param const std::vector<vktoolkit::Primitive> &primitives - массив примитивов (привязка буферов вершин, буферов индексов для каждого и т.д)
-*
-* @note - данную операцию нет нужды выполнять при каждом обновлении кадра, набор команд как правило относительно неизменный. Метод лишь заполняет
-* буферы команд, а сама отправка происходть в draw. При изменении кол-ва примитивов следует сбросить командные буферы и заново их заполнить
-* при помощи данного метода
+* Сущность примитива по хендлу
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @return kge::ecs::Entity - сущность
 */
-void KGEVulkanCore::PrepareDrawCommands(std::vector<VkCommandBuffer> commandBuffers,
-                                        VkRenderPass renderPass,
-                                        VkPipelineLayout pipelineLayout,
-                                        VkDescriptorSet descriptorSetMain,
-                                        VkPipeline pipeline,
-                                        const kge::vkstructs::Swapchain &swapchain,
-                                        const std::vector<kge::vkstructs::Primitive> &primitives)
+kge::ecs::Entity KGEVulkanCore::PrimitiveEntity(kge::vkstructs::PrimitiveHandle primitive) const
 {
-    // Информация начала командного буфера
-    VkCommandBufferBeginInfo cmdBufInfo = {};
-    cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-    cmdBufInfo.pNext = nullptr;
+    if (!PrimitiveAlive(primitive)) {
+        throw std::runtime_error("Vulkan: Error. Primitive handle is invalid or stale");
+    }
+    return m_primitives[primitive.slot];
+}
 
-    // Параметры очистки вложений в начале прохода
-    std::vector<VkClearValue> clearValues(2);
-    // Очистка первого вложения (цветового)
-    clearValues[0].color = { {0.6f, 0.8f, 0.8f, 1.0f} };
-    // Очиска второго вложения (вложения глубины-трфарета)
-    clearValues[1].depthStencil.depth = 1.0f;
-    clearValues[1].depthStencil.stencil = 0;
+/**
+* Увеличение вместимости массива матриц моделей и uniform-буфера моделей
+* @param unsigned int capacity - новая вместимость (кол-во матриц)
+* @note - uniform-буфер и его набор дескрипторов создаются заново. Пара, созданная после последней отправки кадра,
+* устройством не читалась (записанные с ней командные буферы перезапишутся до отправки) и удаляется сразу. Иначе
+* старая пара может еще читаться отправленными кадрами и уходит в очередь отложенного удаления. Ожидания очередей нет:
+* в очереди не больше одной пары на незавершенный кадр, поэтому наборов основного пула хватает всегда
+*/
+static_assert(DESCRIPTOR_SETS_MAIN_MAX_COUNT >= MAX_FRAMES_IN_FLIGHT + 2,
+              "Main descriptor pool must hold the current, the new and one retired model buffer set per frame in flight");
 
-    // Информация о начале прохода
-    VkRenderPassBeginInfo renderPassBeginInfo = {};
-    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassBeginInfo.pNext = nullptr;
-    renderPassBeginInfo.renderPass = renderPass;
-    renderPassBeginInfo.renderArea.offset.x = 0;
-    renderPassBeginInfo.renderArea.offset.y = 0;
-    renderPassBeginInfo.renderArea.extent.width = swapchain.imageExtent.width;
-    renderPassBeginInfo.renderArea.extent.height = swapchain.imageExtent.height;
-    renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassBeginInfo.pClearValues = clearValues.data();
+void KGEVulkanCore::GrowModelBuffer(unsigned int capacity)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::GrowModelBuffer");
+    m_kgeUboModels.Resize(capacity);
+    m_primitivesCapacity = capacity;
 
+    // Все командные буферы изображений будут перезаписаны с новым набором дескрипторов
+    m_drawListVersion++;
 
-    // Пройтись по всем буферам
-    for (unsigned int i = 0; i < commandBuffers.size(); ++i)
-    {
-        // Начать запись команд в командный буфер i
-        vkBeginCommandBuffer(commandBuffers[i], &cmdBufInfo);
+    // Номер последнего отправленного кадра (отправки загрузок не в счет - они не привязывают набор)
+    uint64_t lastFrameSerial = *std::max_element(m_frameSerials.begin(), m_frameSerials.end());
 
-        // Установить целевой фрейм-буфер (поскольку их кол-во равно кол-ву командных буферов, индексы соответствуют)
-        renderPassBeginInfo.framebuffer = swapchain.framebuffers[i];
+    if (m_modelBufferSerial == lastFrameSerial) {
+        // Набор раньше буфера
+        m_kgeVkDescriptorSet.reset();
+        m_kgeVkUniformBufferModels.reset();
+    }
+    else {
+        std::shared_ptr<KGEVkDescriptorSet> descriptorSet = std::move(m_kgeVkDescriptorSet);
+        std::shared_ptr<KGEVkUniformBufferModels> buffer = std::move(m_kgeVkUniformBufferModels);
+        m_kgeVkDeletionQueue.Defer([descriptorSet, buffer]() mutable {
+            descriptorSet.reset();
+            buffer.reset();
+        });
+    }
 
-        // Начать первый под-проход основного прохода, это очистит цветоые вложения
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    m_kgeVkUniformBufferModels = std::make_unique<KGEVkUniformBufferModels>(
+                m_kgeVkDevice.device(),
+                m_primitivesCapacity,
+                static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size()));
+
+    m_kgeVkDescriptorSet = std::make_unique<KGEVkDescriptorSet>(
+                m_kgeVkDevice.device(),
+                &m_kgeVkDescriptorPoolMain.descriptorPool(),
+                &m_kgeVkDescriptorSetLayoutMain.descriptorSetLayout(),
+                m_kgeVkUniformBufferWorld.uniformBufferWorld(),
+                &m_kgeVkUniformBufferModels->m_uniformBufferModels);
+    m_modelBufferSerial = lastFrameSerial;
+
+    // В режиме GPU-отсечения матрицы примитивов лежат в буфере экземпляров (вслед за экземплярами),
+    // а буферы прохода отсечения рассчитаны на вместимость массива матриц
+    if (m_kgeVkGpuCulling) {
+        GrowInstanceBuffers(static_cast<std::size_t>(m_primitiveInstanceOffset) + capacity);
+    }
 
-        // Привязать графический конвейер
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    KGE_LOG_INFO("Vulkan: Model uniform buffer grown to {} objects", capacity);
+}
 
-        // Пройтись по всем примитивам
-        if (!primitives.empty()) {
-            for (unsigned int primitiveIndex = 0; primitiveIndex < primitives.size(); primitiveIndex++)
-            {
-                // Спиок динамических смещений для динамических UBO буферов в наборах дескрипторов
-                // При помощи выравниваниях получаем необходимое смещение для дескрипторов, чтобы была осуществлена привязка
-                // нужного буфера UBO (с матрицей модели) для конкретного примитива
-                std::vector<uint32_t> dynamicOffsets = {
-                    primitiveIndex * static_cast<uint32_t>(m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>())
-                };
+/**
+* Увеличение вместимости буфера экземпляров и буферов прохода GPU-отсечения
+* @param std::size_t requiredInstances - необходимое кол-во матриц в буфере экземпляров
+* @note - буфер экземпляров растет геометрически (не менее чем вдвое), проход отсечения пересоздается под текущую
+* вместимость массива матриц моделей (его наборы дескрипторов ссылаются и на буфер экземпляров). Прежние объекты
+* могут еще читаться отправленными кадрами, поэтому уходят в очередь отложенного удаления - ожидания очередей нет
+*/
+void KGEVulkanCore::GrowInstanceBuffers(std::size_t requiredInstances)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::GrowInstanceBuffers");
+    unsigned int imageCount = static_cast<unsigned int>(m_kgeSwapChain.swapchain().framebuffers.size());
+    bool growInstances = requiredInstances > m_kgeVkInstanceBuffer->maxInstances();
+    bool growCulling = m_kgeVkGpuCulling && (growInstances || m_kgeVkGpuCulling->maxObjects() < m_primitivesCapacity);
+    if (!growInstances && !growCulling) {
+        return;
+    }
 
-                // Наборы дескрипторов (массив наборов)
-                // По умолчанию в нем только основной
-                std::vector<VkDescriptorSet> descriptorSets = {
-                    descriptorSetMain
-                };
+    std::shared_ptr<KGEVkInstanceBuffer> instanceBuffer;
+    std::shared_ptr<KGEVkGpuCulling> gpuCulling;
 
-                // Если у примитива есть текстура
-                // Добавить в список дескрипторов еще один (отвечающий за подачу текстуры и параметров семплинга в шейдер)
-                if (primitives[primitiveIndex].texture != nullptr) {
-                    descriptorSets.push_back(primitives[primitiveIndex].texture->descriptorSet);
-                }
+    if (growInstances) {
+        unsigned int capacity = static_cast<unsigned int>(std::max<std::size_t>(m_kgeVkInstanceBuffer->maxInstances() * 2, requiredInstances));
+        instanceBuffer = std::move(m_kgeVkInstanceBuffer);
+        m_kgeVkInstanceBuffer = std::make_unique<KGEVkInstanceBuffer>(m_kgeVkDevice.device(), capacity, imageCount);
+        KGE_LOG_INFO("Vulkan: Instance buffer grown to {} matrices", capacity);
+    }
 
-                // Привязать наборы дескрипторов
-                vkCmdBindDescriptorSets(
-                            commandBuffers[i],
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipelineLayout,
-                            0,
-                            static_cast<uint32_t>(descriptorSets.size()),
-                            descriptorSets.data(),
-                            static_cast<uint32_t>(dynamicOffsets.size()),
-                            dynamicOffsets.data());
-
-                // Если нужно рисовать индексированную геометрию
-                if (primitives[primitiveIndex].drawIndexed && primitives[primitiveIndex].indexBuffer.count > 0) {
-                    // Привязать буфер вершин
-                    VkDeviceSize offsets[1] = { 0 };
-                    vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, &(primitives[primitiveIndex].vertexBuffer.vkBuffer), offsets);
-
-                    // Привязать буфер индексов
-                    vkCmdBindIndexBuffer(commandBuffers[i], primitives[primitiveIndex].indexBuffer.vkBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-                    // Отрисовка геометрии
-                    vkCmdDrawIndexed(commandBuffers[i], primitives[primitiveIndex].indexBuffer.count, 1, 0, 0, 0);
-                }
-                // Если индексация вершин не используется
-                else {
-                    // Привязать буфер вершин
-                    VkDeviceSize offsets[1] = { 0 };
-                    vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, &(primitives[primitiveIndex].vertexBuffer.vkBuffer), offsets);
+    if (growCulling) {
+        gpuCulling = std::move(m_kgeVkGpuCulling);
+        m_kgeVkGpuCulling = std::make_unique<KGEVkGpuCulling>(m_kgeVkDevice.device(),
+                                                              m_primitivesCapacity,
+                                                              imageCount,
+                                                              m_kgeVkInstanceBuffer->instanceBuffer(),
+                                                              m_kgeVkInstanceBuffer->regionSize());
 
-                    // Отрисовка
-                    vkCmdDraw(commandBuffers[i], primitives[primitiveIndex].vertexBuffer.count, 1, 0, 0);
-                }
+        // Описания объектов загружаются в области новых буферов заново
+        m_gpuCullObjectsVersion++;
+    }
 
-            }
-        }
+    // Набор отсечения удаляется раньше буфера экземпляров, на который он ссылается
+    m_kgeVkDeletionQueue.Defer([instanceBuffer, gpuCulling]() mutable {
+        gpuCulling.reset();
+        instanceBuffer.reset();
+    });
 
-        // Завершение прохода
-        vkCmdEndRenderPass(commandBuffers[i]);
+    // Командные буферы привязывают прежние буферы - каждое изображение перезапишется перед ближайшей отправкой (см. Draw)
+    m_drawListVersion++;
+}
 
-        // Завершение прохода добавит неявное преобразование памяти фрейм-буфера в
-        // VK_IMAGE_LAYOUT_PRESENT_SRC_KHR для представления содержимого
+/**
+* Добавление нового экземпляризированного примитива
+* @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+* @param const std::vector<unsigned int> &indices - массив индексов
+* @param kge::vkstructs::TextureHandle texture - хендл текстуры (общей для всех экземпляров)
+* @param const std::vector<glm::mat4> &instances - матрицы моделей экземпляров
+* @return unsigned int - индекс экземпляризированного примитива
+*
+* @note - геометрия хранится в одном экземпляре, а все экземпляры рисуются одной командой (instanceCount = кол-во матриц),
+* поэтому кол-во команд отрисовки не растет с кол-вом одинаковых объектов (лес, толпа, обломки и т.д.)
+*/
+unsigned int KGEVulkanCore::AddInstancedPrimitive(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                                  const std::vector<unsigned int> &indices,
+                                                  kge::vkstructs::TextureHandle texture,
+                                                  const std::vector<glm::mat4> &instances)
+{
+    kge::vkstructs::MeshHandle mesh = m_kgeVkMeshRegistry.Register(vertices, indices);
+    unsigned int index = AddInstancedPrimitive(mesh, texture, instances);
+    m_kgeVkMeshRegistry.Release(mesh);
 
-        // Завершение записи команд
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Vulkan: Error while preparing commands");
-        }
-    }
+    return index;
 }
 
 /**
-* Сброс командных буферов (для перезаписи)
-* @param const vktoolkit::Device &device - устройство, для получения хендлов очередей
-* @param std::vector<VkCommandBuffer> commandBuffers - массив хендлов командных буферов, которые необходимо сбросить
+* Добавление нового экземпляризированного примитива по хендлу зарегистрированной геометрии
+* @param kge::vkstructs::MeshHandle mesh - хендл геометрии
+* @param kge::vkstructs::TextureHandle texture - хендл текстуры (общей для всех экземпляров)
+* @param const std::vector<glm::mat4> &instances - матрицы моделей экземпляров
+* @return unsigned int - индекс экземпляризированного примитива
 */
-void KGEVulkanCore::ResetCommandBuffers(const kge::vkstructs::Device &device, std::vector<VkCommandBuffer> commandBuffers)
+unsigned int KGEVulkanCore::AddInstancedPrimitive(kge::vkstructs::MeshHandle mesh,
+                                                  kge::vkstructs::TextureHandle texture,
+                                                  const std::vector<glm::mat4> &instances)
 {
-    // Приостановить рендеринг
-    m_isReady = false;
+    // Конвейер экземпляризированной отрисовки создается при первом использовании
+    CreateInstancedPipeline();
 
-    // Подождать завершения всех команд в очередях
-    if (device.queues.graphics != nullptr && device.queues.present != nullptr) {
-        vkQueueWaitIdle(device.queues.graphics);
-        vkQueueWaitIdle(device.queues.present);
+    // Новый примитив
+    kge::vkstructs::InstancedPrimitive primitive;
+    primitive.texture = texture;
+    primitive.mesh = mesh;
+    primitive.instances = instances;
+
+    m_kgeVkMeshRegistry.AddRef(mesh);
+    m_instancedPrimitives.push_back(primitive);
+
+    // Распределить экземпляры по буферу экземпляров
+    // Командный буфер каждого изображения перезапишется перед его ближайшей отправкой (см. Draw)
+    LayoutInstances();
+    m_drawListVersion++;
+
+    // Вернуть индекс
+    return static_cast<unsigned int>(m_instancedPrimitives.size() - 1);
+}
+
+/**
+* Обновление матриц экземпляров
+* @param unsigned int instancedPrimitiveIndex - индекс экземпляризированного примитива
+* @param const std::vector<glm::mat4> &instances - новые матрицы моделей экземпляров
+*/
+void KGEVulkanCore::SetInstanceTransforms(unsigned int instancedPrimitiveIndex,
+                                          const std::vector<glm::mat4> &instances)
+{
+    if (instancedPrimitiveIndex >= m_instancedPrimitives.size()) {
+        throw std::runtime_error("Vulkan: Error. Instanced primitive index is out of range");
+    }
+
+    bool countChanged = m_instancedPrimitives[instancedPrimitiveIndex].instances.size() != instances.size();
+    m_instancedPrimitives[instancedPrimitiveIndex].instances = instances;
+
+    // Кол-во экземпляров записано в командах отрисовки - при его изменении команды нужно перезаписать
+    if (countChanged) {
+        LayoutInstances();
+        m_drawListVersion++;
+    }
+}
+
+/**
+* Перемещение примитива
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @param glm::vec3 position - положение относительно родителя (либо глобального центра)
+* @param glm::vec3 rotaton - вращение вокруг локального центра
+*
+* @note - мировые матрицы примитива и его потомков, а вместе с ними и границы (сфера для отсечения, AABB в иерархии),
+* пересчитываются в ближайшем Update
+*/
+void KGEVulkanCore::SetPrimitiveTransform(kge::vkstructs::PrimitiveHandle primitive,
+                                          glm::vec3 position,
+                                          glm::vec3 rotaton)
+{
+    kge::vkstructs::Transform &transform = *m_ecsWorld.Get<kge::vkstructs::Transform>(PrimitiveEntity(primitive));
+    transform.position = position;
+    transform.rotation = rotaton;
+
+    glm::mat4 local = transform.MakeModelMatrix();
+    m_sceneGraph.SetLocalTransform(transform.node, &local[0][0]);
+}
+
+/**
+* Смена родителя примитива
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @param kge::vkstructs::PrimitiveHandle parent - хендл родительского примитива (хендл по умолчанию - сделать примитив корневым)
+* @note - положение и поворот примитива становятся относительными к родителю
+*/
+void KGEVulkanCore::SetPrimitiveParent(kge::vkstructs::PrimitiveHandle primitive, kge::vkstructs::PrimitiveHandle parent)
+{
+    kge::scene::NodeId parentNode = parent == kge::vkstructs::PrimitiveHandle() ?
+                kge::scene::INVALID_NODE :
+                m_ecsWorld.Get<kge::vkstructs::Transform>(PrimitiveEntity(parent))->node;
+
+    m_sceneGraph.SetParent(m_ecsWorld.Get<kge::vkstructs::Transform>(PrimitiveEntity(primitive))->node, parentNode);
+}
+
+/**
+* Вращение примитива с постоянной скоростью
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @param glm::vec3 angularVelocity - скорость вращения вокруг осей (градусов в секунду), нулевая - остановить
+* @note - у неподвижных примитивов нет компонента анимации, поэтому проход анимации их не затрагивает
+*/
+void KGEVulkanCore::SetPrimitiveAnimation(kge::vkstructs::PrimitiveHandle primitive, glm::vec3 angularVelocity)
+{
+    kge::ecs::Entity entity = PrimitiveEntity(primitive);
+    if (angularVelocity == glm::vec3(0.0f)) {
+        m_ecsWorld.Remove<kge::vkstructs::Animation>(entity);
+        return;
+    }
+
+    kge::vkstructs::Animation animation;
+    animation.angularVelocity = angularVelocity;
+    m_ecsWorld.Add(entity, animation);
+}
+
+/**
+* Задание уровней детализации примитива
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @param const std::vector<kge::vkstructs::MeshLodLevel> &levels - упрощенная геометрия по возрастанию отклонения, пустой массив - отключить
+* @note - примитив держит ссылки на геометрию всех уровней. Сначала берутся ссылки на новые уровни, затем освобождаются
+* ссылки прежних - геометрия, общая для прежней и новой цепочки, не освобождается. Освобождение сразу безопасно:
+* реестр удаляет буферы через очередь отложенного удаления, а командные буферы перезаписываются до следующей отправки
+*/
+void KGEVulkanCore::SetPrimitiveLods(kge::vkstructs::PrimitiveHandle primitive, const std::vector<kge::vkstructs::MeshLodLevel> &levels)
+{
+    kge::ecs::Entity entity = PrimitiveEntity(primitive);
+    kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(entity);
+
+    if (levels.size() + 1 > kge::vkstructs::MESH_LOD_MAX_LEVELS) {
+        throw std::runtime_error("Vulkan: Error. Too many LOD levels");
+    }
+
+    // Исходная геометрия (текущей может быть геометрия одного из прежних уровней)
+    const kge::vkstructs::MeshLod* previous = m_ecsWorld.Get<kge::vkstructs::MeshLod>(entity);
+    kge::vkstructs::MeshHandle baseMesh = previous != nullptr ? previous->levels[0].mesh : renderable.mesh;
+
+    // Уровни рисуются на месте исходной геометрии (в т.ч. в тех же пакетах GPU-отсечения), поэтому способ отрисовки должен совпадать
+    bool baseIndexed = m_kgeVkMeshRegistry.mesh(baseMesh).drawIndexed;
+    for (const kge::vkstructs::MeshLodLevel &level : levels) {
+        if (m_kgeVkMeshRegistry.mesh(level.mesh).drawIndexed != baseIndexed) {
+            throw std::runtime_error("Vulkan: Error. LOD mesh must be drawn the same way as the base mesh");
+        }
+    }
+
+    m_drawListVersion++;
+
+    // Прежние уровни копируются - компонент перезаписывается (либо удаляется) раньше, чем освобождаются их ссылки
+    kge::vkstructs::MeshLod released;
+    if (previous != nullptr) {
+        released = *previous;
+    }
+
+    renderable.mesh = baseMesh;
+
+    if (levels.empty()) {
+        m_ecsWorld.Remove<kge::vkstructs::MeshLod>(entity);
+    }
+    else {
+        kge::vkstructs::MeshLod lod;
+        lod.levels[0].mesh = baseMesh;
+        for (const kge::vkstructs::MeshLodLevel &level : levels) {
+            m_kgeVkMeshRegistry.AddRef(level.mesh);
+            lod.levels[++lod.levelCount] = level;
+        }
+        lod.levelCount++;
+        m_ecsWorld.Add(entity, lod);
+    }
+
+    for (uint32_t i = 1; i < released.levelCount; i++) {
+        m_kgeVkMeshRegistry.Release(released.levels[i].mesh);
+    }
+
+    if (m_cullingMode == CullingGpu) {
+        m_gpuDrawBatchesDirty = true;
+    }
+}
+
+/**
+* Допустимое отклонение упрощенной геометрии на экране
+* @param float pixels - отклонение в пикселях
+*/
+void KGEVulkanCore::SetLodPixelError(float pixels)
+{
+    m_lodPixelError = pixels;
+}
+
+/**
+* Поиск ближайшего примитива, пересекаемого лучом
+* @param const glm::vec3 &origin - начало луча
+* @param const glm::vec3 &direction - направление луча
+* @return kge::vkstructs::PrimitiveHandle - хендл примитива (хендл по умолчанию если пересечений нет)
+*/
+kge::vkstructs::PrimitiveHandle KGEVulkanCore::PickPrimitive(const glm::vec3 &origin, const glm::vec3 &direction)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::PickPrimitive");
+    SyncBvh();
+
+    kge::math::RayHit hit = m_bvh.Raycast(&origin[0], &direction[0], std::numeric_limits<float>::max());
+    if (hit.object == UINT32_MAX) {
+        return {};
+    }
+
+    uint32_t slot = m_bvhObjectSlots[hit.object];
+    return { slot, m_primitiveGenerations[slot] };
+}
+
+/**
+* Примитивы, чьи AABB пересекаются с заданной областью
+* @param const glm::vec3 &min - минимальная точка области
+* @param const glm::vec3 &max - максимальная точка области
+* @return std::vector<kge::vkstructs::PrimitiveHandle> - хендлы примитивов
+*/
+std::vector<kge::vkstructs::PrimitiveHandle> KGEVulkanCore::QueryPrimitives(const glm::vec3 &min, const glm::vec3 &max)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::QueryPrimitives");
+    SyncBvh();
+
+    kge::math::Aabb bounds;
+    for (int axis = 0; axis < 3; axis++) {
+        bounds.min[axis] = min[axis];
+        bounds.max[axis] = max[axis];
+    }
+
+    std::vector<uint32_t> objects;
+    m_bvh.QueryOverlap(bounds, objects);
+
+    std::vector<kge::vkstructs::PrimitiveHandle> primitives;
+    primitives.reserve(objects.size());
+    for (uint32_t object : objects) {
+        uint32_t slot = m_bvhObjectSlots[object];
+        primitives.push_back({ slot, m_primitiveGenerations[slot] });
+    }
+    return primitives;
+}
+
+/**
+* Распределение экземпляров по буферу экземпляров
+* @note - экземпляры всех примитивов лежат в области буфера подряд, firstInstance - индекс первой матрицы примитива в области
+*/
+void KGEVulkanCore::LayoutInstances()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::LayoutInstances");
+    std::size_t totalInstances = 0;
+    for (const kge::vkstructs::InstancedPrimitive &primitive : m_instancedPrimitives) {
+        totalInstances += primitive.instances.size();
+    }
+
+    // В режиме GPU-отсечения за экземплярами лежат матрицы обычных примитивов
+    std::size_t primitiveMatrices = m_cullingMode == CullingGpu ? m_primitives.size() : 0;
+
+    // Буфер заполнен - увеличить (в среднем O(1) на добавление)
+    if (totalInstances + primitiveMatrices > m_kgeVkInstanceBuffer->maxInstances()) {
+        GrowInstanceBuffers(totalInstances + primitiveMatrices);
+    }
+
+    uint32_t firstInstance = 0;
+    for (kge::vkstructs::InstancedPrimitive &primitive : m_instancedPrimitives) {
+        primitive.firstInstance = firstInstance;
+        firstInstance += static_cast<uint32_t>(primitive.instances.size());
+    }
+
+    // Индексы матриц примитивов изменились - описания объектов отсечения нужно пересобрать (перед записью команд)
+    m_primitiveInstanceOffset = firstInstance;
+    if (m_cullingMode == CullingGpu) {
+        m_gpuDrawBatchesDirty = true;
+    }
+}
+
+/**
+* Создание конвейера экземпляризированной отрисовки (если он еще не создан)
+* @note - конвейер используется экземпляризированными примитивами и косвенной отрисовкой GPU-отсечения
+*/
+void KGEVulkanCore::CreateInstancedPipeline()
+{
+    if (!m_kgeVkGraphicsPipelineInstanced) {
+        m_kgeVkGraphicsPipelineInstanced = std::make_unique<KGEVkGraphicsPipeline>(
+                    m_kgeVkDevice.device(),
+                    m_kgeVkPipelineLayout.pipelineLayout(),
+                    m_kgeSwapChain.swapchain(),
+                    m_kgeRenderPass.renderPass(),
+                    m_vertexLayout,
+                    "vert_instanced.spv",
+                    true);
+    }
+}
+
+/**
+* Группировка индексированных примитивов в пакеты косвенной отрисовки и подготовка описаний для GPU-отсечения
+* @note - пакет объединяет примитивы с одинаковой геометрией и текстурой (одна привязка буферов и текстуры на пакет).
+* При уплотнении (есть vkCmdDrawIndexedIndirectCountKHR) все объекты пакета пишут команды начиная с первой ячейки пакета,
+* иначе у каждого объекта своя ячейка. Описания попадут в области буфера объектов в UploadUniformRegion
+*/
+void KGEVulkanCore::RebuildGpuDrawBatches()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::RebuildGpuDrawBatches");
+    m_gpuDrawBatches.clear();
+    m_gpuCullObjects.clear();
+    m_gpuDrawBatchesDirty = false;
+
+    // Пакет каждого примитива (UINT32_MAX - примитив рисуется на хосте)
+    std::map<std::pair<kge::vkstructs::MeshHandle, kge::vkstructs::TextureHandle>, uint32_t> batchIndices;
+    std::vector<uint32_t> primitiveBatches(m_primitives.size(), UINT32_MAX);
+
+    for (std::size_t i = 0; i < m_primitives.size(); i++) {
+        if (!m_ecsWorld.Alive(m_primitives[i])) {
+            continue;
+        }
+
+        const kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(m_primitives[i]);
+        const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(renderable.mesh);
+        if (!mesh.drawIndexed || mesh.indexBuffer.count == 0) {
+            continue;
+        }
+
+        auto key = std::make_pair(renderable.mesh, renderable.texture);
+        auto it = batchIndices.find(key);
+        if (it == batchIndices.end()) {
+            it = batchIndices.emplace(key, static_cast<uint32_t>(m_gpuDrawBatches.size())).first;
+
+            kge::vkstructs::GpuDrawBatch batch;
+            batch.mesh = renderable.mesh;
+            batch.texture = renderable.texture;
+            m_gpuDrawBatches.push_back(batch);
+        }
+
+        m_gpuDrawBatches[it->second].commandCapacity++;
+        primitiveBatches[i] = it->second;
+    }
+
+    // Ячейки команд пакетов идут подряд
+    uint32_t commandOffset = 0;
+    for (kge::vkstructs::GpuDrawBatch &batch : m_gpuDrawBatches) {
+        batch.commandOffset = commandOffset;
+        commandOffset += batch.commandCapacity;
+    }
+
+    bool compact = m_kgeVkDevice.device()->cmdDrawIndexedIndirectCount != nullptr;
+    std::vector<uint32_t> batchFill(m_gpuDrawBatches.size(), 0);
+
+    for (std::size_t i = 0; i < m_primitives.size(); i++) {
+        if (primitiveBatches[i] == UINT32_MAX) {
+            continue;
+        }
+
+        const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(m_ecsWorld.Get<kge::vkstructs::Renderable>(m_primitives[i])->mesh);
+        const kge::vkstructs::GpuDrawBatch &batch = m_gpuDrawBatches[primitiveBatches[i]];
+
+        kge::vkstructs::GpuCullObject object;
+        object.sphere = glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, mesh.boundingRadius);
+        object.indexCount = mesh.indexBuffer.count;
+        object.batch = primitiveBatches[i];
+        object.commandSlot = compact ? batch.commandOffset : batch.commandOffset + batchFill[primitiveBatches[i]]++;
+        object.firstInstance = m_primitiveInstanceOffset + static_cast<uint32_t>(i);
+        m_gpuCullObjects.push_back(object);
+    }
+
+    m_gpuCullObjectsVersion++;
+}
+
+/**
+* Сортировка списка отрисовки по ключам (текстура, геометрия, глубина)
+* @param std::vector<uint32_t> &drawList - индексы примитивов
+* @note - примитивы с одинаковой текстурой и геометрией оказываются рядом (повторные привязки пропускаются при записи),
+* внутри группы - от ближних к дальним (меньше перекрытой работы фрагментного шейдера). Глубина определяет только порядок
+* и берется на момент сортировки: пока набор видимых не меняется, список не пересортировывается
+*/
+void KGEVulkanCore::SortDrawList(std::vector<uint32_t> &drawList)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::SortDrawList");
+    // Глубина квантуется в 24 бита на отрезке [0, дальняя грань]
+    const float depthScale = static_cast<float>(DRAW_KEY_DEPTH_MASK) / m_camera.fFar;
+
+    m_drawSortKeys.resize(drawList.size());
+    for (std::size_t i = 0; i < drawList.size(); i++) {
+        kge::ecs::Entity entity = m_primitives[drawList[i]];
+        const kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(entity);
+        const kge::vkstructs::Bounds &bounds = *m_ecsWorld.Get<kge::vkstructs::Bounds>(entity);
+
+        // Расстояние вдоль оси взгляда (камера смотрит вдоль -Z пространства вида)
+        float viewDepth = -(m_uboWorld.viewMatrix * glm::vec4(bounds.sphereCenter, 1.0f)).z;
+        uint64_t depth = static_cast<uint64_t>(glm::clamp(viewDepth * depthScale, 0.0f, static_cast<float>(DRAW_KEY_DEPTH_MASK)));
+
+        // Ячейки пулов текстур и геометрии (0 - без текстуры)
+        uint64_t texture = renderable.texture.valid() ? static_cast<uint64_t>(renderable.texture.index()) + 1 : 0;
+        uint64_t mesh = renderable.mesh.index();
+
+        m_drawSortKeys[i] = ((texture & DRAW_KEY_TEXTURE_MASK) << DRAW_KEY_TEXTURE_SHIFT) |
+                            ((mesh & DRAW_KEY_MESH_MASK) << DRAW_KEY_MESH_SHIFT) |
+                            depth;
+    }
+
+    kge::sort::RadixSort(m_drawSortKeys, drawList, m_drawSortKeysScratch, m_drawSortScratch);
+}
+
+/**
+* Выбор уровней детализации примитивов по отклонению, спроецированному на экран
+* @note - отклонение уровня в пикселях: ошибка * масштаб * высота экрана / (2 * tg(угол обзора / 2) * расстояние),
+* расстояние берется до ближайшей точки ограничивающей сферы. Выбирается самый грубый уровень, чье отклонение
+* не превышает допустимое; к более грубому уровню примитив переходит с запасом LOD_HYSTERESIS, к более точному - сразу
+*/
+void KGEVulkanCore::SelectLods()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::SelectLods");
+    // Пикселей на единицу длины на единичном расстоянии от камеры
+    const float pixelsPerUnit = static_cast<float>(m_kgeSwapChain.swapchain().imageExtent.height) /
+            (2.0f * std::tan(glm::radians(m_camera.fFOV) * 0.5f));
+    const float refineError = m_lodPixelError;
+    const float coarsenError = m_lodPixelError * (1.0f - LOD_HYSTERESIS);
+
+    std::atomic<bool> changed{false};
+
+    m_ecsWorld.ParallelEach<kge::vkstructs::Transform, kge::vkstructs::Renderable, kge::vkstructs::Bounds, kge::vkstructs::MeshLod>(m_jobSystem,
+            [&](kge::ecs::Entity, kge::vkstructs::Transform &transform, kge::vkstructs::Renderable &renderable, kge::vkstructs::Bounds &bounds, kge::vkstructs::MeshLod &lod) {
+        // Ошибка задана в пространстве модели - учесть наибольший масштаб мировой матрицы
+        const glm::mat4 &world = *reinterpret_cast<const glm::mat4*>(m_sceneGraph.worldTransform(transform.node).m);
+        float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+
+        glm::vec3 viewCenter = glm::vec3(m_uboWorld.viewMatrix * glm::vec4(bounds.sphereCenter, 1.0f));
+        float distance = std::max(glm::length(viewCenter) - bounds.sphereRadius, m_camera.fNear);
+        float projection = pixelsPerUnit * scale / distance;
+
+        uint32_t level = lod.level;
+        while (level + 1 < lod.levelCount && lod.levels[level + 1].geometricError * projection <= coarsenError) {
+            level++;
+        }
+        while (level > 0 && lod.levels[level].geometricError * projection > refineError) {
+            level--;
+        }
+
+        if (level != lod.level) {
+            lod.level = level;
+            renderable.mesh = lod.levels[level].mesh;
+            changed.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    // Геометрия записана в командах отрисовки (в режиме GPU-отсечения - в пакетах косвенной отрисовки)
+    if (changed.load()) {
+        if (m_cullingMode == CullingGpu) {
+            m_gpuDrawBatchesDirty = true;
+        }
+        else {
+            m_drawListVersion++;
+        }
+    }
+}
+
+/**
+* Статистика записи команд отрисовки (последний записанный командный буфер)
+* @return const kge::vkstructs::DrawStats& - кол-во отрисовок, привязок и пропущенных повторных привязок
+*/
+const kge::vkstructs::DrawStats &KGEVulkanCore::drawStats() const
+{
+    return m_drawStats;
+}
+
+/**
+* Подготовка иерархии AABB к запросам
+* @note - после добавления/удаления примитивов иерархия строится заново (параллельно, в системе задач),
+* иначе уточняются границы только перемещенных примитивов. В иерархию попадают только занятые позиции,
+* поэтому объекты иерархии и позиции примитивов связаны таблицами
+*/
+void KGEVulkanCore::SyncBvh()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::SyncBvh");
+    if (!m_bvhDirty) {
+        m_bvh.Refit();
+        return;
+    }
+
+    std::vector<kge::math::Aabb> bounds;
+    bounds.reserve(m_primitives.size());
+    m_bvhObjectSlots.clear();
+    m_slotBvhObjects.assign(m_primitives.size(), UINT32_MAX);
+
+    for (std::size_t i = 0; i < m_primitives.size(); i++) {
+        if (!m_ecsWorld.Alive(m_primitives[i])) {
+            continue;
+        }
+
+        m_slotBvhObjects[i] = static_cast<uint32_t>(m_bvhObjectSlots.size());
+        m_bvhObjectSlots.push_back(static_cast<uint32_t>(i));
+        bounds.push_back(PrimitiveAabb(*m_ecsWorld.Get<kge::vkstructs::Bounds>(m_primitives[i])));
+    }
+
+    m_bvh.Build(bounds, m_jobSystem);
+    m_bvhDirty = false;
+}
+
+/**
+* Создание текстуры по данным о пикселях
+* @param const unsigned char* pixels - пиксели загруженные из файла
+* @return kge::vkstructs::TextureHandle - хендл текстуры в пуле текстур рендерера
+*
+* @note - при загрузке используется временный буфер для перемещения в изображение, распологающееся в памяти устройства.
+* Нельзя сразу создать изображение в памяти устройства и переместить в него данные. Это можно сделать только пр помощи
+* команды копирования (из памяти доступной хосту в память доступную только устройству), см. CreateTextures
+*/
+kge::vkstructs::TextureHandle KGEVulkanCore::CreateTexture(const unsigned char *pixels,
+                                                           uint32_t width,
+                                                           uint32_t height,
+                                                           uint32_t channels,
+                                                           uint32_t bpp)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::CreateTexture");
+    // Если данных не обнаружено
+    if (!pixels) {
+        throw std::runtime_error("Vulkan: Error while creating texture. Empty pixel buffer recieved");
+    }
+
+    // Один мип-уровень (ожидаем по умолчанию 4 байта на пиксель, в режиме RGBA)
+    kge::vkstructs::TextureSource source;
+    source.width = width;
+    source.height = height;
+    source.mips.push_back({ pixels, static_cast<VkDeviceSize>(width) * height * bpp });
+
+    return CreateTextures({ source })[0];
+}
+
+/**
+* Выделение и заполнение текстурного набора дескрипторов
+* @param kge::vkstructs::Texture &texture - текстура (изображение создано, набор будет записан в нее)
+*/
+void KGEVulkanCore::AllocateTextureDescriptorSet(kge::vkstructs::Texture &texture)
+{
+    // Получить новый набор дескрипторов из дескриптороного пула
+    VkDescriptorSetAllocateInfo descriptorSetAllocInfo = {};
+    descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocInfo.descriptorPool = m_kgeVkDescriptorPoolTextures.descriptorPool();
+    descriptorSetAllocInfo.descriptorSetCount = 1;
+    descriptorSetAllocInfo.pSetLayouts = &(m_kgeVkDescriptorSetLayoutTextures.descriptorSetLayout());
+
+    if (vkAllocateDescriptorSets(m_kgeVkDevice.device()->logicalDevice, &descriptorSetAllocInfo, &(texture.descriptorSet)) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error in vkAllocateDescriptorSets. Can't allocate descriptor set for texture");
+    }
+
+    // Информация о передаваемом изображении
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = texture.image.vkImageView;
+    imageInfo.sampler = m_kgeVkSampler.sampler();
+
+    // Конфигурация добавляемых в набор дескрипторов
+    std::vector<VkWriteDescriptorSet> writes =
+    {
+        {
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,      // Тип структуры
+            nullptr,                                     // pNext
+            texture.descriptorSet,                       // Целевой набор дескрипторов
+            0,                                           // Точка привязки (у шейдера)
+            0,                                           // Элемент массив (массив не используется)
+            1,                                           // Кол-во дескрипторов
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,   // Тип дескриптора
+            &imageInfo,                                  // Информация о параметрах изображения
+            nullptr,
+            nullptr
+        }
+    };
+
+    // Обновить наборы дескрипторов
+    vkUpdateDescriptorSets(m_kgeVkDevice.device()->logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+/**
+* Создание набора текстур одной отправкой команд
+* @param const std::vector<kge::vkstructs::TextureSource> &sources - текстуры (RGBA, с мип-уровнями либо без)
+* @return std::vector<kge::vkstructs::TextureHandle> - хендлы текстур в порядке источников
+*
+* @note - пиксели всех уровней всех текстур копируются в один промежуточный буфер, затем один командный буфер переводит
+* размещения и копирует данные во все изображения (vkCmdCopyBufferToImage - без промежуточных линейных изображений)
+* и отправляется один раз. Очереди и устройство не ожидаются: промежуточный буфер освобождается по сигналу забора
+* отправки (см. CollectUploads), а текстуры доступны сразу - кадры отправляются в ту же очередь позже загрузки,
+* и барьер перевода в VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL упорядочивает их чтение после копирования
+*/
+std::vector<kge::vkstructs::TextureHandle> KGEVulkanCore::CreateTextures(const std::vector<kge::vkstructs::TextureSource> &sources)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::CreateTextures");
+    std::vector<kge::vkstructs::TextureHandle> handles;
+    if (sources.empty()) {
+        return handles;
+    }
+
+    std::vector<kge::vkstructs::Texture> textures(sources.size());
+
+    // Смещения уровней в промежуточном буфере (размер RGBA пикселя - 4 байта, поэтому смещения кратны размеру пикселя)
+    std::vector<std::vector<VkDeviceSize>> offsets(sources.size());
+    VkDeviceSize stagingSize = 0;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].mips.empty()) {
+            throw std::runtime_error("Vulkan: Error while creating texture. No pixel data recieved");
+        }
+        for (const kge::vkstructs::TextureMip &mip : sources[i].mips) {
+            offsets[i].push_back(stagingSize);
+            stagingSize += mip.size;
+        }
+    }
+
+    kge::vkstructs::Buffer staging = kge::vkutility::CreateBuffer(*m_kgeVkDevice.device(),
+                                                                  stagingSize,
+                                                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    unsigned char* stagingData = nullptr;
+    vkMapMemory(m_kgeVkDevice.device()->logicalDevice, staging.vkDeviceMemory, 0, stagingSize, 0, reinterpret_cast<void**>(&stagingData));
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        for (std::size_t level = 0; level < sources[i].mips.size(); level++) {
+            memcpy(stagingData + offsets[i][level], sources[i].mips[level].data, static_cast<size_t>(sources[i].mips[level].size));
+        }
+    }
+    vkUnmapMemory(m_kgeVkDevice.device()->logicalDevice, staging.vkDeviceMemory);
+
+    VkCommandBuffer uploadCmdBuffer = kge::vkutility::CreateSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool());
+
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        uint32_t mipLevels = static_cast<uint32_t>(sources[i].mips.size());
+
+        VkImageSubresourceRange subresourceRange = {};
+        subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        subresourceRange.baseMipLevel = 0;
+        subresourceRange.levelCount = mipLevels;
+        subresourceRange.baseArrayLayer = 0;
+        subresourceRange.layerCount = 1;
+
+        textures[i].image = kge::vkutility::CreateImageSingle(*m_kgeVkDevice.device(),
+                                                              VK_IMAGE_TYPE_2D,
+                                                              VK_FORMAT_R8G8B8A8_UNORM,
+                                                              { sources[i].width, sources[i].height, 1 },
+                                                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                                              VK_IMAGE_ASPECT_COLOR_BIT,
+                                                              VK_IMAGE_LAYOUT_UNDEFINED,
+                                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                              VK_IMAGE_TILING_OPTIMAL,
+                                                              VK_SHARING_MODE_EXCLUSIVE,
+                                                              mipLevels);
+
+        kge::vkutility::CmdImageLayoutTransition(uploadCmdBuffer, textures[i].image.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+
+        // По одному региону копирования на мип-уровень
+        std::vector<VkBufferImageCopy> regions(mipLevels);
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            regions[level] = {};
+            regions[level].bufferOffset = offsets[i][level];
+            regions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[level].imageSubresource.mipLevel = level;
+            regions[level].imageSubresource.baseArrayLayer = 0;
+            regions[level].imageSubresource.layerCount = 1;
+            regions[level].imageExtent = { std::max(1u, sources[i].width >> level), std::max(1u, sources[i].height >> level), 1 };
+        }
+        vkCmdCopyBufferToImage(uploadCmdBuffer, staging.vkBuffer, textures[i].image.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               mipLevels, regions.data());
+
+        kge::vkutility::CmdImageLayoutTransition(uploadCmdBuffer, textures[i].image.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+    }
+
+    // Одна отправка на все текстуры (без ожидания)
+    SubmitUpload(uploadCmdBuffer, staging, nullptr);
+
+    handles.reserve(textures.size());
+    for (kge::vkstructs::Texture &texture : textures) {
+        AllocateTextureDescriptorSet(texture);
+        handles.push_back(m_textures.Add(texture));
+    }
+
+    return handles;
+}
+
+/**
+* Отправка команд загрузки без ожидания очереди
+* @param VkCommandBuffer commandBuffer - буфер одиночных команд (см. kge::vkutility::CreateSingleTimeCommandBuffer)
+* @param const kge::vkstructs::Buffer &staging - промежуточный буфер (может отсутствовать)
+* @param std::function<void()> completed - вызывается после сигнала забора отправки (может отсутствовать)
+*
+* @note - для очереди отложенного удаления отправка считается кадром: ресурсы, освобожденные после нее (в т.ч. изображения,
+* в которые либо из которых идет копирование), удаляются только по завершении следующего за ней кадра
+*/
+void KGEVulkanCore::SubmitUpload(VkCommandBuffer commandBuffer, const kge::vkstructs::Buffer &staging, std::function<void()> completed)
+{
+    kge::vkstructs::PendingUpload upload;
+    upload.commandBuffer = commandBuffer;
+    upload.staging = staging;
+    upload.completed = std::move(completed);
+    upload.fence = kge::vkutility::SubmitSingleTimeCommandBuffer(*m_kgeVkDevice.device(), commandBuffer, m_kgeVkDevice.device()->queues.graphics);
+    m_pendingUploads.push_back(std::move(upload));
+
+    m_kgeVkDeletionQueue.FrameSubmitted();
+}
+
+/**
+* Освобождение командных и промежуточных буферов завершенных загрузок (см. kge::vkstructs::PendingUpload)
+* @note - заборы опрашиваются без ожидания. После ожидания устройства (Pause) завершены все загрузки
+*/
+void KGEVulkanCore::CollectUploads()
+{
+    if (m_pendingUploads.empty()) {
+        return;
+    }
+
+    VkDevice logicalDevice = m_kgeVkDevice.device()->logicalDevice;
+
+    // Завершенные загрузки снимаются с учета до обработки - обработка может отправить новые
+    std::vector<kge::vkstructs::PendingUpload> finished;
+    for (auto it = m_pendingUploads.begin(); it != m_pendingUploads.end();) {
+        if (vkGetFenceStatus(logicalDevice, it->fence) == VK_SUCCESS) {
+            finished.push_back(std::move(*it));
+            it = m_pendingUploads.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (kge::vkstructs::PendingUpload &upload : finished) {
+        vkDestroyFence(logicalDevice, upload.fence, kge::vkutility::HostAllocator());
+        vkFreeCommandBuffers(logicalDevice, m_kgeVkCommandPool.commandPool(), 1, &upload.commandBuffer);
+        if (upload.staging.vkBuffer != nullptr) {
+            vkDestroyBuffer(logicalDevice, upload.staging.vkBuffer, kge::vkutility::HostAllocator());
+            kge::vkutility::FreeMemory(logicalDevice, upload.staging.vkDeviceMemory);
+        }
+        if (upload.completed) {
+            upload.completed();
+        }
+    }
+}
+
+/**
+* Загрузка импортированной модели в память устройства
+* @note - текстуры, которые не удалось декодировать при импорте, пропускаются (их сетки рисуются без текстуры)
+*/
+kge::vkstructs::Model KGEVulkanCore::UploadModel(const kge::assets::ModelData &model)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::UploadModel");
+    if (!model.error.empty()) {
+        throw std::runtime_error("Vulkan: Error while uploading model. " + model.error);
+    }
+
+    kge::vkstructs::Model result;
+
+    // Текстуры (индексы сдвигаются, если какие-то текстуры пропущены). Импортер мип-уровни не строит
+    std::vector<kge::vkstructs::TextureSource> sources;
+    std::vector<int32_t> textureIndices(model.textures.size(), -1);
+    for (std::size_t i = 0; i < model.textures.size(); i++) {
+        const kge::assets::TextureData &texture = model.textures[i];
+        if (!texture.pixels.empty()) {
+            textureIndices[i] = static_cast<int32_t>(sources.size());
+
+            kge::vkstructs::TextureSource source;
+            source.width = texture.width;
+            source.height = texture.height;
+            source.mips.push_back({ texture.pixels.data(), static_cast<VkDeviceSize>(texture.pixels.size()) });
+            sources.push_back(std::move(source));
+        }
+    }
+    result.textures = CreateTextures(sources);
+
+    // Геометрия (память доступная хосту, команды копирования не нужны)
+    for (const kge::assets::MeshData &mesh : model.meshes) {
+        kge::vkstructs::ModelMesh modelMesh;
+        modelMesh.mesh = m_kgeVkMeshRegistry.Register(mesh.levels[0].vertices, mesh.levels[0].indices);
+        for (std::size_t level = 1; level < mesh.levels.size(); level++) {
+            modelMesh.lods.push_back({ m_kgeVkMeshRegistry.Register(mesh.levels[level].vertices, mesh.levels[level].indices),
+                                       mesh.levels[level].geometricError });
+        }
+        modelMesh.texture = mesh.texture >= 0 ? textureIndices[mesh.texture] : -1;
+        result.meshes.push_back(std::move(modelMesh));
+    }
+    result.nodes = model.nodes;
+
+    KGE_LOG_INFO("Vulkan: Model {} uploaded ({} meshes, {} nodes, {} textures)",
+                 model.file, result.meshes.size(), result.nodes.size(), result.textures.size());
+
+    return result;
+}
+
+/**
+* Регистрация геометрии из блока пакета
+* @note - данные копируются из отображения пакета прямо в буферы устройства (без разбора и промежуточных массивов)
+*/
+kge::vkstructs::MeshHandle KGEVulkanCore::RegisterPackagedMesh(const KGEPackage &package, uint64_t nameHash, float* geometricError)
+{
+    const kge::pak::PackageEntry* entry = package.Find(nameHash);
+    if (entry == nullptr || entry->type != kge::pak::BlobMesh || entry->size < sizeof(kge::pak::MeshBlob)) {
+        throw std::runtime_error("Vulkan: Error while loading packaged mesh. Mesh blob not found in " + package.path());
+    }
+
+    const unsigned char* data = package.Data(*entry);
+    const kge::pak::MeshBlob* blob = reinterpret_cast<const kge::pak::MeshBlob*>(data);
+
+    VkDeviceSize vertexStride = m_kgeVkMeshRegistry.vertexLayout() == VertexLayoutCompact ?
+                sizeof(kge::vkstructs::VertexCompact) : sizeof(kge::vkstructs::Vertex);
+
+    if (blob->vertexLayout != static_cast<uint32_t>(m_kgeVkMeshRegistry.vertexLayout())) {
+        throw std::runtime_error("Vulkan: Error while loading packaged mesh. Package " + package.path() +
+                                 " is cooked for another vertex layout");
+    }
+    if (blob->vertexBytes != blob->vertexCount * vertexStride ||
+            blob->indexBytes != static_cast<uint64_t>(blob->indexCount) * blob->indexSize ||
+            (blob->indexSize != 2 && blob->indexSize != 4) ||
+            blob->vertexOffset + blob->vertexBytes > entry->size ||
+            blob->indexOffset + blob->indexBytes > entry->size) {
+        throw std::runtime_error("Vulkan: Error while loading packaged mesh. Corrupted mesh blob in " + package.path());
+    }
+
+    kge::vkstructs::EncodedMesh encoded;
+    encoded.vertexData = data + blob->vertexOffset;
+    encoded.vertexBytes = blob->vertexBytes;
+    encoded.vertexCount = blob->vertexCount;
+    encoded.indexData = data + blob->indexOffset;
+    encoded.indexBytes = blob->indexBytes;
+    encoded.indexCount = blob->indexCount;
+    encoded.indexType = blob->indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    encoded.boundsMin = { blob->boundsMin[0], blob->boundsMin[1], blob->boundsMin[2] };
+    encoded.boundsMax = { blob->boundsMax[0], blob->boundsMax[1], blob->boundsMax[2] };
+    encoded.boundingRadius = blob->boundingRadius;
+
+    if (geometricError != nullptr) {
+        *geometricError = blob->geometricError;
+    }
+
+    return m_kgeVkMeshRegistry.RegisterEncoded(encoded);
+}
+
+/**
+* Загрузка модели из пакета ресурсов в память устройства
+* @note - сетки и мип-уровни текстур уже в формате устройства, поэтому загрузка сводится к копированию из отображения пакета
+*/
+kge::vkstructs::Model KGEVulkanCore::LoadPackagedModel(const KGEPackage &package, const std::string &name)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::LoadPackagedModel");
+    const kge::pak::PackageEntry* entry = package.Find(name);
+    if (entry == nullptr || entry->type != kge::pak::BlobModel || entry->size < sizeof(kge::pak::ModelBlob)) {
+        throw std::runtime_error("Vulkan: Error while loading packaged model. Model " + name + " not found in " + package.path());
+    }
+
+    const unsigned char* data = package.Data(*entry);
+    const kge::pak::ModelBlob* blob = reinterpret_cast<const kge::pak::ModelBlob*>(data);
+
+    // Размеры таблиц проверяются до вычисления указателей на них
+    if (sizeof(kge::pak::ModelBlob) + static_cast<uint64_t>(blob->meshCount) * sizeof(kge::pak::ModelMeshRecord) +
+            static_cast<uint64_t>(blob->textureCount) * sizeof(uint64_t) +
+            static_cast<uint64_t>(blob->nodeCount) * sizeof(kge::pak::ModelNodeRecord) > entry->size) {
+        throw std::runtime_error("Vulkan: Error while loading packaged model. Corrupted model blob " + name);
+    }
+
+    const kge::pak::ModelMeshRecord* records = reinterpret_cast<const kge::pak::ModelMeshRecord*>(data + sizeof(kge::pak::ModelBlob));
+    const uint64_t* textureHashes = reinterpret_cast<const uint64_t*>(records + blob->meshCount);
+    const kge::pak::ModelNodeRecord* nodeRecords = reinterpret_cast<const kge::pak::ModelNodeRecord*>(textureHashes + blob->textureCount);
+
+    kge::vkstructs::Model result;
+
+    // Узлы (проверяются до загрузки текстур и геометрии)
+    for (uint32_t i = 0; i < blob->nodeCount; i++) {
+        const kge::pak::ModelNodeRecord &record = nodeRecords[i];
+        if (record.mesh >= blob->meshCount) {
+            throw std::runtime_error("Vulkan: Error while loading packaged model. Corrupted model blob " + name);
+        }
+
+        kge::vkstructs::ModelNode node;
+        node.mesh = record.mesh;
+        node.position = { record.position[0], record.position[1], record.position[2] };
+        node.rotation = { record.rotation[0], record.rotation[1], record.rotation[2] };
+        node.scale = { record.scale[0], record.scale[1], record.scale[2] };
+        result.nodes.push_back(node);
+    }
+
+    // Текстуры (все мип-уровни, одной отправкой команд)
+    std::vector<kge::vkstructs::TextureSource> sources(blob->textureCount);
+    for (uint32_t i = 0; i < blob->textureCount; i++) {
+        const kge::pak::PackageEntry* textureEntry = package.Find(textureHashes[i]);
+        if (textureEntry == nullptr || textureEntry->type != kge::pak::BlobTexture || textureEntry->size < sizeof(kge::pak::TextureBlob)) {
+            throw std::runtime_error("Vulkan: Error while loading packaged model. Texture of " + name + " not found in " + package.path());
+        }
+
+        const unsigned char* textureData = package.Data(*textureEntry);
+        const kge::pak::TextureBlob* texture = reinterpret_cast<const kge::pak::TextureBlob*>(textureData);
+        if (texture->mipLevels == 0 || texture->mipLevels > KGE_PACKAGE_MIP_MAX_LEVELS) {
+            throw std::runtime_error("Vulkan: Error while loading packaged model. Corrupted texture blob of " + name);
+        }
+
+        sources[i].width = texture->width;
+        sources[i].height = texture->height;
+        for (uint32_t level = 0; level < texture->mipLevels; level++) {
+            uint64_t levelBytes = static_cast<uint64_t>(std::max(1u, texture->width >> level)) * std::max(1u, texture->height >> level) * 4;
+            if (texture->mipBytes[level] != levelBytes || texture->mipOffsets[level] + levelBytes > textureEntry->size) {
+                throw std::runtime_error("Vulkan: Error while loading packaged model. Corrupted texture blob of " + name);
+            }
+            sources[i].mips.push_back({ textureData + texture->mipOffsets[level], levelBytes });
+        }
+    }
+    result.textures = CreateTextures(sources);
+
+    // Геометрия с уровнями детализации (при ошибке уже зарегистрированные геометрия и текстуры модели освобождаются)
+    try {
+        for (uint32_t i = 0; i < blob->meshCount; i++) {
+            const kge::pak::ModelMeshRecord &record = records[i];
+            if (record.levelCount == 0 || record.levelCount > KGE_PACKAGE_LOD_MAX_LEVELS ||
+                    record.texture >= static_cast<int32_t>(blob->textureCount)) {
+                throw std::runtime_error("Vulkan: Error while loading packaged model. Corrupted model blob " + name);
+            }
+
+            kge::vkstructs::ModelMesh modelMesh;
+            modelMesh.mesh = RegisterPackagedMesh(package, record.levels[0], nullptr);
+            modelMesh.texture = record.texture;
+            result.meshes.push_back(modelMesh);
+
+            for (uint32_t level = 1; level < record.levelCount; level++) {
+                kge::vkstructs::MeshLodLevel lod;
+                lod.mesh = RegisterPackagedMesh(package, record.levels[level], &lod.geometricError);
+                result.meshes.back().lods.push_back(lod);
+            }
+        }
+    }
+    catch (...) {
+        ReleaseModel(result);
+        ReleaseTextures(result.textures);
+        throw;
+    }
+
+    KGE_LOG_INFO("Vulkan: Model {} loaded from package {} ({} meshes, {} nodes, {} textures)",
+                 name, package.path(), result.meshes.size(), result.nodes.size(), result.textures.size());
+
+    return result;
+}
+
+std::vector<kge::vkstructs::PrimitiveHandle> KGEVulkanCore::AddModel(const kge::vkstructs::Model &model,
+                                                                     glm::vec3 position,
+                                                                     glm::vec3 rotaton)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::AddModel");
+    std::vector<kge::vkstructs::PrimitiveHandle> primitives;
+    primitives.reserve(model.nodes.size());
+
+    for (std::size_t node = 0; node < model.nodes.size(); node++) {
+        primitives.push_back(AddModelNode(model, node, position, rotaton));
+    }
+
+    return primitives;
+}
+
+/**
+* Добавление примитива узла модели
+* @note - преобразование узла переводится в пространство сцены: положение модели * преобразование узла. Поворот модели
+* без масштаба, поэтому произведение снова раскладывается на перенос, поворот и масштаб
+*/
+kge::vkstructs::PrimitiveHandle KGEVulkanCore::AddModelNode(const kge::vkstructs::Model &model,
+                                                            std::size_t node,
+                                                            glm::vec3 position,
+                                                            glm::vec3 rotaton)
+{
+    const kge::vkstructs::ModelNode &modelNode = model.nodes.at(node);
+    const kge::vkstructs::ModelMesh &mesh = model.meshes.at(modelNode.mesh);
+
+    kge::vkstructs::Transform origin;
+    origin.position = position;
+    origin.rotation = rotaton;
+    origin.scale = { 1.0f, 1.0f, 1.0f };
+
+    kge::vkstructs::Transform local;
+    local.position = modelNode.position;
+    local.rotation = modelNode.rotation;
+    local.scale = modelNode.scale;
+
+    // Вырожденный масштаб узла не раскладывается - тогда узел ставится в положение модели
+    kge::vkstructs::Transform placement = origin;
+    placement.scale = modelNode.scale;
+    placement.Decompose(origin.MakeModelMatrix() * local.MakeModelMatrix());
+
+    kge::vkstructs::TextureHandle texture = mesh.texture >= 0 ? model.textures[mesh.texture] : kge::vkstructs::INVALID_TEXTURE_HANDLE;
+    kge::vkstructs::PrimitiveHandle primitive = AddPrimitive(mesh.mesh, texture, placement.position, placement.rotation, placement.scale);
+    if (!mesh.lods.empty()) {
+        SetPrimitiveLods(primitive, mesh.lods);
+    }
+
+    return primitive;
+}
+
+void KGEVulkanCore::ReleaseModel(kge::vkstructs::Model &model)
+{
+    for (const kge::vkstructs::ModelMesh &mesh : model.meshes) {
+        m_kgeVkMeshRegistry.Release(mesh.mesh);
+        for (const kge::vkstructs::MeshLodLevel &level : mesh.lods) {
+            m_kgeVkMeshRegistry.Release(level.mesh);
+        }
+    }
+    model.meshes.clear();
+}
+
+/**
+* Замена геометрии и текстуры примитива
+* @param kge::vkstructs::PrimitiveHandle primitive - хендл примитива
+* @param kge::vkstructs::MeshHandle mesh - новая геометрия
+* @param kge::vkstructs::TextureHandle texture - хендл новой текстуры
+*
+* @note - используется при перезагрузке модели: хендл примитива остается действительным, поэтому все, что на него
+* ссылается (иерархия, анимация, игровой код), продолжает работать с новой геометрией
+*/
+void KGEVulkanCore::SetPrimitiveMesh(kge::vkstructs::PrimitiveHandle primitive,
+                                     kge::vkstructs::MeshHandle mesh,
+                                     kge::vkstructs::TextureHandle texture)
+{
+    kge::ecs::Entity entity = PrimitiveEntity(primitive);
+    kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(entity);
+
+    // Примитив держал ссылки на геометрию всех уровней детализации (либо только на свою геометрию)
+    std::vector<kge::vkstructs::MeshHandle> previous;
+    if (const kge::vkstructs::MeshLod* lod = m_ecsWorld.Get<kge::vkstructs::MeshLod>(entity)) {
+        for (uint32_t i = 0; i < lod->levelCount; i++) {
+            previous.push_back(lod->levels[i].mesh);
+        }
+    }
+    else {
+        previous.push_back(renderable.mesh);
+    }
+
+    bool wasIndexed = m_kgeVkMeshRegistry.mesh(renderable.mesh).drawIndexed;
+    bool indexed = m_kgeVkMeshRegistry.mesh(mesh).drawIndexed;
+
+    m_kgeVkMeshRegistry.AddRef(mesh);
+    renderable.mesh = mesh;
+    renderable.texture = texture;
+
+    // Уровни детализации относились к прежней геометрии (удаление компонента перемещает сущность - ссылка выше более недействительна)
+    m_ecsWorld.Remove<kge::vkstructs::MeshLod>(entity);
+
+    // Границы по новой геометрии с текущей мировой матрицей
+    const kge::vkstructs::Transform &transform = *m_ecsWorld.Get<kge::vkstructs::Transform>(entity);
+    const glm::mat4 &world = *reinterpret_cast<const glm::mat4*>(m_sceneGraph.worldTransform(transform.node).m);
+    kge::vkstructs::Bounds &bounds = *m_ecsWorld.Get<kge::vkstructs::Bounds>(entity);
+    bounds.Update(m_kgeVkMeshRegistry.mesh(mesh), world);
+    m_frustumCuller.Set(primitive.slot, bounds.sphereCenter.x, bounds.sphereCenter.y, bounds.sphereCenter.z, bounds.sphereRadius);
+    m_bvhDirty = true;
+
+    // В режиме GPU-отсечения на хосте рисуются только неиндексированные примитивы
+    if (m_cullingMode == CullingGpu) {
+        if (wasIndexed && !indexed) {
+            m_visiblePrimitives.push_back(primitive.slot);
+        }
+        else if (!wasIndexed && indexed) {
+            m_visiblePrimitives.erase(std::remove(m_visiblePrimitives.begin(), m_visiblePrimitives.end(), primitive.slot), m_visiblePrimitives.end());
+        }
+        m_gpuDrawBatchesDirty = true;
+    }
+
+    m_drawListVersion++;
+    for (kge::vkstructs::MeshHandle previousMesh : previous) {
+        m_kgeVkMeshRegistry.Release(previousMesh);
+    }
+}
+
+/**
+* Замена содержимого текстуры на месте
+* @param kge::vkstructs::TextureHandle texture - хендл заменяемой текстуры
+* @param const kge::vkstructs::TextureSource &source - новые пиксели
+*
+* @note - примитивы и пакеты GPU-отсечения ссылаются на текстуру по хендлу, а набор дескрипторов читается из пула
+* при записи команд, поэтому достаточно перезаписать командные буферы. Новое изображение занимает ячейку прежнего -
+* хендл и порядок отрисовки не меняются
+*/
+void KGEVulkanCore::ReplaceTexture(kge::vkstructs::TextureHandle texture, const kge::vkstructs::TextureSource &source)
+{
+    if (!m_textures.Alive(texture)) {
+        throw std::runtime_error("Vulkan: Error. Invalid texture handle");
+    }
+
+    kge::vkstructs::TextureHandle replacementHandle = CreateTextures({ source })[0];
+    kge::vkstructs::Texture replacement = m_textures.Get(replacementHandle);
+    m_textures.Remove(replacementHandle);
+
+    m_drawListVersion++;
+    kge::vkstructs::Texture &current = m_textures.Get(texture);
+    m_kgeVkDeletionQueue.DestroyTexture(current, m_kgeVkDescriptorPoolTextures.descriptorPool());
+    current = replacement;
+}
+
+/**
+* Удаление текстуры
+* @param kge::vkstructs::TextureHandle texture - хендл текстуры
+*
+* @note - ячейка освобождается сразу (хендл устаревает, примитивы с ним рисуются без текстуры), а изображение и
+* набор дескрипторов - через очередь отложенного удаления
+*/
+void KGEVulkanCore::ReleaseTexture(kge::vkstructs::TextureHandle texture)
+{
+    kge::vkstructs::Texture* item = m_textures.Find(texture);
+    if (item == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Invalid texture handle");
+    }
+
+    m_drawListVersion++;
+    m_kgeVkDeletionQueue.DestroyTexture(*item, m_kgeVkDescriptorPoolTextures.descriptorPool());
+    m_textures.Remove(texture);
+}
+
+/**
+* Удаление текстур
+* @param std::vector<kge::vkstructs::TextureHandle> &textures - хендлы текстур (напр. текстуры замененной модели)
+*/
+void KGEVulkanCore::ReleaseTextures(std::vector<kge::vkstructs::TextureHandle> &textures)
+{
+    for (kge::vkstructs::TextureHandle texture : textures) {
+        ReleaseTexture(texture);
+    }
+    textures.clear();
+}
+
+/**
+* Существует ли текстура
+* @param kge::vkstructs::TextureHandle texture - хендл текстуры
+*/
+bool KGEVulkanCore::TextureAlive(kge::vkstructs::TextureHandle texture) const
+{
+    return m_textures.Alive(texture);
+}
+
+/**
+* Вытеснение давно не использовавшихся текстур и геометрии, когда локальная куча устройства подходит к бюджету
+*
+* @note - копий ресурсов на хосте нет, поэтому ресурс не удаляется, а занимает меньше памяти кучи: у текстуры отбрасывается
+* верхний мип-уровень (до RESIDENCY_MIN_TEXTURE_SIZE), геометрия переносится в память хоста. Кандидаты - ресурсы из
+* переполненных куч, не использовавшиеся RESIDENCY_IDLE_FRAMES кадров, от давно использованных к недавним (при равенстве -
+* сначала крупные), пока не наберется превышение каждой кучи
+*/
+void KGEVulkanCore::EnforceMemoryBudget()
+{
+    if (!m_kgeVkResidency.EvictionDue()) {
+        return;
+    }
+
+    KGE_PROFILE_ZONE("KGEVulkanCore::EnforceMemoryBudget");
+    m_kgeVkResidency.EvictionDone();
+
+    const std::vector<kge::vkstructs::HeapBudget> &heaps = m_kgeVkResidency.heaps();
+    std::vector<VkDeviceSize> overcommit(heaps.size(), 0);
+    for (uint32_t heap = 0; heap < heaps.size(); heap++) {
+        overcommit[heap] = heaps[heap].deviceLocal ? m_kgeVkResidency.Overcommit(heap) : 0;
+    }
+
+    struct Candidate
+    {
+        uint64_t lastUse;
+        VkDeviceSize size;              // Сколько памяти кучи освободится
+        uint32_t heap;
+        kge::vkstructs::TextureHandle texture;
+        kge::vkstructs::MeshHandle mesh;
+    };
+    std::vector<Candidate> candidates;
+
+    for (std::size_t i = 0; i < m_textures.size(); i++) {
+        const kge::vkstructs::Texture &texture = m_textures.items()[i];
+        uint32_t heap = kge::vkutility::MemoryHeap(texture.image.vkDeviceMemory);
+        if (heap >= overcommit.size() || overcommit[heap] == 0 ||
+                std::max(texture.image.extent.width, texture.image.extent.height) <= RESIDENCY_MIN_TEXTURE_SIZE) {
+            continue;
+        }
+
+        Candidate candidate = {};
+        candidate.texture = m_textures.handle(i);
+        if (m_kgeVkResidency.TextureIdle(candidate.texture, &candidate.lastUse)) {
+            // Верхний уровень - около 3/4 памяти цепочки мип-уровней
+            candidate.size = texture.image.memorySize - texture.image.memorySize / 4;
+            candidate.heap = heap;
+            candidates.push_back(candidate);
+        }
+    }
+
+    for (kge::vkstructs::MeshHandle handle : m_kgeVkMeshRegistry.handles()) {
+        const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(handle);
+        uint32_t heap = kge::vkutility::MemoryHeap(mesh.vertexBuffer.vkDeviceMemory);
+        if (heap >= overcommit.size() || overcommit[heap] == 0) {
+            continue;
+        }
+
+        Candidate candidate = {};
+        candidate.mesh = handle;
+        if (m_kgeVkResidency.MeshIdle(handle, &candidate.lastUse)) {
+            candidate.size = mesh.vertexBuffer.size + mesh.indexBuffer.size;
+            candidate.heap = heap;
+            candidates.push_back(candidate);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.lastUse != b.lastUse ? a.lastUse < b.lastUse : a.size > b.size;
+    });
+
+    std::vector<kge::vkstructs::TextureHandle> textures;
+    VkDeviceSize freed = 0;
+    unsigned int meshCount = 0;
+    for (const Candidate &candidate : candidates) {
+        if (overcommit[candidate.heap] == 0) {
+            continue;
+        }
+
+        VkDeviceSize size = candidate.size;
+        if (candidate.texture.valid()) {
+            textures.push_back(candidate.texture);
+        }
+        else {
+            size = m_kgeVkMeshRegistry.Demote(candidate.mesh);
+            meshCount += size > 0 ? 1 : 0;
+        }
+
+        overcommit[candidate.heap] -= std::min(overcommit[candidate.heap], size);
+        freed += size;
+    }
+
+    if (!textures.empty()) {
+        DropTextureMips(textures);
+    }
+
+    // Командные буферы ссылаются на замененные буферы (изображения текстур заменяются по завершении копирования)
+    if (!textures.empty() || meshCount > 0) {
+        m_drawListVersion++;
+        KGE_LOG_INFO("Vulkan: Memory budget exceeded, {} textures reduced and {} meshes moved to host memory ({} KiB)",
+                     textures.size(), meshCount, freed / 1024);
+    }
+    else {
+        KGE_LOG_WARNING("Vulkan: Memory budget exceeded, no idle textures or meshes to evict");
+    }
+}
+
+/**
+* Отбрасывание верхнего мип-уровня текстур
+* @param const std::vector<kge::vkstructs::TextureHandle> &textures - хендлы текстур
+*
+* @note - уровни нового изображения копируются из следующих уровней текущего (размеры совпадают), у текстуры без мип-уровней
+* единственный уровень уменьшается фильтрацией. Все текстуры - одной отправкой, без ожидания очереди: уменьшенные
+* изображения занимают место текущих только после сигнала забора отправки (см. CollectUploads). Текущие изображения
+* читаются еще не завершенными кадрами, поэтому удаляются через очередь отложенного удаления (как при замене текстуры)
+*/
+void KGEVulkanCore::DropTextureMips(const std::vector<kge::vkstructs::TextureHandle> &textures)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::DropTextureMips");
+    std::vector<kge::vkstructs::Texture> reduced(textures.size());
+    std::vector<VkImage> sources(textures.size());
+
+    VkCommandBuffer copyCmdBuffer = kge::vkutility::CreateSingleTimeCommandBuffer(*m_kgeVkDevice.device(), m_kgeVkCommandPool.commandPool());
+
+    for (std::size_t i = 0; i < textures.size(); i++) {
+        const kge::vkstructs::Image &source = m_textures.Get(textures[i]).image;
+        sources[i] = source.vkImage;
+        uint32_t width = std::max(1u, source.extent.width >> 1);
+        uint32_t height = std::max(1u, source.extent.height >> 1);
+        uint32_t mipLevels = std::max(1u, source.mipLevels - 1);
+
+        reduced[i].image = kge::vkutility::CreateImageSingle(*m_kgeVkDevice.device(),
+                                                             VK_IMAGE_TYPE_2D,
+                                                             source.format,
+                                                             { width, height, 1 },
+                                                             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                                             VK_IMAGE_ASPECT_COLOR_BIT,
+                                                             VK_IMAGE_LAYOUT_UNDEFINED,
+                                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                             VK_IMAGE_TILING_OPTIMAL,
+                                                             VK_SHARING_MODE_EXCLUSIVE,
+                                                             mipLevels);
+
+        VkImageSubresourceRange sourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, source.mipLevels, 0, 1 };
+        VkImageSubresourceRange reducedRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+
+        kge::vkutility::CmdImageLayoutTransition(copyCmdBuffer, source.vkImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sourceRange);
+        kge::vkutility::CmdImageLayoutTransition(copyCmdBuffer, reduced[i].image.vkImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, reducedRange);
+
+        // Уровень N нового изображения - уровень N + 1 текущего
+        std::vector<VkImageBlit> regions(mipLevels);
+        for (uint32_t level = 0; level < mipLevels; level++) {
+            uint32_t sourceLevel = std::min(level + 1, source.mipLevels - 1);
+
+            regions[level] = {};
+            regions[level].srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, sourceLevel, 0, 1 };
+            regions[level].srcOffsets[1] = { static_cast<int32_t>(std::max(1u, source.extent.width >> sourceLevel)),
+                                             static_cast<int32_t>(std::max(1u, source.extent.height >> sourceLevel)), 1 };
+            regions[level].dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+            regions[level].dstOffsets[1] = { static_cast<int32_t>(std::max(1u, width >> level)),
+                                             static_cast<int32_t>(std::max(1u, height >> level)), 1 };
+        }
+        vkCmdBlitImage(copyCmdBuffer,
+                       source.vkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       reduced[i].image.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       mipLevels, regions.data(), VK_FILTER_LINEAR);
+
+        kge::vkutility::CmdImageLayoutTransition(copyCmdBuffer, reduced[i].image.vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, reducedRange);
+        kge::vkutility::CmdImageLayoutTransition(copyCmdBuffer, source.vkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sourceRange);
+    }
+
+    SubmitUpload(copyCmdBuffer, {}, [this, textures, reduced, sources]() mutable {
+        for (std::size_t i = 0; i < textures.size(); i++) {
+            // Текстура удалена либо заменена, пока шло копирование - уменьшенное изображение не понадобится (устройство его не читает)
+            if (!m_textures.Alive(textures[i]) || m_textures.Get(textures[i]).image.vkImage != sources[i]) {
+                reduced[i].image.Deinit(m_kgeVkDevice.device()->logicalDevice);
+                continue;
+            }
+
+            AllocateTextureDescriptorSet(reduced[i]);
+
+            kge::vkstructs::Texture &current = m_textures.Get(textures[i]);
+            m_kgeVkDeletionQueue.DestroyTexture(current, m_kgeVkDescriptorPoolTextures.descriptorPool());
+            current = reduced[i];
+        }
+
+        // Командные буферы ссылаются на наборы дескрипторов замененных изображений
+        m_drawListVersion++;
+    });
+}
+
+/**
+* Перезагрузка шейдеров
+* @return bool - удалось ли создать новые конвейеры
+*
+* @note - новые конвейеры создаются рядом с действующими и занимают их место только если созданы все, поэтому ошибка
+* в шейдере не останавливает отрисовку. Командные буферы перезаписываются в ближайших кадрах (по одному на изображение)
+*/
+bool KGEVulkanCore::ReloadShaders()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::ReloadShaders");
+    std::unique_ptr<KGEVkGraphicsPipeline> pipeline;
+    std::unique_ptr<KGEVkGraphicsPipeline> pipelineInstanced;
+
+    try {
+        pipeline = std::make_unique<KGEVkGraphicsPipeline>(
+                    m_kgeVkDevice.device(),
+                    m_kgeVkPipelineLayout.pipelineLayout(),
+                    m_kgeSwapChain.swapchain(),
+                    m_kgeRenderPass.renderPass(),
+                    m_vertexLayout,
+                    m_modelDataPath == ModelDataPushConstants ? "vert_push.spv" : "vert.spv");
+
+        if (m_kgeVkGraphicsPipelineInstanced) {
+            pipelineInstanced = std::make_unique<KGEVkGraphicsPipeline>(
+                        m_kgeVkDevice.device(),
+                        m_kgeVkPipelineLayout.pipelineLayout(),
+                        m_kgeSwapChain.swapchain(),
+                        m_kgeRenderPass.renderPass(),
+                        m_vertexLayout,
+                        "vert_instanced.spv",
+                        true);
+        }
+    }
+    catch (const std::exception &ex) {
+        KGE_LOG_ERROR("Vulkan: Shader reload failed, previous pipelines are kept. {}", ex.what());
+        return false;
+    }
+
+    m_drawListVersion++;
+
+    // Новый конвейер занимает место действующего, прежний хендл уходит в очередь отложенного удаления
+    m_kgeVkGraphicsPipeline.Swap(*pipeline);
+    m_kgeVkDeletionQueue.Release(std::move(pipeline));
+
+    if (pipelineInstanced) {
+        m_kgeVkGraphicsPipelineInstanced.swap(pipelineInstanced);
+        m_kgeVkDeletionQueue.Release(std::move(pipelineInstanced));
+    }
+
+    kge::tools::LogMessage("Vulkan: Shaders reloaded");
+    return true;
+}
+
+KGEVulkanCore::~KGEVulkanCore()
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::~KGEVulkanCore");
+    Pause();
+    m_isReady = false;
+    // Сброс буферов команд
+    ResetCommandBuffers(*m_kgeVkDevice.device(), m_kgeVkCommandBuffer.commandBuffersDraw());
+
+    // Оставшиеся текстуры (устройство простаивает - удаляются сразу, пока пул текстурных наборов еще существует)
+    for (kge::vkstructs::Texture &texture : m_textures.items()) {
+        texture.Deinit(m_kgeVkDevice.device()->logicalDevice, m_kgeVkDescriptorPoolTextures.descriptorPool());
+    }
+    m_textures.Clear();
+}
+
+/**
+* Подготовка команд, заполнение командных буферов
+* @param std::vector<VkCommandBuffer> commandBuffers - массив хендлов командных буферов
+* @param VkRenderPass renderPass - хендл прохода рендеринга, используется при привязке прохода
+* @param VkPipelineLayout pipelineLayout - хендл размещения конвейра, исппользуется при привязке дескрипторов
+* @param VkDescriptorSet descriptorSet - хендл набор дескрипторов, исппользуется при привязке дескрипторов
+* @param VkPipeline pipeline - хендл конвейера, используется при привязке конвейера
+* @param const vktoolkit::Swapchain &swapchain - свопчейн, используется при конфигурации начала прохода (в.ч. для указания фрейм-буфера)
+* @param const std::vector<kge::ecs::Entity> &primitives - сущности примитивов (привязка буферов вершин, буферов индексов для каждого и т.д)
+*
+* @note - данную операцию нет нужды выполнять при каждом обновлении кадра, набор команд как правило относительно неизменный. Метод лишь заполняет
+* буферы команд, а сама отправка происходть в draw. При изменении кол-ва примитивов следует сбросить командные буферы и заново их заполнить
+* при помощи данного метода
+*/
+void KGEVulkanCore::PrepareDrawCommands(std::vector<VkCommandBuffer> commandBuffers,
+                                        VkRenderPass renderPass,
+                                        VkPipelineLayout pipelineLayout,
+                                        VkDescriptorSet descriptorSetMain,
+                                        VkPipeline pipeline,
+                                        const kge::vkstructs::Swapchain &swapchain,
+                                        const std::vector<kge::ecs::Entity> &primitives)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::PrepareDrawCommands");
+    if (m_gpuDrawBatchesDirty) {
+        RebuildGpuDrawBatches();
+    }
+
+    // Все буферы будут записаны с текущим списком отрисовки
+    m_recordedDrawListVersion.assign(commandBuffers.size(), m_drawListVersion);
+
+    // Пройтись по всем буферам (поскольку кол-во фрейм-буферов равно кол-ву командных буферов, индексы соответствуют)
+    for (unsigned int i = 0; i < commandBuffers.size(); ++i)
+    {
+        RecordDrawCommands(commandBuffers[i], i, renderPass, pipelineLayout, descriptorSetMain, pipeline, swapchain, primitives);
+    }
+}
+
+/**
+* Запись команд отрисовки в один командный буфер
+* @param VkCommandBuffer commandBuffer - хендл командного буфера
+* @param unsigned int imageIndex - индекс изображения swap-chain (фрейм-буфер и области uniform-буферов)
+*
+* @note - в режиме ModelDataPushConstants основной набор дескрипторов привязывается один раз, а матрица модели передается
+* push-константой. Значения push-констант "запекаются" в командный буфер, поэтому в этом режиме
+* буфер текущего изображения перезаписывается каждый кадр (см. Draw)
+* Текстурный набор и буферы геометрии в обоих режимах привязываются только при смене (список отрисовки отсортирован, см. SortDrawList)
+*/
+void KGEVulkanCore::RecordDrawCommands(VkCommandBuffer commandBuffer,
+                                       unsigned int imageIndex,
+                                       VkRenderPass renderPass,
+                                       VkPipelineLayout pipelineLayout,
+                                       VkDescriptorSet descriptorSetMain,
+                                       VkPipeline pipeline,
+                                       const kge::vkstructs::Swapchain &swapchain,
+                                       const std::vector<kge::ecs::Entity> &primitives)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::RecordDrawCommands");
+    // Информация начала командного буфера
+    VkCommandBufferBeginInfo cmdBufInfo = {};
+    cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    cmdBufInfo.pNext = nullptr;
+
+    // Параметры очистки вложений в начале прохода
+    std::vector<VkClearValue> clearValues(2);
+    // Очистка первого вложения (цветового)
+    clearValues[0].color = { {0.6f, 0.8f, 0.8f, 1.0f} };
+    // Очиска второго вложения (вложения глубины-трфарета)
+    clearValues[1].depthStencil.depth = 1.0f;
+    clearValues[1].depthStencil.stencil = 0;
+
+    // Информация о начале прохода
+    VkRenderPassBeginInfo renderPassBeginInfo = {};
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext = nullptr;
+    renderPassBeginInfo.renderPass = renderPass;
+    renderPassBeginInfo.renderArea.offset.x = 0;
+    renderPassBeginInfo.renderArea.offset.y = 0;
+    renderPassBeginInfo.renderArea.extent.width = swapchain.imageExtent.width;
+    renderPassBeginInfo.renderArea.extent.height = swapchain.imageExtent.height;
+    renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassBeginInfo.pClearValues = clearValues.data();
+
+    // Установить целевой фрейм-буфер
+    renderPassBeginInfo.framebuffer = swapchain.framebuffers[imageIndex];
+
+    // Начать запись команд в командный буфер
+    vkBeginCommandBuffer(commandBuffer, &cmdBufInfo);
+
+    // Проход GPU-отсечения (вычислительный, до начала прохода рендеринга)
+    if (m_kgeVkGpuCulling) {
+        m_kgeVkGpuCulling->RecordCull(commandBuffer,
+                                      imageIndex,
+                                      static_cast<unsigned int>(m_gpuCullObjects.size()),
+                                      static_cast<unsigned int>(m_gpuDrawBatches.size()),
+                                      m_kgeVkDevice.device()->cmdDrawIndexedIndirectCount != nullptr);
+    }
+
+    // Начать первый под-проход основного прохода, это очистит цветоые вложения
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    // Привязать графический конвейер
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    // Выравнивание одного элемента массива матриц моделей
+    uint32_t dynamicAlignment = static_cast<uint32_t>(m_kgeVkDevice.device()->GetDynamicAlignment<glm::mat4>());
+
+    // Смещения областей uniform-буферов для данного изображения (в порядке точек привязки)
+    uint32_t worldRegionOffset = m_kgeVkUniformBufferWorld.uniformBufferWorld()->regionOffset(imageIndex);
+    uint32_t modelsRegionOffset = m_kgeVkUniformBufferModels->m_uniformBufferModels.regionOffset(imageIndex);
+
+    // Счетчики привязок (для статистики)
+    kge::vkstructs::DrawStats stats;
+
+    // Пройтись по всем видимым примитивам (прошедшим отсечение в Update)
+    if (!m_visiblePrimitives.empty()) {
+
+        // При передаче матриц push-константами основной набор привязывается один раз на весь проход
+        if (m_modelDataPath == ModelDataPushConstants) {
+            const uint32_t dynamicOffsets[2] = { worldRegionOffset, modelsRegionOffset };
+            vkCmdBindDescriptorSets(
+                        commandBuffer,
+                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        pipelineLayout,
+                        0,
+                        1,
+                        &descriptorSetMain,
+                        2,
+                        dynamicOffsets);
+        }
+
+        // Текстура и геометрия привязанные последними (для пропуска повторной привязки)
+        // Список отрисовки отсортирован по ключу (текстура, геометрия, глубина), поэтому одинаковые привязки идут подряд
+        kge::vkstructs::TextureHandle boundTexture = kge::vkstructs::INVALID_TEXTURE_HANDLE;
+        kge::vkstructs::MeshHandle boundMesh = kge::vkstructs::INVALID_MESH_HANDLE;
+
+        for (uint32_t primitiveIndex : m_visiblePrimitives)
+        {
+            // Примитив удален после ближайшего отсечения
+            if (!m_ecsWorld.Alive(primitives[primitiveIndex])) {
+                continue;
+            }
+
+            // Данные отрисовки примитива
+            const kge::vkstructs::Renderable &renderable = *m_ecsWorld.Get<kge::vkstructs::Renderable>(primitives[primitiveIndex]);
+
+            // Привязать текстурный набор только если текстура сменилась (удаленная текстура не привязывается)
+            const kge::vkstructs::Texture* texture = m_textures.Find(renderable.texture);
+            if (texture != nullptr) {
+                if (renderable.texture != boundTexture) {
+                    vkCmdBindDescriptorSets(
+                                commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipelineLayout,
+                                1,
+                                1,
+                                &(texture->descriptorSet),
+                                0,
+                                nullptr);
+                    boundTexture = renderable.texture;
+                    stats.descriptorSetBinds++;
+                }
+                else {
+                    stats.bindsAvoided++;
+                }
+            }
+
+            if (m_modelDataPath == ModelDataPushConstants) {
+                // Матрица модели подготовленная в Update
+                const glm::mat4* modelMat = reinterpret_cast<const glm::mat4*>(reinterpret_cast<const unsigned char*>(m_uboModels) + primitiveIndex * dynamicAlignment);
+
+                // Передать матрицу модели (64 байта) прямо в командный буфер
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), modelMat);
+            }
+            else {
+                // Спиок динамических смещений для динамических UBO буферов в наборах дескрипторов (в порядке точек привязки)
+                // Командный буфер i использует i-ые области буферов (области соответствуют изображениям swap-chain)
+                // При помощи выравниваниях получаем необходимое смещение для дескрипторов, чтобы была осуществлена привязка
+                // нужного буфера UBO (с матрицей модели) для конкретного примитива
+                const uint32_t dynamicOffsets[2] = {
+                    worldRegionOffset,
+                    modelsRegionOffset + primitiveIndex * dynamicAlignment
+                };
+
+                // Привязать основной набор (смещение матрицы модели свое у каждого примитива)
+                // Размещение конвейера общее, поэтому привязанный ранее текстурный набор (набор 1) при этом сохраняется
+                vkCmdBindDescriptorSets(
+                            commandBuffer,
+                            VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipelineLayout,
+                            0,
+                            1,
+                            &descriptorSetMain,
+                            2,
+                            dynamicOffsets);
+                stats.descriptorSetBinds++;
+            }
+
+            // Геометрия примитива (буферы общие для всех примитивов с одинаковой геометрией)
+            const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(renderable.mesh);
+            bool indexed = mesh.drawIndexed && mesh.indexBuffer.count > 0;
+
+            // Привязать буферы вершин и индексов (и передать распаковку позиций геометрии) только если геометрия сменилась
+            if (renderable.mesh != boundMesh) {
+                VkDeviceSize offsets[1] = { 0 };
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &(mesh.vertexBuffer.vkBuffer), offsets);
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), sizeof(glm::vec4), &mesh.positionDequantization);
+                stats.bufferBinds++;
+
+                if (indexed) {
+                    vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer.vkBuffer, 0, mesh.indexBuffer.type);
+                    stats.bufferBinds++;
+                }
+                boundMesh = renderable.mesh;
+            }
+            else {
+                stats.bindsAvoided += indexed ? 2 : 1;
+            }
+
+            // Если нужно рисовать индексированную геометрию
+            if (indexed) {
+                vkCmdDrawIndexed(commandBuffer, mesh.indexBuffer.count, 1, 0, 0, 0);
+                stats.triangles += mesh.indexBuffer.count / 3;
+            }
+            // Если индексация вершин не используется
+            else {
+                vkCmdDraw(commandBuffer, mesh.vertexBuffer.count, 1, 0, 0);
+                stats.triangles += mesh.vertexBuffer.count / 3;
+            }
+            stats.draws++;
+        }
+    }
+
+    m_drawStats = stats;
+
+    // Примитивы прошедшие GPU-отсечение (косвенная отрисовка)
+    if (m_kgeVkGpuCulling) {
+        RecordGpuDrawBatches(commandBuffer, imageIndex, pipelineLayout, descriptorSetMain);
+    }
+
+    // Экземпляризированные примитивы (одна команда отрисовки на примитив, независимо от кол-ва экземпляров)
+    if (!m_instancedPrimitives.empty() && m_kgeVkGraphicsPipelineInstanced) {
+
+        // Привязать конвейер экземпляризированной отрисовки
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_kgeVkGraphicsPipelineInstanced->pipeline());
+
+        // Основной набор (матрицы сцены), привязывается один раз
+        const uint32_t dynamicOffsets[2] = { worldRegionOffset, modelsRegionOffset };
+        vkCmdBindDescriptorSets(
+                    commandBuffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    pipelineLayout,
+                    0,
+                    1,
+                    &descriptorSetMain,
+                    2,
+                    dynamicOffsets);
+
+        // Привязать буфер экземпляров (область данного изображения) к привязке 1
+        VkBuffer instanceBuffer = m_kgeVkInstanceBuffer->instanceBuffer();
+        VkDeviceSize instanceBufferOffset = m_kgeVkInstanceBuffer->regionOffset(imageIndex);
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &instanceBufferOffset);
+
+        // Текстура привязанная последней (для пропуска повторной привязки)
+        kge::vkstructs::TextureHandle boundTexture = kge::vkstructs::INVALID_TEXTURE_HANDLE;
+
+        for (const kge::vkstructs::InstancedPrimitive &primitive : m_instancedPrimitives)
+        {
+            if (primitive.instances.empty()) {
+                continue;
+            }
+
+            // Привязать текстурный набор только если текстура сменилась
+            const kge::vkstructs::Texture* texture = m_textures.Find(primitive.texture);
+            if (texture != nullptr && primitive.texture != boundTexture) {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &(texture->descriptorSet), 0, nullptr);
+                boundTexture = primitive.texture;
+            }
+
+            const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(primitive.mesh);
+
+            // Привязать буфер вершин и передать распаковку позиций
+            VkDeviceSize offsets[1] = { 0 };
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &(mesh.vertexBuffer.vkBuffer), offsets);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), sizeof(glm::vec4), &mesh.positionDequantization);
+
+            uint32_t instanceCount = static_cast<uint32_t>(primitive.instances.size());
+
+            if (mesh.drawIndexed && mesh.indexBuffer.count > 0) {
+                // Привязать буфер индексов
+                vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer.vkBuffer, 0, mesh.indexBuffer.type);
+
+                // Отрисовка всех экземпляров
+                vkCmdDrawIndexed(commandBuffer, mesh.indexBuffer.count, instanceCount, 0, 0, primitive.firstInstance);
+            }
+            else {
+                vkCmdDraw(commandBuffer, mesh.vertexBuffer.count, instanceCount, 0, primitive.firstInstance);
+            }
+        }
+    }
+
+    // Завершение прохода
+    vkCmdEndRenderPass(commandBuffer);
+
+    // Завершение прохода добавит неявное преобразование памяти фрейм-буфера в
+    // VK_IMAGE_LAYOUT_PRESENT_SRC_KHR для представления содержимого
+
+    // Завершение записи команд
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while preparing commands");
+    }
+}
+
+/**
+* Запись косвенной отрисовки пакетов
+* @param VkCommandBuffer commandBuffer - хендл командного буфера (внутри прохода рендеринга)
+* @param unsigned int imageIndex - индекс изображения swap-chain (области буферов команд, счетчиков и экземпляров)
+* @param VkPipelineLayout pipelineLayout - хендл размещения конвейера
+* @param VkDescriptorSet descriptorSetMain - основной набор дескрипторов
+*
+* @note - команды пишет проход GPU-отсечения, хост лишь привязывает геометрию и текстуру пакета. Кол-во команд пакета
+* берется из буфера счетчиков (vkCmdDrawIndexedIndirectCountKHR), а без расширения рисуются все ячейки пакета
+* (у отсеченных объектов instanceCount = 0)
+*/
+void KGEVulkanCore::RecordGpuDrawBatches(VkCommandBuffer commandBuffer,
+                                         unsigned int imageIndex,
+                                         VkPipelineLayout pipelineLayout,
+                                         VkDescriptorSet descriptorSetMain)
+{
+    KGE_PROFILE_ZONE("KGEVulkanCore::RecordGpuDrawBatches");
+    if (m_gpuDrawBatches.empty()) {
+        return;
+    }
+
+    // Матрица модели берется из буфера экземпляров, поэтому используется конвейер экземпляризированной отрисовки
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_kgeVkGraphicsPipelineInstanced->pipeline());
+
+    const uint32_t dynamicOffsets[2] = {
+        m_kgeVkUniformBufferWorld.uniformBufferWorld()->regionOffset(imageIndex),
+        m_kgeVkUniformBufferModels->m_uniformBufferModels.regionOffset(imageIndex)
+    };
+    vkCmdBindDescriptorSets(
+                commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipelineLayout,
+                0,
+                1,
+                &descriptorSetMain,
+                2,
+                dynamicOffsets);
+
+    VkBuffer instanceBuffer = m_kgeVkInstanceBuffer->instanceBuffer();
+    VkDeviceSize instanceBufferOffset = m_kgeVkInstanceBuffer->regionOffset(imageIndex);
+    vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &instanceBufferOffset);
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = m_kgeVkDevice.device()->cmdDrawIndexedIndirectCount;
+    VkDeviceSize commandsOffset = m_kgeVkGpuCulling->commandsRegionOffset(imageIndex);
+    VkDeviceSize countsOffset = m_kgeVkGpuCulling->countsRegionOffset(imageIndex);
+    const uint32_t commandStride = sizeof(VkDrawIndexedIndirectCommand);
+
+    // Текстура привязанная последней (для пропуска повторной привязки)
+    kge::vkstructs::TextureHandle boundTexture = kge::vkstructs::INVALID_TEXTURE_HANDLE;
+
+    for (uint32_t batchIndex = 0; batchIndex < m_gpuDrawBatches.size(); batchIndex++)
+    {
+        const kge::vkstructs::GpuDrawBatch &batch = m_gpuDrawBatches[batchIndex];
+
+        const kge::vkstructs::Texture* texture = m_textures.Find(batch.texture);
+        if (texture != nullptr && batch.texture != boundTexture) {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &(texture->descriptorSet), 0, nullptr);
+            boundTexture = batch.texture;
+        }
+
+        const kge::vkstructs::Mesh &mesh = m_kgeVkMeshRegistry.mesh(batch.mesh);
+        VkDeviceSize offsets[1] = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &(mesh.vertexBuffer.vkBuffer), offsets);
+        vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer.vkBuffer, 0, mesh.indexBuffer.type);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), sizeof(glm::vec4), &mesh.positionDequantization);
+
+        VkDeviceSize batchCommandsOffset = commandsOffset + batch.commandOffset * commandStride;
+
+        if (drawIndexedIndirectCount != nullptr) {
+            drawIndexedIndirectCount(commandBuffer,
+                                     m_kgeVkGpuCulling->commandsBuffer(),
+                                     batchCommandsOffset,
+                                     m_kgeVkGpuCulling->countsBuffer(),
+                                     countsOffset + batchIndex * sizeof(uint32_t),
+                                     batch.commandCapacity,
+                                     commandStride);
+        }
+        else {
+            vkCmdDrawIndexedIndirect(commandBuffer,
+                                     m_kgeVkGpuCulling->commandsBuffer(),
+                                     batchCommandsOffset,
+                                     batch.commandCapacity,
+                                     commandStride);
+        }
+    }
+}
+
+/**
+* Сброс командных буферов (для перезаписи)
+* @param const vktoolkit::Device &device - устройство, для получения хендлов очередей
+* @param std::vector<VkCommandBuffer> commandBuffers - массив хендлов командных буферов, которые необходимо сбросить
+*/
+void KGEVulkanCore::ResetCommandBuffers(const kge::vkstructs::Device &device, std::vector<VkCommandBuffer> commandBuffers)
+{
+    // Приостановить рендеринг
+    m_isReady = false;
+
+    // Подождать завершения всех команд в очередях
+    if (device.queues.graphics != nullptr && device.queues.present != nullptr) {
+        vkQueueWaitIdle(device.queues.graphics);
+        vkQueueWaitIdle(device.queues.present);
+
+        // Очереди простаивают - освобожденные ресурсы можно удалить
+        m_kgeVkDeletionQueue.Flush();
     }
 
     // Сбросить буферы команд
@@ -18,6 +18,7 @@ KGEVkCommandBuffer::KGEVkCommandBuffer(const kge::vkstructs::Device *device,
     m_device{device},
     m_commandPool{commandPool}
 {
+    KGE_PROFILE_ZONE("KGEVkCommandBuffer::KGEVkCommandBuffer");
     m_commandBuffersDraw.resize(count);
     // Конфигурация аллокации буферов
     VkCommandBufferAllocateInfo allocInfo = {};
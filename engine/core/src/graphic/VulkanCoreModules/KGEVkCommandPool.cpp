@@ -16,6 +16,7 @@ KGEVkCommandPool::KGEVkCommandPool(const kge::vkstructs::Device *device,
                                    unsigned int queueFamilyIndex):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkCommandPool::KGEVkCommandPool");
     // Описание пула
     VkCommandPoolCreateInfo commandPoolCreateInfo = {};
     commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -23,7 +24,7 @@ KGEVkCommandPool::KGEVkCommandPool(const kge::vkstructs::Device *device,
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     // Создание пула
-    if (vkCreateCommandPool(device->logicalDevice, &commandPoolCreateInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
+    if (vkCreateCommandPool(device->logicalDevice, &commandPoolCreateInfo, kge::vkutility::HostAllocator(), &m_commandPool) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error in vkCreateCommandPool function. Failed to create command pool");
     }
 
@@ -38,7 +39,7 @@ KGEVkCommandPool::KGEVkCommandPool(const kge::vkstructs::Device *device,
 KGEVkCommandPool::~KGEVkCommandPool()
 {
     if (m_commandPool != nullptr && &m_commandPool != nullptr) {
-        vkDestroyCommandPool(m_device->logicalDevice, m_commandPool, nullptr);
+        vkDestroyCommandPool(m_device->logicalDevice, m_commandPool, kge::vkutility::HostAllocator());
         m_commandPool = nullptr;
         kge::tools::LogMessage("Vulkan: Command pool successfully deinitialized");
     }
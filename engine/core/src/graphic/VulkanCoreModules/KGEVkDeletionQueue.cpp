@@ -0,0 +1,190 @@
+#include "graphic/VulkanCoreModules/KGEVkDeletionQueue.h"
+#include <algorithm>
+
+/**
+* Очередь отложенного удаления ресурсов устройства
+* @param const kge::vkstructs::Device* device - устройство
+*
+* @note - освобождаемый ресурс помечается номером последнего отправленного кадра и удаляется, когда этот кадр завершен
+* (сигнализирован его забор) - устройство ресурс уже не читает. Ожидания очередей при освобождении нет. В очередь можно
+* передавать только ресурсы, на которые не ссылаются командные буферы последующих отправок (перезаписываются до отправки)
+*/
+KGEVkDeletionQueue::KGEVkDeletionQueue(const kge::vkstructs::Device* device):
+    m_device{device},
+    m_submittedFrame{0},
+    m_completedFrame{0}
+{
+    kge::tools::LogMessage("Vulkan: Deletion queue successfully initialized");
+}
+
+/**
+* Удаление оставшихся ресурсов
+* @note - к моменту уничтожения очереди устройство должно простаивать
+*/
+KGEVkDeletionQueue::~KGEVkDeletionQueue()
+{
+    Flush();
+    kge::tools::LogMessage("Vulkan: Deletion queue successfully deinitialized");
+}
+
+/**
+* Добавление ресурса в очередь
+* @param std::function<void()> destroy - удаление ресурса
+*/
+void KGEVkDeletionQueue::Push(std::function<void()> destroy)
+{
+    m_entries.push_back({ m_submittedFrame, std::move(destroy) });
+}
+
+/**
+* Отложенное удаление буфера (и его памяти)
+* @param const kge::vkstructs::Buffer &buffer - буфер
+*/
+void KGEVkDeletionQueue::DestroyBuffer(const kge::vkstructs::Buffer &buffer)
+{
+    VkDevice logicalDevice = m_device->logicalDevice;
+    VkBuffer vkBuffer = buffer.vkBuffer;
+    VkDeviceMemory vkDeviceMemory = buffer.vkDeviceMemory;
+
+    Push([logicalDevice, vkBuffer, vkDeviceMemory]() {
+        if (vkBuffer != nullptr) {
+            vkDestroyBuffer(logicalDevice, vkBuffer, kge::vkutility::HostAllocator());
+        }
+        if (vkDeviceMemory != nullptr) {
+            kge::vkutility::FreeMemory(logicalDevice, vkDeviceMemory);
+        }
+    });
+}
+
+/**
+* Отложенное удаление изображения (вида, самого изображения и его памяти, см. kge::vkstructs::Image::Deinit)
+* @param const kge::vkstructs::Image &image - изображение
+*/
+void KGEVkDeletionQueue::DestroyImage(const kge::vkstructs::Image &image)
+{
+    VkDevice logicalDevice = m_device->logicalDevice;
+    kge::vkstructs::Image retired = image;
+
+    Push([logicalDevice, retired]() mutable {
+        retired.Deinit(logicalDevice);
+    });
+}
+
+/**
+* Отложенное удаление вида изображения
+* @param VkImageView imageView - хендл вида
+*/
+void KGEVkDeletionQueue::DestroyImageView(VkImageView imageView)
+{
+    VkDevice logicalDevice = m_device->logicalDevice;
+
+    Push([logicalDevice, imageView]() {
+        if (imageView != nullptr) {
+            vkDestroyImageView(logicalDevice, imageView, kge::vkutility::HostAllocator());
+        }
+    });
+}
+
+/**
+* Отложенное освобождение набора дескрипторов
+* @param VkDescriptorPool descriptorPool - пул, из которого выделен набор (создан с VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+* @param VkDescriptorSet descriptorSet - хендл набора
+*/
+void KGEVkDeletionQueue::FreeDescriptorSet(VkDescriptorPool descriptorPool, VkDescriptorSet descriptorSet)
+{
+    VkDevice logicalDevice = m_device->logicalDevice;
+
+    Push([logicalDevice, descriptorPool, descriptorSet]() {
+        if (descriptorSet != nullptr) {
+            vkFreeDescriptorSets(logicalDevice, descriptorPool, 1, &descriptorSet);
+        }
+    });
+}
+
+/**
+* Отложенное удаление конвейера
+* @param VkPipeline pipeline - хендл конвейера
+*/
+void KGEVkDeletionQueue::DestroyPipeline(VkPipeline pipeline)
+{
+    VkDevice logicalDevice = m_device->logicalDevice;
+
+    Push([logicalDevice, pipeline]() {
+        if (pipeline != nullptr) {
+            vkDestroyPipeline(logicalDevice, pipeline, kge::vkutility::HostAllocator());
+        }
+    });
+}
+
+/**
+* Отложенное удаление текстуры (набор дескрипторов освобождается раньше изображения, см. kge::vkstructs::Texture::Deinit)
+* @param const kge::vkstructs::Texture &texture - текстура
+* @param VkDescriptorPool descriptorPool - пул текстурных наборов дескрипторов
+*/
+void KGEVkDeletionQueue::DestroyTexture(const kge::vkstructs::Texture &texture, VkDescriptorPool descriptorPool)
+{
+    FreeDescriptorSet(descriptorPool, texture.descriptorSet);
+    DestroyImage(texture.image);
+}
+
+/**
+* Отложенное удаление объекта-владельца ресурсов (напр. конвейера KGEVkGraphicsPipeline) - ресурсы освобождает его деструктор
+* @param std::shared_ptr<void> object - объект (очередь хранит последнюю ссылку на него)
+*/
+void KGEVkDeletionQueue::Release(std::shared_ptr<void> object)
+{
+    Push([object]() mutable {
+        object.reset();
+    });
+}
+
+/**
+* Отложенное выполнение произвольного удаления
+* @param std::function<void()> destroy - удаление (вызывается, когда устройство не читает ресурсы, освобожденные до вызова Defer)
+*/
+void KGEVkDeletionQueue::Defer(std::function<void()> destroy)
+{
+    Push(std::move(destroy));
+}
+
+/**
+* Отметка об отправке кадра
+* @return uint64_t - номер отправленного кадра (передается в FrameCompleted, когда забор этой отправки сигнализирован)
+*/
+uint64_t KGEVkDeletionQueue::FrameSubmitted()
+{
+    return ++m_submittedFrame;
+}
+
+/**
+* Удаление ресурсов, освобожденных не позже отправки кадра
+* @param uint64_t frame - номер завершенного кадра (отправки одной очереди завершаются по порядку - завершены и все предыдущие)
+*/
+void KGEVkDeletionQueue::FrameCompleted(uint64_t frame)
+{
+    m_completedFrame = std::max(m_completedFrame, frame);
+
+    while (!m_entries.empty() && m_entries.front().frame <= m_completedFrame) {
+        // Запись снимается до удаления - удаление может освободить ресурсы через эту же очередь
+        std::function<void()> destroy = std::move(m_entries.front().destroy);
+        m_entries.pop_front();
+        destroy();
+    }
+}
+
+/**
+* Удаление всех ресурсов очереди
+* @note - вызывается после ожидания очередей устройства (все отправленные кадры завершены)
+*/
+void KGEVkDeletionQueue::Flush()
+{
+    FrameCompleted(m_submittedFrame);
+}
+
+/**
+* Кол-во ресурсов, ожидающих удаления
+*/
+std::size_t KGEVkDeletionQueue::pendingCount() const
+{
+    return m_entries.size();
+}
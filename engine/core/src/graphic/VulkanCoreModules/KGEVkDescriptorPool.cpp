@@ -13,13 +13,13 @@ const VkDescriptorPool& KGEVkDescriptorPool::descriptorPool()
 KGEVkDescriptorPool::KGEVkDescriptorPool(const kge::vkstructs::Device* device):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkDescriptorPool::KGEVkDescriptorPool");
     // Парамтеры размеров пула
     std::vector<VkDescriptorPoolSize> descriptorPoolSizes =
     {
-        // Один дескриптор для глобального uniform-буфера
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 1 },
-        // Один дескриптор для unform-буферов отдельных объектов (динамический)
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 }
+        // Два динамических дескриптора на набор: для глобального uniform-буфера и для unform-буферов отдельных объектов
+        // (оба буфера разбиты на области по кадрам, область выбирается динамическим смещением)
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2 * DESCRIPTOR_SETS_MAIN_MAX_COUNT }
     };
 
 
@@ -29,10 +29,12 @@ KGEVkDescriptorPool::KGEVkDescriptorPool(const kge::vkstructs::Device* device):
     poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     poolInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
     poolInfo.pPoolSizes = descriptorPoolSizes.data();
-    poolInfo.maxSets = 1;
+    // При росте буфера матриц моделей выделяется новый набор, а старый освобождается только после того,
+    // как его перестанут использовать записанные командные буферы
+    poolInfo.maxSets = DESCRIPTOR_SETS_MAIN_MAX_COUNT;
 
     // Создание дескрипторного пула
-    if (vkCreateDescriptorPool(m_device->logicalDevice, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS) {
+    if (vkCreateDescriptorPool(m_device->logicalDevice, &poolInfo, kge::vkutility::HostAllocator(), &m_descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error in vkCreateDescriptorPool function. Cant't create descriptor pool");
     }
 
@@ -51,11 +53,12 @@ KGEVkDescriptorPool::KGEVkDescriptorPool(const kge::vkstructs::Device *device,
                                          uint32_t maxDescriptorSets):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkDescriptorPool::KGEVkDescriptorPool");
     // Парамтеры размеров пула
     std::vector<VkDescriptorPoolSize> descriptorPoolSizes =
     {
-        // Два дескриптор для текстурного семплера
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , 2 },
+        // По одному дескриптору текстурного семплера на набор
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , maxDescriptorSets },
     };
 
     // Конфигурация пула
@@ -67,7 +70,7 @@ KGEVkDescriptorPool::KGEVkDescriptorPool(const kge::vkstructs::Device *device,
     poolInfo.maxSets = maxDescriptorSets;
 
     // Создание дескрипторного пула
-    if (vkCreateDescriptorPool(m_device->logicalDevice, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS) {
+    if (vkCreateDescriptorPool(m_device->logicalDevice, &poolInfo, kge::vkutility::HostAllocator(), &m_descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error in vkCreateDescriptorPool function. Cant't create descriptor pool");
     }
 
@@ -82,7 +85,7 @@ KGEVkDescriptorPool::KGEVkDescriptorPool(const kge::vkstructs::Device *device,
 KGEVkDescriptorPool::~KGEVkDescriptorPool()
 {
     if (m_descriptorPool != nullptr && &m_descriptorPool != nullptr) {
-        vkDestroyDescriptorPool(m_device->logicalDevice, m_descriptorPool, nullptr);
+        vkDestroyDescriptorPool(m_device->logicalDevice, m_descriptorPool, kge::vkutility::HostAllocator());
         m_descriptorPool = nullptr;
         kge::tools::LogMessage("Vulkan: Descriptor pool successfully deinitialized");
     }
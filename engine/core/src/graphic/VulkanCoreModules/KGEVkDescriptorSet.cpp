@@ -22,6 +22,7 @@ KGEVkDescriptorSet::KGEVkDescriptorSet(const kge::vkstructs::Device* device,
     m_descriptorPool{descriptorPool},
     m_descriptorSetLayout{descriptorSetLayout}
 {
+    KGE_PROFILE_ZONE("KGEVkDescriptorSet::KGEVkDescriptorSet");
     // Получить новый набор дескрипторов из дескриптороного пула
     VkDescriptorSetAllocateInfo descriptorSetAllocInfo = {};
     descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -43,7 +44,7 @@ KGEVkDescriptorSet::KGEVkDescriptorSet(const kge::vkstructs::Device* device,
             0,                                           // Точка привязки (у шейдера)
             0,                                           // Элемент массив (массив не используется)
             1,                                           // Кол-во дескрипторов
-            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,           // Тип дескриптора
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,   // Тип дескриптора
             nullptr,
             &uniformBufferWorld->descriptorBufferInfo,  // Информация о параметрах буфера
             nullptr
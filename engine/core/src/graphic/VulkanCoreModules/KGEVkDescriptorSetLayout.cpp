@@ -16,6 +16,7 @@ KGEVkDescriptorSetLayout::KGEVkDescriptorSetLayout(const kge::vkstructs::Device
                                                    SET_LAYOUT_TYPE setLayoutType):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkDescriptorSetLayout::KGEVkDescriptorSetLayout");
     if(setLayoutType == SetLayoutMain) {
         // Необходимо описать привязки дескрипторов к этапам конвейера
         // Каждая привязка соостветствует типу дескриптора и может относиться к определенному этапу графического конвейера
@@ -23,7 +24,7 @@ KGEVkDescriptorSetLayout::KGEVkDescriptorSetLayout(const kge::vkstructs::Device
         {
             {
                 0,                                            // Индекс привязки
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,            // Тип дескриптора (буфер формы, обычный)
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,    // Тип дескриптора (буфер формы, динамический - область кадра выбирается смещением)
                 1,                                            // Кол-во дескрипторов
                 VK_SHADER_STAGE_VERTEX_BIT,                   // Этап конвейера (вершинный шейдер)
                 nullptr
@@ -44,7 +45,7 @@ KGEVkDescriptorSetLayout::KGEVkDescriptorSetLayout(const kge::vkstructs::Device
         descriptorLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
         descriptorLayoutInfo.pBindings = bindings.data();
 
-        if (vkCreateDescriptorSetLayout(m_device->logicalDevice, &descriptorLayoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(m_device->logicalDevice, &descriptorLayoutInfo, kge::vkutility::HostAllocator(), &m_descriptorSetLayout) != VK_SUCCESS) {
             throw std::runtime_error("Vulkan: Error in vkCreateDescriptorSetLayout. Can't initialize descriptor set layout");
         }
 
@@ -73,7 +74,7 @@ KGEVkDescriptorSetLayout::KGEVkDescriptorSetLayout(const kge::vkstructs::Device
         descriptorLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
         descriptorLayoutInfo.pBindings = bindings.data();
 
-        if (vkCreateDescriptorSetLayout(m_device->logicalDevice, &descriptorLayoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS) {
+        if (vkCreateDescriptorSetLayout(m_device->logicalDevice, &descriptorLayoutInfo, kge::vkutility::HostAllocator(), &m_descriptorSetLayout) != VK_SUCCESS) {
             throw std::runtime_error("Vulkan: Error in vkCreateDescriptorSetLayout. Can't initialize descriptor set layout");
         }
 
@@ -94,7 +95,7 @@ const VkDescriptorSetLayout& KGEVkDescriptorSetLayout::descriptorSetLayout()
 KGEVkDescriptorSetLayout::~KGEVkDescriptorSetLayout()
 {
     if (m_device->logicalDevice != nullptr && m_descriptorSetLayout != nullptr && m_descriptorSetLayout != nullptr) {
-        vkDestroyDescriptorSetLayout(m_device->logicalDevice, m_descriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(m_device->logicalDevice, m_descriptorSetLayout, kge::vkutility::HostAllocator());
         m_descriptorSetLayout = nullptr;
         kge::tools::LogMessage("Vulkan: Descriptor set layout successfully deinitialized");
     }
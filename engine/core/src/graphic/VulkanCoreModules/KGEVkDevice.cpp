@@ -20,6 +20,7 @@ KGEVkDevice::KGEVkDevice(VkInstance vkInstance,
                          std::vector<const char *> validationLayersRequired,
                          bool uniqueQueueFamilies)
 {
+    KGE_PROFILE_ZONE("KGEVkDevice::KGEVkDevice");
     //Проверяем количество доступных физических устройств
     unsigned int deviceCount = 0;
     vkEnumeratePhysicalDevices(vkInstance, &deviceCount, nullptr);
@@ -69,6 +70,9 @@ KGEVkDevice::KGEVkDevice(VkInstance vkInstance,
         throw std::runtime_error("Vulkan: Error in the 'InitDevice' function! Can't detect suitable device");
     }
 
+    // Кучи памяти выбранного устройства - в учет памяти
+    kge::vkutility::RegisterMemoryHeaps(m_device.physicalDevice);
+
     // Массив объектов структуры VkDeviceQueueCreateInfo содержащих информацию для инициализации очередей
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 
@@ -96,6 +100,20 @@ KGEVkDevice::KGEVkDevice(VkInstance vkInstance,
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
+    // Необязательное расширение: кол-во косвенных отрисовок берется из буфера (используется GPU-отсечением)
+    bool drawIndirectCountSupported = kge::vkutility::CheckDeviceExtensionSupported(m_device.physicalDevice, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME });
+    if (drawIndirectCountSupported) {
+        deviceExtensionsRequired.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    // Необязательное расширение: бюджет куч памяти (запрашивается через свойства памяти из расширения экземпляра,
+    // которое экземпляр включает всегда, когда оно поддерживается - см. KGEVkInstance)
+    bool memoryBudgetSupported = kge::vkutility::CheckDeviceExtensionSupported(m_device.physicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME }) &&
+            kge::vkutility::CheckInstanceExtensionsSupported({ VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME });
+    if (memoryBudgetSupported) {
+        deviceExtensionsRequired.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
     // Проверка запрашиваемых расширений, указать если есть (если не доступны - ошибка)
     if (!deviceExtensionsRequired.empty()) {
         if (!kge::vkutility::CheckDeviceExtensionSupported(m_device.physicalDevice, deviceExtensionsRequired)) {
@@ -118,11 +136,16 @@ KGEVkDevice::KGEVkDevice(VkInstance vkInstance,
         deviceCreateInfo.ppEnabledLayerNames = validationLayersRequired.data();
     }
 
-    // Особенности устройства (пока-что пустая структура)
+    // Особенности устройства (включаются только особенности косвенной отрисовки, если поддерживаются)
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(m_device.physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
     // Создание логического устройства
-    if (vkCreateDevice(m_device.physicalDevice, &deviceCreateInfo, nullptr, &m_device.logicalDevice) != VK_SUCCESS) {
+    if (vkCreateDevice(m_device.physicalDevice, &deviceCreateInfo, kge::vkutility::HostAllocator(), &m_device.logicalDevice) != VK_SUCCESS) {
         std::cout << "cant create device" << std::endl;
         throw std::runtime_error("Vulkan: Failed to create logical device. Can't initialize renderer");
     }
@@ -132,15 +155,27 @@ KGEVkDevice::KGEVkDevice(VkInstance vkInstance,
     vkGetDeviceQueue(m_device.logicalDevice, m_device.queueFamilies.graphics, 0, &(m_device.queues.graphics));
     vkGetDeviceQueue(m_device.logicalDevice, m_device.queueFamilies.present, 0, &(m_device.queues.present));
 
+    m_device.multiDrawIndirect = deviceFeatures.multiDrawIndirect == VK_TRUE;
+    m_device.drawIndirectFirstInstance = deviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+    if (drawIndirectCountSupported) {
+        m_device.cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                    vkGetDeviceProcAddr(m_device.logicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+    if (memoryBudgetSupported) {
+        m_device.getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+                    vkGetInstanceProcAddr(vkInstance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+    }
+    if (m_device.getMemoryProperties2 == nullptr) {
+        kge::tools::LogMessage("Vulkan: VK_EXT_memory_budget is not supported, memory budget will be estimated from heap sizes");
+    }
+
     // Если в итоге устройство не готово - ошибка
     if (!m_device.IsReady()) {
         throw std::runtime_error("Vulkan: Failed to initialize device and queues. Can't initialize renderer");
     }
 
     // Сообщение об успешной инициализации устройства
-    std::string deviceName = std::string(m_device.GetProperties().deviceName);
-    std::string message = "Vulkan: Device successfully initialized (" + deviceName + ")";
-    kge::tools::LogMessage(message);
+    KGE_LOG_INFO("Vulkan: Device successfully initialized ({})", m_device.GetProperties().deviceName);
 }
 
 KGEVkDevice::~KGEVkDevice()
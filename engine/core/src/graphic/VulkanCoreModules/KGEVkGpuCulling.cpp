@@ -0,0 +1,351 @@
+#include "graphic/VulkanCoreModules/KGEVkGpuCulling.h"
+#include <cstring>
+
+// Размер группы вычислительного шейдера (должен совпадать с local_size_x в shaders/cull.comp)
+#define CULL_GROUP_SIZE 64
+
+// Push-константы прохода отсечения
+struct CullPushConstants
+{
+    uint32_t objectCount;
+    uint32_t compact;
+};
+
+/**
+* Проход GPU-отсечения
+* @param const kge::vkstructs::Device* device - устройство
+* @param unsigned int maxObjects - максимальное кол-во объектов (и команд, и пакетов)
+* @param unsigned int regionCount - кол-во областей буферов (по одной на каждое изображение swap-chain)
+* @param VkBuffer instanceBuffer - буфер экземпляров (из него читаются матрицы моделей)
+* @param VkDeviceSize instanceRegionSize - размер области буфера экземпляров
+*
+* @note - вычислительный шейдер проверяет ограничивающую сферу каждого объекта по пирамиде видимости и пишет
+* команды VkDrawIndexedIndirectCommand. При уплотнении (compact) видимые объекты занимают ячейки пакета подряд,
+* а кол-во команд пакета накапливается в буфере счетчиков (для vkCmdDrawIndexedIndirectCountKHR). Без уплотнения
+* каждый объект пишет команду в свою ячейку, у невидимых instanceCount = 0.
+* Буферы, как и uniform-буферы, разбиты на области по изображениям swap-chain
+*/
+KGEVkGpuCulling::KGEVkGpuCulling(const kge::vkstructs::Device* device,
+                                 unsigned int maxObjects,
+                                 unsigned int regionCount,
+                                 VkBuffer instanceBuffer,
+                                 VkDeviceSize instanceRegionSize):
+    m_device{device},
+    m_maxObjects{maxObjects},
+    m_objectsMapped{nullptr},
+    m_frustumMapped{nullptr},
+    m_descriptorSetLayout{nullptr},
+    m_descriptorPool{nullptr},
+    m_pipelineLayout{nullptr},
+    m_pipeline{nullptr}
+{
+    KGE_PROFILE_ZONE("KGEVkGpuCulling::KGEVkGpuCulling");
+    m_objectsRegionSize = AlignStorage(sizeof(kge::vkstructs::GpuCullObject) * maxObjects);
+    m_frustumRegionSize = AlignUniform(sizeof(kge::math::Frustum));
+    m_commandsRegionSize = AlignStorage(sizeof(VkDrawIndexedIndirectCommand) * maxObjects);
+    m_countsRegionSize = AlignStorage(sizeof(uint32_t) * maxObjects);
+
+    // Буферы
+    m_objectsBuffer = kge::vkutility::CreateBuffer(*m_device,
+                                                   m_objectsRegionSize * regionCount,
+                                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    m_frustumBuffer = kge::vkutility::CreateBuffer(*m_device,
+                                                   m_frustumRegionSize * regionCount,
+                                                   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    m_commandsBuffer = kge::vkutility::CreateBuffer(*m_device,
+                                                    m_commandsRegionSize * regionCount,
+                                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_countsBuffer = kge::vkutility::CreateBuffer(*m_device,
+                                                  m_countsRegionSize * regionCount,
+                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkMapMemory(m_device->logicalDevice, m_objectsBuffer.vkDeviceMemory, 0, VK_WHOLE_SIZE, 0, &m_objectsMapped) != VK_SUCCESS ||
+        vkMapMemory(m_device->logicalDevice, m_frustumBuffer.vkDeviceMemory, 0, VK_WHOLE_SIZE, 0, &m_frustumMapped) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while mapping GPU culling buffers memory");
+    }
+
+    // Размещение набора: объекты, матрицы, команды, счетчики, плоскости
+    std::vector<VkDescriptorSetLayoutBinding> bindings(5);
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 4 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_device->logicalDevice, &layoutInfo, kge::vkutility::HostAllocator(), &m_descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while creating GPU culling descriptor set layout");
+    }
+
+    // Пул и наборы (по набору на область)
+    std::vector<VkDescriptorPoolSize> poolSizes = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * regionCount },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, regionCount }
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = regionCount;
+
+    if (vkCreateDescriptorPool(m_device->logicalDevice, &poolInfo, kge::vkutility::HostAllocator(), &m_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while creating GPU culling descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(regionCount, m_descriptorSetLayout);
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = regionCount;
+    allocInfo.pSetLayouts = setLayouts.data();
+
+    m_descriptorSets.resize(regionCount);
+    if (vkAllocateDescriptorSets(m_device->logicalDevice, &allocInfo, m_descriptorSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while allocating GPU culling descriptor sets");
+    }
+
+    // Каждый набор смотрит на свои области буферов
+    for (unsigned int region = 0; region < regionCount; region++) {
+        VkDescriptorBufferInfo bufferInfos[5] = {
+            { m_objectsBuffer.vkBuffer, region * m_objectsRegionSize, m_objectsRegionSize },
+            { instanceBuffer, region * instanceRegionSize, instanceRegionSize },
+            { m_commandsBuffer.vkBuffer, region * m_commandsRegionSize, m_commandsRegionSize },
+            { m_countsBuffer.vkBuffer, region * m_countsRegionSize, m_countsRegionSize },
+            { m_frustumBuffer.vkBuffer, region * m_frustumRegionSize, sizeof(kge::math::Frustum) }
+        };
+
+        std::vector<VkWriteDescriptorSet> writes(5);
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            writes[i] = {};
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = m_descriptorSets[region];
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = bindings[i].descriptorType;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets(m_device->logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // Размещение и вычислительный конвейер
+    VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants) };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(m_device->logicalDevice, &pipelineLayoutInfo, kge::vkutility::HostAllocator(), &m_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while creating GPU culling pipeline layout");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = kge::vkutility::LoadSPIRVShader(std::filesystem::path(SHADERS_DIRECTORY "cull_comp.spv"), m_device->logicalDevice);
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = m_pipelineLayout;
+
+    VkResult pipelineStatus = vkCreateComputePipelines(m_device->logicalDevice, nullptr, 1, &pipelineInfo, kge::vkutility::HostAllocator(), &m_pipeline);
+
+    // Шейдерный модуль больше не нужен
+    vkDestroyShaderModule(m_device->logicalDevice, pipelineInfo.stage.module, kge::vkutility::HostAllocator());
+
+    if (pipelineStatus != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while creating GPU culling pipeline");
+    }
+
+    kge::tools::LogMessage("Vulkan: GPU culling successfully initialized");
+}
+
+/**
+* Деинициализация прохода GPU-отсечения
+*/
+KGEVkGpuCulling::~KGEVkGpuCulling()
+{
+    if (m_pipeline != nullptr) {
+        vkDestroyPipeline(m_device->logicalDevice, m_pipeline, kge::vkutility::HostAllocator());
+        m_pipeline = nullptr;
+    }
+
+    if (m_pipelineLayout != nullptr) {
+        vkDestroyPipelineLayout(m_device->logicalDevice, m_pipelineLayout, kge::vkutility::HostAllocator());
+        m_pipelineLayout = nullptr;
+    }
+
+    // Наборы освобождаются вместе с пулом
+    if (m_descriptorPool != nullptr) {
+        vkDestroyDescriptorPool(m_device->logicalDevice, m_descriptorPool, kge::vkutility::HostAllocator());
+        m_descriptorPool = nullptr;
+        m_descriptorSets.clear();
+    }
+
+    if (m_descriptorSetLayout != nullptr) {
+        vkDestroyDescriptorSetLayout(m_device->logicalDevice, m_descriptorSetLayout, kge::vkutility::HostAllocator());
+        m_descriptorSetLayout = nullptr;
+    }
+
+    if (m_objectsMapped != nullptr) {
+        vkUnmapMemory(m_device->logicalDevice, m_objectsBuffer.vkDeviceMemory);
+        m_objectsMapped = nullptr;
+    }
+
+    if (m_frustumMapped != nullptr) {
+        vkUnmapMemory(m_device->logicalDevice, m_frustumBuffer.vkDeviceMemory);
+        m_frustumMapped = nullptr;
+    }
+
+    for (kge::vkstructs::Buffer* buffer : { &m_objectsBuffer, &m_frustumBuffer, &m_commandsBuffer, &m_countsBuffer }) {
+        if (buffer->vkBuffer != nullptr) {
+            vkDestroyBuffer(m_device->logicalDevice, buffer->vkBuffer, kge::vkutility::HostAllocator());
+            buffer->vkBuffer = nullptr;
+        }
+        if (buffer->vkDeviceMemory != nullptr) {
+            kge::vkutility::FreeMemory(m_device->logicalDevice, buffer->vkDeviceMemory);
+            buffer->vkDeviceMemory = nullptr;
+        }
+    }
+
+    kge::tools::LogMessage("Vulkan: GPU culling successfully deinitialized");
+}
+
+/**
+* Копирование описаний объектов в область буфера объектов
+* @param unsigned int regionIndex - индекс области (изображения swap-chain)
+* @param const std::vector<kge::vkstructs::GpuCullObject> &objects - описания объектов
+*/
+void KGEVkGpuCulling::UploadObjects(unsigned int regionIndex, const std::vector<kge::vkstructs::GpuCullObject> &objects)
+{
+    if (objects.size() > m_maxObjects) {
+        throw std::runtime_error("Vulkan: Error. Too many objects for GPU culling");
+    }
+
+    memcpy(static_cast<unsigned char*>(m_objectsMapped) + regionIndex * m_objectsRegionSize,
+           objects.data(),
+           sizeof(kge::vkstructs::GpuCullObject) * objects.size());
+}
+
+/**
+* Копирование плоскостей пирамиды видимости в область uniform-буфера
+* @param unsigned int regionIndex - индекс области (изображения swap-chain)
+* @param const kge::math::Frustum &frustum - пирамида видимости
+*/
+void KGEVkGpuCulling::UploadFrustum(unsigned int regionIndex, const kge::math::Frustum &frustum)
+{
+    memcpy(static_cast<unsigned char*>(m_frustumMapped) + regionIndex * m_frustumRegionSize,
+           &frustum,
+           sizeof(kge::math::Frustum));
+}
+
+/**
+* Запись прохода отсечения в командный буфер (вне прохода рендеринга)
+* @param VkCommandBuffer commandBuffer - командный буфер
+* @param unsigned int regionIndex - индекс области (изображения swap-chain)
+* @param unsigned int objectCount - кол-во объектов
+* @param unsigned int batchCount - кол-во пакетов (обнуляемых счетчиков)
+* @param bool compact - уплотнять ли команды (требует vkCmdDrawIndexedIndirectCountKHR при отрисовке)
+*
+* @note - после записи команд стоит барьер, делающий их видимыми стадии чтения косвенных команд
+*/
+void KGEVkGpuCulling::RecordCull(VkCommandBuffer commandBuffer,
+                                 unsigned int regionIndex,
+                                 unsigned int objectCount,
+                                 unsigned int batchCount,
+                                 bool compact)
+{
+    if (objectCount == 0) {
+        return;
+    }
+
+    // Обнулить счетчики пакетов
+    if (compact) {
+        vkCmdFillBuffer(commandBuffer, m_countsBuffer.vkBuffer, countsRegionOffset(regionIndex), sizeof(uint32_t) * batchCount, 0);
+
+        VkMemoryBarrier fillBarrier = {};
+        fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    CullPushConstants pushConstants = { objectCount, compact ? 1u : 0u };
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSets[regionIndex], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pushConstants);
+    vkCmdDispatch(commandBuffer, (objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Команды и счетчики будут прочитаны как параметры косвенной отрисовки
+    VkMemoryBarrier cullBarrier = {};
+    cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+unsigned int KGEVkGpuCulling::maxObjects() const
+{
+    return m_maxObjects;
+}
+
+VkBuffer KGEVkGpuCulling::commandsBuffer() const
+{
+    return m_commandsBuffer.vkBuffer;
+}
+
+VkDeviceSize KGEVkGpuCulling::commandsRegionOffset(unsigned int regionIndex) const
+{
+    return regionIndex * m_commandsRegionSize;
+}
+
+VkBuffer KGEVkGpuCulling::countsBuffer() const
+{
+    return m_countsBuffer.vkBuffer;
+}
+
+VkDeviceSize KGEVkGpuCulling::countsRegionOffset(unsigned int regionIndex) const
+{
+    return regionIndex * m_countsRegionSize;
+}
+
+/**
+* Выравнивание размера области под смещение дескриптора буфера хранилища
+*/
+VkDeviceSize KGEVkGpuCulling::AlignStorage(VkDeviceSize size) const
+{
+    VkDeviceSize alignment = m_device->GetProperties().limits.minStorageBufferOffsetAlignment;
+    return alignment > 0 ? (size + alignment - 1) & ~(alignment - 1) : size;
+}
+
+/**
+* Выравнивание размера области под смещение дескриптора uniform-буфера
+*/
+VkDeviceSize KGEVkGpuCulling::AlignUniform(VkDeviceSize size) const
+{
+    VkDeviceSize alignment = m_device->GetProperties().limits.minUniformBufferOffsetAlignment;
+    return alignment > 0 ? (size + alignment - 1) & ~(alignment - 1) : size;
+}
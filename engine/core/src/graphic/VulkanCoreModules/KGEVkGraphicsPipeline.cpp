@@ -6,6 +6,9 @@
 * @param VkPipelineLayout pipelineLayout - хендл размещения конвейера
 * @param vktoolkit::Swapchain &swapchain - swap-chain, для получения информации о разрешении
 * @param VkRenderPass renderPass - хендл прохода рендеринга (на него ссылается конвейер)
+* @param VERTEX_LAYOUT vertexLayout - формат вершин в буферах геометрии
+* @param std::string vertexShaderFile - имя файла вершинного шейдера (SPIR-V), напр. вариант с push-константами
+* @param bool instanced - конвейер для экземпляризированной отрисовки (добавляется привязка 1 - буфер экземпляров, location 4-7)
 *
 * @note - графический конвейер производит рендериннг принимая вершинные данные на вход и выводя пиксели в
 * буферы кадров. Конвейер состоит из множества стадий, некоторые из них программируемые (шейдерные). Конвейер
@@ -20,12 +23,24 @@ VkPipeline KGEVkGraphicsPipeline::pipeline() const
 KGEVkGraphicsPipeline::KGEVkGraphicsPipeline(const kge::vkstructs::Device* device,
                                              VkPipelineLayout pipelineLayout,
                                              const kge::vkstructs::Swapchain &swapchain,
-                                             VkRenderPass renderPass):
+                                             VkRenderPass renderPass,
+                                             VERTEX_LAYOUT vertexLayout,
+                                             std::string vertexShaderFile,
+                                             bool instanced):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkGraphicsPipeline::KGEVkGraphicsPipeline");
     // Конфигурация привязок и аттрибутов входных данных (вершинных)
-    std::vector<VkVertexInputBindingDescription> bindingDescription = kge::vkutility::GetVertexInputBindingDescriptions(0);
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = kge::vkutility::GetVertexInputAttributeDescriptions(0);
+    std::vector<VkVertexInputBindingDescription> bindingDescription = kge::vkutility::GetVertexInputBindingDescriptions(0, vertexLayout);
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = kge::vkutility::GetVertexInputAttributeDescriptions(0, vertexLayout);
+
+    // Для экземпляризированной отрисовки - матрицы моделей экземпляров из буфера экземпляров
+    if (instanced) {
+        std::vector<VkVertexInputBindingDescription> instanceBinding = kge::vkutility::GetInstanceInputBindingDescriptions(1);
+        std::vector<VkVertexInputAttributeDescription> instanceAttributes = kge::vkutility::GetInstanceInputAttributeDescriptions(1, 4);
+        bindingDescription.insert(bindingDescription.end(), instanceBinding.begin(), instanceBinding.end());
+        attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+    }
 
     // Конфигурация стадии ввода вершинных данных
     VkPipelineVertexInputStateCreateInfo vertexInputStage = {};
@@ -54,7 +69,7 @@ KGEVkGraphicsPipeline::KGEVkGraphicsPipeline(const kge::vkstructs::Device* devic
             nullptr,
             0,
             VK_SHADER_STAGE_VERTEX_BIT,
-            kge::vkutility::LoadSPIRVShader(std::filesystem::path("/home/vxuser/GitHub/KitevaGameEngine/shaders/vert.spv"), device->logicalDevice),
+            kge::vkutility::LoadSPIRVShader(std::filesystem::path(SHADERS_DIRECTORY + vertexShaderFile), device->logicalDevice),
             "main",
             nullptr
         },
@@ -63,7 +78,7 @@ KGEVkGraphicsPipeline::KGEVkGraphicsPipeline(const kge::vkstructs::Device* devic
             nullptr,
             0,
             VK_SHADER_STAGE_FRAGMENT_BIT,
-            kge::vkutility::LoadSPIRVShader(std::filesystem::path("/home/vxuser/GitHub/KitevaGameEngine/shaders/frag.spv"), device->logicalDevice),
+            kge::vkutility::LoadSPIRVShader(std::filesystem::path(SHADERS_DIRECTORY "frag.spv"), device->logicalDevice),
             "main",
             nullptr
         }
@@ -179,7 +194,7 @@ KGEVkGraphicsPipeline::KGEVkGraphicsPipeline(const kge::vkstructs::Device* devic
     if (vkCreateGraphicsPipelines(device->logicalDevice,
                                   nullptr, 1,
                                   &pipelineInfo,
-                                  nullptr,
+                                  kge::vkutility::HostAllocator(),
                                   &m_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error while creating pipeline");
     }
@@ -188,15 +203,25 @@ KGEVkGraphicsPipeline::KGEVkGraphicsPipeline(const kge::vkstructs::Device* devic
 
     // Шейдерные модули больше не нужны после создания конвейера
     for (VkPipelineShaderStageCreateInfo &shaderStageInfo : shaderStages) {
-        vkDestroyShaderModule(device->logicalDevice, shaderStageInfo.module, nullptr);
+        vkDestroyShaderModule(device->logicalDevice, shaderStageInfo.module, kge::vkutility::HostAllocator());
     }
 }
 
 KGEVkGraphicsPipeline::~KGEVkGraphicsPipeline()
 {
     if (m_device->logicalDevice != nullptr && &m_pipeline != nullptr && m_pipeline != nullptr) {
-        vkDestroyPipeline(m_device->logicalDevice, m_pipeline, nullptr);
+        vkDestroyPipeline(m_device->logicalDevice, m_pipeline, kge::vkutility::HostAllocator());
         m_pipeline = nullptr;
         kge::tools::LogMessage("Vulkan: Pipeline sucessfully deinitialized");
     }
 }
+
+/**
+* Обмен хендлами с другим конвейером
+* @param KGEVkGraphicsPipeline &other - конвейер, получающий текущий хендл (и удаляющий его в своем деструкторе)
+*/
+void KGEVkGraphicsPipeline::Swap(KGEVkGraphicsPipeline &other)
+{
+    std::swap(m_pipeline, other.m_pipeline);
+    std::swap(m_device, other.m_device);
+}
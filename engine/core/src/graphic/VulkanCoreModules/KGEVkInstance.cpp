@@ -13,6 +13,7 @@ KGEVkInstance::KGEVkInstance(std::string applicationName,
         std::vector<const char*> validationLayersRequired) :
     m_instance{}
 {
+    KGE_PROFILE_ZONE("KGEVkInstance::KGEVkInstance");
     // Структура с информацией о создаваемом приложении
     // Здесь содержиться информация о названии, версии приложения и движка. Эта информация может быть полезна разработчикам драйверов
     VkApplicationInfo applicationInfo = {};
@@ -34,6 +35,18 @@ KGEVkInstance::KGEVkInstance(std::string applicationName,
 
     bool validationQueried = false;
 
+    // Необязательное расширение: запрос свойств устройства через цепочки структур (нужно для бюджета памяти, VK_EXT_memory_budget)
+    bool properties2Queried = false;
+    for (auto* extensionName : extensionsRequired) {
+        if (strcmp(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, extensionName) == 0) {
+            properties2Queried = true;
+            break;
+        }
+    }
+    if (!properties2Queried && kge::vkutility::CheckInstanceExtensionsSupported({ VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME })) {
+        extensionsRequired.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
+
     // Если запрашиваются расширения
     if (!extensionsRequired.empty())
     {
@@ -79,7 +92,7 @@ KGEVkInstance::KGEVkInstance(std::string applicationName,
 
     // Передается указатель на структуру CreateInfo, которую заполнили выше, и указатель на переменную хендла
     // instance'а, куда и будет помещен сам хендл. Если функция не вернула VK_SUCCESS - ошибка
-    if (vkCreateInstance(&instanceCreateInfo, nullptr, &m_instance) != VK_SUCCESS) {
+    if (vkCreateInstance(&instanceCreateInfo, kge::vkutility::HostAllocator(), &m_instance) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error in the 'vkCreateInstance' function");
     }
 
@@ -89,7 +102,7 @@ KGEVkInstance::KGEVkInstance(std::string applicationName,
 KGEVkInstance::~KGEVkInstance()
 {
     if (m_instance != nullptr || m_instance != nullptr) {
-        vkDestroyInstance(m_instance, nullptr);
+        vkDestroyInstance(m_instance, kge::vkutility::HostAllocator());
         m_instance = nullptr;
 
         std::cout << "Vulkan: Instance sucessfully destroyed" << std::endl;
@@ -0,0 +1,88 @@
+#include "graphic/VulkanCoreModules/KGEVkInstanceBuffer.h"
+
+/**
+* Создание буфера экземпляров (вершинный буфер с шагом "на экземпляр", содержит матрицы моделей экземпляров)
+* @param const kge::vkstructs::Device &device - устройство
+* @param unsigned int maxInstances - максимальное кол-во экземпляров на сцене (суммарно для всех экземпляризированных примитивов)
+* @param unsigned int regionCount - кол-во областей буфера (по одной на каждое изображение swap-chain)
+*
+* @note - буфер привязывается к конвейеру как вершинный (VK_VERTEX_INPUT_RATE_INSTANCE), каждая матрица передается в шейдер
+* четырьмя атрибутами vec4. Как и uniform-буферы, буфер разбит на области по изображениям swap-chain, кадр пишет только в свою
+* область. Память хост-когерентна и размечена на все время жизни буфера. Проход GPU-отсечения читает матрицы из того же
+* буфера как из буфера хранилища, поэтому размер области выровнен по minStorageBufferOffsetAlignment
+*/
+VkBuffer KGEVkInstanceBuffer::instanceBuffer() const
+{
+    return m_instanceBuffer.vkBuffer;
+}
+
+unsigned int KGEVkInstanceBuffer::maxInstances() const
+{
+    return m_maxInstances;
+}
+
+VkDeviceSize KGEVkInstanceBuffer::regionSize() const
+{
+    return m_regionSize;
+}
+
+VkDeviceSize KGEVkInstanceBuffer::regionOffset(unsigned int regionIndex) const
+{
+    return regionIndex * m_regionSize;
+}
+
+glm::mat4* KGEVkInstanceBuffer::region(unsigned int regionIndex) const
+{
+    return reinterpret_cast<glm::mat4*>(static_cast<unsigned char*>(m_pMapped) + regionOffset(regionIndex));
+}
+
+KGEVkInstanceBuffer::KGEVkInstanceBuffer(const kge::vkstructs::Device* device,
+                                         unsigned int maxInstances,
+                                         unsigned int regionCount):
+    m_device{device},
+    m_pMapped{nullptr},
+    m_regionSize{sizeof(glm::mat4) * maxInstances},
+    m_maxInstances{maxInstances}
+{
+    KGE_PROFILE_ZONE("KGEVkInstanceBuffer::KGEVkInstanceBuffer");
+    VkDeviceSize storageAlignment = m_device->GetProperties().limits.minStorageBufferOffsetAlignment;
+    if (storageAlignment > 0) {
+        m_regionSize = (m_regionSize + storageAlignment - 1) & ~(storageAlignment - 1);
+    }
+
+    m_instanceBuffer = kge::vkutility::CreateBuffer(
+                *m_device,
+                m_regionSize * regionCount,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Разметить буфер целиком (сделать его доступным для копирования информации)
+    if (vkMapMemory(m_device->logicalDevice, m_instanceBuffer.vkDeviceMemory, 0, VK_WHOLE_SIZE, 0, &m_pMapped) != VK_SUCCESS) {
+        throw std::runtime_error("Vulkan: Error while mapping instance buffer memory");
+    }
+
+    kge::tools::LogMessage("Vulkan: Instance buffer successfully allocated");
+}
+
+/**
+* Деинициализация буфера экземпляров
+*/
+KGEVkInstanceBuffer::~KGEVkInstanceBuffer()
+{
+    if (m_pMapped != nullptr) {
+        vkUnmapMemory(m_device->logicalDevice, m_instanceBuffer.vkDeviceMemory);
+        m_pMapped = nullptr;
+    }
+
+    if (m_instanceBuffer.vkBuffer != nullptr) {
+        vkDestroyBuffer(m_device->logicalDevice, m_instanceBuffer.vkBuffer, kge::vkutility::HostAllocator());
+        m_instanceBuffer.vkBuffer = nullptr;
+    }
+
+    if (m_instanceBuffer.vkDeviceMemory != nullptr) {
+        kge::vkutility::FreeMemory(m_device->logicalDevice, m_instanceBuffer.vkDeviceMemory);
+        m_instanceBuffer.vkDeviceMemory = nullptr;
+
+        kge::tools::LogMessage("Vulkan: Instance buffer successfully deinitialized");
+    }
+}
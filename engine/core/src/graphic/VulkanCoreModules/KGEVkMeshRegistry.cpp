@@ -0,0 +1,421 @@
+#include "graphic/VulkanCoreModules/KGEVkMeshRegistry.h"
+#include <cstring>
+
+/**
+* Хеш геометрии (FNV-1a, 64 бита) по байтам вершин и индексов
+* @param const kge::vkstructs::EncodedMesh &encoded - упакованная геометрия
+* @param const glm::vec4 &positionDequantization - распаковка позиций (одинаковые байты с разной распаковкой - разная геометрия)
+* @return uint64_t - хеш
+*/
+static uint64_t HashGeometry(const kge::vkstructs::EncodedMesh &encoded, const glm::vec4 &positionDequantization)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    auto hashBytes = [&hash](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    // Кол-ва учитываются отдельно, чтобы граница между вершинами и индексами не "сдвигалась"
+    uint64_t vertexSize = encoded.vertexBytes;
+    uint64_t indexSize = encoded.indexBytes;
+    hashBytes(&vertexSize, sizeof(vertexSize));
+    hashBytes(&indexSize, sizeof(indexSize));
+    hashBytes(&positionDequantization, sizeof(positionDequantization));
+    hashBytes(encoded.vertexData, static_cast<std::size_t>(encoded.vertexBytes));
+    hashBytes(encoded.indexData, static_cast<std::size_t>(encoded.indexBytes));
+
+    return hash;
+}
+
+/**
+* Реестр геометрии
+* @param const kge::vkstructs::Device* device - устройство
+* @param VERTEX_LAYOUT vertexLayout - формат вершин в буферах (см. kge::vkutility::EncodeVertices)
+* @param KGEVkDeletionQueue* deletionQueue - очередь отложенного удаления (буферы освобожденной геометрии еще могут читаться отправленными кадрами)
+*
+* @note - одинаковая геометрия (совпадающие вершины и индексы) загружается в память устройства один раз. Примитивы ссылаются
+* на геометрию по хендлу, геометрия освобождается когда на нее не остается ссылок (хендл с поколением - обращение по хендлу
+* освобожденной геометрии распознается, даже если ее ячейку уже заняла другая)
+*/
+KGEVkMeshRegistry::KGEVkMeshRegistry(const kge::vkstructs::Device* device, VERTEX_LAYOUT vertexLayout, KGEVkDeletionQueue* deletionQueue):
+    m_device{device},
+    m_vertexLayout{vertexLayout},
+    m_deletionQueue{deletionQueue},
+    m_hostHeapAvailable{kge::vkutility::GetMemoryTypeIndex(device->physicalDevice,
+                                                           UINT32_MAX,
+                                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                           VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) >= 0}
+{
+    KGE_PROFILE_ZONE("KGEVkMeshRegistry::KGEVkMeshRegistry");
+    kge::tools::LogMessage("Vulkan: Mesh registry successfully initialized");
+}
+
+/**
+* Освобождение всей оставшейся геометрии
+*/
+KGEVkMeshRegistry::~KGEVkMeshRegistry()
+{
+    for (kge::vkstructs::Mesh &mesh : m_meshes.items()) {
+        DestroyBuffers(mesh);
+    }
+
+    m_meshes.Clear();
+    m_hashIndex.clear();
+
+    kge::tools::LogMessage("Vulkan: Mesh registry successfully deinitialized");
+}
+
+/**
+* Регистрация геометрии
+* @param const std::vector<kge::vkstructs::Vertex> &vertices - массив вершин
+* @param const std::vector<unsigned int> &indices - массив индексов (может быть пуст)
+* @return kge::vkstructs::MeshHandle - хендл геометрии (вызывающий владеет одной ссылкой, см. Release)
+*
+* @note - если такая же геометрия уже зарегистрирована, возвращается ее хендл (с увеличением счетчика ссылок),
+* новые буферы не создаются. Совпадение хеша перепроверяется побайтовым сравнением с содержимым буферов.
+* Сравниваются уже упакованные данные - геометрия, различающаяся меньше точности формата, тоже общая
+*/
+kge::vkstructs::MeshHandle KGEVkMeshRegistry::Register(const std::vector<kge::vkstructs::Vertex> &vertices,
+                                                       const std::vector<unsigned int> &indices)
+{
+    if (vertices.empty()) {
+        throw std::runtime_error("Vulkan: Error while registering mesh. Empty vertex array recieved");
+    }
+
+    kge::vkstructs::EncodedMesh encoded;
+    encoded.vertexCount = static_cast<uint32_t>(vertices.size());
+    encoded.indexCount = static_cast<uint32_t>(indices.size());
+
+    // Локальные границы (используются при отсечении примитивов и упаковке позиций)
+    encoded.boundsMin = vertices[0].position;
+    encoded.boundsMax = vertices[0].position;
+    for (const kge::vkstructs::Vertex &vertex : vertices) {
+        encoded.boundsMin = glm::min(encoded.boundsMin, vertex.position);
+        encoded.boundsMax = glm::max(encoded.boundsMax, vertex.position);
+    }
+
+    glm::vec3 boundsCenter = (encoded.boundsMin + encoded.boundsMax) * 0.5f;
+    for (const kge::vkstructs::Vertex &vertex : vertices) {
+        encoded.boundingRadius = glm::max(encoded.boundingRadius, glm::length(vertex.position - boundsCenter));
+    }
+
+    // Упаковка в формат буферов устройства
+    kge::vkutility::EncodeVertices(vertices,
+                                   m_vertexLayout,
+                                   kge::vkutility::PositionDequantization(encoded.boundsMin, encoded.boundsMax, m_vertexLayout),
+                                   m_vertexBytes);
+    encoded.indexType = kge::vkutility::EncodeIndices(indices, encoded.vertexCount, m_indexBytes);
+    encoded.vertexData = m_vertexBytes.data();
+    encoded.vertexBytes = static_cast<VkDeviceSize>(m_vertexBytes.size());
+    encoded.indexData = m_indexBytes.data();
+    encoded.indexBytes = static_cast<VkDeviceSize>(m_indexBytes.size());
+
+    return RegisterEncoded(encoded);
+}
+
+/**
+* Регистрация уже упакованной геометрии (формат вершин должен совпадать с форматом реестра)
+* @param const kge::vkstructs::EncodedMesh &encoded - упакованная геометрия и ее границы
+* @return kge::vkstructs::MeshHandle - хендл геометрии (вызывающий владеет одной ссылкой, см. Release)
+* @note - данные копируются прямо в буферы устройства, поэтому могут находиться в отображенном в память файле
+*/
+kge::vkstructs::MeshHandle KGEVkMeshRegistry::RegisterEncoded(const kge::vkstructs::EncodedMesh &encoded)
+{
+    if (encoded.vertexCount == 0 || encoded.vertexData == nullptr) {
+        throw std::runtime_error("Vulkan: Error while registering mesh. Empty vertex array recieved");
+    }
+
+    // Распаковка позиций определяется границами (так же упаковывает и сборщик пакетов)
+    glm::vec4 positionDequantization = kge::vkutility::PositionDequantization(encoded.boundsMin, encoded.boundsMax, m_vertexLayout);
+    uint64_t hash = HashGeometry(encoded, positionDequantization);
+
+    // Поиск уже загруженной геометрии с таким же содержимым
+    auto range = m_hashIndex.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        kge::vkstructs::Mesh &existing = m_meshes.Get(it->second);
+        if (existing.positionDequantization == positionDequantization && ContentEquals(existing, encoded)) {
+            existing.refCount++;
+            return it->second;
+        }
+    }
+
+    // Новая геометрия
+    kge::vkstructs::Mesh mesh;
+    mesh.hash = hash;
+    mesh.drawIndexed = encoded.indexCount > 0;
+    mesh.refCount = 1;
+    mesh.boundsMin = encoded.boundsMin;
+    mesh.boundsMax = encoded.boundsMax;
+    mesh.boundingRadius = encoded.boundingRadius;
+    mesh.positionDequantization = positionDequantization;
+    CreateBuffers(mesh, encoded);
+
+    // Пул занимает свободную ячейку (с новым поколением) либо добавляет новую
+    kge::vkstructs::MeshHandle handle = m_meshes.Add(mesh);
+    m_hashIndex.emplace(hash, handle);
+
+    return handle;
+}
+
+/**
+* Увеличение счетчика ссылок
+* @param kge::vkstructs::MeshHandle handle - хендл геометрии
+*/
+void KGEVkMeshRegistry::AddRef(kge::vkstructs::MeshHandle handle)
+{
+    kge::vkstructs::Mesh* mesh = m_meshes.Find(handle);
+    if (mesh == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Invalid mesh handle");
+    }
+
+    mesh->refCount++;
+}
+
+/**
+* Уменьшение счетчика ссылок, освобождение буферов при его обнулении
+* @param kge::vkstructs::MeshHandle handle - хендл геометрии
+* @note - буферы удаляются через очередь отложенного удаления, вызывающий должен лишь гарантировать, что командные
+* буферы будут перезаписаны до следующей отправки
+*/
+void KGEVkMeshRegistry::Release(kge::vkstructs::MeshHandle handle)
+{
+    kge::vkstructs::Mesh* found = m_meshes.Find(handle);
+    if (found == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Invalid mesh handle");
+    }
+
+    kge::vkstructs::Mesh &mesh = *found;
+    if (--mesh.refCount > 0) {
+        return;
+    }
+
+    // Убрать из индекса хешей
+    auto range = m_hashIndex.equal_range(mesh.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == handle) {
+            m_hashIndex.erase(it);
+            break;
+        }
+    }
+
+    // Ячейку можно выдать снова сразу (с новым поколением) - буферы удалятся, когда их перестанут читать отправленные кадры
+    m_deletionQueue->DestroyBuffer(mesh.vertexBuffer);
+    m_deletionQueue->DestroyBuffer(mesh.indexBuffer);
+    m_meshes.Remove(handle);
+}
+
+/**
+* Получить геометрию по хендлу
+* @param kge::vkstructs::MeshHandle handle - хендл геометрии
+* @return const kge::vkstructs::Mesh& - геометрия
+*/
+const kge::vkstructs::Mesh& KGEVkMeshRegistry::mesh(kge::vkstructs::MeshHandle handle) const
+{
+    const kge::vkstructs::Mesh* mesh = m_meshes.Find(handle);
+    if (mesh == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Invalid mesh handle");
+    }
+
+    return *mesh;
+}
+
+/**
+* Кол-во уникальной загруженной геометрии
+*/
+unsigned int KGEVkMeshRegistry::meshCount() const
+{
+    return static_cast<unsigned int>(m_meshes.size());
+}
+
+/**
+* Объем памяти занимаемой буферами всей загруженной геометрии
+*/
+VkDeviceSize KGEVkMeshRegistry::memoryUsed() const
+{
+    VkDeviceSize total = 0;
+    for (const kge::vkstructs::Mesh &mesh : m_meshes.items()) {
+        total += mesh.vertexBuffer.size + mesh.indexBuffer.size;
+    }
+    return total;
+}
+
+/**
+* Хендлы всей загруженной геометрии
+*/
+std::vector<kge::vkstructs::MeshHandle> KGEVkMeshRegistry::handles() const
+{
+    std::vector<kge::vkstructs::MeshHandle> result(m_meshes.size());
+    for (std::size_t i = 0; i < m_meshes.size(); i++) {
+        result[i] = m_meshes.handle(i);
+    }
+    return result;
+}
+
+/**
+* Перенос буферов геометрии из локальной кучи устройства в память хоста (вытеснение при нехватке бюджета, см. KGEVkResidency)
+* @param kge::vkstructs::MeshHandle handle - хендл геометрии
+* @return VkDeviceSize - объем освобожденной памяти локальной кучи (0 - геометрия уже вне локальных куч либо переносить некуда)
+*
+* @note - буферы геометрии доступны хосту в любой куче (на некоторых устройствах такая память оказывается локальной),
+* поэтому содержимое копируется хостом, без команд устройства. Старые буферы удаляются через очередь отложенного удаления,
+* вызывающий должен лишь гарантировать, что командные буферы будут перезаписаны до следующей отправки
+*/
+VkDeviceSize KGEVkMeshRegistry::Demote(kge::vkstructs::MeshHandle handle)
+{
+    kge::vkstructs::Mesh* found = m_meshes.Find(handle);
+    if (found == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Invalid mesh handle");
+    }
+
+    kge::vkstructs::Mesh &mesh = *found;
+    uint32_t heap = kge::vkutility::MemoryHeap(mesh.vertexBuffer.vkDeviceMemory);
+    if (!m_hostHeapAvailable || heap == UINT32_MAX || !KGEMemoryTracker::deviceHeap(heap).deviceLocal) {
+        return 0;
+    }
+
+    // Копия буфера в куче хоста
+    auto demote = [this](kge::vkstructs::Buffer &buffer, VkBufferUsageFlags usage) {
+        kge::vkstructs::Buffer demoted = kge::vkutility::CreateBuffer(*m_device,
+                                                                      buffer.size,
+                                                                      usage,
+                                                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                                      VK_SHARING_MODE_EXCLUSIVE,
+                                                                      VK_MEMORY_HEAP_DEVICE_LOCAL_BIT);
+
+        void* source = nullptr;
+        void* destination = nullptr;
+        vkMapMemory(m_device->logicalDevice, buffer.vkDeviceMemory, 0, buffer.size, 0, &source);
+        vkMapMemory(m_device->logicalDevice, demoted.vkDeviceMemory, 0, buffer.size, 0, &destination);
+        memcpy(destination, source, static_cast<size_t>(buffer.size));
+        vkUnmapMemory(m_device->logicalDevice, demoted.vkDeviceMemory);
+        vkUnmapMemory(m_device->logicalDevice, buffer.vkDeviceMemory);
+
+        m_deletionQueue->DestroyBuffer(buffer);
+        buffer.vkBuffer = demoted.vkBuffer;
+        buffer.vkDeviceMemory = demoted.vkDeviceMemory;
+    };
+
+    VkDeviceSize freed = mesh.vertexBuffer.size;
+    demote(mesh.vertexBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    if (mesh.indexBuffer.vkBuffer != nullptr) {
+        freed += mesh.indexBuffer.size;
+        demote(mesh.indexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    }
+
+    return freed;
+}
+
+/**
+* Создание буферов вершин и индексов (в памяти доступной хосту) из упакованных данных
+* @param kge::vkstructs::Mesh &mesh - геометрия, в которую будут записаны хендлы буферов
+* @param const kge::vkstructs::EncodedMesh &encoded - упакованная геометрия
+*/
+void KGEVkMeshRegistry::CreateBuffers(kge::vkstructs::Mesh &mesh,
+                                      const kge::vkstructs::EncodedMesh &encoded)
+{
+    VkDeviceSize vertexBufferSize = encoded.vertexBytes;
+
+    // Создать буфер вершин в памяти хоста
+    kge::vkstructs::Buffer tmp = kge::vkutility::CreateBuffer(*m_device, vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    mesh.vertexBuffer.vkBuffer = tmp.vkBuffer;
+    mesh.vertexBuffer.vkDeviceMemory = tmp.vkDeviceMemory;
+    mesh.vertexBuffer.size = tmp.size;
+    mesh.vertexBuffer.count = encoded.vertexCount;
+
+    // Разметить память буфера вершин и скопировать в него данные (без промежуточной копии), после чего убрать разметку
+    void * verticesMemPtr;
+    vkMapMemory(m_device->logicalDevice, mesh.vertexBuffer.vkDeviceMemory, 0, vertexBufferSize, 0, &verticesMemPtr);
+    memcpy(verticesMemPtr, encoded.vertexData, static_cast<size_t>(vertexBufferSize));
+    vkUnmapMemory(m_device->logicalDevice, mesh.vertexBuffer.vkDeviceMemory);
+
+    // Если необходимо рисовать индексированную геометрию
+    if (encoded.indexCount > 0) {
+        VkDeviceSize indexBufferSize = encoded.indexBytes;
+
+        // Cоздать буфер индексов в памяти хоста
+        tmp = kge::vkutility::CreateBuffer(*m_device,
+                                           indexBufferSize,
+                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        mesh.indexBuffer.vkBuffer = tmp.vkBuffer;
+        mesh.indexBuffer.vkDeviceMemory = tmp.vkDeviceMemory;
+        mesh.indexBuffer.size = tmp.size;
+        mesh.indexBuffer.count = encoded.indexCount;
+        mesh.indexBuffer.type = encoded.indexType;
+
+        // Разметить память буфера индексов и скопировать в него данные, после чего убрать разметку
+        void * indicesMemPtr;
+        vkMapMemory(m_device->logicalDevice, mesh.indexBuffer.vkDeviceMemory, 0, indexBufferSize, 0, &indicesMemPtr);
+        memcpy(indicesMemPtr, encoded.indexData, static_cast<size_t>(indexBufferSize));
+        vkUnmapMemory(m_device->logicalDevice, mesh.indexBuffer.vkDeviceMemory);
+    }
+}
+
+/**
+* Освобождение буферов геометрии
+* @param kge::vkstructs::Mesh &mesh - геометрия
+*/
+void KGEVkMeshRegistry::DestroyBuffers(kge::vkstructs::Mesh &mesh)
+{
+    if (mesh.vertexBuffer.vkBuffer != nullptr) {
+        vkDestroyBuffer(m_device->logicalDevice, mesh.vertexBuffer.vkBuffer, kge::vkutility::HostAllocator());
+        mesh.vertexBuffer.vkBuffer = nullptr;
+    }
+
+    if (mesh.vertexBuffer.vkDeviceMemory != nullptr) {
+        kge::vkutility::FreeMemory(m_device->logicalDevice, mesh.vertexBuffer.vkDeviceMemory);
+        mesh.vertexBuffer.vkDeviceMemory = nullptr;
+    }
+
+    if (mesh.indexBuffer.vkBuffer != nullptr) {
+        vkDestroyBuffer(m_device->logicalDevice, mesh.indexBuffer.vkBuffer, kge::vkutility::HostAllocator());
+        mesh.indexBuffer.vkBuffer = nullptr;
+    }
+
+    if (mesh.indexBuffer.vkDeviceMemory != nullptr) {
+        kge::vkutility::FreeMemory(m_device->logicalDevice, mesh.indexBuffer.vkDeviceMemory);
+        mesh.indexBuffer.vkDeviceMemory = nullptr;
+    }
+}
+
+/**
+* Побайтовое сравнение упакованной геометрии с содержимым буферов уже загруженной геометрии
+* (защита от коллизий хеша)
+* @note - буферы находятся в памяти доступной хосту, поэтому сравнение идет с их содержимым, без хранения копии на стороне хоста
+*/
+bool KGEVkMeshRegistry::ContentEquals(const kge::vkstructs::Mesh &mesh,
+                                      const kge::vkstructs::EncodedMesh &encoded) const
+{
+    if (mesh.vertexBuffer.count != encoded.vertexCount || mesh.indexBuffer.count != encoded.indexCount ||
+            mesh.vertexBuffer.size != encoded.vertexBytes || (encoded.indexCount > 0 && mesh.indexBuffer.type != encoded.indexType)) {
+        return false;
+    }
+
+    bool equals = true;
+
+    void* memPtr = nullptr;
+    vkMapMemory(m_device->logicalDevice, mesh.vertexBuffer.vkDeviceMemory, 0, encoded.vertexBytes, 0, &memPtr);
+    equals = memcmp(memPtr, encoded.vertexData, static_cast<size_t>(encoded.vertexBytes)) == 0;
+    vkUnmapMemory(m_device->logicalDevice, mesh.vertexBuffer.vkDeviceMemory);
+
+    if (equals && encoded.indexCount > 0) {
+        vkMapMemory(m_device->logicalDevice, mesh.indexBuffer.vkDeviceMemory, 0, encoded.indexBytes, 0, &memPtr);
+        equals = memcmp(memPtr, encoded.indexData, static_cast<size_t>(encoded.indexBytes)) == 0;
+        vkUnmapMemory(m_device->logicalDevice, mesh.indexBuffer.vkDeviceMemory);
+    }
+
+    return equals;
+}
+
+/**
+* Формат вершин в буферах реестра
+*/
+VERTEX_LAYOUT KGEVkMeshRegistry::vertexLayout() const
+{
+    return m_vertexLayout;
+}
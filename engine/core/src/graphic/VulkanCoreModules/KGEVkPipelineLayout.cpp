@@ -4,6 +4,8 @@
 * Инициализация размещения графического конвейера
 * @param const vktoolkit::Device &device - устройство
 * @param std::vector<VkDescriptorSetLayout> descriptorSetLayouts - хендлы размещениий дискрипторного набора (дает конвейеру инфу о дескрипторах)
+* @param std::vector<VkPushConstantRange> pushConstantRanges - диапазоны push-констант (необязательно). Push-константы записываются
+* прямо в командный буфер (vkCmdPushConstants) и позволяют передавать небольшие данные на каждую отрисовку без привязки дескрипторов
 * @return VkPipelineLayout - хендл размещения конвейера
 */
 VkPipelineLayout KGEVkPipelineLayout::pipelineLayout() const
@@ -12,16 +14,20 @@ VkPipelineLayout KGEVkPipelineLayout::pipelineLayout() const
 }
 
 KGEVkPipelineLayout::KGEVkPipelineLayout(const kge::vkstructs::Device* device,
-                                         std::vector<VkDescriptorSetLayout> descriptorSetLayouts):
+                                         std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+                                         std::vector<VkPushConstantRange> pushConstantRanges):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkPipelineLayout::KGEVkPipelineLayout");
     VkPipelineLayoutCreateInfo pPipelineLayoutCreateInfo = {};
     pPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pPipelineLayoutCreateInfo.pNext = nullptr;
     pPipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pPipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+    pPipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pPipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data();
 
-    if (vkCreatePipelineLayout(m_device->logicalDevice, &pPipelineLayoutCreateInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+    if (vkCreatePipelineLayout(m_device->logicalDevice, &pPipelineLayoutCreateInfo, kge::vkutility::HostAllocator(), &m_pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error while creating pipeline layout");
     }
 
@@ -36,7 +42,7 @@ KGEVkPipelineLayout::KGEVkPipelineLayout(const kge::vkstructs::Device* device,
 KGEVkPipelineLayout::~KGEVkPipelineLayout()
 {
     if (m_device->logicalDevice != nullptr && &m_pipelineLayout != nullptr && m_pipelineLayout != nullptr) {
-        vkDestroyPipelineLayout(m_device->logicalDevice, m_pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(m_device->logicalDevice, m_pipelineLayout, kge::vkutility::HostAllocator());
         m_pipelineLayout = nullptr;
 
         kge::tools::LogMessage("Vulkan: Pipeline layout successfully deinitialized");
@@ -23,6 +23,7 @@ KGEVkRenderPass::KGEVkRenderPass(const kge::vkstructs::Device *device,
         VkFormat depthStencilFormat):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkRenderPass::KGEVkRenderPass");
     // Проверка доступности формата вложений (изображений)
     kge::vkstructs::SurfaceInfo si = kge::vkutility::GetSurfaceInfo(device->physicalDevice, surface);
     if (!si.IsFormatSupported(colorAttachmentFormat)) {
@@ -130,7 +131,7 @@ KGEVkRenderPass::KGEVkRenderPass(const kge::vkstructs::Device *device,
     renderPassInfo.dependencyCount = static_cast<unsigned int>(dependencies.size());//Кол-во зависимсотей
     renderPassInfo.pDependencies = dependencies.data();                             //Зависимости
 
-    if (vkCreateRenderPass(device->logicalDevice, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) {
+    if (vkCreateRenderPass(device->logicalDevice, &renderPassInfo, kge::vkutility::HostAllocator(), &m_renderPass) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Failed to create render pass!");
     }
 
@@ -141,8 +142,18 @@ KGEVkRenderPass::~KGEVkRenderPass()
 {
     // Если создан проход рендера - уничтожить
     if (m_renderPass != nullptr) {
-        vkDestroyRenderPass(m_device->logicalDevice, m_renderPass, nullptr);
+        vkDestroyRenderPass(m_device->logicalDevice, m_renderPass, kge::vkutility::HostAllocator());
         m_renderPass = nullptr;
         kge::tools::LogMessage("Vulkan: Render pass successfully deinitialized");
     }
 }
+
+/**
+* Обмен хендлами с другим проходом рендеринга
+* @param KGEVkRenderPass &other - проход, получающий текущий хендл (и удаляющий его в своем деструкторе)
+*/
+void KGEVkRenderPass::Swap(KGEVkRenderPass &other)
+{
+    std::swap(m_renderPass, other.m_renderPass);
+    std::swap(m_device, other.m_device);
+}
@@ -30,7 +30,7 @@ KGEVkReportCallBack::KGEVkReportCallBack(VkInstance instance):
     create_info.pfnCallback = kge::vkutility::DebugVulkanCallback;
     create_info.pUserData = nullptr;
 
-    res = m_createDebugReportCallbackEXT(instance, &create_info, nullptr, &debug_report_callback);
+    res = m_createDebugReportCallbackEXT(instance, &create_info, kge::vkutility::HostAllocator(), &debug_report_callback);
     switch (res) {
     case VK_SUCCESS:
         std::cout << "Successfully created debug report callback object\n";
@@ -46,5 +46,5 @@ KGEVkReportCallBack::KGEVkReportCallBack(VkInstance instance):
 
 KGEVkReportCallBack::~KGEVkReportCallBack()
 {
-    m_destroyDebugReportCallbackEXT(m_instance, debug_report_callback, nullptr);
+    m_destroyDebugReportCallbackEXT(m_instance, debug_report_callback, kge::vkutility::HostAllocator());
 }
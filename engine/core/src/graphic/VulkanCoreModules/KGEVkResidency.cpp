@@ -0,0 +1,139 @@
+#include "graphic/VulkanCoreModules/KGEVkResidency.h"
+
+/**
+* Учет резидентности ресурсов в памяти устройства
+* @param const kge::vkstructs::Device* device - устройство
+* @param float budgetTarget - доля бюджета кучи, выше которой начинается вытеснение
+*
+* @note - каждый кадр опрашиваются бюджеты куч (VK_EXT_memory_budget либо оценка, см. kge::vkutility::GetHeapBudgets)
+* и отмечаются использованные кадром текстуры и геометрия. Когда потребление локальной кучи устройства подходит к бюджету,
+* рендерер вытесняет ресурсы, дольше всех не использовавшиеся (см. KGEVulkanCore::EnforceMemoryBudget)
+*/
+KGEVkResidency::KGEVkResidency(const kge::vkstructs::Device* device, float budgetTarget):
+    m_device{device},
+    m_budgetTarget{budgetTarget},
+    m_frame{0},
+    m_evictionFrame{0}
+{
+    kge::vkutility::GetHeapBudgets(*m_device, m_heaps);
+    kge::tools::LogMessage("Vulkan: Residency tracking successfully initialized");
+}
+
+KGEVkResidency::~KGEVkResidency()
+{
+    kge::tools::LogMessage("Vulkan: Residency tracking successfully deinitialized");
+}
+
+/**
+* Начало кадра: следующий номер кадра и опрос бюджетов куч
+*/
+void KGEVkResidency::BeginFrame()
+{
+    m_frame++;
+    kge::vkutility::GetHeapBudgets(*m_device, m_heaps);
+}
+
+/**
+* Отметка использования ресурса текущим кадром
+*/
+void KGEVkResidency::Touch(std::vector<Use> &uses, uint32_t handle, uint32_t slot)
+{
+    if (slot >= uses.size()) {
+        uses.resize(slot + 1);
+    }
+    uses[slot].handle = handle;
+    uses[slot].frame = m_frame;
+}
+
+/**
+* Кадр последнего использования ресурса
+* @note - ресурс, который еще не отмечался (новый, в том числе в ячейке удаленного), считается использованным сейчас -
+* только что загруженный ресурс не вытесняется до того, как его успеют нарисовать
+*/
+uint64_t KGEVkResidency::LastUse(std::vector<Use> &uses, uint32_t handle, uint32_t slot)
+{
+    if (slot >= uses.size() || uses[slot].handle != handle) {
+        Touch(uses, handle, slot);
+    }
+    return uses[slot].frame;
+}
+
+void KGEVkResidency::TouchTexture(kge::vkstructs::TextureHandle texture)
+{
+    Touch(m_textureUses, texture.value, texture.index());
+}
+
+void KGEVkResidency::TouchMesh(kge::vkstructs::MeshHandle mesh)
+{
+    Touch(m_meshUses, mesh.value, mesh.index());
+}
+
+/**
+* Можно ли вытеснить текстуру (не использовалась RESIDENCY_IDLE_FRAMES кадров)
+* @param kge::vkstructs::TextureHandle texture - хендл текстуры
+* @param uint64_t* lastUse - кадр последнего использования (порядок вытеснения)
+*/
+bool KGEVkResidency::TextureIdle(kge::vkstructs::TextureHandle texture, uint64_t* lastUse)
+{
+    *lastUse = LastUse(m_textureUses, texture.value, texture.index());
+    return m_frame - *lastUse >= RESIDENCY_IDLE_FRAMES;
+}
+
+/**
+* Можно ли вытеснить геометрию (не использовалась RESIDENCY_IDLE_FRAMES кадров)
+* @param kge::vkstructs::MeshHandle mesh - хендл геометрии
+* @param uint64_t* lastUse - кадр последнего использования (порядок вытеснения)
+*/
+bool KGEVkResidency::MeshIdle(kge::vkstructs::MeshHandle mesh, uint64_t* lastUse)
+{
+    *lastUse = LastUse(m_meshUses, mesh.value, mesh.index());
+    return m_frame - *lastUse >= RESIDENCY_IDLE_FRAMES;
+}
+
+/**
+* Сколько памяти нужно освободить в куче, чтобы потребление вернулось к доле бюджета
+* @param uint32_t heap - индекс кучи
+* @return VkDeviceSize - объем (0 - куча в пределах бюджета)
+*/
+VkDeviceSize KGEVkResidency::Overcommit(uint32_t heap) const
+{
+    if (heap >= m_heaps.size()) {
+        return 0;
+    }
+
+    VkDeviceSize target = static_cast<VkDeviceSize>(static_cast<double>(m_heaps[heap].budget) * m_budgetTarget);
+    return m_heaps[heap].usage > target ? m_heaps[heap].usage - target : 0;
+}
+
+/**
+* Нужен ли проход вытеснения (локальная куча устройства сверх доли бюджета и интервал с прошлого прохода истек)
+*/
+bool KGEVkResidency::EvictionDue() const
+{
+    if (m_frame - m_evictionFrame < RESIDENCY_EVICTION_INTERVAL) {
+        return false;
+    }
+
+    for (uint32_t heap = 0; heap < m_heaps.size(); heap++) {
+        if (m_heaps[heap].deviceLocal && Overcommit(heap) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* Проход вытеснения выполнен (следующий - не раньше чем через RESIDENCY_EVICTION_INTERVAL кадров)
+*/
+void KGEVkResidency::EvictionDone()
+{
+    m_evictionFrame = m_frame;
+}
+
+/**
+* Бюджеты куч текущего кадра
+*/
+const std::vector<kge::vkstructs::HeapBudget>& KGEVkResidency::heaps() const
+{
+    return m_heaps;
+}
@@ -13,6 +13,7 @@ VkSampler KGEVkSampler::sampler() const
 KGEVkSampler::KGEVkSampler(const kge::vkstructs::Device* device):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkSampler::KGEVkSampler");
     // Настройка семплера
     VkSamplerCreateInfo samplerInfo = {};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -28,9 +29,11 @@ KGEVkSampler::KGEVkSampler(const kge::vkstructs::Device* device):
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;                        // Использовать все мип-уровни текстуры
 
     // Создание семплера
-    if (vkCreateSampler(m_device->logicalDevice, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+    if (vkCreateSampler(m_device->logicalDevice, &samplerInfo, kge::vkutility::HostAllocator(), &m_sampler) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error while creating texture sampler");
     }
 
@@ -45,7 +48,7 @@ KGEVkSampler::KGEVkSampler(const kge::vkstructs::Device* device):
 KGEVkSampler::~KGEVkSampler()
 {
     if (m_sampler != nullptr && &m_sampler != nullptr) {
-        vkDestroySampler(m_device->logicalDevice, m_sampler, nullptr);
+        vkDestroySampler(m_device->logicalDevice, m_sampler, kge::vkutility::HostAllocator());
         m_sampler = nullptr;
     }
     kge::tools::LogMessage("Vulkan: Texture sampler successfully deinitialized");
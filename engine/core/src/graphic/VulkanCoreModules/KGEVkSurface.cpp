@@ -1,4 +1,5 @@
 #include "graphic/VulkanCoreModules/KGEVkSurface.h"
+#include <graphic/KGEVulkan.h>
 
 VkSurfaceKHR KGEVkSurface::surface() const
 {
@@ -15,12 +16,13 @@ KGEVkSurface::KGEVkSurface():
 KGEVkSurface::KGEVkSurface(IVulkanWindowControl *windowControl, VkInstance instance) :
     m_instance{instance}
 {
+    KGE_PROFILE_ZONE("KGEVkSurface::KGEVkSurface");
     m_surface = windowControl->CreateSurface(m_instance);
 }
 
 KGEVkSurface::~KGEVkSurface()
 {
     if(m_surface != nullptr & (&m_surface) != nullptr){
-        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        vkDestroySurfaceKHR(m_instance, m_surface, kge::vkutility::HostAllocator());
     }
 }
@@ -8,7 +8,8 @@
 * @param VkFormat depthStencilFormat - формат вложений глубины (должен поддерживаться устройством)
 * @param VkRenderPass renderPass - хендл прохода рендеринга, нужен для создания фрейм-буферов swap-chain
 * @param unsigned int bufferCount - кол-во буферов кадра (напр. для тройной буферизации - 3)
-* @param kge::vkstructs::Swapchain * oldSwapchain - передыдуший swap-chain (полезно в случае пересоздания свап-чейна, например, сменив размеро поверхности)
+* @param const kge::vkstructs::Swapchain * oldSwapchain - передыдуший swap-chain (полезно в случае пересоздания свап-чейна, например, сменив размеро поверхности).
+* Его ресурсы не удаляются - это делает деструктор владеющего им объекта (после замены, см. Swap)
 * @return kge::vkstructs::Swapchain структура описывающая swap-chain cодержащая необходимые хендлы
 * @note - в одно изображение может происходить запись (рендеринг) в то время как другое будет показываться (презентация)
 */
@@ -23,9 +24,10 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
                                VkFormat depthStencilFormat,
                                VkRenderPass renderPass,
                                unsigned int bufferCount,
-                               kge::vkstructs::Swapchain *oldSwapchain):
+                               const kge::vkstructs::Swapchain *oldSwapchain):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkSwapChain::KGEVkSwapChain");
     // Информация о поверхности
     kge::vkstructs::SurfaceInfo si = kge::vkutility::GetSurfaceInfo(device->physicalDevice, surface);
 
@@ -82,12 +84,6 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
     m_swapchain.imageFormat = swapchainCreateInfo.imageFormat;
     m_swapchain.imageExtent = swapchainCreateInfo.imageExtent;
 
-    // Если старый swap-chain был передан - очистить его информацию о формате и расширении
-    if (oldSwapchain != nullptr) {
-        oldSwapchain->imageExtent = {};
-        oldSwapchain->imageFormat = {};
-    }
-
     // Индексы семейств
     std::vector<unsigned int> queueFamilyIndices = {
         static_cast<unsigned int>(device->queueFamilies.graphics),
@@ -113,16 +109,10 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
     swapchainCreateInfo.oldSwapchain = (oldSwapchain != nullptr ? oldSwapchain->vkSwapchain : nullptr);  // Старый swap-chain (для более эффективного пересоздания можно указывать старый swap-chain)
 
     // Создание swap-chain (записать хендл в результирующий объект)
-    if (vkCreateSwapchainKHR(device->logicalDevice, &swapchainCreateInfo, nullptr, &(m_swapchain.vkSwapchain)) != VK_SUCCESS) {
+    if (vkCreateSwapchainKHR(device->logicalDevice, &swapchainCreateInfo, kge::vkutility::HostAllocator(), &(m_swapchain.vkSwapchain)) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan: Error in vkCreateSwapchainKHR function. Failed to create swapchain");
     }
 
-    // Уничтожение предыдущего swap-chain, если он был передан
-    if (oldSwapchain != nullptr) {
-        vkDestroySwapchainKHR(device->logicalDevice, oldSwapchain->vkSwapchain, nullptr);
-        oldSwapchain->vkSwapchain = nullptr;
-    }
-
     // Получить хендлы изображений swap-chain
     // Кол-во изображений по сути равно кол-ву буферов (за это отвечает bufferCount при создании swap-chain)
     unsigned int swapChainImageCount = 0;
@@ -131,15 +121,6 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
     vkGetSwapchainImagesKHR(device->logicalDevice, m_swapchain.vkSwapchain, &swapChainImageCount, m_swapchain.images.data());
 
     // Теперь необходимо создать image-views для каждого изображения (своеобразный интерфейс объектов изображений предостовляющий нужные возможности)
-    // Если был передан старый swap-chain - предварительно очистить все его image-views
-    if (oldSwapchain != nullptr) {
-        if (!oldSwapchain->imageViews.empty()) {
-            for (VkImageView const &swapchainImageView : oldSwapchain->imageViews) {
-                vkDestroyImageView(device->logicalDevice, swapchainImageView, nullptr);
-            }
-            oldSwapchain->imageViews.clear();
-        }
-    }
 
     // Для каждого изображения (image) swap-chain'а создать свой imageView объект
     for (unsigned int i = 0; i < m_swapchain.images.size(); i++) {
@@ -164,7 +145,7 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
         createInfo.subresourceRange.layerCount = 1;
 
         // Создать и добавить в массив
-        if (vkCreateImageView(device->logicalDevice, &createInfo, nullptr, &swapChainImageCount) == VK_SUCCESS) {
+        if (vkCreateImageView(device->logicalDevice, &createInfo, kge::vkutility::HostAllocator(), &swapChainImageCount) == VK_SUCCESS) {
             m_swapchain.imageViews.push_back(swapChainImageCount);
         }
         else {
@@ -177,11 +158,6 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
     // Буфер может быть один для всех фрейм-буферов, даже при двойной/тройной буферизации (в отличии от изображений swap-chain)
     // поскольку он не учавствует в презентации (память из него непосредственно не отображается на экране).
 
-    // Если это пересоздание swap-chain (передан старый) следует очистить компоненты прежнего буфера глубины
-    if (oldSwapchain != nullptr) {
-        oldSwapchain->depthStencil.Deinit(device->logicalDevice);
-    }
-
     // Создать буфер глубины-трафарета (обычное 2D-изображение с требуемым форматом)
     m_swapchain.depthStencil = kge::vkutility::CreateImageSingle(
                 *device,
@@ -197,15 +173,6 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
 
 
     // Теперь необходимо создать фрейм-буферы привязанные к image-views объектам изображений и буфера глубины (изображения глубины)
-    // Перед этим стоит очистить буферы старого swap-сhain (если он был передан)
-    if (oldSwapchain != nullptr) {
-        if (!oldSwapchain->framebuffers.empty()) {
-            for (VkFramebuffer const &frameBuffer : oldSwapchain->framebuffers) {
-                vkDestroyFramebuffer(device->logicalDevice, frameBuffer, nullptr);
-            }
-            oldSwapchain->framebuffers.clear();
-        }
-    }
 
     // Пройтись по всем image views и создать фрейм-буфер для каждого
     for (unsigned int i = 0; i < m_swapchain.imageViews.size(); i++) {
@@ -228,7 +195,7 @@ KGEVkSwapChain::KGEVkSwapChain(const kge::vkstructs::Device* device,
         framebufferInfo.layers = 1;                                                     // Один слой
 
         // В случае успешного создания - добавить в массив
-        if (vkCreateFramebuffer(device->logicalDevice, &framebufferInfo, nullptr, &framebuffer) == VK_SUCCESS) {
+        if (vkCreateFramebuffer(device->logicalDevice, &framebufferInfo, kge::vkutility::HostAllocator(), &framebuffer) == VK_SUCCESS) {
             m_swapchain.framebuffers.push_back(framebuffer);
         }
         else {
@@ -244,7 +211,7 @@ KGEVkSwapChain::~KGEVkSwapChain()
     // Очистить фрейм-буферы
     if (!m_swapchain.framebuffers.empty()) {
         for (VkFramebuffer const &frameBuffer : m_swapchain.framebuffers) {
-            vkDestroyFramebuffer(m_device->logicalDevice, frameBuffer, nullptr);
+            vkDestroyFramebuffer(m_device->logicalDevice, frameBuffer, kge::vkutility::HostAllocator());
         }
         m_swapchain.framebuffers.clear();
     }
@@ -252,7 +219,7 @@ KGEVkSwapChain::~KGEVkSwapChain()
     // Очистить image-views объекты
     if (!m_swapchain.imageViews.empty()) {
         for (VkImageView const &imageView : m_swapchain.imageViews) {
-            vkDestroyImageView(m_device->logicalDevice, imageView, nullptr);
+            vkDestroyImageView(m_device->logicalDevice, imageView, kge::vkutility::HostAllocator());
         }
         m_swapchain.imageViews.clear();
     }
@@ -262,7 +229,7 @@ KGEVkSwapChain::~KGEVkSwapChain()
 
     // Очистить swap-chain
     if (m_swapchain.vkSwapchain != nullptr) {
-        vkDestroySwapchainKHR(m_device->logicalDevice, m_swapchain.vkSwapchain, nullptr);
+        vkDestroySwapchainKHR(m_device->logicalDevice, m_swapchain.vkSwapchain, kge::vkutility::HostAllocator());
         m_swapchain.vkSwapchain = nullptr;
     }
 
@@ -272,3 +239,13 @@ KGEVkSwapChain::~KGEVkSwapChain()
 
     kge::tools::LogMessage("Vulkan: Swap-chain successfully deinitialized");
 }
+
+/**
+* Обмен хендлами с другим swap-chain (замена на месте при пересоздании)
+* @param KGEVkSwapChain &other - swap-chain, получающий текущие хендлы (и удаляющий их в своем деструкторе)
+*/
+void KGEVkSwapChain::Swap(KGEVkSwapChain &other)
+{
+    std::swap(m_swapchain, other.m_swapchain);
+    std::swap(m_device, other.m_device);
+}
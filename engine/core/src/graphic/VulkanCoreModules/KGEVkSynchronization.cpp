@@ -3,24 +3,45 @@
 /**
 * Инициализация примитивов синхронизации
 * @param const vktoolkit::Device &device - устройство
-* @return vktoolkit::Synchronization - структура с набором хендлов семафоров
-* @note - семафоры синхронизации позволяют отслеживать состояние рендеринга и в нужный момент показывать изображение
+* @param unsigned int framesInFlight - кол-во кадров "в полете" (сколько кадров хост может подготовить наперед, не дожидаясь устройства)
+* @param unsigned int imageCount - кол-во изображений swap-chain
+* @return vktoolkit::Synchronization - структура с набором хендлов семафоров и заборов
+* @note - семафоры синхронизации позволяют отслеживать состояние рендеринга и в нужный момент показывать изображение,
+* заборы позволяют хосту дождаться завершения кадра перед повторным использованием его ресурсов (напр. области uniform-буфера)
 */
 KGEVkSynchronization::KGEVkSynchronization(kge::vkstructs::Synchronization* sync,
-                                           const kge::vkstructs::Device* device):
+                                           const kge::vkstructs::Device* device,
+                                           unsigned int framesInFlight,
+                                           unsigned int imageCount):
     m_sync{sync},
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkSynchronization::KGEVkSynchronization");
     // Информация о создаваемом семафоре (ничего не нужно указывать)
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     semaphoreInfo.pNext = nullptr;
     semaphoreInfo.flags = 0;
 
+    // Информация о создаваемом заборе (создается в сигнальном состоянии, чтобы ожидание первого кадра не блокировало)
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.pNext = nullptr;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    m_sync->readyToRender.resize(framesInFlight, nullptr);
+    m_sync->readyToPresent.resize(framesInFlight, nullptr);
+    m_sync->frameFences.resize(framesInFlight, nullptr);
+    m_sync->imageFences.assign(imageCount, nullptr);
+    m_sync->currentFrame = 0;
+
     // Создать примитивы синхронизации
-    if (vkCreateSemaphore(m_device->logicalDevice, &semaphoreInfo, nullptr, &m_sync->readyToRender) != VK_SUCCESS ||
-            vkCreateSemaphore(m_device->logicalDevice, &semaphoreInfo, nullptr, &m_sync->readyToPresent) != VK_SUCCESS) {
-        throw std::runtime_error("Vulkan: Error while creating synchronization primitives");
+    for (unsigned int i = 0; i < framesInFlight; i++) {
+        if (vkCreateSemaphore(m_device->logicalDevice, &semaphoreInfo, kge::vkutility::HostAllocator(), &m_sync->readyToRender[i]) != VK_SUCCESS ||
+                vkCreateSemaphore(m_device->logicalDevice, &semaphoreInfo, kge::vkutility::HostAllocator(), &m_sync->readyToPresent[i]) != VK_SUCCESS ||
+                vkCreateFence(m_device->logicalDevice, &fenceInfo, kge::vkutility::HostAllocator(), &m_sync->frameFences[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Vulkan: Error while creating synchronization primitives");
+        }
     }
 
     kge::tools::LogMessage("Vulkan: Synchronization primitives sucessfully initialized");
@@ -29,21 +50,35 @@ KGEVkSynchronization::KGEVkSynchronization(kge::vkstructs::Synchronization* sync
 /**
 * Деинициализация примитивов синхронизации
 * @param const vktoolkit::Device &device - устройство
-* @param vktoolkit::Synchronization * sync - указатель на структуру с хендлами семафоров
+* @param vktoolkit::Synchronization * sync - указатель на структуру с хендлами семафоров и заборов
 */
 KGEVkSynchronization::~KGEVkSynchronization()
 {
     if (m_sync != nullptr) {
-        if (m_sync->readyToRender != nullptr) {
-            vkDestroySemaphore(m_device->logicalDevice, m_sync->readyToRender, nullptr);
-            m_sync->readyToRender = nullptr;
+        for (VkSemaphore &semaphore : m_sync->readyToRender) {
+            if (semaphore != nullptr) {
+                vkDestroySemaphore(m_device->logicalDevice, semaphore, kge::vkutility::HostAllocator());
+                semaphore = nullptr;
+            }
         }
 
-        if (m_sync->readyToRender != nullptr) {
-            vkDestroySemaphore(m_device->logicalDevice, m_sync->readyToRender, nullptr);
-            m_sync->readyToRender = nullptr;
+        for (VkSemaphore &semaphore : m_sync->readyToPresent) {
+            if (semaphore != nullptr) {
+                vkDestroySemaphore(m_device->logicalDevice, semaphore, kge::vkutility::HostAllocator());
+                semaphore = nullptr;
+            }
         }
 
+        for (VkFence &fence : m_sync->frameFences) {
+            if (fence != nullptr) {
+                vkDestroyFence(m_device->logicalDevice, fence, kge::vkutility::HostAllocator());
+                fence = nullptr;
+            }
+        }
+
+        // Заборы изображений - лишь ссылки на заборы кадров
+        m_sync->imageFences.clear();
+
         kge::tools::LogMessage("Vulkan: Synchronization primitives sucessfully deinitialized");
     }
 }
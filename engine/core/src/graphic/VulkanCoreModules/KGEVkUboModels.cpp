@@ -1,4 +1,6 @@
 #include "graphic/VulkanCoreModules/KGEVkUboModels.h"
+#include <algorithm>
+#include <cstring>
 
 /**
 * Аллокация памяти под объект динамического UBO буфера
@@ -10,8 +12,10 @@ KGEVkUboModels::KGEVkUboModels(kge::vkstructs::UboModelArray* uboModels,
                                const kge::vkstructs::Device* device,
                                unsigned int maxObjects):
     m_uboModels{uboModels},
-    m_device{device}
+    m_device{device},
+    m_maxObjects{maxObjects}
 {
+    KGE_PROFILE_ZONE("KGEVkUboModels::KGEVkUboModels");
     // Получить оптимальное выравнивание для типа glm::mat4
     std::size_t dynamicAlignment = static_cast<size_t>(m_device->GetDynamicAlignment<glm::mat4>());
 
@@ -19,18 +23,45 @@ KGEVkUboModels::KGEVkUboModels(kge::vkstructs::UboModelArray* uboModels,
     std::size_t bufferSize = static_cast<size_t>(dynamicAlignment * maxObjects);
 
     // Аллоцировать память с учетом выравнивания
-    *m_uboModels = static_cast<kge::vkstructs::UboModelArray>(aligned_alloc(bufferSize, dynamicAlignment));
+    *m_uboModels = static_cast<kge::vkstructs::UboModelArray>(KGEMemoryTracker::Allocate(kge::memory::TagRenderer, bufferSize, dynamicAlignment));
 
     kge::tools::LogMessage("Vulkan: Dynamic UBO satage-buffer successfully allocated");
 }
 
+/**
+* Изменение вместимости массива
+* @param unsigned int maxObjects - новое максимальное кол-во объектов
+* @note - массив находится только в памяти хоста (устройство читает копию в uniform-буфере), поэтому его можно
+* переаллоцировать в любой момент. Матрицы, умещающиеся в новую вместимость, сохраняются
+*/
+void KGEVkUboModels::Resize(unsigned int maxObjects)
+{
+    std::size_t dynamicAlignment = static_cast<size_t>(m_device->GetDynamicAlignment<glm::mat4>());
+
+    kge::vkstructs::UboModelArray resized = static_cast<kge::vkstructs::UboModelArray>(KGEMemoryTracker::Allocate(kge::memory::TagRenderer, dynamicAlignment * maxObjects, dynamicAlignment));
+    if (resized == nullptr) {
+        throw std::runtime_error("Vulkan: Error. Can't reallocate dynamic UBO stage-buffer");
+    }
+
+    memcpy(resized, *m_uboModels, dynamicAlignment * std::min(m_maxObjects, maxObjects));
+    KGEMemoryTracker::Free(*m_uboModels);
+
+    *m_uboModels = resized;
+    m_maxObjects = maxObjects;
+}
+
+unsigned int KGEVkUboModels::maxObjects() const
+{
+    return m_maxObjects;
+}
+
 /**
 * Освобождение памяти объекта динамического UBO буфера
 * @param vktoolkit::UboModelArray * uboModels - указатель на массив матриц, память которого будет очищена
 */
 KGEVkUboModels::~KGEVkUboModels()
 {
-    free(*m_uboModels);
+    KGEMemoryTracker::Free(*m_uboModels);
     *m_uboModels = nullptr;
     kge::tools::LogMessage("Vulkan: Dynamic UBO satage-buffer successfully freed");
 }
@@ -4,12 +4,17 @@
 * Создание буфера для моделей (динамический uniform-bufer)
 * @param const kge::vkstructs::Device &device - устройство
 * @param unsigned int maxObjects - максимальное кол-во отдельных объектов на сцене
+* @param unsigned int regionCount - кол-во областей буфера (по одной на каждое изображение swap-chain)
 * @return kge::vkstructs::UniformBuffer - буфер, структура с хендлами буфера, его памяти, а так же доп. свойствами
 *
 * @note - в отличии от мирового uniform-буфера, uniform-буфер моделей содержит отдельные матрицы для каждой модели (по сути массив)
 * и выделение памяти под передаваемый в такой буфер объект должно использовать выравнивание. У устройства есть определенные лимиты
 * на выравнивание памяти, поэтому размер такого буфера вычисляется с учетом допустимого шага выравивания и кол-ва объектов которые
 * могут быть на сцене.
+*
+* Буфер разбит на области (кольцо) по кол-ву изображений swap-chain. Каждая область вмещает матрицы всех объектов,
+* кадр пишет только в свою область, поэтому хост не перезаписывает данные, которые еще может читать устройство.
+* Память хост-когерентна и размечена целиком на все время жизни буфера.
 */
 //kge::vkstructs::UniformBuffer& KGEVkUniformBufferModels::uniformBufferModels()
 //{
@@ -17,28 +22,33 @@
 //}
 
 KGEVkUniformBufferModels::KGEVkUniformBufferModels(const kge::vkstructs::Device* device,
-                                                   unsigned int maxObjects):
+                                                   unsigned int maxObjects,
+                                                   unsigned int regionCount):
     m_device{device}
 {
-    // Вычислить размер буфера учитывая доступное вырванивание памяти (для типа glm::mat4 размером в 64 байта)
-    VkDeviceSize bufferSize = m_device->GetDynamicAlignment<glm::mat4>() * maxObjects;
+    KGE_PROFILE_ZONE("KGEVkUniformBufferModels::KGEVkUniformBufferModels");
+    // Вычислить размер области учитывая доступное вырванивание памяти (для типа glm::mat4 размером в 64 байта)
+    // Размер кратен выравниванию, поэтому начало каждой области - допустимое динамическое смещение
+    VkDeviceSize regionSize = m_device->GetDynamicAlignment<glm::mat4>() * maxObjects;
 
     kge::vkstructs::Buffer buffer = kge::vkutility::CreateBuffer(
                 *m_device,
-                bufferSize,
+                regionSize * regionCount,
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     // Настройка результирубщего буфера (uniform-буфер)
     m_uniformBufferModels.vkBuffer = buffer.vkBuffer;
     m_uniformBufferModels.vkDeviceMemory = buffer.vkDeviceMemory;
     m_uniformBufferModels.size = buffer.size;
+    m_uniformBufferModels.regionSize = regionSize;
+    m_uniformBufferModels.regionCount = regionCount;
 
-    // Настройка информации для дескриптора
-    m_uniformBufferModels.configDescriptorInfo(64);
+    // Настройка информации для дескриптора (одна матрица, конкретный элемент выбирается динамическим смещением)
+    m_uniformBufferModels.configDescriptorInfo(sizeof(glm::mat4));
 
-    // Разметить буфер (сделать его доступным для копирования информации)
-    m_uniformBufferModels.map(m_device->logicalDevice, 64, 0);
+    // Разметить буфер целиком (сделать его доступным для копирования информации)
+    m_uniformBufferModels.map(m_device->logicalDevice, VK_WHOLE_SIZE, 0);
 
     kge::tools::LogMessage("Vulkan: Uniform buffer for models successfully allocated");
 }
@@ -55,12 +65,12 @@ KGEVkUniformBufferModels::~KGEVkUniformBufferModels()
         m_uniformBufferModels.unmap(m_device->logicalDevice);
 
         if (m_uniformBufferModels.vkBuffer != nullptr) {
-            vkDestroyBuffer(m_device->logicalDevice, m_uniformBufferModels.vkBuffer, nullptr);
+            vkDestroyBuffer(m_device->logicalDevice, m_uniformBufferModels.vkBuffer, kge::vkutility::HostAllocator());
             m_uniformBufferModels.vkBuffer = nullptr;
         }
 
         if (m_uniformBufferModels.vkDeviceMemory != nullptr) {
-            vkFreeMemory(m_device->logicalDevice, m_uniformBufferModels.vkDeviceMemory, nullptr);
+            kge::vkutility::FreeMemory(m_device->logicalDevice, m_uniformBufferModels.vkDeviceMemory);
             m_uniformBufferModels.vkDeviceMemory = nullptr;
         }
 
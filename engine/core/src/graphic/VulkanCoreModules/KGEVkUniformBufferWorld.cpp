@@ -3,25 +3,35 @@
 /**
 * Создание мирового (глобального) unform-buffer'а
 * @param const kge::vkstructs::Device &device - устройство
+* @param unsigned int regionCount - кол-во областей буфера (по одной на каждое изображение swap-chain)
 * @return kge::vkstructs::UniformBuffer - буфер, структура с хендлами буфера, его памяти, а так же доп. свойствами
 *
 * @note - unform-буфер это буфер доступный для шейдера посредством дескриптороа. В нем содержится информация о матрицах используемых
 * для преобразования координат вершин сцены. В буфер помещается UBO объект содержащий необходимые матрицы. При каждом обновлении сцены
 * можно отправлять объект с новыми данными (например, если сменилось положение камеры, либо угол ее поворота). Таким образом шейдер будет
 * использовать для преобразования координат вершины новые данные.
+*
+* Буфер разбит на области (кольцо), каждый кадр пишет в свою область и привязывает ее динамическим смещением,
+* поэтому дескриптор буфера - динамический (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC). Память остается размеченной
+* на все время жизни буфера.
 */
 kge::vkstructs::UniformBuffer* KGEVkUniformBufferWorld::uniformBufferWorld()
 {
     return &m_uniformBufferWorld;
 }
 
-KGEVkUniformBufferWorld::KGEVkUniformBufferWorld(const kge::vkstructs::Device* device):
+KGEVkUniformBufferWorld::KGEVkUniformBufferWorld(const kge::vkstructs::Device* device,
+                                                 unsigned int regionCount):
     m_device{device}
 {
+    KGE_PROFILE_ZONE("KGEVkUniformBufferWorld::KGEVkUniformBufferWorld");
+    // Размер области с учетом выравнивания динамических смещений
+    VkDeviceSize regionSize = m_device->GetDynamicAlignment<kge::vkstructs::UboWorld>();
+
     // Создать буфер, выделить память, привязать память к буферу
     kge::vkstructs::Buffer buffer = kge::vkutility::CreateBuffer(
                 *m_device,
-                sizeof(kge::vkstructs::UboWorld),
+                regionSize * regionCount,
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -29,9 +39,11 @@ KGEVkUniformBufferWorld::KGEVkUniformBufferWorld(const kge::vkstructs::Device* d
     m_uniformBufferWorld.vkBuffer = buffer.vkBuffer;
     m_uniformBufferWorld.vkDeviceMemory = buffer.vkDeviceMemory;
     m_uniformBufferWorld.size = buffer.size;
+    m_uniformBufferWorld.regionSize = regionSize;
+    m_uniformBufferWorld.regionCount = regionCount;
 
-    // Настройка информации для дескриптора
-    m_uniformBufferWorld.configDescriptorInfo(buffer.size, 0);
+    // Настройка информации для дескриптора (дескриптор "видит" одну область, сама область выбирается динамическим смещением)
+    m_uniformBufferWorld.configDescriptorInfo(sizeof(kge::vkstructs::UboWorld), 0);
 
     // Разметить буфер (сделать его доступным для копирования информации)
     m_uniformBufferWorld.map(m_device->logicalDevice, buffer.size, 0);
@@ -51,12 +63,12 @@ KGEVkUniformBufferWorld::~KGEVkUniformBufferWorld()
         m_uniformBufferWorld.unmap(m_device->logicalDevice);
 
         if (m_uniformBufferWorld.vkBuffer != nullptr) {
-            vkDestroyBuffer(m_device->logicalDevice, m_uniformBufferWorld.vkBuffer, nullptr);
+            vkDestroyBuffer(m_device->logicalDevice, m_uniformBufferWorld.vkBuffer, kge::vkutility::HostAllocator());
             m_uniformBufferWorld.vkBuffer = nullptr;
         }
 
         if (m_uniformBufferWorld.vkDeviceMemory != nullptr) {
-            vkFreeMemory(m_device->logicalDevice, m_uniformBufferWorld.vkDeviceMemory, nullptr);
+            kge::vkutility::FreeMemory(m_device->logicalDevice, m_uniformBufferWorld.vkDeviceMemory);
             m_uniformBufferWorld.vkDeviceMemory = nullptr;
         }
 
@@ -1,3 +1,4 @@
+#include "graphic/KGEVulkan.h"
 #include "graphic/VulkanWindowControl/GLFWWindowControl.h"
 
 GLFWWindowControl::GLFWWindowControl(const char *appName) : m_appName{appName}
@@ -35,7 +36,7 @@ VkSurfaceKHR GLFWWindowControl::CreateSurface(VkInstance &vkInstance)
 {
     VkSurfaceKHR surface;
 
-    if(glfwCreateWindowSurface(vkInstance, m_window, nullptr, &surface) != VK_SUCCESS){
+    if(glfwCreateWindowSurface(vkInstance, m_window, kge::vkutility::HostAllocator(), &surface) != VK_SUCCESS){
         throw std::runtime_error("Vulkan: Failed to create glfw window surface");
     }
 
@@ -79,7 +79,7 @@ VkSurfaceKHR LinuxXCBWindowControl::CreateSurface(VkInstance &vkInstance)
 
     VkSurfaceKHR surface;
 
-    if(vkCreateXcbSurfaceKHR(vkInstance, &surfaceCreateInfo, nullptr, &surface) != VK_SUCCESS){
+    if(vkCreateXcbSurfaceKHR(vkInstance, &surfaceCreateInfo, kge::vkutility::HostAllocator(), &surface) != VK_SUCCESS){
         throw std::runtime_error("Vulkan: Error creating XCB Linux window!");
     }
 
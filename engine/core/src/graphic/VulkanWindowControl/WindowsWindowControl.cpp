@@ -73,7 +73,7 @@ VkSurfaceKHR WindowsWindowControl::CreateSurface(VkInstance &vkInstance)
 
      VkSurfaceKHR surface;
 
-    if(vkCreateWin32SurfaceKHR(vkInstance, &win32SurfaceCreateInfoKhr, nullptr, &surface) != VK_SUCCESS){
+    if(vkCreateWin32SurfaceKHR(vkInstance, &win32SurfaceCreateInfoKhr, kge::vkutility::HostAllocator(), &surface) != VK_SUCCESS){
         throw std::runtime_error("Vulkan: Error in vkCreateWin32SurfaceKHR function!");
     }
 
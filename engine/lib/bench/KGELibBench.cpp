@@ -0,0 +1,465 @@
+#include <jobs/KGEJobSystem.h>
+#include <math/KGEFrustumCuller.h>
+#include <mesh/KGEMeshOptimizer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/**
+* Замеры KGELib, на которые ссылается история изменений: отсечение сфер по пирамиде видимости (SSE и скалярный путь),
+* параллельный расчет матриц моделей системой задач, запись команд отрисовки при передаче матриц моделей динамическим
+* UBO либо push-константами и выбор уровней детализации. Данные случайные с фиксированным зерном - повторный запуск
+* на той же машине дает сопоставимые цифры
+*
+* Использование: kgelibbench [кол-во объектов (по умолчанию 100000)] [кол-во повторов (по умолчанию 200)]
+*/
+
+/**
+* Среднее время одного вызова в миллисекундах
+*/
+template <typename Function>
+static double MeasureMs(unsigned int repeats, Function function)
+{
+    // Прогрев (кэши, страницы памяти, рабочие потоки)
+    function();
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < repeats; i++) {
+        function();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeats;
+}
+
+/**
+* Матрица "проекция * вид" (по столбцам): перспектива 60 градусов, 16:9, грани 0.1 и 1000, камера в начале координат смотрит вдоль -Z
+*/
+static std::vector<float> MakeViewProjection()
+{
+    const float fov = 60.0f * 3.14159265f / 180.0f;
+    const float aspect = 16.0f / 9.0f;
+    const float zNear = 0.1f;
+    const float zFar = 1000.0f;
+    const float f = 1.0f / std::tan(fov / 2.0f);
+
+    std::vector<float> m(16, 0.0f);
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zFar + zNear) / (zNear - zFar);
+    m[11] = -1.0f;
+    m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+    return m;
+}
+
+/**
+* Скалярное отсечение (та же проверка, что и в KGEFrustumCuller::Cull, по одной сфере)
+*/
+static void CullScalar(const kge::math::Frustum &frustum,
+                       const std::vector<float> &x,
+                       const std::vector<float> &y,
+                       const std::vector<float> &z,
+                       const std::vector<float> &radius,
+                       std::vector<uint32_t> &visible)
+{
+    visible.clear();
+    for (std::size_t i = 0; i < radius.size(); i++) {
+        bool inside = true;
+        for (int p = 0; p < 6; p++) {
+            const kge::math::Plane &plane = frustum.planes[p];
+            if (plane.a * x[i] + plane.b * y[i] + plane.c * z[i] + plane.d + radius[i] < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        if (inside) {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+/**
+* Матрица модели (по столбцам): масштаб, поворот вокруг Y, перенос
+*/
+static void MakeModelMatrix(float* m, float px, float py, float pz, float angle, float scale)
+{
+    float c = std::cos(angle) * scale;
+    float s = std::sin(angle) * scale;
+
+    m[0] = c;     m[1] = 0.0f;  m[2] = -s;     m[3] = 0.0f;
+    m[4] = 0.0f;  m[5] = scale; m[6] = 0.0f;   m[7] = 0.0f;
+    m[8] = s;     m[9] = 0.0f;  m[10] = c;     m[11] = 0.0f;
+    m[12] = px;   m[13] = py;   m[14] = pz;    m[15] = 1.0f;
+}
+
+// Выравнивание элемента динамического UBO (типичный minUniformBufferOffsetAlignment дискретных GPU)
+static const std::size_t DYNAMIC_ALIGNMENT = 256;
+
+// Через сколько команд отрисовки сменяется геометрия (список отрисовки отсортирован по текстуре и геометрии)
+static const std::size_t DRAWS_PER_MESH = 64;
+
+/**
+* Модель командного буфера - пакеты команд в потоке слов в памяти хоста (так команды кодирует драйвер).
+* Замеряется только запись на стороне процессора, работа устройства не учитывается
+*/
+static void EmitHeader(std::vector<uint32_t> &stream, uint32_t opcode, uint32_t words)
+{
+    stream.push_back((opcode << 16) | words);
+}
+
+// vkCmdBindDescriptorSets: динамические смещения разрешаются в адреса буферов при записи
+static void RecordBindDescriptorSet(std::vector<uint32_t> &stream,
+                                    uint64_t set,
+                                    const uint64_t* bufferAddresses,
+                                    const uint32_t* dynamicOffsets,
+                                    uint32_t dynamicCount)
+{
+    EmitHeader(stream, 1, 3 + dynamicCount * 3);
+    stream.push_back(static_cast<uint32_t>(set));
+    stream.push_back(static_cast<uint32_t>(set >> 32));
+    stream.push_back(dynamicCount);
+    for (uint32_t i = 0; i < dynamicCount; i++) {
+        uint64_t address = bufferAddresses[i] + dynamicOffsets[i];
+        stream.push_back(static_cast<uint32_t>(address));
+        stream.push_back(static_cast<uint32_t>(address >> 32));
+        stream.push_back(static_cast<uint32_t>(DYNAMIC_ALIGNMENT));
+    }
+}
+
+// vkCmdPushConstants: значения копируются в сам командный буфер
+static void RecordPushConstants(std::vector<uint32_t> &stream, uint32_t offset, uint32_t size, const void* values)
+{
+    EmitHeader(stream, 2, 2 + size / 4);
+    stream.push_back(offset);
+    stream.push_back(size);
+    std::size_t position = stream.size();
+    stream.resize(position + size / 4);
+    std::memcpy(&stream[position], values, size);
+}
+
+// vkCmdBindVertexBuffers + vkCmdBindIndexBuffer
+static void RecordBindGeometry(std::vector<uint32_t> &stream, uint64_t vertexBuffer, uint64_t indexBuffer)
+{
+    EmitHeader(stream, 3, 4);
+    stream.push_back(static_cast<uint32_t>(vertexBuffer));
+    stream.push_back(static_cast<uint32_t>(vertexBuffer >> 32));
+    stream.push_back(static_cast<uint32_t>(indexBuffer));
+    stream.push_back(static_cast<uint32_t>(indexBuffer >> 32));
+}
+
+// vkCmdDrawIndexed
+static void RecordDrawIndexed(std::vector<uint32_t> &stream, uint32_t indexCount)
+{
+    EmitHeader(stream, 4, 5);
+    stream.push_back(indexCount);
+    stream.push_back(1);
+    stream.push_back(0);
+    stream.push_back(0);
+    stream.push_back(0);
+}
+
+/**
+* Запись команд отрисовки как в KGEVulkanCore::RecordDrawCommands
+* @param bool pushConstants - матрица модели push-константой (иначе - привязка основного набора со своим смещением на каждую отрисовку)
+*/
+static void RecordDraws(std::vector<uint32_t> &stream, const std::vector<unsigned char> &models, std::size_t count, bool pushConstants)
+{
+    const uint64_t mainSet = 0x1000;
+    const uint64_t bufferAddresses[2] = { 0x100000, 0x200000 };
+    const float dequantization[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    stream.clear();
+    if (pushConstants) {
+        const uint32_t dynamicOffsets[2] = { 0, 0 };
+        RecordBindDescriptorSet(stream, mainSet, bufferAddresses, dynamicOffsets, 2);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        if (pushConstants) {
+            RecordPushConstants(stream, 0, 64, &models[i * DYNAMIC_ALIGNMENT]);
+        }
+        else {
+            const uint32_t dynamicOffsets[2] = { 0, static_cast<uint32_t>(i * DYNAMIC_ALIGNMENT) };
+            RecordBindDescriptorSet(stream, mainSet, bufferAddresses, dynamicOffsets, 2);
+        }
+
+        if (i % DRAWS_PER_MESH == 0) {
+            RecordBindGeometry(stream, 0x300000 + i, 0x400000 + i);
+            RecordPushConstants(stream, 64, 16, dequantization);
+        }
+        RecordDrawIndexed(stream, 36);
+    }
+}
+
+/**
+* Уровень детализации тестовой сетки
+*/
+struct LodLevel
+{
+    std::vector<uint32_t> indices;
+    float geometricError = 0.0f;
+    uint32_t vertexTransforms = 0;      // Вызовы вершинного шейдера (модель FIFO кэша)
+};
+
+/**
+* Замкнутая сфера радиуса 1 с рельефом (шов и полюса без дублирования вершин - у сетки нет границ)
+*/
+static void MakeBumpySphere(uint32_t rings, uint32_t segments, std::vector<float> &positions, std::vector<uint32_t> &indices)
+{
+    const float pi = 3.14159265f;
+    positions.clear();
+    indices.clear();
+
+    auto addVertex = [&](float theta, float phi) {
+        float radius = 1.0f + 0.02f * std::sin(theta * 48.0f) * std::sin(phi * 40.0f);
+        positions.push_back(radius * std::sin(theta) * std::cos(phi));
+        positions.push_back(radius * std::cos(theta));
+        positions.push_back(radius * std::sin(theta) * std::sin(phi));
+    };
+
+    // Полюс, кольца 1..rings-1, полюс
+    addVertex(0.0f, 0.0f);
+    for (uint32_t ring = 1; ring < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            addVertex(pi * ring / rings, 2.0f * pi * segment / segments);
+        }
+    }
+    addVertex(pi, 0.0f);
+
+    const uint32_t south = static_cast<uint32_t>(positions.size() / 3 - 1);
+    auto ringVertex = [segments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+
+    for (uint32_t segment = 0; segment < segments; segment++) {
+        indices.insert(indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+        indices.insert(indices.end(), { south, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1) });
+    }
+    for (uint32_t ring = 1; ring + 1 < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            uint32_t a = ringVertex(ring, segment);
+            uint32_t b = ringVertex(ring, segment + 1);
+            uint32_t c = ringVertex(ring + 1, segment);
+            uint32_t d = ringVertex(ring + 1, segment + 1);
+            indices.insert(indices.end(), { a, b, c, b, d, c });
+        }
+    }
+}
+
+/**
+* Уровни детализации с параметрами импортера моделей (каждый следующий - вдвое меньше треугольников,
+* отклонение не больше 5% радиуса, уровень с выигрышем меньше 10% не сохраняется)
+*/
+static std::vector<LodLevel> BuildLods(const std::vector<float> &positions, const std::vector<uint32_t> &indices, uint32_t levelCount)
+{
+    const uint32_t vertexCount = static_cast<uint32_t>(positions.size() / 3);
+    const float maxError = 1.0f * 0.05f;
+
+    std::vector<LodLevel> levels(1);
+    levels[0].indices = indices;
+    kge::mesh::OptimizeVertexCache(levels[0].indices, vertexCount);
+
+    std::size_t previousCount = indices.size();
+    for (uint32_t level = 1; level < levelCount; level++) {
+        std::size_t targetCount = static_cast<std::size_t>(previousCount * 0.5f) / 3 * 3;
+
+        LodLevel lod;
+        lod.geometricError = kge::mesh::Simplify(indices, positions.data(), sizeof(float) * 3, vertexCount, targetCount, maxError, lod.indices);
+        if (lod.indices.empty() || lod.indices.size() > previousCount * 0.9f) {
+            break;
+        }
+
+        kge::mesh::OptimizeVertexCache(lod.indices, vertexCount);
+        previousCount = lod.indices.size();
+        levels.push_back(std::move(lod));
+    }
+
+    for (LodLevel &level : levels) {
+        level.vertexTransforms = kge::mesh::AnalyzeVertexCache(level.indices, vertexCount).vertexTransforms;
+    }
+    return levels;
+}
+
+/**
+* Выбор уровня как в KGEVulkanCore::SelectLods (с гистерезисом, от текущего уровня)
+*/
+static uint32_t SelectLod(const std::vector<LodLevel> &levels, uint32_t level, float projection, float pixelError)
+{
+    const float coarsenError = pixelError * (1.0f - 0.25f);
+    while (level + 1 < levels.size() && levels[level + 1].geometricError * projection <= coarsenError) {
+        level++;
+    }
+    while (level > 0 && levels[level].geometricError * projection > pixelError) {
+        level--;
+    }
+    return level;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t count = argc > 1 ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    unsigned int repeats = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 200;
+    if (count == 0 || repeats == 0) {
+        std::fprintf(stderr, "Usage: kgelibbench [objects] [repeats]\n");
+        return 1;
+    }
+
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    // Отсечение
+    std::vector<float> x(count), y(count), z(count), radius(count);
+    KGEFrustumCuller culler;
+    for (std::size_t i = 0; i < count; i++) {
+        x[i] = position(random);
+        y[i] = position(random);
+        z[i] = position(random);
+        radius[i] = size(random);
+        culler.Add(x[i], y[i], z[i], radius[i]);
+    }
+
+    std::vector<float> viewProjection = MakeViewProjection();
+    kge::math::Frustum frustum = kge::math::ExtractFrustum(viewProjection.data());
+
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> visibleScalar;
+    double cullMs = MeasureMs(repeats, [&]() { culler.Cull(frustum, visible); });
+    double cullScalarMs = MeasureMs(repeats, [&]() { CullScalar(frustum, x, y, z, radius, visibleScalar); });
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const char* cullPath = "SSE";
+#else
+    const char* cullPath = "scalar";
+#endif
+
+    std::printf("Frustum culling, %zu spheres, %zu visible\n", count, visible.size());
+    std::printf("  KGEFrustumCuller::Cull (%s): %.3f ms\n", cullPath, cullMs);
+    std::printf("  scalar reference: %.3f ms\n", cullScalarMs);
+    if (visible != visibleScalar) {
+        std::fprintf(stderr, "Error: culling results differ (%zu vs %zu)\n", visible.size(), visibleScalar.size());
+        return 1;
+    }
+
+    // Матрицы моделей (как в KGEVulkanCore::Update)
+    std::vector<float> angles(count), scales(count);
+    for (std::size_t i = 0; i < count; i++) {
+        angles[i] = angle(random);
+        scales[i] = size(random);
+    }
+    std::vector<float> matrices(count * 16);
+
+    auto computeMatrices = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            MakeModelMatrix(&matrices[i * 16], x[i], y[i], z[i], angles[i], scales[i]);
+        }
+    };
+
+    KGEJobSystem jobSystem;
+    double serialMs = MeasureMs(repeats, [&]() { computeMatrices(0, count); });
+    double parallelMs = MeasureMs(repeats, [&]() { jobSystem.ParallelFor(count, 1024, computeMatrices); });
+
+    std::printf("Model matrices, %zu objects\n", count);
+    std::printf("  serial: %.3f ms\n", serialMs);
+    std::printf("  KGEJobSystem::ParallelFor (%u workers, batch 1024): %.3f ms\n", jobSystem.WorkerCount(), parallelMs);
+
+    // Запись команд отрисовки (матрицы моделей лежат с шагом выравнивания динамического UBO, как m_uboModels)
+    std::vector<unsigned char> models(count * DYNAMIC_ALIGNMENT);
+    std::vector<unsigned char> region(count * DYNAMIC_ALIGNMENT);
+    for (std::size_t i = 0; i < count; i++) {
+        std::memcpy(&models[i * DYNAMIC_ALIGNMENT], &matrices[i * 16], 64);
+    }
+
+    std::vector<uint32_t> uboStream;
+    std::vector<uint32_t> pushStream;
+    uboStream.reserve(count * 16);
+    pushStream.reserve(count * 32);
+
+    // Копирование матриц в область uniform-буфера изображения (KGEVulkanCore::UploadUniformRegion, в обоих режимах)
+    double uploadMs = MeasureMs(repeats, [&]() { std::memcpy(region.data(), models.data(), models.size()); });
+    double uboRecordMs = MeasureMs(repeats, [&]() { RecordDraws(uboStream, models, count, false); });
+    double pushRecordMs = MeasureMs(repeats, [&]() { RecordDraws(pushStream, models, count, true); });
+
+    std::printf("Draw recording, %zu draws (geometry changes every %zu draws, UBO alignment %zu)\n", count, DRAWS_PER_MESH, DYNAMIC_ALIGNMENT);
+    std::printf("  uniform upload (both paths): %.3f ms\n", uploadMs);
+    std::printf("  dynamic UBO record: %.3f ms, %zu KB of commands\n", uboRecordMs, uboStream.size() * 4 / 1024);
+    std::printf("  push constants record: %.3f ms, %zu KB of commands\n", pushRecordMs, pushStream.size() * 4 / 1024);
+    std::printf("  frame CPU, static draw list (UBO path reuses its command buffer): UBO %.3f ms, push %.3f ms\n",
+                uploadMs, uploadMs + pushRecordMs);
+    std::printf("  frame CPU, draw list changes every frame: UBO %.3f ms, push %.3f ms\n",
+                uploadMs + uboRecordMs, uploadMs + pushRecordMs);
+
+    // Уровни детализации: видимые сферы отсечения - экземпляры тестовой сетки (радиус сферы - масштаб),
+    // камера в начале координат, 1080 строк, угол обзора 60 градусов, допустимое отклонение 1 пиксель
+    std::vector<float> spherePositions;
+    std::vector<uint32_t> sphereIndices;
+    MakeBumpySphere(128, 256, spherePositions, sphereIndices);
+
+    auto lodStart = std::chrono::steady_clock::now();
+    std::vector<LodLevel> lods = BuildLods(spherePositions, sphereIndices, 4);
+    std::chrono::duration<double, std::milli> lodBuildMs = std::chrono::steady_clock::now() - lodStart;
+
+    std::printf("Mesh LODs, %zu-triangle mesh (LOD chain built in %.1f ms)\n", lods[0].indices.size() / 3, lodBuildMs.count());
+    for (std::size_t level = 0; level < lods.size(); level++) {
+        std::printf("  level %zu: %zu triangles, %u vertex transforms, error %.5f\n",
+                    level, lods[level].indices.size() / 3, lods[level].vertexTransforms, lods[level].geometricError);
+    }
+
+    // Проекция - пикселей на единицу модели (как в SelectLods: масштаб / расстояние до ближайшей точки сферы)
+    const float pixelsPerUnit = 1080.0f / (2.0f * std::tan(60.0f * 3.14159265f / 180.0f * 0.5f));
+    const float zNear = 0.1f;
+
+    auto measureLods = [&](const char* scene, const std::vector<float> &projections) {
+        std::vector<uint32_t> selected(projections.size(), 0);
+        double selectMs = MeasureMs(repeats, [&]() {
+            for (std::size_t i = 0; i < projections.size(); i++) {
+                selected[i] = SelectLod(lods, selected[i], projections[i], 1.0f);
+            }
+        });
+
+        std::vector<std::size_t> histogram(lods.size(), 0);
+        uint64_t trianglesLod = 0;
+        uint64_t transformsLod = 0;
+        for (uint32_t level : selected) {
+            histogram[level]++;
+            trianglesLod += lods[level].indices.size() / 3;
+            transformsLod += lods[level].vertexTransforms;
+        }
+        uint64_t trianglesBase = static_cast<uint64_t>(projections.size()) * (lods[0].indices.size() / 3);
+        uint64_t transformsBase = static_cast<uint64_t>(projections.size()) * lods[0].vertexTransforms;
+
+        std::printf("  %s, %zu instances, per level:", scene, projections.size());
+        for (std::size_t count : histogram) {
+            std::printf(" %zu", count);
+        }
+        std::printf("\n    triangles: %llu without LODs, %llu with LODs (%.1f%%)\n",
+                    static_cast<unsigned long long>(trianglesBase), static_cast<unsigned long long>(trianglesLod),
+                    100.0 * trianglesLod / trianglesBase);
+        std::printf("    vertex shader invocations: %llu without LODs, %llu with LODs (%.1f%%)\n",
+                    static_cast<unsigned long long>(transformsBase), static_cast<unsigned long long>(transformsLod),
+                    100.0 * transformsLod / transformsBase);
+        std::printf("    level selection: %.3f ms\n", selectMs);
+    };
+
+    // Видимые сферы отсечения (радиус сферы - масштаб сетки)
+    std::vector<float> farProjections(visible.size());
+    for (std::size_t i = 0; i < visible.size(); i++) {
+        uint32_t object = visible[i];
+        float distance = std::max(std::sqrt(x[object] * x[object] + y[object] * y[object] + z[object] * z[object]) - radius[object], zNear);
+        farProjections[i] = pixelsPerUnit * radius[object] / distance;
+    }
+    measureLods("culling scene", farProjections);
+
+    // Экземпляры единичного масштаба на расстоянии 2..200 от камеры
+    std::uniform_real_distribution<float> nearDistance(2.0f, 200.0f);
+    std::vector<float> nearProjections(visible.size());
+    for (float &projection : nearProjections) {
+        projection = pixelsPerUnit / std::max(nearDistance(random) - 1.0f, zNear);
+    }
+    measureLods("near scene (distance 2..200)", nearProjections);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#ifndef KGEPACKAGE_H
+#define KGEPACKAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Выравнивание блоков данных внутри пакета (и смещений внутри блоков)
+#define KGE_PACKAGE_ALIGNMENT 16
+
+// Наибольшее кол-во уровней детализации сетки и мип-уровней текстуры в пакете
+#define KGE_PACKAGE_LOD_MAX_LEVELS 4
+#define KGE_PACKAGE_MIP_MAX_LEVELS 16
+
+namespace kge
+{
+    namespace pak
+    {
+        const uint32_t PACKAGE_MAGIC = 0x4B41504B;     // "KPAK" (little-endian)
+        const uint32_t PACKAGE_VERSION = 3;            // 2 - позиции VertexLayoutCompact в snorm16 относительно границ сетки, 3 - узлы модели
+
+        // Тип блока данных
+        typedef enum
+        {
+            BlobRaw = 0,                // Произвольные данные
+            BlobMesh = 1,               // Геометрия (MeshBlob + вершины + индексы)
+            BlobTexture = 2,            // Текстура (TextureBlob + мип-уровни)
+            BlobModel = 3               // Описание модели (ModelBlob + ModelMeshRecord[] + хеши текстур + ModelNodeRecord[])
+        }BLOB_TYPE;
+
+        /**
+        * Заголовок пакета (в начале файла)
+        */
+        struct PackageHeader
+        {
+            uint32_t magic = PACKAGE_MAGIC;
+            uint32_t version = PACKAGE_VERSION;
+            uint32_t entryCount = 0;
+            uint32_t reserved = 0;
+            uint64_t tableOffset = 0;   // Смещение таблицы записей (записи отсортированы по хешу имени)
+            uint64_t fileSize = 0;      // Размер файла (защита от обрезанных файлов)
+        };
+
+        /**
+        * Запись таблицы - положение блока данных в файле
+        */
+        struct PackageEntry
+        {
+            uint64_t nameHash = 0;      // Хеш имени (см. HashName)
+            uint64_t offset = 0;        // Смещение блока от начала файла (кратно KGE_PACKAGE_ALIGNMENT)
+            uint64_t size = 0;
+            uint32_t type = BlobRaw;
+            uint32_t reserved = 0;
+        };
+
+        /**
+        * Заголовок блока геометрии. Вершины и индексы уже в формате буферов устройства,
+        * смещения - от начала блока
+        */
+        struct MeshBlob
+        {
+            uint32_t vertexCount = 0;
+            uint32_t indexCount = 0;
+            uint32_t vertexLayout = 0;  // Формат вершин (VERTEX_LAYOUT рендерера)
+            uint32_t indexSize = 4;     // Размер индекса в байтах (2 либо 4)
+            uint64_t vertexOffset = 0;
+            uint64_t vertexBytes = 0;
+            uint64_t indexOffset = 0;
+            uint64_t indexBytes = 0;
+            float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+            float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+            float boundingRadius = 0.0f;
+            float geometricError = 0.0f;
+        };
+
+        /**
+        * Заголовок блока текстуры (RGBA8, мип-уровни от большего к меньшему)
+        */
+        struct TextureBlob
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t mipLevels = 0;
+            uint32_t reserved = 0;
+            uint64_t mipOffsets[KGE_PACKAGE_MIP_MAX_LEVELS] = {};
+            uint64_t mipBytes[KGE_PACKAGE_MIP_MAX_LEVELS] = {};
+        };
+
+        /**
+        * Сетка модели - хеши блоков геометрии уровней детализации и индекс текстуры
+        */
+        struct ModelMeshRecord
+        {
+            uint32_t levelCount = 0;
+            int32_t texture = -1;       // Индекс в массиве хешей текстур модели (-1 - без текстуры)
+            uint64_t levels[KGE_PACKAGE_LOD_MAX_LEVELS] = {};
+        };
+
+        /**
+        * Узел модели - индекс сетки и ее преобразование относительно начала модели (поворот в градусах, порядок X, Y, Z)
+        */
+        struct ModelNodeRecord
+        {
+            uint32_t mesh = 0;          // Индекс в массиве ModelMeshRecord модели
+            float position[3] = {};
+            float rotation[3] = {};
+            float scale[3] = { 1.0f, 1.0f, 1.0f };
+        };
+
+        /**
+        * Заголовок блока модели (за ним ModelMeshRecord[meshCount], uint64_t[textureCount] - хеши текстур,
+        * затем ModelNodeRecord[nodeCount])
+        */
+        struct ModelBlob
+        {
+            uint32_t meshCount = 0;
+            uint32_t textureCount = 0;
+            uint32_t nodeCount = 0;
+            uint32_t reserved = 0;
+        };
+
+        /**
+        * Хеш имени блока (FNV-1a, 64 бита)
+        */
+        uint64_t HashName(const std::string &name);
+
+        /**
+        * Выравнивание смещения вверх до KGE_PACKAGE_ALIGNMENT
+        */
+        inline uint64_t Align(uint64_t offset)
+        {
+            return (offset + KGE_PACKAGE_ALIGNMENT - 1) & ~static_cast<uint64_t>(KGE_PACKAGE_ALIGNMENT - 1);
+        }
+    }
+}
+
+/**
+* Пакет ресурсов (.kgepak), отображенный в память
+* Файл открывается один раз и отображается целиком (mmap), блоки читаются прямо из отображения - без разбора
+* и промежуточных копий. Таблица записей отсортирована по хешу имени, поиск - двоичный
+*/
+class KGEPackage
+{
+public:
+    /**
+    * @param const std::string &path - путь к файлу пакета
+    * @note - бросает исключение, если файл не открывается либо не является пакетом этой версии
+    */
+    explicit KGEPackage(const std::string &path);
+    ~KGEPackage();
+
+    KGEPackage(const KGEPackage&) = delete;
+    KGEPackage& operator=(const KGEPackage&) = delete;
+
+    /**
+    * Поиск записи
+    * @return const kge::pak::PackageEntry* - запись (nullptr если блока нет)
+    */
+    const kge::pak::PackageEntry* Find(uint64_t nameHash) const;
+    const kge::pak::PackageEntry* Find(const std::string &name) const;
+
+    /**
+    * Данные блока (указатель внутрь отображения, выровнен по KGE_PACKAGE_ALIGNMENT)
+    */
+    const unsigned char* Data(const kge::pak::PackageEntry &entry) const;
+
+    uint32_t entryCount() const;
+    const std::string &path() const;
+
+private:
+    std::string m_path;
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<unsigned char> m_buffer;        // Содержимое файла там, где отображение не поддерживается (Windows)
+    const kge::pak::PackageEntry* m_entries = nullptr;
+    uint32_t m_entryCount = 0;
+
+    void Validate();
+};
+
+/**
+* Запись пакета ресурсов (используется сборщиком пакетов)
+*/
+class KGEPackageWriter
+{
+public:
+    /**
+    * Добавить блок
+    * @param const std::string &name - имя блока (в пакете хранится только хеш)
+    * @param kge::pak::BLOB_TYPE type - тип блока
+    * @param std::vector<unsigned char> data - данные блока
+    * @note - бросает исключение, если блок с таким хешем имени уже добавлен
+    */
+    void Add(const std::string &name, kge::pak::BLOB_TYPE type, std::vector<unsigned char> data);
+
+    /**
+    * Записать пакет в файл
+    * @return bool - удалось ли записать
+    */
+    bool Write(const std::string &path) const;
+
+private:
+    struct PendingBlob
+    {
+        uint64_t nameHash;
+        kge::pak::BLOB_TYPE type;
+        std::vector<unsigned char> data;
+    };
+
+    std::vector<PendingBlob> m_blobs;
+};
+
+#endif // KGEPACKAGE_H
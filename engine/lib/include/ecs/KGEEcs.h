@@ -0,0 +1,299 @@
+#ifndef KGEECS_H
+#define KGEECS_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <jobs/KGEJobSystem.h>
+
+// Размер блока хранения сущностей одного архетипа
+#define KGE_ECS_CHUNK_SIZE 16384
+
+// Максимальное кол-во типов компонентов (маска архетипа - 64 бита)
+#define KGE_ECS_MAX_COMPONENT_TYPES 64
+
+namespace kge
+{
+    namespace ecs
+    {
+        /**
+        * Сущность - индекс записи и поколение (после удаления сущности старые хендлы становятся недействительными)
+        */
+        struct Entity
+        {
+            uint32_t index = UINT32_MAX;
+            uint32_t generation = 0;
+
+            bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+            bool operator!=(const Entity &other) const { return !(*this == other); }
+        };
+
+        // Набор типов компонентов (бит на тип)
+        typedef uint64_t ComponentMask;
+
+        // Выдача очередного идентификатора типа компонента
+        uint32_t NextComponentType();
+
+        // Идентификатор типа компонента (выдается при первом обращении)
+        template <typename T>
+        uint32_t ComponentType()
+        {
+            static const uint32_t type = NextComponentType();
+            return type;
+        }
+
+        // Маска набора типов компонентов
+        template <typename... Ts>
+        ComponentMask MakeComponentMask()
+        {
+            return (ComponentMask(0) | ... | (ComponentMask(1) << ComponentType<Ts>()));
+        }
+
+        /**
+        * Описание типа компонента
+        * Компоненты переносятся между блоками побайтно и не разрушаются, поэтому не должны владеть ресурсами
+        * (тривиальный деструктор)
+        */
+        struct ComponentInfo
+        {
+            uint32_t type = 0;
+            uint32_t size = 0;
+            uint32_t alignment = 0;
+        };
+
+        template <typename T>
+        ComponentInfo MakeComponentInfo()
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "ECS: Components must be trivially destructible");
+            ComponentInfo info;
+            info.type = ComponentType<T>();
+            info.size = static_cast<uint32_t>(sizeof(T));
+            info.alignment = static_cast<uint32_t>(alignof(T));
+            return info;
+        }
+
+        /**
+        * Блок хранения. Внутри блока каждый компонент лежит своим массивом (SoA), первым идет массив сущностей
+        */
+        struct Chunk
+        {
+            alignas(64) unsigned char data[KGE_ECS_CHUNK_SIZE];
+            uint32_t count = 0;
+        };
+
+        /**
+        * Архетип - набор сущностей с одинаковым набором компонентов
+        * Все блоки архетипа, кроме последнего, заполнены полностью (при удалении на место дыры переносится последняя сущность)
+        */
+        struct Archetype
+        {
+            ComponentMask mask = 0;
+            std::vector<ComponentInfo> components;                  // Компоненты (по возрастанию типа)
+            uint32_t offsets[KGE_ECS_MAX_COMPONENT_TYPES];          // Смещение массива компонента в блоке (по типу, UINT32_MAX - нет)
+            uint32_t capacity = 0;                                  // Кол-во сущностей в блоке
+            std::vector<std::unique_ptr<Chunk>> chunks;
+
+            Entity* entities(Chunk &chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+            void* column(Chunk &chunk, uint32_t type) const { return chunk.data + offsets[type]; }
+        };
+    }
+}
+
+/**
+* Мир сущностей (ECS) с хранением по архетипам
+* - Сущности с одинаковым набором компонентов лежат в блоках по 16 КБ, внутри блока - массив на каждый компонент,
+*   поэтому проход по одному компоненту читает только его данные
+* - Запросы типизированы: ForEachChunk/Each/ParallelEach<Ts...> обходят архетипы, содержащие все Ts
+*   (список подходящих архетипов кэшируется по маске)
+* - ParallelEach раздает блоки рабочим потокам системы задач (блоки не пересекаются, синхронизация не нужна)
+* @note - добавление/удаление сущностей и компонентов во время обхода недопустимо
+*/
+class KGEEcsWorld
+{
+public:
+    KGEEcsWorld();
+
+    // Создание сущности без компонентов
+    kge::ecs::Entity Create();
+
+    // Создание сущности сразу с набором компонентов (без промежуточных переносов между архетипами)
+    template <typename... Ts>
+    kge::ecs::Entity Create(const Ts&... components)
+    {
+        std::vector<kge::ecs::ComponentInfo> infos = { kge::ecs::MakeComponentInfo<Ts>()... };
+        uint32_t archetype = FindOrCreateArchetype(infos);
+        kge::ecs::Entity entity = Place(archetype);
+        (Write<Ts>(entity, components), ...);
+        return entity;
+    }
+
+    // Удаление сущности
+    void Destroy(kge::ecs::Entity entity);
+
+    // Существует ли сущность (хендл не устарел)
+    bool Alive(kge::ecs::Entity entity) const;
+
+    // Добавление (либо перезапись) компонента
+    template <typename T>
+    void Add(kge::ecs::Entity entity, const T &component)
+    {
+        kge::ecs::ComponentInfo info = kge::ecs::MakeComponentInfo<T>();
+        const kge::ecs::Archetype &source = *m_archetypes[m_records[entity.index].archetype];
+        if ((source.mask & (kge::ecs::ComponentMask(1) << info.type)) == 0) {
+            std::vector<kge::ecs::ComponentInfo> infos = source.components;
+            infos.push_back(info);
+            MoveEntity(entity, FindOrCreateArchetype(infos));
+        }
+        Write<T>(entity, component);
+    }
+
+    // Удаление компонента
+    template <typename T>
+    void Remove(kge::ecs::Entity entity)
+    {
+        uint32_t type = kge::ecs::ComponentType<T>();
+        const kge::ecs::Archetype &source = *m_archetypes[m_records[entity.index].archetype];
+        if ((source.mask & (kge::ecs::ComponentMask(1) << type)) != 0) {
+            std::vector<kge::ecs::ComponentInfo> infos;
+            for (const kge::ecs::ComponentInfo &info : source.components) {
+                if (info.type != type) {
+                    infos.push_back(info);
+                }
+            }
+            MoveEntity(entity, FindOrCreateArchetype(infos));
+        }
+    }
+
+    // Есть ли у сущности компонент
+    template <typename T>
+    bool Has(kge::ecs::Entity entity) const
+    {
+        const kge::ecs::Archetype &archetype = *m_archetypes[m_records[entity.index].archetype];
+        return (archetype.mask & (kge::ecs::ComponentMask(1) << kge::ecs::ComponentType<T>())) != 0;
+    }
+
+    // Компонент сущности (nullptr если его нет)
+    template <typename T>
+    T* Get(kge::ecs::Entity entity) const
+    {
+        const Record &record = m_records[entity.index];
+        const kge::ecs::Archetype &archetype = *m_archetypes[record.archetype];
+        uint32_t type = kge::ecs::ComponentType<T>();
+        if ((archetype.mask & (kge::ecs::ComponentMask(1) << type)) == 0) {
+            return nullptr;
+        }
+        return static_cast<T*>(archetype.column(*archetype.chunks[record.chunk], type)) + record.row;
+    }
+
+    /**
+    * Обход блоков, содержащих все компоненты Ts
+    * @param F &&function - функция (uint32_t count, const kge::ecs::Entity* entities, Ts*... components)
+    */
+    template <typename... Ts, typename F>
+    void ForEachChunk(F &&function)
+    {
+        for (uint32_t archetypeIndex : Matching(kge::ecs::MakeComponentMask<Ts...>())) {
+            kge::ecs::Archetype &archetype = *m_archetypes[archetypeIndex];
+            for (std::unique_ptr<kge::ecs::Chunk> &chunk : archetype.chunks) {
+                function(chunk->count,
+                         archetype.entities(*chunk),
+                         static_cast<Ts*>(archetype.column(*chunk, kge::ecs::ComponentType<Ts>()))...);
+            }
+        }
+    }
+
+    /**
+    * Обход сущностей, содержащих все компоненты Ts
+    * @param F &&function - функция (kge::ecs::Entity entity, Ts&... components)
+    */
+    template <typename... Ts, typename F>
+    void Each(F &&function)
+    {
+        ForEachChunk<Ts...>([&function](uint32_t count, const kge::ecs::Entity* entities, Ts*... components) {
+            for (uint32_t i = 0; i < count; i++) {
+                function(entities[i], components[i]...);
+            }
+        });
+    }
+
+    /**
+    * Параллельный обход сущностей, содержащих все компоненты Ts (по блоку на задачу)
+    * @param KGEJobSystem* jobSystem - система задач
+    * @param F &&function - функция (kge::ecs::Entity entity, Ts&... components), вызывается из рабочих потоков
+    */
+    template <typename... Ts, typename F>
+    void ParallelEach(KGEJobSystem* jobSystem, F &&function)
+    {
+        const std::vector<uint32_t> &archetypes = Matching(kge::ecs::MakeComponentMask<Ts...>());
+
+        std::vector<std::pair<kge::ecs::Archetype*, kge::ecs::Chunk*>> chunks;
+        for (uint32_t archetypeIndex : archetypes) {
+            for (std::unique_ptr<kge::ecs::Chunk> &chunk : m_archetypes[archetypeIndex]->chunks) {
+                chunks.emplace_back(m_archetypes[archetypeIndex].get(), chunk.get());
+            }
+        }
+
+        jobSystem->ParallelFor(chunks.size(), 1, [&chunks, &function](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c < end; c++) {
+                kge::ecs::Archetype &archetype = *chunks[c].first;
+                kge::ecs::Chunk &chunk = *chunks[c].second;
+                const kge::ecs::Entity* entities = archetype.entities(chunk);
+                std::tuple<Ts*...> columns(static_cast<Ts*>(archetype.column(chunk, kge::ecs::ComponentType<Ts>()))...);
+                for (uint32_t i = 0; i < chunk.count; i++) {
+                    function(entities[i], std::get<Ts*>(columns)[i]...);
+                }
+            }
+        });
+    }
+
+    // Кол-во живых сущностей
+    uint32_t entityCount() const;
+
+    // Кол-во архетипов
+    uint32_t archetypeCount() const;
+
+private:
+    // Положение сущности
+    struct Record
+    {
+        uint32_t archetype = 0;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    // Кэш запроса: подходящие архетипы и сколько архетипов уже просмотрено
+    struct QueryCache
+    {
+        std::vector<uint32_t> archetypes;
+        uint32_t checked = 0;
+    };
+
+    std::vector<Record> m_records;
+    std::vector<uint32_t> m_freeRecords;
+    uint32_t m_entityCount;
+
+    std::vector<std::unique_ptr<kge::ecs::Archetype>> m_archetypes;
+    std::unordered_map<kge::ecs::ComponentMask, uint32_t> m_archetypeByMask;
+    std::unordered_map<kge::ecs::ComponentMask, QueryCache> m_queries;
+
+    uint32_t FindOrCreateArchetype(std::vector<kge::ecs::ComponentInfo> components);
+    kge::ecs::Entity Place(uint32_t archetype);
+    void AllocateRow(uint32_t archetype, uint32_t &chunk, uint32_t &row);
+    void FreeRow(uint32_t archetype, uint32_t chunk, uint32_t row);
+    void MoveEntity(kge::ecs::Entity entity, uint32_t targetArchetype);
+    const std::vector<uint32_t>& Matching(kge::ecs::ComponentMask mask);
+
+    template <typename T>
+    void Write(kge::ecs::Entity entity, const T &component)
+    {
+        memcpy(static_cast<void*>(Get<T>(entity)), &component, sizeof(T));
+    }
+};
+
+#endif // KGEECS_H
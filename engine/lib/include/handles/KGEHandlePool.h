@@ -0,0 +1,191 @@
+#ifndef KGEHANDLEPOOL_H
+#define KGEHANDLEPOOL_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Раскладка 32-битного хендла: младшие биты - индекс ячейки пула, старшие - поколение ячейки
+#define KGE_HANDLE_INDEX_BITS 20
+#define KGE_HANDLE_INDEX_MASK ((1u << KGE_HANDLE_INDEX_BITS) - 1u)
+#define KGE_HANDLE_GENERATION_MASK ((1u << (32 - KGE_HANDLE_INDEX_BITS)) - 1u)
+
+// Максимальное кол-во ячеек пула
+#define KGE_HANDLE_MAX_SLOTS (1u << KGE_HANDLE_INDEX_BITS)
+
+namespace kge
+{
+    namespace handles
+    {
+        /**
+        * Типизированный хендл ресурса - индекс ячейки пула и ее поколение в одном 32-битном слове
+        * Тег различает хендлы разных ресурсов (хендл текстуры нельзя передать вместо хендла геометрии).
+        * Поколение ячейки начинается с 1, поэтому нулевой хендл (по умолчанию) недействителен
+        */
+        template <typename Tag>
+        struct Handle
+        {
+            uint32_t value = 0;
+
+            static Handle Make(uint32_t index, uint32_t generation)
+            {
+                Handle handle;
+                handle.value = (generation << KGE_HANDLE_INDEX_BITS) | (index & KGE_HANDLE_INDEX_MASK);
+                return handle;
+            }
+
+            uint32_t index() const { return value & KGE_HANDLE_INDEX_MASK; }
+            uint32_t generation() const { return value >> KGE_HANDLE_INDEX_BITS; }
+            bool valid() const { return value != 0; }
+
+            bool operator==(const Handle &other) const { return value == other.value; }
+            bool operator!=(const Handle &other) const { return value != other.value; }
+            bool operator<(const Handle &other) const { return value < other.value; }
+        };
+    }
+}
+
+/**
+* Пул ресурсов с доступом по типизированным хендлам (см. kge::handles::Handle)
+* - Элементы лежат плотным массивом (обход - последовательное чтение без переходов по указателям),
+*   при удалении на место дыры переносится последний элемент
+* - Ячейка хендла хранит индекс элемента в плотном массиве и поколение, поэтому доступ по хендлу - O(1)
+* - Освобожденные ячейки выдаются снова с новым поколением - устаревшие хендлы распознаются
+* @note - адреса элементов меняются при добавлении и удалении, хранить следует хендлы, а не указатели
+*/
+template <typename T, typename Tag>
+class KGEHandlePool
+{
+public:
+    typedef kge::handles::Handle<Tag> HandleType;
+
+    /**
+    * Добавление элемента
+    * @param T item - элемент
+    * @return HandleType - хендл элемента
+    * @note - бросает исключение, если все ячейки пула заняты
+    */
+    HandleType Add(T item)
+    {
+        uint32_t slot;
+        if (!m_freeSlots.empty()) {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else {
+            if (m_slotItems.size() >= KGE_HANDLE_MAX_SLOTS) {
+                throw std::runtime_error("HandlePool: Error. Pool is full");
+            }
+            slot = static_cast<uint32_t>(m_slotItems.size());
+            m_slotItems.push_back(UINT32_MAX);
+            m_generations.push_back(1);
+        }
+
+        m_slotItems[slot] = static_cast<uint32_t>(m_items.size());
+        m_items.push_back(std::move(item));
+        m_itemSlots.push_back(slot);
+
+        return HandleType::Make(slot, m_generations[slot]);
+    }
+
+    /**
+    * Удаление элемента (ячейка получает новое поколение и уходит в список свободных)
+    * @param HandleType handle - хендл элемента
+    * @note - бросает исключение, если хендл недействителен либо устарел
+    */
+    void Remove(HandleType handle)
+    {
+        uint32_t item = ItemIndex(handle);
+        uint32_t last = static_cast<uint32_t>(m_items.size() - 1);
+
+        // Последний элемент занимает место удаляемого
+        if (item != last) {
+            m_items[item] = std::move(m_items[last]);
+            m_itemSlots[item] = m_itemSlots[last];
+            m_slotItems[m_itemSlots[item]] = item;
+        }
+        m_items.pop_back();
+        m_itemSlots.pop_back();
+
+        // Нулевое поколение пропускается - нулевой хендл всегда недействителен
+        uint32_t slot = handle.index();
+        m_slotItems[slot] = UINT32_MAX;
+        m_generations[slot] = (m_generations[slot] + 1) & KGE_HANDLE_GENERATION_MASK;
+        if (m_generations[slot] == 0) {
+            m_generations[slot] = 1;
+        }
+        m_freeSlots.push_back(slot);
+    }
+
+    /**
+    * Действителен ли хендл (ячейка занята элементом того же поколения)
+    */
+    bool Alive(HandleType handle) const
+    {
+        uint32_t slot = handle.index();
+        return handle.valid() &&
+               slot < m_slotItems.size() &&
+               m_slotItems[slot] != UINT32_MAX &&
+               m_generations[slot] == handle.generation();
+    }
+
+    /**
+    * Элемент по хендлу
+    * @note - бросает исключение, если хендл недействителен либо устарел
+    */
+    T& Get(HandleType handle) { return m_items[ItemIndex(handle)]; }
+    const T& Get(HandleType handle) const { return m_items[ItemIndex(handle)]; }
+
+    /**
+    * Элемент по хендлу либо nullptr, если хендл недействителен либо устарел
+    */
+    T* Find(HandleType handle) { return Alive(handle) ? &m_items[m_slotItems[handle.index()]] : nullptr; }
+    const T* Find(HandleType handle) const { return Alive(handle) ? &m_items[m_slotItems[handle.index()]] : nullptr; }
+
+    /**
+    * Плотный массив элементов (порядок меняется при удалении)
+    */
+    std::vector<T>& items() { return m_items; }
+    const std::vector<T>& items() const { return m_items; }
+
+    /**
+    * Хендл элемента плотного массива
+    * @param std::size_t item - индекс элемента в items()
+    */
+    HandleType handle(std::size_t item) const
+    {
+        uint32_t slot = m_itemSlots[item];
+        return HandleType::Make(slot, m_generations[slot]);
+    }
+
+    std::size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+
+    /**
+    * Удаление всех элементов (выданные хендлы становятся недействительными)
+    */
+    void Clear()
+    {
+        while (!m_items.empty()) {
+            Remove(handle(m_items.size() - 1));
+        }
+    }
+
+private:
+    std::vector<T> m_items;                 // Элементы (плотно)
+    std::vector<uint32_t> m_itemSlots;      // Ячейка каждого элемента
+    std::vector<uint32_t> m_slotItems;      // Индекс элемента каждой ячейки (UINT32_MAX - ячейка свободна)
+    std::vector<uint32_t> m_generations;    // Поколения ячеек
+    std::vector<uint32_t> m_freeSlots;      // Свободные ячейки
+
+    uint32_t ItemIndex(HandleType handle) const
+    {
+        if (!Alive(handle)) {
+            throw std::runtime_error("HandlePool: Error. Handle is invalid or stale");
+        }
+        return m_slotItems[handle.index()];
+    }
+};
+
+#endif // KGEHANDLEPOOL_H
@@ -0,0 +1,235 @@
+#ifndef KGEFILESYSTEM_H
+#define KGEFILESYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "assets/KGEPackage.h"
+#include "io/KGEIoUring.h"
+
+// Наибольшее кол-во одновременно выполняемых чтений (глубина очереди io_uring)
+#define KGE_VFS_QUEUE_DEPTH 32
+
+// Кол-во потоков чтения, если io_uring недоступен
+#define KGE_VFS_FALLBACK_THREADS 2
+
+// Размер одной операции чтения. Отмена выполняемого чтения срабатывает между операциями
+#define KGE_VFS_READ_CHUNK (4u * 1024u * 1024u)
+
+namespace kge
+{
+    namespace io
+    {
+        // Приоритет чтения (из очереди первыми отправляются чтения с большим приоритетом, при равном - в порядке запроса)
+        typedef enum
+        {
+            ReadPriorityLow = 0,        // Упреждающая подгрузка
+            ReadPriorityNormal = 1,
+            ReadPriorityHigh = 2,       // Ресурсы, нужные в ближайших кадрах
+            ReadPriorityCritical = 3    // Ресурсы, без которых кадр не может быть построен
+        }READ_PRIORITY;
+
+        // Результат чтения
+        typedef enum
+        {
+            ReadOk = 0,
+            ReadNotFound = 1,           // Путь не найден ни в одной точке монтирования
+            ReadFailed = 2,             // Ошибка ввода-вывода
+            ReadCancelled = 3
+        }READ_STATUS;
+
+        /**
+        * Хендл чтения (0 - недействительный хендл)
+        */
+        typedef uint64_t ReadHandle;
+        const ReadHandle INVALID_READ_HANDLE = 0;
+
+        /**
+        * Результат чтения, передаваемый обработчику
+        */
+        struct ReadResult
+        {
+            ReadHandle handle = INVALID_READ_HANDLE;
+            READ_STATUS status = ReadFailed;
+            std::string path;
+            std::vector<unsigned char> data;
+        };
+
+        typedef std::function<void(ReadResult &result)> ReadCallback;
+    }
+}
+
+/**
+* Виртуальная файловая система
+* Пути разрешаются через точки монтирования (каталоги и пакеты .kgepak). Точки проверяются от последней смонтированной
+* к первой, поэтому более поздние точки перекрывают более ранние. Путь, не попавший ни в одну точку, читается как обычный путь
+*
+* Чтение асинхронное: запрос ставится в очередь с приоритетом, чтения выполняются потоком ввода-вывода через io_uring
+* (если ядро его поддерживает) либо пулом потоков с блокирующим чтением. Обработчики завершенных чтений вызываются
+* в потоке, который вызывает DispatchCompleted (как правило - в основном потоке раз в кадр), поэтому основной поток
+* никогда не ждет диск
+*/
+class KGEFileSystem
+{
+public:
+    /**
+    * @param bool allowIoUring - использовать ли io_uring (false - всегда пул потоков)
+    */
+    explicit KGEFileSystem(bool allowIoUring = true);
+    ~KGEFileSystem();
+
+    KGEFileSystem(const KGEFileSystem&) = delete;
+    KGEFileSystem& operator=(const KGEFileSystem&) = delete;
+
+    /**
+    * Монтирование каталога
+    * @param const std::string &mountPoint - виртуальный путь точки монтирования ("" - корень)
+    * @param const std::string &directory - каталог на диске
+    */
+    void MountDirectory(const std::string &mountPoint, const std::string &directory);
+
+    /**
+    * Монтирование пакета (имя блока в пакете - путь относительно точки монтирования)
+    * @param const std::string &mountPoint - виртуальный путь точки монтирования ("" - корень)
+    * @param const std::string &packagePath - путь к файлу пакета
+    * @note - бросает исключение, если пакет не открывается
+    */
+    void MountPackage(const std::string &mountPoint, const std::string &packagePath);
+
+    /**
+    * Снятие всех точек монтирования с этим виртуальным путем (уже идущие чтения завершаются)
+    */
+    void Unmount(const std::string &mountPoint);
+
+    /**
+    * Асинхронное чтение файла целиком
+    * @param const std::string &path - виртуальный путь
+    * @param kge::io::ReadCallback callback - обработчик результата (вызывается из DispatchCompleted)
+    * @param kge::io::READ_PRIORITY priority - приоритет
+    * @return kge::io::ReadHandle - хендл чтения (для отмены и смены приоритета)
+    */
+    kge::io::ReadHandle ReadAsync(const std::string &path,
+                                  kge::io::ReadCallback callback,
+                                  kge::io::READ_PRIORITY priority = kge::io::ReadPriorityNormal);
+
+    /**
+    * Отмена чтения. Чтение из очереди снимается сразу, выполняемое - прерывается перед следующей операцией.
+    * Обработчик вызывается в любом случае (со статусом ReadCancelled, если отмена успела)
+    * @return bool - найден ли незавершенный запрос
+    */
+    bool Cancel(kge::io::ReadHandle handle);
+
+    /**
+    * Смена приоритета чтения, еще не отправленного на выполнение
+    * @return bool - найден ли запрос в очереди
+    */
+    bool SetPriority(kge::io::ReadHandle handle, kge::io::READ_PRIORITY priority);
+
+    /**
+    * Вызов обработчиков завершенных чтений в текущем потоке
+    * @param unsigned int maxCount - наибольшее кол-во обработчиков за вызов (ограничение работы в кадре)
+    * @return unsigned int - кол-во вызванных обработчиков
+    */
+    unsigned int DispatchCompleted(unsigned int maxCount = UINT32_MAX);
+
+    /**
+    * Синхронное чтение в текущем потоке (для загрузки при запуске, когда ждать все равно нужно)
+    * @return kge::io::READ_STATUS - результат
+    */
+    kge::io::READ_STATUS ReadSync(const std::string &path, std::vector<unsigned char> &data);
+
+    /**
+    * Существует ли файл по виртуальному пути
+    */
+    bool Exists(const std::string &path) const;
+
+    bool usingIoUring() const;
+    unsigned int pendingCount() const;
+
+private:
+    /**
+    * Точка монтирования (каталог либо пакет)
+    */
+    struct Mount
+    {
+        std::string point;
+        std::string directory;
+        std::shared_ptr<KGEPackage> package;
+    };
+
+    /**
+    * Разрешенный путь: файл на диске либо блок пакета
+    */
+    struct Source
+    {
+        std::string nativePath;
+        std::shared_ptr<KGEPackage> package;    // Держит отображение пакета, пока идет чтение
+        const unsigned char* packageData = nullptr;
+        uint64_t size = 0;
+    };
+
+    /**
+    * Запрос чтения
+    */
+    struct Request
+    {
+        kge::io::ReadHandle handle = kge::io::INVALID_READ_HANDLE;
+        kge::io::READ_PRIORITY priority = kge::io::ReadPriorityNormal;
+        std::string path;
+        kge::io::ReadCallback callback;
+        std::atomic<bool> cancelled{false};
+
+        // Состояние выполняемого чтения (принадлежит потоку ввода-вывода)
+        int file = -1;
+        uint64_t offset = 0;
+        std::vector<unsigned char> data;
+    };
+
+    // Ключ очереди: (-приоритет, хендл) - больший приоритет первым, при равном - более ранний запрос
+    typedef std::pair<int, kge::io::ReadHandle> QueueKey;
+
+    mutable std::mutex m_mountMutex;
+    std::vector<Mount> m_mounts;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::unordered_map<kge::io::ReadHandle, std::unique_ptr<Request>> m_requests;   // Все незавершенные запросы
+    std::map<QueueKey, Request*> m_queue;                                           // Запросы, еще не отправленные на выполнение
+    std::deque<std::pair<kge::io::ReadCallback, kge::io::ReadResult>> m_completed;  // Ожидают вызова обработчика
+    kge::io::ReadHandle m_nextHandle = 1;
+    bool m_stop = false;
+
+    std::vector<std::thread> m_threads;
+
+#ifdef KGE_IO_URING_AVAILABLE
+    std::unique_ptr<KGEIoUring> m_ring;
+    int m_wakeEvent = -1;
+    void IoUringLoop();
+    void SubmitChunk(Request* request);
+#endif
+
+    void WorkerLoop();
+    void Wake();
+
+    bool Resolve(const std::string &path, Source &source) const;
+    bool OpenRequest(Request* request, kge::io::READ_STATUS &status);
+    kge::io::READ_STATUS ReadBlocking(Request* request);
+    Request* PopQueued(bool wait);
+    void Complete(Request* request, kge::io::READ_STATUS status);
+    void CompleteLocked(Request* request, kge::io::READ_STATUS status);
+
+    static std::string NormalizeMountPoint(const std::string &mountPoint);
+};
+
+#endif // KGEFILESYSTEM_H
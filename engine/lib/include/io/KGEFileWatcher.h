@@ -0,0 +1,64 @@
+#ifndef KGEFILEWATCHER_H
+#define KGEFILEWATCHER_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Слежение за каталогами реализовано через inotify (только Linux), на других платформах наблюдатель ничего не сообщает
+#if defined(__linux__)
+#define KGE_INOTIFY_AVAILABLE 1
+#endif
+
+// Сколько файл должен оставаться без изменений, прежде чем о нем будет сообщено (редакторы и экспортеры пишут файл
+// в несколько приемов - читать его до окончания записи нельзя)
+#define KGE_WATCH_DEBOUNCE_MS 100
+
+/**
+* Наблюдатель за изменением файлов в каталогах (рекурсивно, включая подкаталоги, созданные после начала слежения)
+* Файл считается измененным, когда его закрыли после записи либо переместили на его место другой файл (сохранение
+* через временный файл). Не блокирует - события забираются вызовом Poll (как правило - раз в кадр)
+*/
+class KGEFileWatcher
+{
+public:
+    /**
+    * @note - бросает исключение, если inotify недоступен (исчерпан лимит экземпляров)
+    */
+    KGEFileWatcher();
+    ~KGEFileWatcher();
+
+    KGEFileWatcher(const KGEFileWatcher&) = delete;
+    KGEFileWatcher& operator=(const KGEFileWatcher&) = delete;
+
+    /**
+    * Начать слежение за каталогом и всеми его подкаталогами
+    * @param const std::string &directory - каталог
+    * @note - бросает исключение, если за каталогом нельзя следить (не существует либо исчерпан лимит наблюдений)
+    */
+    void WatchDirectory(const std::string &directory);
+
+    /**
+    * Забрать изменения
+    * @return std::vector<std::string> - пути измененных файлов, которые не менялись последние KGE_WATCH_DEBOUNCE_MS
+    * (каждый путь - один раз, сколько бы событий о нем ни пришло)
+    */
+    std::vector<std::string> Poll();
+
+    /**
+    * Поддерживается ли слежение на этой платформе
+    */
+    bool available() const;
+
+private:
+#ifdef KGE_INOTIFY_AVAILABLE
+    int m_inotify = -1;
+    std::unordered_map<int, std::string> m_directories;                                 // Каталог по дескриптору наблюдения
+#endif
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_pending;   // Измененные файлы и время последнего изменения
+
+    void AddWatch(const std::string &directory);
+};
+
+#endif // KGEFILEWATCHER_H
@@ -0,0 +1,89 @@
+#ifndef KGEIOURING_H
+#define KGEIOURING_H
+
+// io_uring доступен только в Linux (заголовки ядра 5.1+). Библиотека liburing не используется - кольца настраиваются
+// системными вызовами напрямую
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define KGE_IO_URING_AVAILABLE 1
+#endif
+#endif
+
+#ifdef KGE_IO_URING_AVAILABLE
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+* Кольца io_uring (очередь отправки и очередь завершения)
+* Не потокобезопасен - используется одним потоком (потоком ввода-вывода файловой системы)
+*/
+class KGEIoUring
+{
+public:
+    /**
+    * @param unsigned int entries - размер очереди отправки
+    * @note - бросает исключение, если ядро не поддерживает io_uring (либо он запрещен, например, в контейнере)
+    */
+    explicit KGEIoUring(unsigned int entries);
+    ~KGEIoUring();
+
+    KGEIoUring(const KGEIoUring&) = delete;
+    KGEIoUring& operator=(const KGEIoUring&) = delete;
+
+    /**
+    * Добавить чтение в очередь отправки
+    * @return bool - false если очередь отправки заполнена
+    */
+    bool PrepareRead(int file, void* buffer, unsigned int size, uint64_t offset, uint64_t userData);
+
+    /**
+    * Добавить однократное ожидание готовности дескриптора к чтению (используется для пробуждения потока)
+    * @return bool - false если очередь отправки заполнена
+    */
+    bool PreparePollIn(int file, uint64_t userData);
+
+    /**
+    * Отправить подготовленные запросы
+    * @param unsigned int waitCompletions - сколько завершений ждать (0 - не ждать)
+    * @return bool - false при ошибке системного вызова
+    */
+    bool Submit(unsigned int waitCompletions);
+
+    /**
+    * Забрать одно завершение
+    * @return bool - false если очередь завершения пуста
+    */
+    bool PopCompletion(uint64_t &userData, int32_t &result);
+
+private:
+    int m_ring = -1;
+    unsigned int m_entries = 0;
+    unsigned int m_toSubmit = 0;
+
+    void* m_sqRing = nullptr;
+    std::size_t m_sqRingSize = 0;
+    void* m_cqRing = nullptr;
+    std::size_t m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    std::size_t m_sqesSize = 0;
+
+    unsigned int* m_sqHead = nullptr;
+    unsigned int* m_sqTail = nullptr;
+    unsigned int* m_sqMask = nullptr;
+    unsigned int* m_sqArray = nullptr;
+    unsigned int* m_cqHead = nullptr;
+    unsigned int* m_cqTail = nullptr;
+    unsigned int* m_cqMask = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+
+    io_uring_sqe* NextSqe();
+    void Release();
+};
+
+#endif // KGE_IO_URING_AVAILABLE
+
+#endif // KGEIOURING_H
@@ -0,0 +1,139 @@
+#ifndef KGEJOBSYSTEM_H
+#define KGEJOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kge
+{
+    namespace jobs
+    {
+        // Подсказка привязки: задача может быть выполнена любым рабочим потоком
+        const int ANY_WORKER = -1;
+
+        struct Counter;
+
+        /**
+        * Задача системы задач
+        * - Функция (сама работа)
+        * - Счетчик, который будет уменьшен по завершении задачи (может отсутствовать)
+        * - Подсказка привязки (индекс рабочего потока, в очередь которого задача попадет в первую очередь)
+        */
+        struct Job
+        {
+            std::function<void()> function;
+            Counter* signal = nullptr;
+            int affinity = ANY_WORKER;
+        };
+
+        /**
+        * Счетчик задач. Увеличивается при постановке задачи, уменьшается при ее завершении.
+        * Используется для ожидания группы задач (KGEJobSystem::Wait) и для описания зависимостей
+        * (KGEJobSystem::RunAfter) - задачи-продолжения будут поставлены в очередь когда счетчик станет нулевым
+        */
+        struct Counter
+        {
+            std::atomic<int> value{0};
+
+            // Задачи ожидающие обнуления счетчика
+            std::mutex mutex;
+            std::vector<Job> continuations;
+
+            bool IsDone() const {
+                return value.load(std::memory_order_acquire) == 0;
+            }
+        };
+    }
+}
+
+/**
+* Система задач с "кражей работы" (work-stealing)
+* У каждого рабочего потока своя двусторонняя очередь. Владелец берет задачи с конца очереди (LIFO - данные
+* еще в кеше), простаивающие потоки "крадут" задачи с начала чужих очередей (FIFO - самые крупные/старые задачи).
+* Задачи поставленные не из рабочего потока попадают в общую очередь, которую разбирают все рабочие потоки.
+*/
+class KGEJobSystem
+{
+public:
+    /**
+    * @param unsigned int workerCount - кол-во рабочих потоков (0 - по кол-ву аппаратных потоков минус основной)
+    * @param bool pinWorkers - закрепить ли рабочие потоки за ядрами процессора (привязка к ядру i)
+    */
+    explicit KGEJobSystem(unsigned int workerCount = 0, bool pinWorkers = false);
+    ~KGEJobSystem();
+
+    KGEJobSystem(const KGEJobSystem&) = delete;
+    KGEJobSystem& operator=(const KGEJobSystem&) = delete;
+
+    /**
+    * Поставить задачу в очередь
+    * @param std::function<void()> function - работа
+    * @param kge::jobs::Counter* signal - счетчик, уменьшаемый по завершении (может быть nullptr)
+    * @param int affinity - подсказка привязки (индекс рабочего потока либо kge::jobs::ANY_WORKER)
+    */
+    void Run(std::function<void()> function,
+             kge::jobs::Counter* signal = nullptr,
+             int affinity = kge::jobs::ANY_WORKER);
+
+    /**
+    * Поставить задачу, которая начнет выполняться только после обнуления счетчика зависимости
+    * @param kge::jobs::Counter* dependency - счетчик задач, от которых зависит новая задача
+    * @note - счетчик signal увеличивается сразу, поэтому Wait(signal) учитывает и отложенные задачи
+    */
+    void RunAfter(kge::jobs::Counter* dependency,
+                  std::function<void()> function,
+                  kge::jobs::Counter* signal = nullptr,
+                  int affinity = kge::jobs::ANY_WORKER);
+
+    /**
+    * Ожидание обнуления счетчика. Ожидающий поток не простаивает, а выполняет задачи из очередей
+    */
+    void Wait(kge::jobs::Counter* counter);
+
+    /**
+    * Параллельный цикл по диапазону [0, count), разбитому на пакеты по batchSize элементов
+    * @param std::size_t count - кол-во элементов
+    * @param std::size_t batchSize - размер пакета (одна задача обрабатывает один пакет)
+    * @param function - функция обработки поддиапазона [begin, end)
+    * @note - метод возвращает управление после обработки всех пакетов
+    */
+    void ParallelFor(std::size_t count,
+                     std::size_t batchSize,
+                     const std::function<void(std::size_t begin, std::size_t end)>& function);
+
+    // Кол-во рабочих потоков
+    unsigned int WorkerCount() const;
+
+    // Индекс рабочего потока из которого вызван метод (-1 если поток не рабочий)
+    static int CurrentWorkerIndex();
+
+private:
+    // Очередь задач рабочего потока
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<kge::jobs::Job> jobs;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;   // Очереди рабочих потоков + общая очередь (последняя)
+    std::atomic<bool> m_running;
+    std::atomic<int> m_pendingJobs;                        // Кол-во задач в очередях (для усыпления потоков)
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+
+    void WorkerLoop(unsigned int workerIndex, bool pin);
+    void Enqueue(kge::jobs::Job job);
+    bool PopJob(int workerIndex, kge::jobs::Job &job);
+    void Execute(kge::jobs::Job &job);
+    void Finish(kge::jobs::Counter* signal);
+};
+
+#endif // KGEJOBSYSTEM_H
@@ -0,0 +1,267 @@
+#ifndef KGELOGGER_H
+#define KGELOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "memory/KGEMemoryTracker.h"
+
+// Кол-во записей кольцевого буфера по умолчанию (степень двойки)
+#define KGE_LOG_QUEUE_CAPACITY 4096
+
+// Максимальное кол-во аргументов одного сообщения
+#define KGE_LOG_MAX_ARGUMENTS 8
+
+// Размер области строковых аргументов записи (более длинные строки обрезаются)
+#define KGE_LOG_TEXT_BYTES 320
+
+// Минимальный уровень, вызовы ниже которого удаляются при компиляции (по умолчанию - отладочные сообщения только в отладочной сборке)
+#ifndef KGE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define KGE_LOG_MIN_LEVEL 1
+#else
+#define KGE_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// Запись сообщения с проверкой уровня при компиляции (аргументы отброшенного вызова не вычисляются)
+#define KGE_LOG_WRITE(logger, level, ...) \
+    do { if ((level) >= KGE_LOG_MIN_LEVEL) { (logger).Write((level), __VA_ARGS__); } } while (0)
+
+namespace kge
+{
+    namespace log
+    {
+        /**
+        * Уровень важности сообщения
+        */
+        enum Level : uint8_t
+        {
+            LevelDebug = 0,
+            LevelInfo = 1,
+            LevelWarning = 2,
+            LevelError = 3
+        };
+
+        /**
+        * Аргумент сообщения (значение либо участок строковой области записи)
+        */
+        struct Argument
+        {
+            enum Type : uint8_t { Signed, Unsigned, Float, Bool, Pointer, Text };
+
+            Type type = Signed;
+            union
+            {
+                int64_t i;
+                uint64_t u;
+                double d;
+                const void* p;
+                struct { uint16_t offset; uint16_t length; } text;
+            };
+        };
+
+        /**
+        * Запись сообщения. Форматирование отложено: поток-источник копирует только строку формата (указатель)
+        * и аргументы, строка сообщения собирается потоком записи
+        */
+        struct Record
+        {
+            int64_t time = 0;                           // Время (нс от начала эпохи системных часов)
+            const char* format = nullptr;               // Строка формата ("{}" - место очередного аргумента), должна существовать все время работы
+            Level level = LevelInfo;
+            bool timestamp = true;                      // Выводить ли время
+            uint8_t argumentCount = 0;
+            uint16_t textLength = 0;                    // Занятая часть строковой области
+            Argument arguments[KGE_LOG_MAX_ARGUMENTS];
+            char text[KGE_LOG_TEXT_BYTES];
+
+            void AddText(const char* data, std::size_t length)
+            {
+                std::size_t copied = std::min<std::size_t>(length, KGE_LOG_TEXT_BYTES - textLength);
+                Argument &argument = arguments[argumentCount++];
+                argument.type = Argument::Text;
+                argument.text.offset = textLength;
+                argument.text.length = static_cast<uint16_t>(copied);
+                memcpy(text + textLength, data, copied);
+                textLength = static_cast<uint16_t>(textLength + copied);
+            }
+
+            void Add(const std::string &value) { AddText(value.data(), value.size()); }
+            void Add(std::string_view value) { AddText(value.data(), value.size()); }
+            void Add(const char* value) { AddText(value != nullptr ? value : "(null)", value != nullptr ? strlen(value) : 6); }
+            void Add(char* value) { Add(static_cast<const char*>(value)); }
+            void Add(char value) { AddText(&value, 1); }
+
+            template <typename T>
+            void Add(const T &value)
+            {
+                Argument &argument = arguments[argumentCount++];
+                if constexpr (std::is_same<T, bool>::value) {
+                    argument.type = Argument::Bool;
+                    argument.u = value ? 1 : 0;
+                }
+                else if constexpr (std::is_floating_point<T>::value) {
+                    argument.type = Argument::Float;
+                    argument.d = static_cast<double>(value);
+                }
+                else if constexpr (std::is_enum<T>::value) {
+                    argument.type = Argument::Signed;
+                    argument.i = static_cast<int64_t>(value);
+                }
+                else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+                    argument.type = Argument::Signed;
+                    argument.i = static_cast<int64_t>(value);
+                }
+                else if constexpr (std::is_integral<T>::value) {
+                    argument.type = Argument::Unsigned;
+                    argument.u = static_cast<uint64_t>(value);
+                }
+                else {
+                    static_assert(std::is_pointer<T>::value, "Log: Unsupported argument type");
+                    argument.type = Argument::Pointer;
+                    argument.p = static_cast<const void*>(value);
+                }
+            }
+        };
+    }
+}
+
+/**
+* Асинхронный журнал
+* Потоки-источники кладут записи в ограниченный кольцевой буфер без блокировок (несколько писателей, один читатель),
+* а фоновый поток форматирует их и пишет в консоль и файл. Источник не ждет ни ввода-вывода, ни других источников:
+* запись сообщения - проверка уровня, захват ячейки одной атомарной операцией и копирование аргументов.
+* Если буфер заполнен, сообщение отбрасывается (кол-во отброшенных выводится в журнал)
+*/
+class KGELogger
+{
+public:
+    /**
+    * @param const std::string &file - файл журнала (дописывается; пустая строка - только консоль)
+    * @param std::size_t capacity - кол-во записей кольцевого буфера (округляется вверх до степени двойки)
+    */
+    explicit KGELogger(const std::string &file = "", std::size_t capacity = KGE_LOG_QUEUE_CAPACITY);
+
+    /**
+    * @note - дожидается записи всех сообщений буфера
+    */
+    ~KGELogger();
+
+    KGELogger(const KGELogger&) = delete;
+    KGELogger& operator=(const KGELogger&) = delete;
+
+    /**
+    * Запись сообщения
+    * @param kge::log::Level level - уровень важности
+    * @param const char* format - строка формата ("{}" заменяется очередным аргументом); указатель сохраняется до записи,
+    * поэтому формат - строковый литерал, а не временная строка
+    * @param const Args&... args - аргументы (числа, bool, указатели, строки - строки копируются)
+    */
+    template <typename... Args>
+    void Write(kge::log::Level level, const char* format, const Args&... args)
+    {
+        Push(level, true, format, args...);
+    }
+
+    /**
+    * Запись сообщения без времени
+    */
+    template <typename... Args>
+    void WriteUntimed(kge::log::Level level, const char* format, const Args&... args)
+    {
+        Push(level, false, format, args...);
+    }
+
+    /**
+    * Минимальный уровень записываемых сообщений (проверяется при каждом вызове, можно менять во время работы)
+    */
+    void SetLevel(kge::log::Level level);
+    kge::log::Level level() const;
+
+    bool Enabled(kge::log::Level level) const
+    {
+        return level >= m_level.load(std::memory_order_relaxed);
+    }
+
+    // Кол-во сообщений, отброшенных из-за заполненного буфера
+    uint64_t droppedCount() const;
+
+private:
+    /**
+    * Ячейка кольцевого буфера. Номер последовательности сообщает состояние: равен позиции - ячейка свободна для
+    * этой позиции, позиция + 1 - запись опубликована и ждет читателя
+    */
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> sequence;
+        kge::log::Record record;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    uint64_t m_mask;
+    alignas(64) std::atomic<uint64_t> m_enqueuePosition;    // Следующая позиция записи (общая для источников)
+    alignas(64) uint64_t m_dequeuePosition;                 // Следующая позиция чтения (только поток записи)
+    alignas(64) std::atomic<uint64_t> m_dropped;
+    std::atomic<int> m_level;
+
+    std::thread m_writer;
+    std::atomic<bool> m_stopping;
+    std::mutex m_wakeMutex;                                 // Только для ожидания потока записи (источники его не захватывают)
+    std::condition_variable m_wakeCondition;
+
+    std::ofstream m_file;
+    std::string m_buffer;                                   // Отформатированные сообщения очередной порции
+    int64_t m_cachedSecond = -1;                            // Секунда, для которой отформатировано время (strftime - раз в секунду)
+    char m_cachedTime[32] = {};
+    uint64_t m_reportedDropped = 0;
+
+    template <typename... Args>
+    void Push(kge::log::Level level, bool timestamp, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= KGE_LOG_MAX_ARGUMENTS, "Log: Too many arguments");
+
+        if (!Enabled(level)) {
+            return;
+        }
+
+        uint64_t position;
+        Cell* cell = Claim(position);
+        if (cell == nullptr) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        kge::log::Record &record = cell->record;
+        record.time = Now();
+        record.format = format;
+        record.level = level;
+        record.timestamp = timestamp;
+        record.argumentCount = 0;
+        record.textLength = 0;
+        (record.Add(args), ...);
+
+        cell->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    Cell* Claim(uint64_t &position);
+    static int64_t Now();
+
+    void WriterLoop();
+    bool Drain();
+    void Format(const kge::log::Record &record);
+    void Flush();
+};
+
+#endif // KGELOGGER_H
@@ -0,0 +1,119 @@
+#ifndef KGEBVH_H
+#define KGEBVH_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <jobs/KGEJobSystem.h>
+#include <math/KGEFrustumCuller.h>
+
+namespace kge
+{
+    namespace math
+    {
+        /**
+        * Выровненный по осям ограничивающий параллелепипед
+        */
+        struct Aabb
+        {
+            float min[3] = { 0.0f, 0.0f, 0.0f };
+            float max[3] = { 0.0f, 0.0f, 0.0f };
+        };
+
+        /**
+        * Результат пересечения луча
+        */
+        struct RayHit
+        {
+            uint32_t object = UINT32_MAX;   // Индекс объекта (UINT32_MAX - пересечений нет)
+            float distance = 0.0f;          // Расстояние до точки входа в AABB объекта (в длинах направления луча)
+        };
+    }
+}
+
+/**
+* Иерархия ограничивающих объемов (BVH) над AABB объектов сцены
+* - Построение: разбиение по SAH (эвристика площади поверхности) с корзинами, крупные поддеревья строятся
+*   параллельно в системе задач
+* - Обновление: перемещенные объекты помечаются (Update), Refit пересчитывает только их листья и предков,
+*   поэтому стоимость пропорциональна кол-ву перемещенных объектов (и глубине дерева), а не размеру сцены.
+*   Топология при этом не меняется - после массовых перемещений или добавления объектов дерево нужно перестроить
+* - Запросы: пирамида видимости, пересечение с AABB, ближайшее пересечение луча (по AABB объектов)
+*/
+class KGEBvh
+{
+public:
+    KGEBvh();
+
+    /**
+    * Построение дерева
+    * @param const std::vector<kge::math::Aabb> &bounds - AABB объектов (индекс в массиве - индекс объекта)
+    * @param KGEJobSystem* jobSystem - система задач для параллельного построения (nullptr - в вызывающем потоке)
+    */
+    void Build(const std::vector<kge::math::Aabb> &bounds, KGEJobSystem* jobSystem = nullptr);
+
+    /**
+    * Изменить AABB объекта (дерево обновится при вызове Refit)
+    */
+    void Update(uint32_t object, const kge::math::Aabb &bounds);
+
+    /**
+    * Пересчет границ листьев перемещенных объектов и их предков
+    */
+    void Refit();
+
+    /**
+    * Объекты, чьи AABB хотя бы частично внутри пирамиды видимости
+    * @note - поддеревья, целиком попавшие внутрь, добавляются без дальнейших проверок
+    */
+    void QueryFrustum(const kge::math::Frustum &frustum, std::vector<uint32_t> &objects) const;
+
+    // Объекты, чьи AABB пересекаются с заданным
+    void QueryOverlap(const kge::math::Aabb &bounds, std::vector<uint32_t> &objects) const;
+
+    /**
+    * Ближайшее пересечение луча с AABB объектов
+    * @param const float origin[3] - начало луча
+    * @param const float direction[3] - направление луча (не обязательно нормализованное)
+    * @param float maxDistance - максимальное расстояние (в длинах направления)
+    * @return kge::math::RayHit - результат (object == UINT32_MAX если пересечений нет)
+    */
+    kge::math::RayHit Raycast(const float origin[3], const float direction[3], float maxDistance) const;
+
+    // Кол-во объектов
+    uint32_t objectCount() const;
+
+    // Кол-во узлов
+    uint32_t nodeCount() const;
+
+private:
+    /**
+    * Узел дерева. Объекты поддерева лежат в m_objects подряд: [first, first + count)
+    * Потомки внутреннего узла - left и left + 1, у листа left == 0 (корень не бывает потомком)
+    */
+    struct Node
+    {
+        kge::math::Aabb bounds;
+        uint32_t first = 0;
+        uint32_t count = 0;
+        uint32_t left = 0;
+        uint32_t parent = UINT32_MAX;
+    };
+
+    std::vector<Node> m_nodes;
+    std::atomic<uint32_t> m_nodesUsed;
+    std::vector<uint32_t> m_objects;            // Индексы объектов в порядке листьев
+    std::vector<kge::math::Aabb> m_bounds;      // AABB объектов
+    std::vector<uint32_t> m_objectLeaf;         // Лист, в котором лежит объект
+    std::vector<uint32_t> m_dirtyLeaves;        // Листья перемещенных объектов
+    std::vector<uint8_t> m_leafDirty;           // Отметка "лист уже в списке" (по индексу узла)
+
+    void BuildNode(uint32_t nodeIndex,
+                   const std::vector<float> &centroids,
+                   KGEJobSystem* jobSystem,
+                   kge::jobs::Counter* counter);
+    void ComputeNodeBounds(Node &node) const;
+};
+
+#endif // KGEBVH_H
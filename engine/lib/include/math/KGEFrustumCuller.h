@@ -0,0 +1,81 @@
+#ifndef KGEFRUSTUMCULLER_H
+#define KGEFRUSTUMCULLER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace kge
+{
+    namespace math
+    {
+        /**
+        * Плоскость (a*x + b*y + c*z + d = 0), нормаль направлена внутрь пирамиды видимости
+        */
+        struct Plane
+        {
+            float a = 0.0f;
+            float b = 0.0f;
+            float c = 0.0f;
+            float d = 0.0f;
+        };
+
+        /**
+        * Пирамида видимости (левая, правая, нижняя, верхняя, ближняя, дальняя плоскости)
+        */
+        struct Frustum
+        {
+            Plane planes[6];
+        };
+
+        /**
+        * Получить плоскости пирамиды видимости из матрицы "проекция * вид" (метод Gribb-Hartmann)
+        * @param const float* viewProjection - матрица 4x4 по столбцам (как в glm, т.е. &matrix[0][0])
+        * @return Frustum - нормализованные плоскости
+        *
+        * @note - ближняя плоскость берется для глубины [-w, w], поэтому при глубине [0, w] отсечение остается
+        * консервативным (ничего видимого не отбрасывается)
+        */
+        Frustum ExtractFrustum(const float* viewProjection);
+    }
+}
+
+/**
+* Отсечение ограничивающих сфер по пирамиде видимости
+* Сферы хранятся в виде структуры массивов (отдельно X, Y, Z центров и радиусы), что позволяет
+* проверять по 4 сферы за раз (SSE). Индекс сферы совпадает с индексом объекта, которому она принадлежит
+*/
+class KGEFrustumCuller
+{
+public:
+    KGEFrustumCuller() = default;
+
+    /**
+    * Добавить сферу
+    * @return unsigned int - индекс сферы
+    */
+    unsigned int Add(float x, float y, float z, float radius);
+
+    // Изменить сферу по индексу
+    void Set(unsigned int index, float x, float y, float z, float radius);
+
+    // Удалить все сферы
+    void Clear();
+
+    // Кол-во сфер
+    unsigned int count() const;
+
+    /**
+    * Отсечение
+    * @param const kge::math::Frustum &frustum - пирамида видимости
+    * @param std::vector<uint32_t> &visible - индексы видимых (хотя бы частично) сфер в порядке возрастания
+    */
+    void Cull(const kge::math::Frustum &frustum, std::vector<uint32_t> &visible) const;
+
+private:
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_radius;
+};
+
+#endif // KGEFRUSTUMCULLER_H
@@ -0,0 +1,183 @@
+#ifndef KGEMEMORYTRACKER_H
+#define KGEMEMORYTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Максимальное кол-во куч памяти устройства (совпадает с VK_MAX_MEMORY_HEAPS)
+#define KGE_MEMORY_DEVICE_HEAPS 16
+
+namespace kge
+{
+    namespace memory
+    {
+        /**
+        * Подсистема, за которой учитывается память хоста
+        */
+        enum Tag : uint8_t
+        {
+            TagGeneral = 0,
+            TagRenderer,        // Массивы рендерера в памяти хоста (напр. матрицы динамического UBO)
+            TagTextures,        // Декодированные изображения
+            TagVulkan,          // Память драйвера Vulkan (VkAllocationCallbacks)
+            TagLog,             // Кольцевой буфер журнала
+            TagProfiler,        // Буферы зон профилировщика
+            TagCount
+        };
+
+        /**
+        * Счетчики одной подсистемы либо кучи устройства (байты)
+        */
+        struct Usage
+        {
+            uint64_t current = 0;       // Занято сейчас
+            uint64_t peak = 0;          // Максимум за время работы
+            uint64_t allocations = 0;   // Кол-во живых выделений
+        };
+
+        /**
+        * Куча памяти устройства
+        */
+        struct DeviceHeap
+        {
+            uint64_t size = 0;          // Размер кучи (0 - куча не зарегистрирована)
+            bool deviceLocal = false;   // Локальная память устройства (иначе - память хоста, видимая устройству)
+            Usage usage;
+        };
+    }
+}
+
+/**
+* Учет памяти движка
+* - Память хоста считается по подсистемам (тегам): выделения через кучу трекера (Allocate / Free, заголовок блока хранит
+*   тег и размер), через STL-аллокатор KGETaggedAllocator либо ручной учет (Track / Untrack) для буферов, выделенных иначе
+* - Память устройства считается по кучам (регистрирует и пополняет рендерер, см. kge::vkutility::AllocateMemory)
+* Счетчики - атомарные (без блокировок) и инициализируются статически, поэтому учет работает и для статических объектов
+*/
+class KGEMemoryTracker
+{
+public:
+    /**
+    * Выделение памяти с учетом
+    * @param kge::memory::Tag tag - подсистема
+    * @param std::size_t size - размер блока
+    * @param std::size_t alignment - выравнивание (степень двойки)
+    * @return void* - блок либо nullptr, если память не выделилась
+    */
+    static void* Allocate(kge::memory::Tag tag, std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    /**
+    * Изменение размера блока (содержимое сохраняется в пределах меньшего из размеров)
+    * @param kge::memory::Tag tag - подсистема (для нового блока, если pointer = nullptr)
+    * @param void* pointer - блок (Allocate) либо nullptr
+    * @param std::size_t size - новый размер (0 - освободить блок)
+    * @param std::size_t alignment - выравнивание
+    * @return void* - новый блок либо nullptr (при ошибке исходный блок не освобождается)
+    */
+    static void* Reallocate(kge::memory::Tag tag, void* pointer, std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    /**
+    * Освобождение блока, выделенного Allocate / Reallocate (nullptr допускается)
+    */
+    static void Free(void* pointer);
+
+    /**
+    * Ручной учет памяти, выделенной в обход кучи трекера
+    */
+    static void Track(kge::memory::Tag tag, std::size_t size);
+    static void Untrack(kge::memory::Tag tag, std::size_t size);
+
+    /**
+    * Регистрация кучи устройства
+    * @param uint32_t heap - индекс кучи
+    * @param uint64_t size - размер кучи
+    * @param bool deviceLocal - локальная ли память устройства
+    */
+    static void SetDeviceHeap(uint32_t heap, uint64_t size, bool deviceLocal);
+
+    /**
+    * Учет выделения и освобождения памяти устройства
+    */
+    static void TrackDevice(uint32_t heap, uint64_t size);
+    static void UntrackDevice(uint32_t heap, uint64_t size);
+
+    /**
+    * Счетчики подсистемы
+    */
+    static kge::memory::Usage usage(kge::memory::Tag tag);
+
+    /**
+    * Куча устройства (размер 0 - куча не зарегистрирована)
+    */
+    static kge::memory::DeviceHeap deviceHeap(uint32_t heap);
+
+    /**
+    * Имя подсистемы (для отчетов)
+    */
+    static const char* TagName(kge::memory::Tag tag);
+
+private:
+    /**
+    * Атомарные счетчики (отдельная строка кэша - подсистемы не мешают друг другу)
+    */
+    struct alignas(64) Counter
+    {
+        std::atomic<uint64_t> current{0};
+        std::atomic<uint64_t> peak{0};
+        std::atomic<uint64_t> allocations{0};
+
+        void Add(uint64_t size);
+        void Remove(uint64_t size);
+        kge::memory::Usage Load() const;
+    };
+
+    static Counter s_tags[kge::memory::TagCount];
+    static Counter s_deviceHeaps[KGE_MEMORY_DEVICE_HEAPS];
+    static std::atomic<uint64_t> s_deviceHeapSizes[KGE_MEMORY_DEVICE_HEAPS];
+    static std::atomic<bool> s_deviceHeapLocal[KGE_MEMORY_DEVICE_HEAPS];
+};
+
+/**
+* STL-аллокатор с учетом памяти по подсистеме (напр. std::vector<T, KGETaggedAllocator<T, kge::memory::TagRenderer>>)
+* @note - размер освобождаемого блока известен контейнеру, поэтому заголовок не нужен - только счетчики
+*/
+template <typename T, kge::memory::Tag TAG>
+class KGETaggedAllocator
+{
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef KGETaggedAllocator<U, TAG> other;
+    };
+
+    KGETaggedAllocator() = default;
+
+    template <typename U>
+    KGETaggedAllocator(const KGETaggedAllocator<U, TAG>&) {}
+
+    T* allocate(std::size_t count)
+    {
+        T* pointer = static_cast<T*>(::operator new(count * sizeof(T)));
+        KGEMemoryTracker::Track(TAG, count * sizeof(T));
+        return pointer;
+    }
+
+    void deallocate(T* pointer, std::size_t count)
+    {
+        KGEMemoryTracker::Untrack(TAG, count * sizeof(T));
+        ::operator delete(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const KGETaggedAllocator<U, TAG>&) const { return true; }
+
+    template <typename U>
+    bool operator!=(const KGETaggedAllocator<U, TAG>&) const { return false; }
+};
+
+#endif // KGEMEMORYTRACKER_H
@@ -0,0 +1,145 @@
+#ifndef KGEMESHOPTIMIZER_H
+#define KGEMESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Размер FIFO кэша преобразованных вершин, по которому считается статистика (типичный для современных GPU)
+#define KGE_VERTEX_CACHE_SIZE 16
+
+namespace kge
+{
+    namespace mesh
+    {
+        /**
+        * Статистика кэша преобразованных вершин (модель FIFO кэша)
+        */
+        struct VertexCacheStats
+        {
+            uint32_t vertexTransforms = 0;  // Кол-во вызовов вершинного шейдера (промахов кэша)
+            float acmr = 0.0f;              // Промахов на треугольник (ACMR, не меньше 0.5 у сеток без дыр)
+            float atvr = 0.0f;              // Промахов на вершину (ATVR, идеал - 1)
+        };
+
+        /**
+        * Статистика до и после оптимизации
+        */
+        struct OptimizationReport
+        {
+            VertexCacheStats before;
+            VertexCacheStats after;
+        };
+
+        /**
+        * Статистика кэша вершин для порядка треугольников
+        * @param const std::vector<uint32_t> &indices - индексы (по 3 на треугольник)
+        * @param uint32_t vertexCount - кол-во вершин
+        * @param uint32_t cacheSize - размер кэша
+        */
+        VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t> &indices,
+                                             uint32_t vertexCount,
+                                             uint32_t cacheSize = KGE_VERTEX_CACHE_SIZE);
+
+        /**
+        * Переупорядочивание треугольников под кэш вершин (алгоритм Т. Форсайта)
+        * Жадно выбирается треугольник с наибольшей оценкой: вершины, недавно попавшие в кэш, и вершины с малым
+        * кол-вом оставшихся треугольников (чтобы не оставлять "хвостов") ценятся выше
+        * @param std::vector<uint32_t> &indices - индексы (переупорядочиваются на месте)
+        * @param uint32_t vertexCount - кол-во вершин
+        */
+        void OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+        /**
+        * Упорядочивание кластеров треугольников для уменьшения перерисовки
+        * Порядок, оптимизированный под кэш, разбивается на кластеры в точках, где кэш и так "холодный" (все три вершины
+        * треугольника - промахи), поэтому перестановка кластеров почти не ухудшает ACMR. Кластеры, обращенные наружу
+        * от центра сетки, рисуются первыми - они чаще закрывают остальные
+        * @param std::vector<uint32_t> &indices - индексы после OptimizeVertexCache (переупорядочиваются на месте)
+        * @param const float* positions - позиции вершин (3 float)
+        * @param std::size_t positionStride - шаг между позициями в байтах
+        * @param uint32_t vertexCount - кол-во вершин
+        */
+        void OptimizeOverdraw(std::vector<uint32_t> &indices,
+                              const float* positions,
+                              std::size_t positionStride,
+                              uint32_t vertexCount);
+
+        /**
+        * Перенумерация вершин в порядке первого обращения (последовательная выборка вершин)
+        * @param std::vector<uint32_t> &indices - индексы (переписываются на новые номера)
+        * @param uint32_t vertexCount - кол-во вершин
+        * @param std::vector<uint32_t> &remap - новый номер каждой вершины (UINT32_MAX - вершина не используется)
+        * @return uint32_t - кол-во используемых вершин
+        */
+        uint32_t OptimizeVertexFetchRemap(std::vector<uint32_t> &indices,
+                                          uint32_t vertexCount,
+                                          std::vector<uint32_t> &remap);
+
+        /**
+        * Перестановка вершин по таблице OptimizeVertexFetchRemap (неиспользуемые вершины отбрасываются)
+        */
+        template <typename T>
+        void RemapVertices(std::vector<T> &vertices, const std::vector<uint32_t> &remap, uint32_t usedCount)
+        {
+            std::vector<T> result(usedCount);
+            for (std::size_t i = 0; i < vertices.size(); i++) {
+                if (remap[i] != UINT32_MAX) {
+                    result[remap[i]] = vertices[i];
+                }
+            }
+            vertices.swap(result);
+        }
+
+        /**
+        * Упрощение сетки стягиванием ребер по квадрикам ошибки (Garland-Heckbert)
+        * Вершина стягивается в одну из соседних, поэтому результат ссылается на тот же массив вершин.
+        * Вершины на границах (в т.ч. на швах текстурных координат - там вершины продублированы) не двигаются,
+        * стягивания, переворачивающие треугольники, отбрасываются
+        * @param const std::vector<uint32_t> &indices - исходные индексы
+        * @param const float* positions - позиции вершин (3 float)
+        * @param std::size_t positionStride - шаг между позициями в байтах
+        * @param uint32_t vertexCount - кол-во вершин
+        * @param std::size_t targetIndexCount - желаемое кол-во индексов
+        * @param float maxError - наибольшее допустимое отклонение (в единицах позиций)
+        * @param std::vector<uint32_t> &result - индексы упрощенной сетки
+        * @return float - отклонение упрощенной сетки от исходной (оценка сверху среднеквадратичного расстояния
+        * до плоскостей исходных треугольников), подходит как ошибка уровня детализации
+        */
+        float Simplify(const std::vector<uint32_t> &indices,
+                       const float* positions,
+                       std::size_t positionStride,
+                       uint32_t vertexCount,
+                       std::size_t targetIndexCount,
+                       float maxError,
+                       std::vector<uint32_t> &result);
+
+        /**
+        * Полная оптимизация сетки: кэш вершин, перерисовка, выборка вершин
+        * @param std::vector<T> &vertices - вершины (переставляются, неиспользуемые отбрасываются)
+        * @param std::vector<uint32_t> &indices - индексы
+        * @param std::size_t positionOffset - смещение позиции (3 float) внутри вершины
+        * @return OptimizationReport - статистика кэша вершин до и после
+        */
+        template <typename T>
+        OptimizationReport OptimizeMesh(std::vector<T> &vertices, std::vector<uint32_t> &indices, std::size_t positionOffset = 0)
+        {
+            OptimizationReport report;
+            uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+            report.before = AnalyzeVertexCache(indices, vertexCount);
+
+            const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(vertices.data()) + positionOffset);
+            OptimizeVertexCache(indices, vertexCount);
+            OptimizeOverdraw(indices, positions, sizeof(T), vertexCount);
+
+            std::vector<uint32_t> remap;
+            uint32_t usedCount = OptimizeVertexFetchRemap(indices, vertexCount, remap);
+            RemapVertices(vertices, remap, usedCount);
+
+            report.after = AnalyzeVertexCache(indices, usedCount);
+            return report;
+        }
+    }
+}
+
+#endif // KGEMESHOPTIMIZER_H
@@ -0,0 +1,176 @@
+#ifndef KGEPROFILER_H
+#define KGEPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "memory/KGEMemoryTracker.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Кол-во зон в буфере одного потока (степень двойки; при переполнении перезаписываются самые старые)
+#define KGE_PROFILE_THREAD_EVENTS 32768
+
+// Зоны компилируются, если не отключены при сборке (-DKGE_PROFILE_ENABLED=0)
+#ifndef KGE_PROFILE_ENABLED
+#define KGE_PROFILE_ENABLED 1
+#endif
+
+#define KGE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define KGE_PROFILE_CONCAT(a, b) KGE_PROFILE_CONCAT_IMPL(a, b)
+
+// Зона профилирования до конца текущей области видимости (имя - строковый литерал)
+#if KGE_PROFILE_ENABLED
+#define KGE_PROFILE_ZONE(name) KGEProfileZone KGE_PROFILE_CONCAT(kgeProfileZone, __LINE__){ name }
+#else
+#define KGE_PROFILE_ZONE(name) ((void)0)
+#endif
+
+namespace kge
+{
+    namespace profile
+    {
+        /**
+        * Завершенная зона (метки времени - такты счетчика профилировщика, см. KGEProfiler::Timestamp)
+        */
+        struct Event
+        {
+            const char* name = nullptr;
+            uint64_t start = 0;
+            uint64_t end = 0;
+        };
+
+        /**
+        * Буфер зон одного потока. Пишет только поток-владелец, счетчик записей публикуется с release -
+        * экспорт читает буфер без блокировок (см. KGEProfiler::ExportChromeTrace)
+        */
+        struct ThreadBuffer
+        {
+            uint32_t thread = 0;                        // Номер потока в трассе
+            std::string name;                           // Имя потока (под мьютексом профилировщика)
+            std::vector<Event, KGETaggedAllocator<Event, kge::memory::TagProfiler>> events;
+            std::atomic<uint64_t> written{0};           // Кол-во записанных зон (за все время, позиция - по модулю размера)
+        };
+    }
+}
+
+/**
+* Иерархический профилировщик процессорного времени
+* Зона (KGE_PROFILE_ZONE / KGEProfileZone) запоминает время начала и при выходе из области видимости пишет событие в буфер
+* своего потока - без блокировок и без выделения памяти. Вложенность зон восстанавливается по времени (вложенная зона
+* лежит внутри внешней на той же линии потока). Время - счетчик тактов процессора (rdtsc) либо steady_clock,
+* переводится в микросекунды при экспорте. Выключенный профилировщик стоит одной загрузки флага на зону
+*/
+class KGEProfiler
+{
+public:
+    /**
+    * Профилировщик процесса (создается при первом обращении)
+    */
+    static KGEProfiler& Instance();
+
+    KGEProfiler(const KGEProfiler&) = delete;
+    KGEProfiler& operator=(const KGEProfiler&) = delete;
+
+    /**
+    * Включение и выключение записи зон (можно переключать во время работы)
+    */
+    void Enable(bool enable);
+
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * Имя текущего потока в трассе (напр. "Main", "Worker 2")
+    */
+    void SetThreadName(const std::string &name);
+
+    /**
+    * Запись завершенной зоны в буфер текущего потока
+    * @param const char* name - имя зоны (строковый литерал - указатель хранится до экспорта)
+    * @param uint64_t start - время начала (Timestamp)
+    * @param uint64_t end - время окончания (Timestamp)
+    */
+    void Record(const char* name, uint64_t start, uint64_t end);
+
+    /**
+    * Экспорт записанных зон в формате Chrome trace (JSON, открывается в chrome://tracing и Perfetto)
+    * @param const std::string &path - путь к файлу трассы
+    * @note - вызывается из любого потока, запись зон не останавливается. Бросает исключение, если файл не открылся
+    */
+    void ExportChromeTrace(const std::string &path);
+
+    /**
+    * Удаление записанных зон
+    * @note - вызывается, когда зоны не пишутся (профилировщик выключен и открытые зоны завершены)
+    */
+    void Clear();
+
+    /**
+    * Текущее время в тактах счетчика профилировщика
+    */
+    static uint64_t Timestamp()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+private:
+    KGEProfiler();
+
+    static std::atomic<bool> s_enabled;
+
+    std::mutex m_mutex;                                                 // Регистрация потоков и экспорт
+    std::vector<std::unique_ptr<kge::profile::ThreadBuffer>> m_threads; // Буферы живут до конца процесса (потоки могут завершиться раньше экспорта)
+    uint64_t m_baseTicks;                                               // Точка отсчета трассы и калибровки счетчика
+    std::chrono::steady_clock::time_point m_baseTime;
+
+    kge::profile::ThreadBuffer* CurrentThread();
+};
+
+/**
+* Зона профилирования (RAII): от создания до уничтожения объекта
+* @note - состояние профилировщика запоминается при входе - зона, начатая до выключения, завершается корректно
+*/
+class KGEProfileZone
+{
+    const char* m_name;
+    uint64_t m_start;
+    bool m_active;
+
+public:
+    explicit KGEProfileZone(const char* name):
+        m_name{name},
+        m_start{0},
+        m_active{KGEProfiler::enabled()}
+    {
+        if (m_active) {
+            m_start = KGEProfiler::Timestamp();
+        }
+    }
+
+    ~KGEProfileZone()
+    {
+        if (m_active) {
+            KGEProfiler::Instance().Record(m_name, m_start, KGEProfiler::Timestamp());
+        }
+    }
+
+    KGEProfileZone(const KGEProfileZone&) = delete;
+    KGEProfileZone& operator=(const KGEProfileZone&) = delete;
+};
+
+#endif // KGEPROFILER_H
@@ -0,0 +1,113 @@
+#ifndef KGESCENEGRAPH_H
+#define KGESCENEGRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+namespace kge
+{
+    namespace scene
+    {
+        // Идентификатор узла (не меняется при пересортировке узлов)
+        typedef uint32_t NodeId;
+
+        // Отсутствие узла (в т.ч. отсутствие родителя)
+        const NodeId INVALID_NODE = UINT32_MAX;
+
+        /**
+        * Матрица 4x4 по столбцам (совпадает по раскладке с glm::mat4, можно копировать напрямую)
+        */
+        struct Matrix4
+        {
+            float m[16] = { 1.0f, 0.0f, 0.0f, 0.0f,
+                            0.0f, 1.0f, 0.0f, 0.0f,
+                            0.0f, 0.0f, 1.0f, 0.0f,
+                            0.0f, 0.0f, 0.0f, 1.0f };
+        };
+    }
+}
+
+/**
+* Иерархия преобразований сцены
+* - Узлы хранятся плоскими массивами, отсортированными по глубине (родитель всегда раньше потомков)
+* - Изменение локального преобразования или родителя помечает узел. Update одним линейным проходом
+*   пересчитывает мировые матрицы помеченных узлов и всех их потомков (пометка родителя передается потомкам),
+*   остальные узлы не пересчитываются
+* - Узлы, чья мировая матрица изменилась в последнем Update, можно узнать через changed (например, чтобы
+*   скопировать в uniform-буфер только их матрицы)
+* - Удаленные узлы оставляют свободные позиции, которые занимают новые узлы (если это не нарушает порядок
+*   "родитель раньше потомков"). Когда свободных позиций больше половины - массивы уплотняются в ближайшем Update
+*/
+class KGESceneGraph
+{
+public:
+    KGESceneGraph() = default;
+
+    /**
+    * Создание узла (локальное преобразование - единичная матрица)
+    * @param kge::scene::NodeId parent - родитель (INVALID_NODE - корневой узел)
+    * @return kge::scene::NodeId - идентификатор узла
+    */
+    kge::scene::NodeId CreateNode(kge::scene::NodeId parent = kge::scene::INVALID_NODE);
+
+    /**
+    * Удаление узла (идентификатор может быть выдан повторно)
+    * @param kge::scene::NodeId node - узел
+    * @note - потомки узла становятся корневыми, их локальные преобразования далее считаются относительно глобального центра
+    */
+    void DestroyNode(kge::scene::NodeId node);
+
+    /**
+    * Смена родителя (мировая матрица узла будет пересчитана в Update)
+    * @param kge::scene::NodeId node - узел
+    * @param kge::scene::NodeId parent - новый родитель (INVALID_NODE - сделать корневым)
+    * @note - родителем не может быть сам узел или его потомок
+    */
+    void SetParent(kge::scene::NodeId node, kge::scene::NodeId parent);
+
+    /**
+    * Изменение локального преобразования (относительно родителя)
+    * @param const float* local - матрица 4x4 по столбцам (&matrix[0][0] для glm)
+    */
+    void SetLocalTransform(kge::scene::NodeId node, const float* local);
+
+    /**
+    * Пересчет мировых матриц помеченных поддеревьев
+    */
+    void Update();
+
+    // Мировая матрица узла (на момент последнего Update)
+    const kge::scene::Matrix4& worldTransform(kge::scene::NodeId node) const;
+
+    // Изменилась ли мировая матрица узла в последнем Update
+    bool changed(kge::scene::NodeId node) const;
+
+    // Родитель узла
+    kge::scene::NodeId parent(kge::scene::NodeId node) const;
+
+    // Кол-во узлов (без удаленных)
+    uint32_t nodeCount() const;
+
+private:
+    // Данные узлов по позиции в отсортированном по глубине порядке
+    std::vector<uint32_t> m_parentSlot;                  // Позиция родителя (UINT32_MAX у корневых)
+    std::vector<uint32_t> m_depth;                       // Глубина (0 у корневых)
+    std::vector<kge::scene::Matrix4> m_local;            // Локальные матрицы
+    std::vector<kge::scene::Matrix4> m_world;            // Мировые матрицы
+    std::vector<uint8_t> m_dirty;                        // Локальное преобразование либо родитель изменены
+    std::vector<uint8_t> m_changed;                      // Мировая матрица изменилась в последнем Update
+    std::vector<uint32_t> m_childCount;                  // Кол-во непосредственных потомков
+
+    std::vector<kge::scene::NodeId> m_slotNode;          // Позиция -> идентификатор (INVALID_NODE у свободных позиций)
+    std::vector<uint32_t> m_nodeSlot;                    // Идентификатор -> позиция (UINT32_MAX у удаленных)
+    std::vector<uint32_t> m_freeSlots;                   // Позиции удаленных узлов
+    std::vector<kge::scene::NodeId> m_freeNodes;         // Идентификаторы удаленных узлов
+
+    bool m_orderDirty = false;                           // Порядок по глубине нарушен (пересортировка в Update)
+    bool m_anyDirty = false;                             // Есть помеченные узлы
+    bool m_anyChanged = false;                           // В последнем Update изменилась хотя бы одна матрица
+
+    void SortByDepth();
+};
+
+#endif // KGESCENEGRAPH_H
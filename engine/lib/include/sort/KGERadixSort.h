@@ -0,0 +1,27 @@
+#ifndef KGERADIXSORT_H
+#define KGERADIXSORT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace kge
+{
+    namespace sort
+    {
+        /**
+        * Сортировка пар (ключ, значение) по возрастанию 64-битного ключа
+        * Поразрядная (LSD) по байтам: устойчивая, O(n) на проход. Проходы по байтам, одинаковым у всех ключей, пропускаются,
+        * поэтому ключи с узким диапазоном (например, несколько текстур и геометрий) сортируются за 2-4 прохода
+        * @param std::vector<uint64_t> &keys - ключи
+        * @param std::vector<uint32_t> &values - значения (переставляются вместе с ключами)
+        * @param std::vector<uint64_t> &keysScratch - временный массив (переиспользуется между вызовами, чтобы не выделять память)
+        * @param std::vector<uint32_t> &valuesScratch - временный массив значений
+        */
+        void RadixSort(std::vector<uint64_t> &keys,
+                       std::vector<uint32_t> &values,
+                       std::vector<uint64_t> &keysScratch,
+                       std::vector<uint32_t> &valuesScratch);
+    }
+}
+
+#endif // KGERADIXSORT_H
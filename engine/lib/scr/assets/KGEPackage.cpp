@@ -0,0 +1,219 @@
+#include "assets/KGEPackage.h"
+#include "profile/KGEProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t kge::pak::HashName(const std::string &name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+* Открытие пакета
+* @note - отображение только для чтения, страницы подгружаются системой при первом обращении. Подсказка
+* MADV_WILLNEED запускает упреждающее чтение, пока вызывающий разбирает таблицу
+*/
+KGEPackage::KGEPackage(const std::string &path):
+    m_path{path}
+{
+    KGE_PROFILE_ZONE("KGEPackage::KGEPackage");
+#ifndef _WIN32
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error("Package: Can't open " + path);
+    }
+
+    struct stat fileStat = {};
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(kge::pak::PackageHeader))) {
+        close(file);
+        throw std::runtime_error("Package: " + path + " is not a package");
+    }
+
+    m_size = static_cast<std::size_t>(fileStat.st_size);
+    void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Package: Can't map " + path);
+    }
+
+    madvise(mapping, m_size, MADV_WILLNEED);
+    m_data = static_cast<const unsigned char*>(mapping);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Package: Can't open " + path);
+    }
+
+    m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+
+    m_size = m_buffer.size();
+    m_data = m_buffer.data();
+#endif
+
+    try {
+        Validate();
+    }
+    catch (...) {
+#ifndef _WIN32
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+        throw;
+    }
+}
+
+KGEPackage::~KGEPackage()
+{
+#ifndef _WIN32
+    if (m_data != nullptr) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
+
+/**
+* Проверка заголовка и таблицы (блоки не читаются - их содержимое проверяет тот, кто их использует)
+*/
+void KGEPackage::Validate()
+{
+    if (m_size < sizeof(kge::pak::PackageHeader)) {
+        throw std::runtime_error("Package: " + m_path + " is not a package");
+    }
+
+    const kge::pak::PackageHeader* header = reinterpret_cast<const kge::pak::PackageHeader*>(m_data);
+    if (header->magic != kge::pak::PACKAGE_MAGIC) {
+        throw std::runtime_error("Package: " + m_path + " is not a package");
+    }
+    if (header->version != kge::pak::PACKAGE_VERSION) {
+        throw std::runtime_error("Package: " + m_path + " has unsupported version " + std::to_string(header->version));
+    }
+    if (header->fileSize != m_size ||
+            header->tableOffset % KGE_PACKAGE_ALIGNMENT != 0 ||
+            header->tableOffset + static_cast<uint64_t>(header->entryCount) * sizeof(kge::pak::PackageEntry) > m_size) {
+        throw std::runtime_error("Package: " + m_path + " is truncated or corrupted");
+    }
+
+    m_entries = reinterpret_cast<const kge::pak::PackageEntry*>(m_data + header->tableOffset);
+    m_entryCount = header->entryCount;
+
+    for (uint32_t i = 0; i < m_entryCount; i++) {
+        const kge::pak::PackageEntry &entry = m_entries[i];
+        if (entry.offset % KGE_PACKAGE_ALIGNMENT != 0 || entry.offset + entry.size > m_size ||
+                (i > 0 && m_entries[i - 1].nameHash >= entry.nameHash)) {
+            throw std::runtime_error("Package: " + m_path + " is truncated or corrupted");
+        }
+    }
+}
+
+const kge::pak::PackageEntry* KGEPackage::Find(uint64_t nameHash) const
+{
+    const kge::pak::PackageEntry* end = m_entries + m_entryCount;
+    const kge::pak::PackageEntry* found = std::lower_bound(m_entries, end, nameHash,
+                                                           [](const kge::pak::PackageEntry &entry, uint64_t hash) {
+        return entry.nameHash < hash;
+    });
+
+    return found != end && found->nameHash == nameHash ? found : nullptr;
+}
+
+const kge::pak::PackageEntry* KGEPackage::Find(const std::string &name) const
+{
+    return Find(kge::pak::HashName(name));
+}
+
+const unsigned char* KGEPackage::Data(const kge::pak::PackageEntry &entry) const
+{
+    return m_data + entry.offset;
+}
+
+uint32_t KGEPackage::entryCount() const
+{
+    return m_entryCount;
+}
+
+const std::string &KGEPackage::path() const
+{
+    return m_path;
+}
+
+void KGEPackageWriter::Add(const std::string &name, kge::pak::BLOB_TYPE type, std::vector<unsigned char> data)
+{
+    uint64_t nameHash = kge::pak::HashName(name);
+    for (const PendingBlob &blob : m_blobs) {
+        if (blob.nameHash == nameHash) {
+            throw std::runtime_error("Package: Blob " + name + " is already added (or its name hash collides)");
+        }
+    }
+
+    m_blobs.push_back({ nameHash, type, std::move(data) });
+}
+
+/**
+* Запись пакета: заголовок, выровненные блоки, таблица записей (в конце - ее размер известен только после раскладки блоков)
+*/
+bool KGEPackageWriter::Write(const std::string &path) const
+{
+    std::vector<kge::pak::PackageEntry> entries;
+    entries.reserve(m_blobs.size());
+
+    uint64_t offset = kge::pak::Align(sizeof(kge::pak::PackageHeader));
+    for (const PendingBlob &blob : m_blobs) {
+        kge::pak::PackageEntry entry;
+        entry.nameHash = blob.nameHash;
+        entry.offset = offset;
+        entry.size = blob.data.size();
+        entry.type = blob.type;
+        entries.push_back(entry);
+
+        offset = kge::pak::Align(offset + blob.data.size());
+    }
+
+    kge::pak::PackageHeader header;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.tableOffset = offset;
+    header.fileSize = offset + entries.size() * sizeof(kge::pak::PackageEntry);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const char padding[KGE_PACKAGE_ALIGNMENT] = {};
+    auto pad = [&file, &padding]() {
+        uint64_t position = static_cast<uint64_t>(file.tellp());
+        file.write(padding, static_cast<std::streamsize>(kge::pak::Align(position) - position));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad();
+
+    for (const PendingBlob &blob : m_blobs) {
+        file.write(reinterpret_cast<const char*>(blob.data.data()), static_cast<std::streamsize>(blob.data.size()));
+        pad();
+    }
+
+    // Таблица по возрастанию хеша (двоичный поиск при чтении)
+    std::sort(entries.begin(), entries.end(), [](const kge::pak::PackageEntry &a, const kge::pak::PackageEntry &b) {
+        return a.nameHash < b.nameHash;
+    });
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(kge::pak::PackageEntry)));
+
+    return file.good();
+}
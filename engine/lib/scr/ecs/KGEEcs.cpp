@@ -0,0 +1,225 @@
+#include "ecs/KGEEcs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+uint32_t kge::ecs::NextComponentType()
+{
+    static std::atomic<uint32_t> nextType{0};
+
+    uint32_t type = nextType.fetch_add(1);
+    if (type >= KGE_ECS_MAX_COMPONENT_TYPES) {
+        throw std::runtime_error("ECS: Too many component types");
+    }
+    return type;
+}
+
+KGEEcsWorld::KGEEcsWorld():
+    m_entityCount(0)
+{
+    // Архетип сущностей без компонентов (всегда с индексом 0)
+    FindOrCreateArchetype({});
+}
+
+kge::ecs::Entity KGEEcsWorld::Create()
+{
+    return Place(0);
+}
+
+void KGEEcsWorld::Destroy(kge::ecs::Entity entity)
+{
+    if (!Alive(entity)) {
+        return;
+    }
+
+    Record &record = m_records[entity.index];
+    FreeRow(record.archetype, record.chunk, record.row);
+
+    // Новое поколение делает все выданные хендлы недействительными
+    record.generation++;
+    m_freeRecords.push_back(entity.index);
+    m_entityCount--;
+}
+
+bool KGEEcsWorld::Alive(kge::ecs::Entity entity) const
+{
+    return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation;
+}
+
+uint32_t KGEEcsWorld::entityCount() const
+{
+    return m_entityCount;
+}
+
+uint32_t KGEEcsWorld::archetypeCount() const
+{
+    return static_cast<uint32_t>(m_archetypes.size());
+}
+
+/**
+* Поиск архетипа по набору компонентов (либо создание нового)
+* @note - раскладка блока: массив сущностей, затем массивы компонентов (каждый выровнен по своему типу).
+* Вместимость подбирается так, чтобы все массивы уместились в KGE_ECS_CHUNK_SIZE
+*/
+uint32_t KGEEcsWorld::FindOrCreateArchetype(std::vector<kge::ecs::ComponentInfo> components)
+{
+    std::sort(components.begin(), components.end(), [](const kge::ecs::ComponentInfo &a, const kge::ecs::ComponentInfo &b) {
+        return a.type < b.type;
+    });
+
+    kge::ecs::ComponentMask mask = 0;
+    for (const kge::ecs::ComponentInfo &info : components) {
+        mask |= kge::ecs::ComponentMask(1) << info.type;
+    }
+
+    auto found = m_archetypeByMask.find(mask);
+    if (found != m_archetypeByMask.end()) {
+        return found->second;
+    }
+
+    std::unique_ptr<kge::ecs::Archetype> archetype(new kge::ecs::Archetype());
+    archetype->mask = mask;
+    archetype->components = components;
+    std::fill(std::begin(archetype->offsets), std::end(archetype->offsets), UINT32_MAX);
+
+    uint32_t rowSize = sizeof(kge::ecs::Entity);
+    for (const kge::ecs::ComponentInfo &info : components) {
+        rowSize += info.size;
+    }
+
+    // Раскладка массивов при заданной вместимости (возвращает занятый размер)
+    auto layout = [&](uint32_t capacity) {
+        uint32_t offset = sizeof(kge::ecs::Entity) * capacity;
+        for (const kge::ecs::ComponentInfo &info : archetype->components) {
+            offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+            archetype->offsets[info.type] = offset;
+            offset += info.size * capacity;
+        }
+        return offset;
+    };
+
+    uint32_t capacity = KGE_ECS_CHUNK_SIZE / rowSize;
+    while (capacity > 0 && layout(capacity) > KGE_ECS_CHUNK_SIZE) {
+        capacity--;
+    }
+    if (capacity == 0) {
+        throw std::runtime_error("ECS: Components are too large for a chunk");
+    }
+    archetype->capacity = capacity;
+
+    uint32_t index = static_cast<uint32_t>(m_archetypes.size());
+    m_archetypes.push_back(std::move(archetype));
+    m_archetypeByMask[mask] = index;
+    return index;
+}
+
+kge::ecs::Entity KGEEcsWorld::Place(uint32_t archetype)
+{
+    kge::ecs::Entity entity;
+    if (!m_freeRecords.empty()) {
+        entity.index = m_freeRecords.back();
+        m_freeRecords.pop_back();
+    }
+    else {
+        entity.index = static_cast<uint32_t>(m_records.size());
+        m_records.emplace_back();
+    }
+
+    Record &record = m_records[entity.index];
+    entity.generation = record.generation;
+    record.archetype = archetype;
+    AllocateRow(archetype, record.chunk, record.row);
+
+    kge::ecs::Archetype &target = *m_archetypes[archetype];
+    target.entities(*target.chunks[record.chunk])[record.row] = entity;
+
+    m_entityCount++;
+    return entity;
+}
+
+void KGEEcsWorld::AllocateRow(uint32_t archetype, uint32_t &chunk, uint32_t &row)
+{
+    kge::ecs::Archetype &target = *m_archetypes[archetype];
+    if (target.chunks.empty() || target.chunks.back()->count == target.capacity) {
+        target.chunks.emplace_back(new kge::ecs::Chunk());
+    }
+
+    chunk = static_cast<uint32_t>(target.chunks.size() - 1);
+    row = target.chunks.back()->count++;
+}
+
+/**
+* Освобождение строки блока
+* @note - на место освобожденной строки переносится последняя сущность архетипа, поэтому блоки остаются плотными
+*/
+void KGEEcsWorld::FreeRow(uint32_t archetype, uint32_t chunk, uint32_t row)
+{
+    kge::ecs::Archetype &source = *m_archetypes[archetype];
+    kge::ecs::Chunk &hole = *source.chunks[chunk];
+    kge::ecs::Chunk &last = *source.chunks.back();
+    uint32_t lastRow = last.count - 1;
+
+    if (&hole != &last || row != lastRow) {
+        kge::ecs::Entity moved = source.entities(last)[lastRow];
+        source.entities(hole)[row] = moved;
+        for (const kge::ecs::ComponentInfo &info : source.components) {
+            memcpy(static_cast<unsigned char*>(source.column(hole, info.type)) + row * info.size,
+                   static_cast<unsigned char*>(source.column(last, info.type)) + lastRow * info.size,
+                   info.size);
+        }
+
+        m_records[moved.index].chunk = chunk;
+        m_records[moved.index].row = row;
+    }
+
+    if (--last.count == 0) {
+        source.chunks.pop_back();
+    }
+}
+
+/**
+* Перенос сущности в другой архетип (общие компоненты копируются, лишние отбрасываются, новые не инициализируются)
+*/
+void KGEEcsWorld::MoveEntity(kge::ecs::Entity entity, uint32_t targetArchetype)
+{
+    Record &record = m_records[entity.index];
+
+    uint32_t chunk, row;
+    AllocateRow(targetArchetype, chunk, row);
+
+    kge::ecs::Archetype &source = *m_archetypes[record.archetype];
+    kge::ecs::Archetype &target = *m_archetypes[targetArchetype];
+    kge::ecs::Chunk &sourceChunk = *source.chunks[record.chunk];
+    kge::ecs::Chunk &targetChunk = *target.chunks[chunk];
+
+    target.entities(targetChunk)[row] = entity;
+    for (const kge::ecs::ComponentInfo &info : source.components) {
+        if (target.offsets[info.type] != UINT32_MAX) {
+            memcpy(static_cast<unsigned char*>(target.column(targetChunk, info.type)) + row * info.size,
+                   static_cast<unsigned char*>(source.column(sourceChunk, info.type)) + record.row * info.size,
+                   info.size);
+        }
+    }
+
+    FreeRow(record.archetype, record.chunk, record.row);
+
+    record.archetype = targetArchetype;
+    record.chunk = chunk;
+    record.row = row;
+}
+
+/**
+* Архетипы, содержащие все компоненты маски
+* @note - архетипы только добавляются, поэтому кэш дополняется лишь новыми архетипами
+*/
+const std::vector<uint32_t> &KGEEcsWorld::Matching(kge::ecs::ComponentMask mask)
+{
+    QueryCache &cache = m_queries[mask];
+    for (; cache.checked < m_archetypes.size(); cache.checked++) {
+        if ((m_archetypes[cache.checked]->mask & mask) == mask) {
+            cache.archetypes.push_back(cache.checked);
+        }
+    }
+    return cache.archetypes;
+}
@@ -0,0 +1,583 @@
+#include "io/KGEFileSystem.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef KGE_IO_URING_AVAILABLE
+#include <sys/eventfd.h>
+#endif
+
+// Данные завершения io_uring, означающие пробуждение потока (адреса запросов не бывают нулевыми)
+#define KGE_VFS_WAKE_TAG 0
+
+/**
+* Файловые операции платформы (каждое чтение открывает свой дескриптор, поэтому чтение со смещением не разделяет позицию)
+*/
+static int OpenReadOnly(const std::string &path)
+{
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+static long long ReadAt(int file, void* buffer, std::size_t size, uint64_t offset)
+{
+#ifdef _WIN32
+    if (_lseeki64(file, static_cast<long long>(offset), SEEK_SET) < 0) {
+        return -1;
+    }
+    return _read(file, buffer, static_cast<unsigned int>(size));
+#else
+    return pread(file, buffer, size, static_cast<off_t>(offset));
+#endif
+}
+
+static void CloseFile(int file)
+{
+#ifdef _WIN32
+    _close(file);
+#else
+    close(file);
+#endif
+}
+
+static bool RegularFileSize(const std::string &path, uint64_t &size)
+{
+#ifdef _WIN32
+    struct _stat64 fileStat = {};
+    if (_stat64(path.c_str(), &fileStat) != 0 || (fileStat.st_mode & _S_IFREG) == 0) {
+        return false;
+    }
+#else
+    struct stat fileStat = {};
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        return false;
+    }
+#endif
+    size = static_cast<uint64_t>(fileStat.st_size);
+    return true;
+}
+
+/**
+* Запуск потока ввода-вывода с io_uring либо, если он недоступен, пула потоков чтения
+*/
+KGEFileSystem::KGEFileSystem(bool allowIoUring)
+{
+#ifdef KGE_IO_URING_AVAILABLE
+    if (allowIoUring) {
+        try {
+            // Одно место в очереди отправки - под ожидание события пробуждения
+            m_ring = std::make_unique<KGEIoUring>(KGE_VFS_QUEUE_DEPTH + 1);
+            m_wakeEvent = eventfd(0, EFD_CLOEXEC);
+            if (m_wakeEvent < 0) {
+                throw std::runtime_error("FileSystem: Can't create wake event");
+            }
+            m_threads.emplace_back(&KGEFileSystem::IoUringLoop, this);
+        }
+        catch (const std::exception&) {
+            m_ring.reset();
+            if (m_wakeEvent >= 0) {
+                close(m_wakeEvent);
+                m_wakeEvent = -1;
+            }
+        }
+    }
+#else
+    (void)allowIoUring;
+#endif
+
+    if (m_threads.empty()) {
+        for (unsigned int i = 0; i < KGE_VFS_FALLBACK_THREADS; i++) {
+            m_threads.emplace_back(&KGEFileSystem::WorkerLoop, this);
+        }
+    }
+}
+
+/**
+* Остановка потоков. Запросы из очереди не выполняются, выполняемые чтения дожидаются завершения
+* (ядро может писать в их буферы), обработчики не вызываются
+*/
+KGEFileSystem::~KGEFileSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    Wake();
+
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+
+#ifdef KGE_IO_URING_AVAILABLE
+    m_ring.reset();
+    if (m_wakeEvent >= 0) {
+        close(m_wakeEvent);
+    }
+#endif
+}
+
+std::string KGEFileSystem::NormalizeMountPoint(const std::string &mountPoint)
+{
+    std::string point = mountPoint;
+    while (!point.empty() && point.back() == '/') {
+        point.pop_back();
+    }
+    return point;
+}
+
+void KGEFileSystem::MountDirectory(const std::string &mountPoint, const std::string &directory)
+{
+    Mount mount;
+    mount.point = NormalizeMountPoint(mountPoint);
+    mount.directory = directory;
+
+    std::lock_guard<std::mutex> lock(m_mountMutex);
+    m_mounts.push_back(std::move(mount));
+}
+
+void KGEFileSystem::MountPackage(const std::string &mountPoint, const std::string &packagePath)
+{
+    Mount mount;
+    mount.point = NormalizeMountPoint(mountPoint);
+    mount.package = std::make_shared<KGEPackage>(packagePath);
+
+    std::lock_guard<std::mutex> lock(m_mountMutex);
+    m_mounts.push_back(std::move(mount));
+}
+
+void KGEFileSystem::Unmount(const std::string &mountPoint)
+{
+    std::string point = NormalizeMountPoint(mountPoint);
+
+    std::lock_guard<std::mutex> lock(m_mountMutex);
+    m_mounts.erase(std::remove_if(m_mounts.begin(), m_mounts.end(), [&point](const Mount &mount) {
+        return mount.point == point;
+    }), m_mounts.end());
+}
+
+/**
+* Разрешение виртуального пути (от последней точки монтирования к первой)
+*/
+bool KGEFileSystem::Resolve(const std::string &path, Source &source) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mountMutex);
+        for (auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it) {
+            const Mount &mount = *it;
+
+            std::string relative;
+            if (mount.point.empty()) {
+                relative = path;
+            }
+            else if (path.size() > mount.point.size() && path.compare(0, mount.point.size(), mount.point) == 0 &&
+                     path[mount.point.size()] == '/') {
+                relative = path.substr(mount.point.size() + 1);
+            }
+            else {
+                continue;
+            }
+
+            if (mount.package != nullptr) {
+                const kge::pak::PackageEntry* entry = mount.package->Find(relative);
+                if (entry != nullptr) {
+                    source.package = mount.package;
+                    source.packageData = mount.package->Data(*entry);
+                    source.size = entry->size;
+                    return true;
+                }
+            }
+            else {
+                std::string nativePath = mount.directory + "/" + relative;
+                if (RegularFileSize(nativePath, source.size)) {
+                    source.nativePath = std::move(nativePath);
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Вне точек монтирования - обычный путь
+    if (RegularFileSize(path, source.size)) {
+        source.nativePath = path;
+        return true;
+    }
+
+    return false;
+}
+
+bool KGEFileSystem::Exists(const std::string &path) const
+{
+    Source source;
+    return Resolve(path, source);
+}
+
+/**
+* Подготовка запроса к чтению: разрешение пути, открытие файла, выделение буфера
+* @return bool - нужно ли читать файл (false - запрос завершен, результат в status)
+* @note - блоки пакета копируются сразу, из отображения пакета
+*/
+bool KGEFileSystem::OpenRequest(Request* request, kge::io::READ_STATUS &status)
+{
+    Source source;
+    if (!Resolve(request->path, source)) {
+        status = kge::io::ReadNotFound;
+        return false;
+    }
+
+    if (source.package != nullptr) {
+        request->data.assign(source.packageData, source.packageData + source.size);
+        status = kge::io::ReadOk;
+        return false;
+    }
+
+    request->file = OpenReadOnly(source.nativePath);
+    if (request->file < 0) {
+        status = kge::io::ReadFailed;
+        return false;
+    }
+
+    request->data.resize(static_cast<std::size_t>(source.size));
+    request->offset = 0;
+
+    if (source.size == 0) {
+        CloseFile(request->file);
+        request->file = -1;
+        status = kge::io::ReadOk;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+* Блокирующее чтение открытого запроса (пул потоков и ReadSync)
+*/
+kge::io::READ_STATUS KGEFileSystem::ReadBlocking(Request* request)
+{
+    kge::io::READ_STATUS status = kge::io::ReadOk;
+
+    while (request->offset < request->data.size()) {
+        if (request->cancelled.load(std::memory_order_relaxed)) {
+            status = kge::io::ReadCancelled;
+            break;
+        }
+
+        std::size_t chunk = std::min<std::size_t>(request->data.size() - static_cast<std::size_t>(request->offset), KGE_VFS_READ_CHUNK);
+        long long bytesRead = ReadAt(request->file, request->data.data() + request->offset, chunk, request->offset);
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            status = kge::io::ReadFailed;
+            break;
+        }
+
+        request->offset += static_cast<uint64_t>(bytesRead);
+    }
+
+    CloseFile(request->file);
+    request->file = -1;
+    return status;
+}
+
+kge::io::ReadHandle KGEFileSystem::ReadAsync(const std::string &path,
+                                             kge::io::ReadCallback callback,
+                                             kge::io::READ_PRIORITY priority)
+{
+    kge::io::ReadHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        handle = m_nextHandle++;
+
+        std::unique_ptr<Request> request = std::make_unique<Request>();
+        request->handle = handle;
+        request->priority = priority;
+        request->path = path;
+        request->callback = std::move(callback);
+
+        m_queue.emplace(QueueKey(-static_cast<int>(priority), handle), request.get());
+        m_requests.emplace(handle, std::move(request));
+    }
+
+    Wake();
+    return handle;
+}
+
+bool KGEFileSystem::Cancel(kge::io::ReadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_requests.find(handle);
+    if (it == m_requests.end()) {
+        return false;
+    }
+
+    Request* request = it->second.get();
+    if (m_queue.erase(QueueKey(-static_cast<int>(request->priority), handle)) > 0) {
+        CompleteLocked(request, kge::io::ReadCancelled);
+    }
+    else {
+        request->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+bool KGEFileSystem::SetPriority(kge::io::ReadHandle handle, kge::io::READ_PRIORITY priority)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_requests.find(handle);
+    if (it == m_requests.end()) {
+        return false;
+    }
+
+    Request* request = it->second.get();
+    if (m_queue.erase(QueueKey(-static_cast<int>(request->priority), handle)) == 0) {
+        return false;
+    }
+
+    request->priority = priority;
+    m_queue.emplace(QueueKey(-static_cast<int>(priority), handle), request);
+    return true;
+}
+
+unsigned int KGEFileSystem::DispatchCompleted(unsigned int maxCount)
+{
+    std::vector<std::pair<kge::io::ReadCallback, kge::io::ReadResult>> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (!m_completed.empty() && completed.size() < maxCount) {
+            completed.push_back(std::move(m_completed.front()));
+            m_completed.pop_front();
+        }
+    }
+
+    // Обработчики вызываются без блокировки - они могут ставить новые чтения
+    for (auto &item : completed) {
+        if (item.first) {
+            item.first(item.second);
+        }
+    }
+
+    return static_cast<unsigned int>(completed.size());
+}
+
+kge::io::READ_STATUS KGEFileSystem::ReadSync(const std::string &path, std::vector<unsigned char> &data)
+{
+    Request request;
+    request.path = path;
+
+    kge::io::READ_STATUS status;
+    if (OpenRequest(&request, status)) {
+        status = ReadBlocking(&request);
+    }
+
+    data = std::move(request.data);
+    return status;
+}
+
+bool KGEFileSystem::usingIoUring() const
+{
+#ifdef KGE_IO_URING_AVAILABLE
+    return m_ring != nullptr;
+#else
+    return false;
+#endif
+}
+
+unsigned int KGEFileSystem::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<unsigned int>(m_requests.size());
+}
+
+void KGEFileSystem::Wake()
+{
+#ifdef KGE_IO_URING_AVAILABLE
+    if (m_wakeEvent >= 0) {
+        uint64_t value = 1;
+        ssize_t written = write(m_wakeEvent, &value, sizeof(value));
+        (void)written;
+    }
+#endif
+    m_condition.notify_all();
+}
+
+/**
+* Взять запрос с наибольшим приоритетом из очереди
+* @param bool wait - ждать появления запроса
+* @return Request* - запрос (nullptr если очередь пуста либо система останавливается)
+*/
+KGEFileSystem::Request* KGEFileSystem::PopQueued(bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (wait) {
+        m_condition.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+    }
+
+    if (m_stop || m_queue.empty()) {
+        return nullptr;
+    }
+
+    Request* request = m_queue.begin()->second;
+    m_queue.erase(m_queue.begin());
+    return request;
+}
+
+void KGEFileSystem::Complete(Request* request, kge::io::READ_STATUS status)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CompleteLocked(request, status);
+}
+
+/**
+* Перенос результата в очередь завершенных и удаление запроса (вызывается под m_mutex)
+*/
+void KGEFileSystem::CompleteLocked(Request* request, kge::io::READ_STATUS status)
+{
+    if (status == kge::io::ReadOk && request->cancelled.load(std::memory_order_relaxed)) {
+        status = kge::io::ReadCancelled;
+    }
+
+    kge::io::ReadResult result;
+    result.handle = request->handle;
+    result.status = status;
+    result.path = std::move(request->path);
+    if (status == kge::io::ReadOk) {
+        result.data = std::move(request->data);
+    }
+
+    m_completed.emplace_back(std::move(request->callback), std::move(result));
+    m_requests.erase(request->handle);
+}
+
+/**
+* Поток пула: берет запрос с наибольшим приоритетом и читает его блокирующими вызовами
+*/
+void KGEFileSystem::WorkerLoop()
+{
+    while (true) {
+        Request* request = PopQueued(true);
+        if (request == nullptr) {
+            return;
+        }
+
+        kge::io::READ_STATUS status;
+        if (OpenRequest(request, status)) {
+            status = ReadBlocking(request);
+        }
+
+        Complete(request, status);
+    }
+}
+
+#ifdef KGE_IO_URING_AVAILABLE
+
+/**
+* Отправка следующей части чтения (адрес запроса - данные завершения)
+*/
+void KGEFileSystem::SubmitChunk(Request* request)
+{
+    std::size_t chunk = std::min<std::size_t>(request->data.size() - static_cast<std::size_t>(request->offset), KGE_VFS_READ_CHUNK);
+    m_ring->PrepareRead(request->file,
+                        request->data.data() + request->offset,
+                        static_cast<unsigned int>(chunk),
+                        request->offset,
+                        reinterpret_cast<uint64_t>(request));
+}
+
+/**
+* Поток ввода-вывода io_uring
+* Держит в полете до KGE_VFS_QUEUE_DEPTH чтений и ждет завершений одним системным вызовом. Новые запросы будят поток
+* через eventfd, ожидание которого тоже стоит в кольце - поэтому поток никогда не спит, пока в очереди есть работа
+*/
+void KGEFileSystem::IoUringLoop()
+{
+    m_ring->PreparePollIn(m_wakeEvent, KGE_VFS_WAKE_TAG);
+    unsigned int inFlight = 0;
+
+    while (true) {
+        // Дополнить кольцо запросами из очереди (по приоритету)
+        while (inFlight < KGE_VFS_QUEUE_DEPTH) {
+            Request* request = PopQueued(false);
+            if (request == nullptr) {
+                break;
+            }
+
+            kge::io::READ_STATUS status;
+            if (!OpenRequest(request, status)) {
+                Complete(request, status);
+                continue;
+            }
+
+            SubmitChunk(request);
+            inFlight++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop && inFlight == 0) {
+                return;
+            }
+        }
+
+        // Отправить подготовленное и дождаться хотя бы одного завершения (чтения либо пробуждения)
+        m_ring->Submit(1);
+
+        uint64_t userData = 0;
+        int32_t result = 0;
+        while (m_ring->PopCompletion(userData, result)) {
+            if (userData == KGE_VFS_WAKE_TAG) {
+                uint64_t value = 0;
+                ssize_t bytesRead = read(m_wakeEvent, &value, sizeof(value));
+                (void)bytesRead;
+                m_ring->PreparePollIn(m_wakeEvent, KGE_VFS_WAKE_TAG);
+                continue;
+            }
+
+            Request* request = reinterpret_cast<Request*>(userData);
+            if (result == -EINTR || result == -EAGAIN) {
+                SubmitChunk(request);
+                continue;
+            }
+
+            kge::io::READ_STATUS status = kge::io::ReadOk;
+            if (result <= 0) {
+                status = kge::io::ReadFailed;
+            }
+            else {
+                request->offset += static_cast<uint64_t>(result);
+                if (request->offset < request->data.size()) {
+                    if (!request->cancelled.load(std::memory_order_relaxed)) {
+                        SubmitChunk(request);
+                        continue;
+                    }
+                    status = kge::io::ReadCancelled;
+                }
+            }
+
+            CloseFile(request->file);
+            request->file = -1;
+            Complete(request, status);
+            inFlight--;
+        }
+    }
+}
+
+#endif // KGE_IO_URING_AVAILABLE
@@ -0,0 +1,175 @@
+#include "io/KGEFileWatcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef KGE_INOTIFY_AVAILABLE
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// События, означающие что файл записан целиком, а также появление подкаталогов и снятие наблюдения
+#define KGE_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR)
+
+KGEFileWatcher::KGEFileWatcher()
+{
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) {
+        throw std::runtime_error("FileWatcher: Can't initialize inotify (" + std::string(strerror(errno)) + ")");
+    }
+}
+
+KGEFileWatcher::~KGEFileWatcher()
+{
+    if (m_inotify >= 0) {
+        close(m_inotify);
+    }
+}
+
+void KGEFileWatcher::WatchDirectory(const std::string &directory)
+{
+    std::string path = directory;
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+
+    int watch = inotify_add_watch(m_inotify, path.c_str(), KGE_WATCH_MASK);
+    if (watch < 0) {
+        throw std::runtime_error("FileWatcher: Can't watch " + path + " (" + std::string(strerror(errno)) + ")");
+    }
+    m_directories[watch] = path;
+
+    AddWatch(path);
+}
+
+/**
+* Слежение за подкаталогами каталога (рекурсивно)
+* @param const std::string &directory - каталог (сам он уже под наблюдением)
+* @note - подкаталоги, за которыми нельзя следить, пропускаются (исключение только для корня в WatchDirectory)
+*/
+void KGEFileWatcher::AddWatch(const std::string &directory)
+{
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        std::string path = directory + "/" + entry->d_name;
+
+        // IN_ONLYDIR отклоняет обычные файлы, поэтому тип записи каталога можно не проверять
+        int watch = inotify_add_watch(m_inotify, path.c_str(), KGE_WATCH_MASK);
+        if (watch >= 0) {
+            m_directories[watch] = path;
+            AddWatch(path);
+        }
+    }
+
+    closedir(dir);
+}
+
+std::vector<std::string> KGEFileWatcher::Poll()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // Буфер выровнен под заголовок события, имя файла следует сразу за заголовком
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    while (true) {
+        ssize_t size = read(m_inotify, buffer, sizeof(buffer));
+        if (size <= 0) {
+            // EAGAIN - событий больше нет
+            break;
+        }
+
+        for (char* position = buffer; position < buffer + size;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+            position += sizeof(inotify_event) + event->len;
+
+            if ((event->mask & IN_IGNORED) != 0) {
+                m_directories.erase(event->wd);
+                continue;
+            }
+
+            auto directory = m_directories.find(event->wd);
+            if (directory == m_directories.end() || event->len == 0) {
+                continue;
+            }
+
+            std::string path = directory->second + "/" + event->name;
+
+            if ((event->mask & IN_ISDIR) != 0) {
+                // Новый (либо перемещенный в наблюдаемый) подкаталог
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                    int watch = inotify_add_watch(m_inotify, path.c_str(), KGE_WATCH_MASK);
+                    if (watch >= 0) {
+                        m_directories[watch] = path;
+                        AddWatch(path);
+                    }
+                }
+                continue;
+            }
+
+            // Создание файла само по себе не означает, что его можно читать - ждать закрытия после записи
+            if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+                m_pending[path] = now;
+            }
+        }
+    }
+
+    // Сообщить о файлах, которые успели "успокоиться"
+    std::vector<std::string> changed;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (now - it->second >= std::chrono::milliseconds(KGE_WATCH_DEBOUNCE_MS)) {
+            changed.push_back(it->first);
+            it = m_pending.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    std::sort(changed.begin(), changed.end());
+    return changed;
+}
+
+bool KGEFileWatcher::available() const
+{
+    return true;
+}
+
+#else
+
+KGEFileWatcher::KGEFileWatcher()
+{
+}
+
+KGEFileWatcher::~KGEFileWatcher()
+{
+}
+
+void KGEFileWatcher::WatchDirectory(const std::string &)
+{
+}
+
+void KGEFileWatcher::AddWatch(const std::string &)
+{
+}
+
+std::vector<std::string> KGEFileWatcher::Poll()
+{
+    return {};
+}
+
+bool KGEFileWatcher::available() const
+{
+    return false;
+}
+
+#endif // KGE_INOTIFY_AVAILABLE
@@ -0,0 +1,202 @@
+#include "io/KGEIoUring.h"
+
+#ifdef KGE_IO_URING_AVAILABLE
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+/**
+* Настройка колец и отображение их в память процесса
+*/
+KGEIoUring::KGEIoUring(unsigned int entries)
+{
+    io_uring_params params = {};
+    m_ring = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_ring < 0) {
+        throw std::runtime_error("IoUring: Setup failed (" + std::string(strerror(errno)) + ")");
+    }
+
+    // IORING_OP_READ появился в 5.6 вместе с этим признаком
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+        Release();
+        throw std::runtime_error("IoUring: Kernel is too old");
+    }
+
+    m_entries = params.sq_entries;
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // Ядра 5.4+ отображают обе очереди одним регионом
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        Release();
+        throw std::runtime_error("IoUring: Can't map submission ring");
+    }
+
+    if (singleMap) {
+        m_cqRing = m_sqRing;
+    }
+    else {
+        m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            Release();
+            throw std::runtime_error("IoUring: Can't map completion ring");
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        Release();
+        throw std::runtime_error("IoUring: Can't map submission entries");
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    unsigned char* sq = static_cast<unsigned char*>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+    unsigned char* cq = static_cast<unsigned char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+KGEIoUring::~KGEIoUring()
+{
+    Release();
+}
+
+void KGEIoUring::Release()
+{
+    if (m_sqes != nullptr) {
+        munmap(m_sqes, m_sqesSize);
+        m_sqes = nullptr;
+    }
+    if (m_cqRing != nullptr && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    m_cqRing = nullptr;
+    if (m_sqRing != nullptr) {
+        munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = nullptr;
+    }
+    if (m_ring >= 0) {
+        close(m_ring);
+        m_ring = -1;
+    }
+}
+
+/**
+* Следующий свободный элемент очереди отправки (очередь пополняется только этим потоком, ядро лишь продвигает голову)
+*/
+io_uring_sqe* KGEIoUring::NextSqe()
+{
+    unsigned int tail = *m_sqTail;
+    unsigned int head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= m_entries) {
+        return nullptr;
+    }
+
+    unsigned int index = tail & *m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    m_sqArray[index] = index;
+    return sqe;
+}
+
+bool KGEIoUring::PrepareRead(int file, void* buffer, unsigned int size, uint64_t offset, uint64_t userData)
+{
+    io_uring_sqe* sqe = NextSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = file;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = size;
+    sqe->off = offset;
+    sqe->user_data = userData;
+
+    // Элемент заполнен - сделать его видимым ядру
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    return true;
+}
+
+bool KGEIoUring::PreparePollIn(int file, uint64_t userData)
+{
+    io_uring_sqe* sqe = NextSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = file;
+    sqe->poll_events = POLLIN;
+    sqe->user_data = userData;
+
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    return true;
+}
+
+bool KGEIoUring::Submit(unsigned int waitCompletions)
+{
+    unsigned int flags = waitCompletions > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    while (true) {
+        int submitted = static_cast<int>(syscall(__NR_io_uring_enter, m_ring, m_toSubmit, waitCompletions, flags, nullptr, 0));
+        if (submitted >= 0) {
+            m_toSubmit -= static_cast<unsigned int>(submitted);
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool KGEIoUring::PopCompletion(uint64_t &userData, int32_t &result)
+{
+    unsigned int head = *m_cqHead;
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    const io_uring_cqe &cqe = m_cqes[head & *m_cqMask];
+    userData = cqe.user_data;
+    result = cqe.res;
+
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif // KGE_IO_URING_AVAILABLE
@@ -0,0 +1,285 @@
+#include "jobs/KGEJobSystem.h"
+#include "profile/KGEProfiler.h"
+
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Индекс рабочего потока текущего потока (-1 для потоков не принадлежащих системе задач)
+static thread_local int t_workerIndex = -1;
+
+/**
+* Создание системы задач и запуск рабочих потоков
+* @param unsigned int workerCount - кол-во рабочих потоков (0 - по кол-ву аппаратных потоков минус основной)
+* @param bool pinWorkers - закрепить ли рабочие потоки за ядрами процессора
+*/
+KGEJobSystem::KGEJobSystem(unsigned int workerCount, bool pinWorkers):
+    m_running{true},
+    m_pendingJobs{0}
+{
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    // Очереди рабочих потоков и одна общая (для задач поставленных извне)
+    for (unsigned int i = 0; i < workerCount + 1; i++) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (unsigned int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&KGEJobSystem::WorkerLoop, this, i, pinWorkers);
+    }
+}
+
+/**
+* Остановка рабочих потоков. Задачи оставшиеся в очередях не выполняются
+*/
+KGEJobSystem::~KGEJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+
+    for (std::thread &worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void KGEJobSystem::Run(std::function<void()> function, kge::jobs::Counter *signal, int affinity)
+{
+    if (signal != nullptr) {
+        signal->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Enqueue({std::move(function), signal, affinity});
+}
+
+void KGEJobSystem::RunAfter(kge::jobs::Counter *dependency,
+                            std::function<void()> function,
+                            kge::jobs::Counter *signal,
+                            int affinity)
+{
+    if (signal != nullptr) {
+        signal->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    kge::jobs::Job job{std::move(function), signal, affinity};
+
+    // Если зависимость еще не выполнена - задача станет продолжением счетчика.
+    // Проверка и добавление под мьютексом счетчика, чтобы не разминуться с его обнулением (см. Finish)
+    if (dependency != nullptr) {
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->IsDone()) {
+            dependency->continuations.push_back(std::move(job));
+            return;
+        }
+    }
+
+    Enqueue(std::move(job));
+}
+
+void KGEJobSystem::Wait(kge::jobs::Counter *counter)
+{
+    kge::jobs::Job job;
+
+    while (!counter->IsDone()) {
+        if (PopJob(t_workerIndex, job)) {
+            Execute(job);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    // Дождаться выхода завершающего потока из Finish (см. комментарий к Finish)
+    std::lock_guard<std::mutex> lock(counter->mutex);
+}
+
+void KGEJobSystem::ParallelFor(std::size_t count,
+                               std::size_t batchSize,
+                               const std::function<void(std::size_t, std::size_t)> &function)
+{
+    if (count == 0) {
+        return;
+    }
+
+    batchSize = std::max<std::size_t>(batchSize, 1);
+
+    // Один пакет - нет смысла отдавать его другому потоку
+    if (count <= batchSize) {
+        function(0, count);
+        return;
+    }
+
+    kge::jobs::Counter counter;
+
+    // Последний пакет выполняется вызывающим потоком, остальные - раздаются
+    std::size_t begin = 0;
+    for (; begin + batchSize < count; begin += batchSize) {
+        std::size_t end = begin + batchSize;
+        Run([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    function(begin, count);
+
+    Wait(&counter);
+}
+
+unsigned int KGEJobSystem::WorkerCount() const
+{
+    return static_cast<unsigned int>(m_workers.size());
+}
+
+int KGEJobSystem::CurrentWorkerIndex()
+{
+    return t_workerIndex;
+}
+
+/**
+* Цикл рабочего потока: выполнение своих задач, кража чужих, сон при отсутствии работы
+*/
+void KGEJobSystem::WorkerLoop(unsigned int workerIndex, bool pin)
+{
+    t_workerIndex = static_cast<int>(workerIndex);
+    KGEProfiler::Instance().SetThreadName("Worker " + std::to_string(workerIndex));
+
+#ifdef __linux__
+    if (pin) {
+        unsigned int cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        // Ядро 0 оставляем основному потоку
+        CPU_SET((workerIndex + 1) % cpuCount, &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+    }
+#else
+    (void)pin;
+#endif
+
+    kge::jobs::Job job;
+
+    while (true) {
+        if (PopJob(t_workerIndex, job)) {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.wait(lock, [this]() {
+            return !m_running || m_pendingJobs.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!m_running) {
+            break;
+        }
+    }
+}
+
+/**
+* Поместить задачу в очередь: в очередь текущего рабочего потока, в очередь потока из подсказки
+* привязки, либо в общую очередь (если задача поставлена извне)
+*/
+void KGEJobSystem::Enqueue(kge::jobs::Job job)
+{
+    int workerCount = static_cast<int>(m_workers.size());
+    int queueIndex = workerCount;
+
+    if (job.affinity >= 0) {
+        queueIndex = job.affinity % workerCount;
+    }
+    else if (t_workerIndex >= 0) {
+        queueIndex = t_workerIndex;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_pendingJobs.fetch_add(1, std::memory_order_release);
+    }
+    m_wakeCondition.notify_one();
+}
+
+/**
+* Получить задачу: сначала с конца своей очереди, затем с начала общей, затем кража из очередей других потоков
+*/
+bool KGEJobSystem::PopJob(int workerIndex, kge::jobs::Job &job)
+{
+    if (m_pendingJobs.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+
+    int queueCount = static_cast<int>(m_queues.size());
+
+    if (workerIndex >= 0) {
+        WorkerQueue &own = *m_queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // Обход начинается с общей очереди, далее - соседние потоки
+    int start = queueCount - 1;
+    for (int i = 0; i < queueCount; i++) {
+        int victim = (start + i) % queueCount;
+        if (victim == workerIndex) {
+            continue;
+        }
+
+        WorkerQueue &queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void KGEJobSystem::Execute(kge::jobs::Job &job)
+{
+    job.function();
+    kge::jobs::Counter* signal = job.signal;
+    job = {};
+    Finish(signal);
+}
+
+/**
+* Завершение задачи: уменьшение счетчика и постановка продолжений в очередь при его обнулении
+* @note - уменьшение происходит под мьютексом счетчика, а Wait перед возвратом захватывает тот же мьютекс.
+* Так счетчик (часто живущий на стеке ожидающего потока) не будет уничтожен пока Finish с ним работает
+*/
+void KGEJobSystem::Finish(kge::jobs::Counter *signal)
+{
+    if (signal == nullptr) {
+        return;
+    }
+
+    std::vector<kge::jobs::Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(signal->mutex);
+        if (signal->value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            continuations.swap(signal->continuations);
+        }
+    }
+
+    for (kge::jobs::Job &continuation : continuations) {
+        Enqueue(std::move(continuation));
+    }
+}
@@ -0,0 +1,263 @@
+#include "log/KGELogger.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+// Метки уровней в строке сообщения
+static const char* const LEVEL_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+// Интервал опроса буфера потоком записи, когда буфер пуст
+static const std::chrono::milliseconds WRITER_IDLE_INTERVAL{ 2 };
+
+/**
+* Создание журнала и запуск потока записи
+* @param const std::string &file - файл журнала (дописывается; пустая строка - только консоль)
+* @param std::size_t capacity - кол-во записей кольцевого буфера (округляется вверх до степени двойки)
+*
+* @note - ячейки буфера выделяются один раз и переиспользуются (сообщение не выделяет память в потоке-источнике)
+*/
+KGELogger::KGELogger(const std::string &file, std::size_t capacity):
+    m_enqueuePosition{0},
+    m_dequeuePosition{0},
+    m_dropped{0},
+    m_level{KGE_LOG_MIN_LEVEL},
+    m_stopping{false}
+{
+    std::size_t cellCount = 2;
+    while (cellCount < capacity) {
+        cellCount <<= 1;
+    }
+
+    m_cells = std::make_unique<Cell[]>(cellCount);
+    m_mask = cellCount - 1;
+    for (std::size_t i = 0; i < cellCount; i++) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    KGEMemoryTracker::Track(kge::memory::TagLog, cellCount * sizeof(Cell));
+
+    if (!file.empty()) {
+        m_file.open(file, std::ios_base::app);
+        if (!m_file.is_open()) {
+            std::cout << "Log: Can't open log file " << file << ". Logging to console only" << std::endl;
+        }
+    }
+
+    m_writer = std::thread(&KGELogger::WriterLoop, this);
+}
+
+KGELogger::~KGELogger()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping.store(true, std::memory_order_release);
+    }
+    m_wakeCondition.notify_all();
+
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    KGEMemoryTracker::Untrack(kge::memory::TagLog, (m_mask + 1) * sizeof(Cell));
+}
+
+void KGELogger::SetLevel(kge::log::Level level)
+{
+    m_level.store(level, std::memory_order_relaxed);
+}
+
+kge::log::Level KGELogger::level() const
+{
+    return static_cast<kge::log::Level>(m_level.load(std::memory_order_relaxed));
+}
+
+uint64_t KGELogger::droppedCount() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+/**
+* Захват ячейки для записи
+* @param uint64_t &position - позиция захваченной ячейки (публикуется записью номера position + 1)
+* @return Cell* - ячейка либо nullptr, если буфер заполнен
+*
+* @note - источники соревнуются только за счетчик позиции (сравнение с обменом), ячейки у каждого свои
+*/
+KGELogger::Cell* KGELogger::Claim(uint64_t &position)
+{
+    position = m_enqueuePosition.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Cell* cell = &m_cells[position & m_mask];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+        if (difference == 0) {
+            // Ячейка свободна для этой позиции - занять позицию
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return cell;
+            }
+        }
+        else if (difference < 0) {
+            // Ячейка еще не прочитана с прошлого круга - буфер заполнен
+            return nullptr;
+        }
+        else {
+            // Позицию занял другой источник
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+int64_t KGELogger::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+* Цикл потока записи: разбор буфера порциями, ожидание при пустом буфере
+* @note - после запроса остановки буфер разбирается до конца
+*/
+void KGELogger::WriterLoop()
+{
+    for (;;) {
+        bool stopping = m_stopping.load(std::memory_order_acquire);
+
+        bool written = Drain();
+        if (written) {
+            Flush();
+            continue;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait_for(lock, WRITER_IDLE_INTERVAL, [this]() { return m_stopping.load(std::memory_order_acquire); });
+    }
+
+    Flush();
+}
+
+/**
+* Форматирование опубликованных записей
+* @return bool - были ли записи
+*/
+bool KGELogger::Drain()
+{
+    bool written = false;
+
+    for (;;) {
+        Cell &cell = m_cells[m_dequeuePosition & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1) {
+            break;
+        }
+
+        Format(cell.record);
+
+        // Освободить ячейку для источника следующего круга
+        cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+        m_dequeuePosition++;
+        written = true;
+    }
+
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDropped) {
+        m_buffer += "Log: " + std::to_string(dropped - m_reportedDropped) + " messages dropped (buffer is full)\n";
+        m_reportedDropped = dropped;
+        written = true;
+    }
+
+    return written;
+}
+
+/**
+* Сборка строки сообщения: [ГГГГ-ММ-ДД ЧЧ:ММ:СС.мс] [УРОВЕНЬ] текст
+*/
+void KGELogger::Format(const kge::log::Record &record)
+{
+    char number[32];
+
+    if (record.timestamp) {
+        int64_t second = record.time / 1000000000;
+        if (second != m_cachedSecond) {
+            std::time_t time = static_cast<std::time_t>(second);
+            tm timeInfo;
+            localtime_r(&time, &timeInfo);
+            strftime(m_cachedTime, sizeof(m_cachedTime), "%Y-%m-%d %H:%M:%S", &timeInfo);
+            m_cachedSecond = second;
+        }
+
+        snprintf(number, sizeof(number), ".%03d] ", static_cast<int>((record.time / 1000000) % 1000));
+        m_buffer += '[';
+        m_buffer += m_cachedTime;
+        m_buffer += number;
+    }
+
+    if (record.level != kge::log::LevelInfo) {
+        m_buffer += '[';
+        m_buffer += LEVEL_NAMES[record.level];
+        m_buffer += "] ";
+    }
+
+    // Подстановка аргументов на места "{}" (лишние места остаются как есть)
+    uint8_t argumentIndex = 0;
+    for (const char* c = record.format; *c != '\0'; c++) {
+        if (c[0] != '{' || c[1] != '}' || argumentIndex >= record.argumentCount) {
+            m_buffer += *c;
+            continue;
+        }
+
+        const kge::log::Argument &argument = record.arguments[argumentIndex++];
+        switch (argument.type) {
+        case kge::log::Argument::Signed:
+            snprintf(number, sizeof(number), "%" PRId64, argument.i);
+            m_buffer += number;
+            break;
+        case kge::log::Argument::Unsigned:
+            snprintf(number, sizeof(number), "%" PRIu64, argument.u);
+            m_buffer += number;
+            break;
+        case kge::log::Argument::Float:
+            snprintf(number, sizeof(number), "%g", argument.d);
+            m_buffer += number;
+            break;
+        case kge::log::Argument::Bool:
+            m_buffer += argument.u != 0 ? "true" : "false";
+            break;
+        case kge::log::Argument::Pointer:
+            snprintf(number, sizeof(number), "%p", argument.p);
+            m_buffer += number;
+            break;
+        case kge::log::Argument::Text:
+            m_buffer.append(record.text + argument.text.offset, argument.text.length);
+            break;
+        }
+        c++;
+    }
+
+    m_buffer += '\n';
+}
+
+/**
+* Вывод порции сообщений в консоль и файл
+*/
+void KGELogger::Flush()
+{
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    std::cout.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    std::cout.flush();
+
+    if (m_file.is_open()) {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_file.flush();
+    }
+
+    m_buffer.clear();
+}
@@ -0,0 +1,463 @@
+#include "math/KGEBvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Кол-во корзин SAH
+#define BVH_BIN_COUNT 12
+
+// Максимальное кол-во объектов в листе
+#define BVH_MAX_LEAF_SIZE 4
+
+// Поддеревья с большим кол-вом объектов строятся отдельной задачей
+#define BVH_PARALLEL_THRESHOLD 4096
+
+// Начальная емкость стека обхода (для сбалансированного дерева с запасом)
+#define BVH_STACK_SIZE 64
+
+namespace
+{
+    void GrowAabb(kge::math::Aabb &target, const kge::math::Aabb &source)
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            target.min[axis] = std::min(target.min[axis], source.min[axis]);
+            target.max[axis] = std::max(target.max[axis], source.max[axis]);
+        }
+    }
+
+    kge::math::Aabb EmptyAabb()
+    {
+        kge::math::Aabb aabb;
+        for (int axis = 0; axis < 3; axis++) {
+            aabb.min[axis] = std::numeric_limits<float>::max();
+            aabb.max[axis] = -std::numeric_limits<float>::max();
+        }
+        return aabb;
+    }
+
+    float SurfaceArea(const kge::math::Aabb &aabb)
+    {
+        float x = aabb.max[0] - aabb.min[0];
+        float y = aabb.max[1] - aabb.min[1];
+        float z = aabb.max[2] - aabb.min[2];
+        return (x < 0.0f || y < 0.0f || z < 0.0f) ? 0.0f : 2.0f * (x * y + y * z + z * x);
+    }
+
+    bool Overlaps(const kge::math::Aabb &a, const kge::math::Aabb &b)
+    {
+        return a.min[0] <= b.max[0] && a.max[0] >= b.min[0] &&
+               a.min[1] <= b.max[1] && a.max[1] >= b.min[1] &&
+               a.min[2] <= b.max[2] && a.max[2] >= b.min[2];
+    }
+
+    bool SameAabb(const kge::math::Aabb &a, const kge::math::Aabb &b)
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            if (a.min[axis] != b.min[axis] || a.max[axis] != b.max[axis]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Положение AABB относительно пирамиды: -1 снаружи, 0 пересекает, 1 целиком внутри
+    int ClassifyAabb(const kge::math::Frustum &frustum, const kge::math::Aabb &aabb)
+    {
+        int result = 1;
+        for (const kge::math::Plane &plane : frustum.planes) {
+            // Ближайшая к внутренней стороне вершина (p) и наиболее удаленная (n)
+            float px = plane.a >= 0.0f ? aabb.max[0] : aabb.min[0];
+            float py = plane.b >= 0.0f ? aabb.max[1] : aabb.min[1];
+            float pz = plane.c >= 0.0f ? aabb.max[2] : aabb.min[2];
+            if (plane.a * px + plane.b * py + plane.c * pz + plane.d < 0.0f) {
+                return -1;
+            }
+
+            float nx = plane.a >= 0.0f ? aabb.min[0] : aabb.max[0];
+            float ny = plane.b >= 0.0f ? aabb.min[1] : aabb.max[1];
+            float nz = plane.c >= 0.0f ? aabb.min[2] : aabb.max[2];
+            if (plane.a * nx + plane.b * ny + plane.c * nz + plane.d < 0.0f) {
+                result = 0;
+            }
+        }
+        return result;
+    }
+
+    // Пересечение луча с AABB (метод пластин), возвращает расстояние входа либо бесконечность
+    float IntersectAabb(const kge::math::Aabb &aabb, const float origin[3], const float inverseDirection[3], float maxDistance)
+    {
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (aabb.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t1 = (aabb.max[axis] - origin[axis]) * inverseDirection[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+        }
+        return tMin <= tMax ? tMin : std::numeric_limits<float>::infinity();
+    }
+}
+
+KGEBvh::KGEBvh():
+    m_nodesUsed{0}
+{
+}
+
+/**
+* Построение дерева с нуля
+* @note - узлы выделяются из заранее выделенного массива (2N - 1 узлов максимум), индексы - атомарным счетчиком,
+* поэтому поддеревья могут строиться одновременно. Каждое поддерево переставляет только свой диапазон m_objects
+*/
+void KGEBvh::Build(const std::vector<kge::math::Aabb> &bounds, KGEJobSystem *jobSystem)
+{
+    uint32_t count = static_cast<uint32_t>(bounds.size());
+
+    m_bounds = bounds;
+    m_objects.resize(count);
+    m_objectLeaf.assign(count, 0);
+    m_dirtyLeaves.clear();
+    m_nodes.clear();
+    m_leafDirty.clear();
+    m_nodesUsed = 0;
+
+    if (count == 0) {
+        return;
+    }
+
+    // Центры AABB (по ним выбирается разбиение)
+    std::vector<float> centroids(count * 3);
+    for (uint32_t i = 0; i < count; i++) {
+        m_objects[i] = i;
+        for (int axis = 0; axis < 3; axis++) {
+            centroids[i * 3 + axis] = (bounds[i].min[axis] + bounds[i].max[axis]) * 0.5f;
+        }
+    }
+
+    m_nodes.resize(count * 2 - 1);
+    m_nodesUsed = 1;
+    m_nodes[0].first = 0;
+    m_nodes[0].count = count;
+
+    kge::jobs::Counter counter;
+    BuildNode(0, centroids, jobSystem, &counter);
+    if (jobSystem != nullptr) {
+        jobSystem->Wait(&counter);
+    }
+
+    m_nodes.resize(m_nodesUsed);
+    m_leafDirty.assign(m_nodes.size(), 0);
+}
+
+void KGEBvh::BuildNode(uint32_t nodeIndex,
+                       const std::vector<float> &centroids,
+                       KGEJobSystem *jobSystem,
+                       kge::jobs::Counter *counter)
+{
+    Node &node = m_nodes[nodeIndex];
+    ComputeNodeBounds(node);
+
+    // Границы центров - по ним распределяются корзины
+    kge::math::Aabb centroidBounds = EmptyAabb();
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        const float* c = &centroids[m_objects[i] * 3];
+        for (int axis = 0; axis < 3; axis++) {
+            centroidBounds.min[axis] = std::min(centroidBounds.min[axis], c[axis]);
+            centroidBounds.max[axis] = std::max(centroidBounds.max[axis], c[axis]);
+        }
+    }
+
+    // Поиск лучшего разбиения (ось, граница корзин) по SAH
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+
+    if (node.count > BVH_MAX_LEAF_SIZE / 2) {
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+            if (extent <= 0.0f) {
+                continue;
+            }
+
+            struct Bin { kge::math::Aabb bounds = EmptyAabb(); uint32_t count = 0; } bins[BVH_BIN_COUNT];
+            float scale = BVH_BIN_COUNT / extent;
+
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                uint32_t object = m_objects[i];
+                int bin = std::min(BVH_BIN_COUNT - 1, static_cast<int>((centroids[object * 3 + axis] - centroidBounds.min[axis]) * scale));
+                bins[bin].count++;
+                GrowAabb(bins[bin].bounds, m_bounds[object]);
+            }
+
+            // Проход слева направо и справа налево: площади и кол-ва по обе стороны каждой границы
+            float leftArea[BVH_BIN_COUNT - 1], rightArea[BVH_BIN_COUNT - 1];
+            uint32_t leftCount[BVH_BIN_COUNT - 1], rightCount[BVH_BIN_COUNT - 1];
+            kge::math::Aabb leftBox = EmptyAabb(), rightBox = EmptyAabb();
+            uint32_t leftSum = 0, rightSum = 0;
+            for (int i = 0; i < BVH_BIN_COUNT - 1; i++) {
+                leftSum += bins[i].count;
+                GrowAabb(leftBox, bins[i].bounds);
+                leftCount[i] = leftSum;
+                leftArea[i] = SurfaceArea(leftBox);
+
+                rightSum += bins[BVH_BIN_COUNT - 1 - i].count;
+                GrowAabb(rightBox, bins[BVH_BIN_COUNT - 1 - i].bounds);
+                rightCount[BVH_BIN_COUNT - 2 - i] = rightSum;
+                rightArea[BVH_BIN_COUNT - 2 - i] = SurfaceArea(rightBox);
+            }
+
+            for (int i = 0; i < BVH_BIN_COUNT - 1; i++) {
+                if (leftCount[i] == 0 || rightCount[i] == 0) {
+                    continue;
+                }
+                float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+    }
+
+    // Лист: разбиение не выгоднее листа (стоимость листа - кол-во объектов на площадь узла) либо разбивать нечего
+    float leafCost = node.count * SurfaceArea(node.bounds);
+    bool makeLeaf = bestAxis < 0 ? node.count <= BVH_MAX_LEAF_SIZE
+                                 : node.count <= BVH_MAX_LEAF_SIZE && bestCost >= leafCost;
+    if (makeLeaf) {
+        node.left = 0;
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            m_objectLeaf[m_objects[i]] = nodeIndex;
+        }
+        return;
+    }
+
+    // Центры совпадают, а объектов много - делим пополам по порядку, чтобы не получить огромный лист
+    if (bestAxis < 0) {
+        bestAxis = 0;
+    }
+
+    // Перестановка объектов диапазона: левее границы - в начало
+    uint32_t middle;
+    if (centroidBounds.max[bestAxis] > centroidBounds.min[bestAxis]) {
+        float scale = BVH_BIN_COUNT / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+        auto begin = m_objects.begin() + node.first;
+        auto split = std::partition(begin, begin + node.count, [&](uint32_t object) {
+            int bin = std::min(BVH_BIN_COUNT - 1, static_cast<int>((centroids[object * 3 + bestAxis] - centroidBounds.min[bestAxis]) * scale));
+            return bin <= bestSplit;
+        });
+        middle = static_cast<uint32_t>(split - m_objects.begin());
+    }
+    else {
+        middle = node.first + node.count / 2;
+    }
+
+    uint32_t left = m_nodesUsed.fetch_add(2, std::memory_order_relaxed);
+    m_nodes[left].first = node.first;
+    m_nodes[left].count = middle - node.first;
+    m_nodes[left].parent = nodeIndex;
+    m_nodes[left + 1].first = middle;
+    m_nodes[left + 1].count = node.first + node.count - middle;
+    m_nodes[left + 1].parent = nodeIndex;
+    node.left = left;
+
+    // Крупное левое поддерево - отдельной задачей, правое - в текущем потоке
+    if (jobSystem != nullptr && m_nodes[left].count > BVH_PARALLEL_THRESHOLD) {
+        jobSystem->Run([this, left, &centroids, jobSystem, counter]() {
+            BuildNode(left, centroids, jobSystem, counter);
+        }, counter);
+    }
+    else {
+        BuildNode(left, centroids, jobSystem, counter);
+    }
+    BuildNode(left + 1, centroids, jobSystem, counter);
+}
+
+void KGEBvh::ComputeNodeBounds(Node &node) const
+{
+    node.bounds = EmptyAabb();
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        GrowAabb(node.bounds, m_bounds[m_objects[i]]);
+    }
+}
+
+void KGEBvh::Update(uint32_t object, const kge::math::Aabb &bounds)
+{
+    m_bounds[object] = bounds;
+
+    uint32_t leaf = m_objectLeaf[object];
+    if (!m_leafDirty[leaf]) {
+        m_leafDirty[leaf] = 1;
+        m_dirtyLeaves.push_back(leaf);
+    }
+}
+
+/**
+* Пересчет границ измененных листьев и подъем к корню
+* @note - подъем прекращается, как только границы предка не изменились (выше изменений тоже не будет)
+*/
+void KGEBvh::Refit()
+{
+    for (uint32_t leaf : m_dirtyLeaves) {
+        m_leafDirty[leaf] = 0;
+        ComputeNodeBounds(m_nodes[leaf]);
+
+        uint32_t nodeIndex = m_nodes[leaf].parent;
+        while (nodeIndex != UINT32_MAX) {
+            Node &node = m_nodes[nodeIndex];
+            kge::math::Aabb bounds = m_nodes[node.left].bounds;
+            GrowAabb(bounds, m_nodes[node.left + 1].bounds);
+
+            if (SameAabb(bounds, node.bounds)) {
+                break;
+            }
+
+            node.bounds = bounds;
+            nodeIndex = node.parent;
+        }
+    }
+
+    m_dirtyLeaves.clear();
+}
+
+void KGEBvh::QueryFrustum(const kge::math::Frustum &frustum, std::vector<uint32_t> &objects) const
+{
+    objects.clear();
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.reserve(BVH_STACK_SIZE);
+    stack.push_back(0);
+
+    while (!stack.empty()) {
+        const Node &node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        int classification = ClassifyAabb(frustum, node.bounds);
+        if (classification < 0) {
+            continue;
+        }
+
+        // Узел целиком внутри либо лист - объекты без дальнейших проверок узлов
+        if (classification > 0) {
+            objects.insert(objects.end(), m_objects.begin() + node.first, m_objects.begin() + node.first + node.count);
+        }
+        else if (node.left == 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (ClassifyAabb(frustum, m_bounds[m_objects[i]]) >= 0) {
+                    objects.push_back(m_objects[i]);
+                }
+            }
+        }
+        else {
+            stack.push_back(node.left);
+            stack.push_back(node.left + 1);
+        }
+    }
+}
+
+void KGEBvh::QueryOverlap(const kge::math::Aabb &bounds, std::vector<uint32_t> &objects) const
+{
+    objects.clear();
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.reserve(BVH_STACK_SIZE);
+    stack.push_back(0);
+
+    while (!stack.empty()) {
+        const Node &node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node.bounds, bounds)) {
+            continue;
+        }
+
+        if (node.left == 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (Overlaps(m_bounds[m_objects[i]], bounds)) {
+                    objects.push_back(m_objects[i]);
+                }
+            }
+        }
+        else {
+            stack.push_back(node.left);
+            stack.push_back(node.left + 1);
+        }
+    }
+}
+
+/**
+* Обход от ближнего потомка к дальнему, узлы дальше уже найденного пересечения отбрасываются
+*/
+kge::math::RayHit KGEBvh::Raycast(const float origin[3], const float direction[3], float maxDistance) const
+{
+    kge::math::RayHit hit;
+    if (m_nodes.empty()) {
+        return hit;
+    }
+
+    float inverseDirection[3];
+    for (int axis = 0; axis < 3; axis++) {
+        inverseDirection[axis] = 1.0f / direction[axis];
+    }
+
+    float closest = maxDistance;
+
+    std::vector<uint32_t> stack;
+    stack.reserve(BVH_STACK_SIZE);
+    if (IntersectAabb(m_nodes[0].bounds, origin, inverseDirection, closest) < closest) {
+        stack.push_back(0);
+    }
+
+    while (!stack.empty()) {
+        const Node &node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.left == 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                float distance = IntersectAabb(m_bounds[m_objects[i]], origin, inverseDirection, closest);
+                if (distance < closest) {
+                    closest = distance;
+                    hit.object = m_objects[i];
+                    hit.distance = distance;
+                }
+            }
+            continue;
+        }
+
+        float leftDistance = IntersectAabb(m_nodes[node.left].bounds, origin, inverseDirection, closest);
+        float rightDistance = IntersectAabb(m_nodes[node.left + 1].bounds, origin, inverseDirection, closest);
+
+        // Ближний потомок кладется последним, чтобы быть извлеченным первым
+        uint32_t nearChild = node.left, farChild = node.left + 1;
+        if (rightDistance < leftDistance) {
+            std::swap(nearChild, farChild);
+            std::swap(leftDistance, rightDistance);
+        }
+        if (rightDistance < closest) {
+            stack.push_back(farChild);
+        }
+        if (leftDistance < closest) {
+            stack.push_back(nearChild);
+        }
+    }
+
+    return hit;
+}
+
+uint32_t KGEBvh::objectCount() const
+{
+    return static_cast<uint32_t>(m_bounds.size());
+}
+
+uint32_t KGEBvh::nodeCount() const
+{
+    return static_cast<uint32_t>(m_nodes.size());
+}
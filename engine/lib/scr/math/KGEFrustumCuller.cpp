@@ -0,0 +1,140 @@
+#include "math/KGEFrustumCuller.h"
+
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#define KGE_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+kge::math::Frustum kge::math::ExtractFrustum(const float *viewProjection)
+{
+    // Элемент строки row столбца column (матрица хранится по столбцам)
+    auto at = [viewProjection](int row, int column) {
+        return viewProjection[column * 4 + row];
+    };
+
+    // Плоскость = строка 3 +/- строка i
+    auto combine = [&at](int row, float sign) {
+        kge::math::Plane plane;
+        plane.a = at(3, 0) + sign * at(row, 0);
+        plane.b = at(3, 1) + sign * at(row, 1);
+        plane.c = at(3, 2) + sign * at(row, 2);
+        plane.d = at(3, 3) + sign * at(row, 3);
+
+        // Нормализация, чтобы расстояние до плоскости можно было сравнивать с радиусом
+        float length = std::sqrt(plane.a * plane.a + plane.b * plane.b + plane.c * plane.c);
+        if (length > 0.0f) {
+            plane.a /= length;
+            plane.b /= length;
+            plane.c /= length;
+            plane.d /= length;
+        }
+        return plane;
+    };
+
+    kge::math::Frustum frustum;
+    frustum.planes[0] = combine(0, 1.0f);   // Левая
+    frustum.planes[1] = combine(0, -1.0f);  // Правая
+    frustum.planes[2] = combine(1, 1.0f);   // Нижняя
+    frustum.planes[3] = combine(1, -1.0f);  // Верхняя
+    frustum.planes[4] = combine(2, 1.0f);   // Ближняя
+    frustum.planes[5] = combine(2, -1.0f);  // Дальняя
+    return frustum;
+}
+
+unsigned int KGEFrustumCuller::Add(float x, float y, float z, float radius)
+{
+    m_centerX.push_back(x);
+    m_centerY.push_back(y);
+    m_centerZ.push_back(z);
+    m_radius.push_back(radius);
+    return static_cast<unsigned int>(m_radius.size() - 1);
+}
+
+void KGEFrustumCuller::Set(unsigned int index, float x, float y, float z, float radius)
+{
+    m_centerX[index] = x;
+    m_centerY[index] = y;
+    m_centerZ[index] = z;
+    m_radius[index] = radius;
+}
+
+void KGEFrustumCuller::Clear()
+{
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+}
+
+unsigned int KGEFrustumCuller::count() const
+{
+    return static_cast<unsigned int>(m_radius.size());
+}
+
+/**
+* Сфера видима, если ее центр не дальше радиуса "снаружи" каждой из 6 плоскостей (dot(n, c) + d >= -r)
+* @note - проверка консервативная: сфера у угла пирамиды может быть признана видимой, будучи снаружи
+*/
+void KGEFrustumCuller::Cull(const kge::math::Frustum &frustum, std::vector<uint32_t> &visible) const
+{
+    const std::size_t count = m_radius.size();
+
+    // Запись без проверок емкости: индексы пишутся по указателю, лишнее отрезается в конце
+    visible.resize(count);
+    uint32_t* out = visible.data();
+
+    std::size_t i = 0;
+
+#ifdef KGE_CULL_SSE
+    // Коэффициенты плоскостей размноженные на 4 полосы (подготавливаются один раз на весь проход)
+    __m128 planeA[6], planeB[6], planeC[6], planeD[6];
+    for (int p = 0; p < 6; p++) {
+        planeA[p] = _mm_set1_ps(frustum.planes[p].a);
+        planeB[p] = _mm_set1_ps(frustum.planes[p].b);
+        planeC[p] = _mm_set1_ps(frustum.planes[p].c);
+        planeD[p] = _mm_set1_ps(frustum.planes[p].d);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    // По 4 сферы за итерацию
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(m_centerX.data() + i);
+        __m128 y = _mm_loadu_ps(m_centerY.data() + i);
+        __m128 z = _mm_loadu_ps(m_centerZ.data() + i);
+        __m128 r = _mm_loadu_ps(m_radius.data() + i);
+
+        // Маска "снаружи хотя бы одной плоскости"
+        __m128 outside = zero;
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeA[p], x), _mm_mul_ps(planeB[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeC[p], z), planeD[p]));
+            // distance + r < 0 - сфера полностью по внешнюю сторону плоскости
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, r), zero));
+        }
+
+        // Безветвленная запись: индекс пишется всегда, а указатель сдвигается только для видимых
+        int visibleMask = ~_mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; lane++) {
+            *out = static_cast<uint32_t>(i + lane);
+            out += (visibleMask >> lane) & 1;
+        }
+    }
+#endif
+
+    // Оставшиеся сферы (либо все, если SSE недоступен)
+    for (; i < count; i++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            const kge::math::Plane &plane = frustum.planes[p];
+            float distance = plane.a * m_centerX[i] + plane.b * m_centerY[i] + plane.c * m_centerZ[i] + plane.d;
+            inside = distance + m_radius[i] >= 0.0f;
+        }
+        if (inside) {
+            *out++ = static_cast<uint32_t>(i);
+        }
+    }
+
+    visible.resize(static_cast<std::size_t>(out - visible.data()));
+}
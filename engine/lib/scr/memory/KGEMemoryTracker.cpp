@@ -0,0 +1,178 @@
+#include "memory/KGEMemoryTracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+KGEMemoryTracker::Counter KGEMemoryTracker::s_tags[kge::memory::TagCount];
+KGEMemoryTracker::Counter KGEMemoryTracker::s_deviceHeaps[KGE_MEMORY_DEVICE_HEAPS];
+std::atomic<uint64_t> KGEMemoryTracker::s_deviceHeapSizes[KGE_MEMORY_DEVICE_HEAPS] = {};
+std::atomic<bool> KGEMemoryTracker::s_deviceHeapLocal[KGE_MEMORY_DEVICE_HEAPS] = {};
+
+// Имена подсистем (по значениям kge::memory::Tag)
+static const char* const TAG_NAMES[kge::memory::TagCount] = { "General", "Renderer", "Textures", "Vulkan", "Log", "Profiler" };
+
+namespace
+{
+    /**
+    * Заголовок блока кучи трекера (непосредственно перед блоком)
+    */
+    struct BlockHeader
+    {
+        uint64_t size;          // Размер блока (без заголовка и выравнивания)
+        uint32_t offset;        // Смещение блока от начала выделенной памяти
+        uint8_t tag;
+        uint8_t reserved[3];
+    };
+
+    static_assert(sizeof(BlockHeader) == 16, "Memory: Block header must keep 16-byte alignment");
+
+    BlockHeader* HeaderOf(void* pointer)
+    {
+        return reinterpret_cast<BlockHeader*>(static_cast<unsigned char*>(pointer) - sizeof(BlockHeader));
+    }
+}
+
+void KGEMemoryTracker::Counter::Add(uint64_t size)
+{
+    uint64_t currentValue = current.fetch_add(size, std::memory_order_relaxed) + size;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Максимум обновляется, только если текущее значение его превысило
+    uint64_t peakValue = peak.load(std::memory_order_relaxed);
+    while (currentValue > peakValue && !peak.compare_exchange_weak(peakValue, currentValue, std::memory_order_relaxed)) {
+    }
+}
+
+void KGEMemoryTracker::Counter::Remove(uint64_t size)
+{
+    current.fetch_sub(size, std::memory_order_relaxed);
+    allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+kge::memory::Usage KGEMemoryTracker::Counter::Load() const
+{
+    kge::memory::Usage usage;
+    usage.current = current.load(std::memory_order_relaxed);
+    usage.peak = peak.load(std::memory_order_relaxed);
+    usage.allocations = allocations.load(std::memory_order_relaxed);
+    return usage;
+}
+
+/**
+* Выделение памяти с учетом
+* @note - блок выделяется malloc вместе с заголовком; при выравнивании больше 16 байт выделяется запас под сдвиг блока
+*/
+void* KGEMemoryTracker::Allocate(kge::memory::Tag tag, std::size_t size, std::size_t alignment)
+{
+    alignment = std::max<std::size_t>(alignment, alignof(std::max_align_t));
+    std::size_t padding = alignment > sizeof(BlockHeader) ? alignment - sizeof(BlockHeader) : 0;
+
+    unsigned char* raw = static_cast<unsigned char*>(malloc(size + sizeof(BlockHeader) + padding));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(raw) + sizeof(BlockHeader);
+    address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+
+    void* pointer = reinterpret_cast<void*>(address);
+    BlockHeader* header = HeaderOf(pointer);
+    header->size = size;
+    header->offset = static_cast<uint32_t>(address - reinterpret_cast<uintptr_t>(raw));
+    header->tag = tag;
+
+    s_tags[tag].Add(size);
+    return pointer;
+}
+
+void* KGEMemoryTracker::Reallocate(kge::memory::Tag tag, void* pointer, std::size_t size, std::size_t alignment)
+{
+    if (pointer == nullptr) {
+        return Allocate(tag, size, alignment);
+    }
+
+    if (size == 0) {
+        Free(pointer);
+        return nullptr;
+    }
+
+    // Подсистема блока не меняется
+    BlockHeader* header = HeaderOf(pointer);
+    void* resized = Allocate(static_cast<kge::memory::Tag>(header->tag), size, alignment);
+    if (resized == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(resized, pointer, static_cast<std::size_t>(std::min<uint64_t>(header->size, size)));
+    Free(pointer);
+    return resized;
+}
+
+void KGEMemoryTracker::Free(void* pointer)
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    BlockHeader* header = HeaderOf(pointer);
+    s_tags[header->tag].Remove(header->size);
+    free(static_cast<unsigned char*>(pointer) - header->offset);
+}
+
+void KGEMemoryTracker::Track(kge::memory::Tag tag, std::size_t size)
+{
+    s_tags[tag].Add(size);
+}
+
+void KGEMemoryTracker::Untrack(kge::memory::Tag tag, std::size_t size)
+{
+    s_tags[tag].Remove(size);
+}
+
+void KGEMemoryTracker::SetDeviceHeap(uint32_t heap, uint64_t size, bool deviceLocal)
+{
+    if (heap >= KGE_MEMORY_DEVICE_HEAPS) {
+        return;
+    }
+
+    s_deviceHeapSizes[heap].store(size, std::memory_order_relaxed);
+    s_deviceHeapLocal[heap].store(deviceLocal, std::memory_order_relaxed);
+}
+
+void KGEMemoryTracker::TrackDevice(uint32_t heap, uint64_t size)
+{
+    if (heap < KGE_MEMORY_DEVICE_HEAPS) {
+        s_deviceHeaps[heap].Add(size);
+    }
+}
+
+void KGEMemoryTracker::UntrackDevice(uint32_t heap, uint64_t size)
+{
+    if (heap < KGE_MEMORY_DEVICE_HEAPS) {
+        s_deviceHeaps[heap].Remove(size);
+    }
+}
+
+kge::memory::Usage KGEMemoryTracker::usage(kge::memory::Tag tag)
+{
+    return s_tags[tag].Load();
+}
+
+kge::memory::DeviceHeap KGEMemoryTracker::deviceHeap(uint32_t heap)
+{
+    kge::memory::DeviceHeap result;
+    if (heap >= KGE_MEMORY_DEVICE_HEAPS) {
+        return result;
+    }
+
+    result.size = s_deviceHeapSizes[heap].load(std::memory_order_relaxed);
+    result.deviceLocal = s_deviceHeapLocal[heap].load(std::memory_order_relaxed);
+    result.usage = s_deviceHeaps[heap].Load();
+    return result;
+}
+
+const char* KGEMemoryTracker::TagName(kge::memory::Tag tag)
+{
+    return tag < kge::memory::TagCount ? TAG_NAMES[tag] : "Unknown";
+}
@@ -0,0 +1,526 @@
+#include "mesh/KGEMeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Размер кэша, которым оперирует оценка вершин алгоритма Форсайта
+#define FORSYTH_CACHE_SIZE 32
+
+namespace
+{
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 Position(const float* positions, std::size_t stride, uint32_t vertex)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + vertex * stride);
+        return { p[0], p[1], p[2] };
+    }
+
+    Vec3 Sub(const Vec3 &a, const Vec3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 Cross(const Vec3 &a, const Vec3 &b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    float Dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    /**
+    * Симметричная квадрика ошибки (сумма квадратов расстояний до плоскостей, взвешенная площадями) и суммарный вес
+    */
+    struct Quadric
+    {
+        double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+        double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+        double weight = 0;
+
+        void AddPlane(double a, double b, double c, double d, double w)
+        {
+            a2 += w * a * a; b2 += w * b * b; c2 += w * c * c; d2 += w * d * d;
+            ab += w * a * b; ac += w * a * c; ad += w * a * d;
+            bc += w * b * c; bd += w * b * d; cd += w * c * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &other)
+        {
+            a2 += other.a2; b2 += other.b2; c2 += other.c2; d2 += other.d2;
+            ab += other.ab; ac += other.ac; ad += other.ad;
+            bc += other.bc; bd += other.bd; cd += other.cd;
+            weight += other.weight;
+        }
+
+        // Средний квадрат расстояния от точки до плоскостей
+        double Error(const Vec3 &p) const
+        {
+            if (weight <= 0.0) {
+                return 0.0;
+            }
+            double x = p.x, y = p.y, z = p.z;
+            double error = a2 * x * x + b2 * y * y + c2 * z * z +
+                           2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z) + d2;
+            return std::max(error, 0.0) / weight;
+        }
+    };
+
+    // Оценка позиции вершины в кэше (три вершины последнего треугольника - фиксированная оценка)
+    float CacheScore(int position)
+    {
+        if (position < 0) {
+            return 0.0f;
+        }
+        if (position < 3) {
+            return 0.75f;
+        }
+        return std::pow(1.0f - static_cast<float>(position - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Оценка кол-ва оставшихся треугольников вершины
+    float ValenceScore(uint32_t remaining)
+    {
+        return remaining == 0 ? 0.0f : 2.0f / std::sqrt(static_cast<float>(remaining));
+    }
+}
+
+kge::mesh::VertexCacheStats kge::mesh::AnalyzeVertexCache(const std::vector<uint32_t> &indices,
+                                                          uint32_t vertexCount,
+                                                          uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+
+    // Момент попадания вершины в кэш (FIFO: вершина в кэше, пока после нее было меньше cacheSize промахов)
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+
+    stats.vertexTransforms = misses;
+    std::size_t triangleCount = indices.size() / 3;
+    stats.acmr = triangleCount == 0 ? 0.0f : static_cast<float>(misses) / triangleCount;
+    stats.atvr = vertexCount == 0 ? 0.0f : static_cast<float>(misses) / vertexCount;
+    return stats;
+}
+
+/**
+* Переупорядочивание треугольников под кэш вершин
+* @note - оценки пересчитываются только для вершин кэша (и вытесненных из него) и их треугольников,
+* поэтому каждый шаг стоит O(размер кэша * валентность). Если у вершин кэша не осталось треугольников,
+* берется следующий невыведенный треугольник исходного порядка
+*/
+void kge::mesh::OptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Треугольники каждой вершины (невыведенные хранятся в начале списка вершины)
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices) {
+        remaining[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    }
+
+    std::vector<uint32_t> adjacency(adjacencyOffset[vertexCount]);
+    std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = ValenceScore(remaining[v]);
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    uint32_t cursor = 0;
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (best == UINT32_MAX) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const uint32_t triangle[3] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+
+        // Убрать треугольник из списков его вершин
+        for (uint32_t v : triangle) {
+            uint32_t begin = adjacencyOffset[v];
+            for (uint32_t i = begin; i < begin + remaining[v];) {
+                if (adjacency[i] == best) {
+                    std::swap(adjacency[i], adjacency[begin + remaining[v] - 1]);
+                    remaining[v]--;
+                }
+                else {
+                    i++;
+                }
+            }
+        }
+
+        // Вершины треугольника - в начало кэша, остальные сдвигаются
+        nextCache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache.push_back(v);
+            }
+        }
+
+        for (std::size_t i = 0; i < nextCache.size(); i++) {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScore[v] = CacheScore(cachePosition[v]) + ValenceScore(remaining[v]);
+        }
+
+        // Пересчитать треугольники затронутых вершин и выбрать лучший
+        best = UINT32_MAX;
+        float bestScore = -1.0f;
+        for (uint32_t v : nextCache) {
+            uint32_t begin = adjacencyOffset[v];
+            for (uint32_t i = begin; i < begin + remaining[v]; i++) {
+                uint32_t t = adjacency[i];
+                float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+
+    indices.swap(result);
+}
+
+/**
+* Упорядочивание кластеров треугольников для уменьшения перерисовки
+* @note - ключ кластера - проекция направления от центра сетки к центру кластера на среднюю нормаль кластера
+*/
+void kge::mesh::OptimizeOverdraw(std::vector<uint32_t> &indices,
+                                 const float* positions,
+                                 std::size_t positionStride,
+                                 uint32_t vertexCount)
+{
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Границы кластеров - треугольники, все вершины которых промахиваются мимо кэша
+    std::vector<uint32_t> clusterStart;
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        uint32_t triangleMisses = 0;
+        for (int k = 0; k < 3; k++) {
+            uint32_t index = indices[t * 3 + k];
+            if (insertedAt[index] == 0 || misses - insertedAt[index] >= KGE_VERTEX_CACHE_SIZE) {
+                misses++;
+                insertedAt[index] = misses;
+                triangleMisses++;
+            }
+        }
+        if (t == 0 || triangleMisses == 3) {
+            clusterStart.push_back(t);
+        }
+    }
+    clusterStart.push_back(triangleCount);
+
+    const std::size_t clusterCount = clusterStart.size() - 1;
+    if (clusterCount < 2) {
+        return;
+    }
+
+    // Центры (взвешенные площадями) и средние нормали кластеров
+    std::vector<Vec3> clusterCenter(clusterCount, Vec3{ 0.0f, 0.0f, 0.0f });
+    std::vector<Vec3> clusterNormal(clusterCount, Vec3{ 0.0f, 0.0f, 0.0f });
+    Vec3 meshCenter = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for (std::size_t c = 0; c < clusterCount; c++) {
+        float clusterArea = 0.0f;
+        for (uint32_t t = clusterStart[c]; t < clusterStart[c + 1]; t++) {
+            Vec3 p0 = Position(positions, positionStride, indices[t * 3]);
+            Vec3 p1 = Position(positions, positionStride, indices[t * 3 + 1]);
+            Vec3 p2 = Position(positions, positionStride, indices[t * 3 + 2]);
+
+            Vec3 normal = Cross(Sub(p1, p0), Sub(p2, p0));
+            float area = std::sqrt(Dot(normal, normal));
+
+            clusterNormal[c] = { clusterNormal[c].x + normal.x, clusterNormal[c].y + normal.y, clusterNormal[c].z + normal.z };
+            clusterCenter[c].x += (p0.x + p1.x + p2.x) * area / 3.0f;
+            clusterCenter[c].y += (p0.y + p1.y + p2.y) * area / 3.0f;
+            clusterCenter[c].z += (p0.z + p1.z + p2.z) * area / 3.0f;
+            clusterArea += area;
+        }
+
+        meshCenter = { meshCenter.x + clusterCenter[c].x, meshCenter.y + clusterCenter[c].y, meshCenter.z + clusterCenter[c].z };
+        meshArea += clusterArea;
+
+        if (clusterArea > 0.0f) {
+            clusterCenter[c] = { clusterCenter[c].x / clusterArea, clusterCenter[c].y / clusterArea, clusterCenter[c].z / clusterArea };
+        }
+    }
+
+    if (meshArea > 0.0f) {
+        meshCenter = { meshCenter.x / meshArea, meshCenter.y / meshArea, meshCenter.z / meshArea };
+    }
+
+    std::vector<float> sortKey(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; c++) {
+        float length = std::sqrt(Dot(clusterNormal[c], clusterNormal[c]));
+        sortKey[c] = length > 0.0f ? Dot(Sub(clusterCenter[c], meshCenter), clusterNormal[c]) / length : 0.0f;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; c++) {
+        order[c] = static_cast<uint32_t>(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKey](uint32_t a, uint32_t b) {
+        return sortKey[a] > sortKey[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t c : order) {
+        result.insert(result.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+uint32_t kge::mesh::OptimizeVertexFetchRemap(std::vector<uint32_t> &indices,
+                                             uint32_t vertexCount,
+                                             std::vector<uint32_t> &remap)
+{
+    remap.assign(vertexCount, UINT32_MAX);
+
+    uint32_t next = 0;
+    for (uint32_t &index : indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    return next;
+}
+
+/**
+* Упрощение сетки
+* @note - стягивания выполняются проходами: в каждом проходе ребра сортируются по ошибке и стягиваются жадно,
+* при этом вершины треугольников вокруг стянутой вершины в этом проходе больше не трогаются (проверка переворота
+* треугольников остается точной). Квадрика стянутой вершины прибавляется к квадрике вершины, в которую она стянута
+*/
+float kge::mesh::Simplify(const std::vector<uint32_t> &indices,
+                          const float* positions,
+                          std::size_t positionStride,
+                          uint32_t vertexCount,
+                          std::size_t targetIndexCount,
+                          float maxError,
+                          std::vector<uint32_t> &result)
+{
+    result.clear();
+    result.reserve(indices.size());
+
+    // Квадрики вершин по плоскостям исходных треугольников, вырожденные треугольники отбрасываются
+    std::vector<Quadric> quadrics(vertexCount);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a == b || b == c || a == c) {
+            continue;
+        }
+        result.insert(result.end(), { a, b, c });
+
+        Vec3 p0 = Position(positions, positionStride, a);
+        Vec3 normal = Cross(Sub(Position(positions, positionStride, b), p0), Sub(Position(positions, positionStride, c), p0));
+        double length = std::sqrt(static_cast<double>(Dot(normal, normal)));
+        if (length <= 0.0) {
+            continue;
+        }
+
+        double nx = normal.x / length, ny = normal.y / length, nz = normal.z / length;
+        double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+        for (uint32_t v : { a, b, c }) {
+            quadrics[v].AddPlane(nx, ny, nz, d, length * 0.5);
+        }
+    }
+
+    // Вершины граничных (и неманифолдных) ребер неподвижны
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(result.size());
+        for (std::size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                edgeUse[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+            }
+        }
+        for (const auto &edge : edgeUse) {
+            if (edge.second != 2) {
+                locked[edge.first >> 32] = 1;
+                locked[edge.first & 0xFFFFFFFFu] = 1;
+            }
+        }
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    const double maxErrorSquared = static_cast<double>(maxError) * maxError;
+    double resultError = 0.0;
+
+    std::vector<uint32_t> adjacencyOffset, adjacency, fill;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTarget(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+
+    while (result.size() > targetIndexCount) {
+        const uint32_t triangleCount = static_cast<uint32_t>(result.size() / 3);
+
+        // Треугольники каждой вершины
+        adjacencyOffset.assign(vertexCount + 1, 0);
+        for (uint32_t index : result) {
+            adjacencyOffset[index + 1]++;
+        }
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        }
+        adjacency.resize(result.size());
+        fill.assign(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[result[t * 3 + k]]++] = t;
+            }
+        }
+
+        // Кандидаты: оба направления каждого ребра, ошибка - квадрика обеих вершин в точке назначения
+        collapses.clear();
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = result[t * 3 + k], b = result[t * 3 + (k + 1) % 3];
+                for (int direction = 0; direction < 2; direction++) {
+                    uint32_t from = direction == 0 ? a : b;
+                    uint32_t to = direction == 0 ? b : a;
+                    if (locked[from]) {
+                        continue;
+                    }
+                    Quadric combined = quadrics[from];
+                    combined.Add(quadrics[to]);
+                    double error = combined.Error(Position(positions, positionStride, to));
+                    if (error <= maxErrorSquared) {
+                        collapses.push_back({ from, to, error });
+                    }
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) {
+            return x.error < y.error;
+        });
+
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            collapseTarget[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        std::size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+        std::size_t removed = 0;
+        bool anyCollapse = false;
+
+        // Стягивания с ошибкой заметно выше нужного кол-ва самых дешевых откладываются до следующего прохода
+        // (дешевые кандидаты могли быть заблокированы соседними стягиваниями этого прохода)
+        double passLimit = collapses.empty() ? 0.0 : collapses[std::min(collapses.size() - 1, trianglesToRemove)].error * 1.5;
+
+        for (const Collapse &collapse : collapses) {
+            if (removed >= trianglesToRemove || collapse.error > passLimit) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Треугольники вокруг вершины не должны перевернуться после переноса вершины
+            Vec3 target = Position(positions, positionStride, collapse.to);
+            bool flips = false;
+            std::size_t collapsedTriangles = 0;
+            for (uint32_t i = adjacencyOffset[collapse.from]; i < adjacencyOffset[collapse.from + 1] && !flips; i++) {
+                uint32_t t = adjacency[i];
+                uint32_t tri[3] = { result[t * 3], result[t * 3 + 1], result[t * 3 + 2] };
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    collapsedTriangles++;
+                    continue;
+                }
+
+                Vec3 p[3], moved[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = Position(positions, positionStride, tri[k]);
+                    moved[k] = tri[k] == collapse.from ? target : p[k];
+                }
+                Vec3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+                Vec3 after = Cross(Sub(moved[1], moved[0]), Sub(moved[2], moved[0]));
+                flips = Dot(before, after) <= 0.0f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            collapseTarget[collapse.from] = collapse.to;
+            for (uint32_t i = adjacencyOffset[collapse.from]; i < adjacencyOffset[collapse.from + 1]; i++) {
+                uint32_t t = adjacency[i];
+                touched[result[t * 3]] = touched[result[t * 3 + 1]] = touched[result[t * 3 + 2]] = 1;
+            }
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+
+            resultError = std::max(resultError, collapse.error);
+            removed += collapsedTriangles;
+            anyCollapse = true;
+        }
+
+        if (!anyCollapse) {
+            break;
+        }
+
+        // Переписать индексы, треугольники стянутых ребер вырождаются и отбрасываются
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = collapseTarget[result[i]], b = collapseTarget[result[i + 1]], c = collapseTarget[result[i + 2]];
+            if (a != b && b != c && a != c) {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    return static_cast<float>(std::sqrt(resultError));
+}
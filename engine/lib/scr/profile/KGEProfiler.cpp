@@ -0,0 +1,185 @@
+#include "profile/KGEProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+std::atomic<bool> KGEProfiler::s_enabled{false};
+
+// Буфер текущего потока (регистрируется при первой зоне потока)
+static thread_local kge::profile::ThreadBuffer* t_threadBuffer = nullptr;
+
+// Имя текущего потока (применяется при регистрации буфера - имя можно задать до включения профилировщика)
+static thread_local std::string t_threadName;
+
+// Минимальный интервал калибровки счетчика тактов относительно steady_clock
+static const std::chrono::milliseconds CALIBRATION_INTERVAL{ 10 };
+
+KGEProfiler& KGEProfiler::Instance()
+{
+    static KGEProfiler profiler;
+    return profiler;
+}
+
+KGEProfiler::KGEProfiler():
+    m_baseTicks{Timestamp()},
+    m_baseTime{std::chrono::steady_clock::now()}
+{
+}
+
+void KGEProfiler::Enable(bool enable)
+{
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+/**
+* Имя текущего потока
+* @note - буфер потока не создается (память выделяется только потокам, записавшим хотя бы одну зону)
+*/
+void KGEProfiler::SetThreadName(const std::string &name)
+{
+    t_threadName = name;
+
+    if (t_threadBuffer != nullptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        t_threadBuffer->name = name;
+    }
+}
+
+/**
+* Буфер текущего потока
+* @note - мьютекс захватывается один раз за время жизни потока (регистрация), далее - обращение к thread_local
+*/
+kge::profile::ThreadBuffer* KGEProfiler::CurrentThread()
+{
+    if (t_threadBuffer == nullptr) {
+        std::unique_ptr<kge::profile::ThreadBuffer> buffer = std::make_unique<kge::profile::ThreadBuffer>();
+        buffer->events.resize(KGE_PROFILE_THREAD_EVENTS);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer->thread = static_cast<uint32_t>(m_threads.size());
+        buffer->name = t_threadName.empty() ? "Thread " + std::to_string(buffer->thread) : t_threadName;
+        t_threadBuffer = buffer.get();
+        m_threads.push_back(std::move(buffer));
+    }
+
+    return t_threadBuffer;
+}
+
+void KGEProfiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+    kge::profile::ThreadBuffer* buffer = CurrentThread();
+
+    uint64_t written = buffer->written.load(std::memory_order_relaxed);
+    kge::profile::Event &event = buffer->events[written & (KGE_PROFILE_THREAD_EVENTS - 1)];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+
+    buffer->written.store(written + 1, std::memory_order_release);
+}
+
+/**
+* Экранирование строки JSON
+*/
+static void AppendJsonString(std::string &out, const char* text)
+{
+    out += '"';
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+            out += *c;
+        }
+        else if (static_cast<unsigned char>(*c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(*c));
+            out += escaped;
+        }
+        else {
+            out += *c;
+        }
+    }
+    out += '"';
+}
+
+/**
+* Экспорт трассы
+* @param const std::string &path - путь к файлу трассы
+*
+* @note - зоны пишутся в формате "полных событий" (ph = "X": начало и длительность в микросекундах), каждый поток -
+* отдельная линия (tid). Буфер потока копируется без блокировки: после копирования счетчик записей читается снова,
+* и зоны, которые поток-владелец мог перезаписать во время копирования, отбрасываются
+*/
+void KGEProfiler::ExportChromeTrace(const std::string &path)
+{
+    // Калибровка счетчика тактов по steady_clock (интервал - от создания профилировщика)
+    while (std::chrono::steady_clock::now() - m_baseTime < CALIBRATION_INTERVAL) {
+        std::this_thread::sleep_for(CALIBRATION_INTERVAL);
+    }
+    uint64_t nowTicks = Timestamp();
+    double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_baseTime).count();
+    double ticksPerUs = static_cast<double>(nowTicks - m_baseTicks) / elapsedUs;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char number[96];
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<kge::profile::Event> events;
+    for (const std::unique_ptr<kge::profile::ThreadBuffer> &buffer : m_threads) {
+        // Имя линии потока
+        json += first ? "" : ",";
+        first = false;
+        snprintf(number, sizeof(number), "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", buffer->thread);
+        json += number;
+        AppendJsonString(json, buffer->name.c_str());
+        json += "}}";
+
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = written > KGE_PROFILE_THREAD_EVENTS ? written - KGE_PROFILE_THREAD_EVENTS : 0;
+
+        events.clear();
+        for (uint64_t i = begin; i < written; i++) {
+            events.push_back(buffer->events[i & (KGE_PROFILE_THREAD_EVENTS - 1)]);
+        }
+
+        // Зоны, перезаписанные во время копирования
+        uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+        uint64_t overwritten = writtenAfter > begin + KGE_PROFILE_THREAD_EVENTS ? writtenAfter - KGE_PROFILE_THREAD_EVENTS - begin : 0;
+
+        for (std::size_t i = static_cast<std::size_t>(std::min<uint64_t>(overwritten, events.size())); i < events.size(); i++) {
+            const kge::profile::Event &event = events[i];
+            if (event.start < m_baseTicks || event.end < event.start) {
+                continue;
+            }
+
+            json += ",{\"ph\":\"X\",\"pid\":1,";
+            snprintf(number, sizeof(number), "\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                     buffer->thread,
+                     static_cast<double>(event.start - m_baseTicks) / ticksPerUs,
+                     static_cast<double>(event.end - event.start) / ticksPerUs);
+            json += number;
+            AppendJsonString(json, event.name);
+            json += '}';
+        }
+    }
+
+    json += "]}\n";
+
+    std::ofstream file(path, std::ios_base::out | std::ios_base::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Profiler: Can't open trace file " + path);
+    }
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+}
+
+void KGEProfiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::unique_ptr<kge::profile::ThreadBuffer> &buffer : m_threads) {
+        buffer->written.store(0, std::memory_order_relaxed);
+    }
+}
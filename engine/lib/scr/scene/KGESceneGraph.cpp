@@ -0,0 +1,307 @@
+#include "scene/KGESceneGraph.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // result = a * b (все матрицы по столбцам)
+    void Multiply(const kge::scene::Matrix4 &a, const kge::scene::Matrix4 &b, kge::scene::Matrix4 &result)
+    {
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                result.m[column * 4 + row] = a.m[row] * b.m[column * 4] +
+                                             a.m[4 + row] * b.m[column * 4 + 1] +
+                                             a.m[8 + row] * b.m[column * 4 + 2] +
+                                             a.m[12 + row] * b.m[column * 4 + 3];
+            }
+        }
+    }
+}
+
+/**
+* Создание узла
+* @note - узел занимает свободную позицию, если она позже позиции родителя, иначе добавляется в конец - в обоих случаях
+* родитель гарантированно раньше него. Если при добавлении в конец нарушился порядок по глубине (узел мельче последнего),
+* массивы будут пересортированы в ближайшем Update
+*/
+kge::scene::NodeId KGESceneGraph::CreateNode(kge::scene::NodeId parent)
+{
+    uint32_t parentSlot = parent == kge::scene::INVALID_NODE ? UINT32_MAX : m_nodeSlot[parent];
+    uint32_t depth = parentSlot == UINT32_MAX ? 0 : m_depth[parentSlot] + 1;
+
+    kge::scene::NodeId node;
+    if (!m_freeNodes.empty()) {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else {
+        node = static_cast<kge::scene::NodeId>(m_nodeSlot.size());
+        m_nodeSlot.push_back(UINT32_MAX);
+    }
+
+    uint32_t slot;
+    if (!m_freeSlots.empty() && (parentSlot == UINT32_MAX || m_freeSlots.back() > parentSlot)) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+
+        m_parentSlot[slot] = parentSlot;
+        m_depth[slot] = depth;
+        m_local[slot] = kge::scene::Matrix4();
+        m_dirty[slot] = 1;
+        m_changed[slot] = 0;
+        m_childCount[slot] = 0;
+        m_slotNode[slot] = node;
+    }
+    else {
+        slot = static_cast<uint32_t>(m_slotNode.size());
+
+        if (!m_depth.empty() && depth < m_depth.back()) {
+            m_orderDirty = true;
+        }
+
+        m_parentSlot.push_back(parentSlot);
+        m_depth.push_back(depth);
+        m_local.emplace_back();
+        m_world.emplace_back();
+        m_dirty.push_back(1);
+        m_changed.push_back(0);
+        m_childCount.push_back(0);
+        m_slotNode.push_back(node);
+    }
+
+    m_nodeSlot[node] = slot;
+    if (parentSlot != UINT32_MAX) {
+        m_childCount[parentSlot]++;
+    }
+
+    m_anyDirty = true;
+    return node;
+}
+
+/**
+* Удаление узла
+* @note - позиция освобождается без сдвига остальных узлов. Потомки ищутся проходом по всем узлам,
+* но только если они есть (у листьев удаление стоит O(1))
+*/
+void KGESceneGraph::DestroyNode(kge::scene::NodeId node)
+{
+    uint32_t slot = m_nodeSlot[node];
+
+    // Потомки становятся корневыми (корневой узел может стоять на любой позиции, порядок не нарушается)
+    if (m_childCount[slot] > 0) {
+        for (uint32_t child = 0; child < m_slotNode.size(); child++) {
+            if (m_parentSlot[child] == slot) {
+                m_parentSlot[child] = UINT32_MAX;
+                m_dirty[child] = 1;
+            }
+        }
+        m_anyDirty = true;
+    }
+
+    if (m_parentSlot[slot] != UINT32_MAX) {
+        m_childCount[m_parentSlot[slot]]--;
+    }
+
+    // Свободная позиция пропускается проходом Update (не помечена и без родителя)
+    m_parentSlot[slot] = UINT32_MAX;
+    m_dirty[slot] = 0;
+    m_changed[slot] = 0;
+    m_childCount[slot] = 0;
+    m_slotNode[slot] = kge::scene::INVALID_NODE;
+    m_nodeSlot[node] = UINT32_MAX;
+
+    m_freeSlots.push_back(slot);
+    m_freeNodes.push_back(node);
+
+    // Слишком много дыр - уплотнить массивы (проход Update не должен расти от удаленных узлов)
+    if (m_freeSlots.size() * 2 > m_slotNode.size()) {
+        m_orderDirty = true;
+    }
+}
+
+void KGESceneGraph::SetParent(kge::scene::NodeId node, kge::scene::NodeId parent)
+{
+    uint32_t slot = m_nodeSlot[node];
+    uint32_t parentSlot = parent == kge::scene::INVALID_NODE ? UINT32_MAX : m_nodeSlot[parent];
+
+    // Новый родитель не должен быть потомком узла (иначе получится цикл)
+    for (uint32_t ancestor = parentSlot; ancestor != UINT32_MAX; ancestor = m_parentSlot[ancestor]) {
+        if (ancestor == slot) {
+            throw std::runtime_error("SceneGraph: Node can't be attached to itself or to its descendant");
+        }
+    }
+
+    if (m_parentSlot[slot] != UINT32_MAX) {
+        m_childCount[m_parentSlot[slot]]--;
+    }
+    if (parentSlot != UINT32_MAX) {
+        m_childCount[parentSlot]++;
+    }
+
+    m_parentSlot[slot] = parentSlot;
+    m_dirty[slot] = 1;
+    m_anyDirty = true;
+
+    // Глубина поддерева изменилась, а родитель может оказаться позже узла
+    m_orderDirty = true;
+}
+
+void KGESceneGraph::SetLocalTransform(kge::scene::NodeId node, const float *local)
+{
+    uint32_t slot = m_nodeSlot[node];
+    memcpy(m_local[slot].m, local, sizeof(kge::scene::Matrix4::m));
+    m_dirty[slot] = 1;
+    m_anyDirty = true;
+}
+
+/**
+* Пересчет мировых матриц
+* @note - потомки всегда позже родителей, поэтому к моменту обработки узла пометка "изменен" его родителя
+* в этом проходе уже известна. Матрицы перемножаются только для помеченных поддеревьев, для остальных узлов
+* проход лишь читает пару байт
+*/
+void KGESceneGraph::Update()
+{
+    if (m_orderDirty) {
+        SortByDepth();
+    }
+
+    // Ничего не менялось - достаточно снять пометки прошлого прохода
+    if (!m_anyDirty) {
+        if (m_anyChanged) {
+            std::fill(m_changed.begin(), m_changed.end(), 0);
+            m_anyChanged = false;
+        }
+        return;
+    }
+
+    const std::size_t count = m_slotNode.size();
+    for (std::size_t slot = 0; slot < count; slot++) {
+        uint32_t parentSlot = m_parentSlot[slot];
+        uint8_t changed = m_dirty[slot] | (parentSlot != UINT32_MAX ? m_changed[parentSlot] : 0);
+
+        m_changed[slot] = changed;
+        m_dirty[slot] = 0;
+
+        if (changed) {
+            if (parentSlot == UINT32_MAX) {
+                m_world[slot] = m_local[slot];
+            }
+            else {
+                Multiply(m_world[parentSlot], m_local[slot], m_world[slot]);
+            }
+        }
+    }
+
+    m_anyDirty = false;
+    m_anyChanged = true;
+}
+
+const kge::scene::Matrix4 &KGESceneGraph::worldTransform(kge::scene::NodeId node) const
+{
+    return m_world[m_nodeSlot[node]];
+}
+
+bool KGESceneGraph::changed(kge::scene::NodeId node) const
+{
+    return m_changed[m_nodeSlot[node]] != 0;
+}
+
+kge::scene::NodeId KGESceneGraph::parent(kge::scene::NodeId node) const
+{
+    uint32_t parentSlot = m_parentSlot[m_nodeSlot[node]];
+    return parentSlot == UINT32_MAX ? kge::scene::INVALID_NODE : m_slotNode[parentSlot];
+}
+
+uint32_t KGESceneGraph::nodeCount() const
+{
+    return static_cast<uint32_t>(m_slotNode.size() - m_freeSlots.size());
+}
+
+/**
+* Восстановление порядка по глубине
+* @note - глубины пересчитываются подъемом к уже известному предку (каждый узел считается один раз),
+* затем узлы раскладываются сортировкой подсчетом (устойчивой - порядок внутри уровня сохраняется).
+* Свободные позиции при этом отбрасываются
+*/
+void KGESceneGraph::SortByDepth()
+{
+    const uint32_t count = static_cast<uint32_t>(m_slotNode.size());
+    const uint32_t liveCount = count - static_cast<uint32_t>(m_freeSlots.size());
+
+    // Глубины (родитель может быть позже узла, поэтому не одним проходом)
+    std::vector<uint32_t> depth(count, UINT32_MAX);
+    std::vector<uint32_t> path;
+    uint32_t maxDepth = 0;
+    for (uint32_t slot = 0; slot < count; slot++) {
+        if (m_slotNode[slot] == kge::scene::INVALID_NODE) {
+            continue;
+        }
+
+        uint32_t current = slot;
+        while (current != UINT32_MAX && depth[current] == UINT32_MAX) {
+            path.push_back(current);
+            current = m_parentSlot[current];
+        }
+
+        uint32_t base = current == UINT32_MAX ? 0 : depth[current] + 1;
+        while (!path.empty()) {
+            depth[path.back()] = base++;
+            path.pop_back();
+        }
+        maxDepth = std::max(maxDepth, depth[slot]);
+    }
+
+    // Начало каждого уровня в новом порядке
+    std::vector<uint32_t> levelStart(maxDepth + 2, 0);
+    for (uint32_t slot = 0; slot < count; slot++) {
+        if (depth[slot] != UINT32_MAX) {
+            levelStart[depth[slot] + 1]++;
+        }
+    }
+    for (uint32_t level = 1; level < levelStart.size(); level++) {
+        levelStart[level] += levelStart[level - 1];
+    }
+
+    std::vector<uint32_t> newSlot(count, UINT32_MAX);
+    for (uint32_t slot = 0; slot < count; slot++) {
+        if (depth[slot] != UINT32_MAX) {
+            newSlot[slot] = levelStart[depth[slot]]++;
+        }
+    }
+
+    // Перестановка данных (у живого узла родитель всегда жив - потомки удаленных узлов становятся корневыми)
+    std::vector<uint32_t> parentSlot(liveCount), sortedDepth(liveCount), childCount(liveCount);
+    std::vector<kge::scene::Matrix4> local(liveCount), world(liveCount);
+    std::vector<uint8_t> dirty(liveCount), changed(liveCount);
+    std::vector<kge::scene::NodeId> slotNode(liveCount);
+    for (uint32_t slot = 0; slot < count; slot++) {
+        uint32_t target = newSlot[slot];
+        if (target == UINT32_MAX) {
+            continue;
+        }
+        parentSlot[target] = m_parentSlot[slot] == UINT32_MAX ? UINT32_MAX : newSlot[m_parentSlot[slot]];
+        sortedDepth[target] = depth[slot];
+        childCount[target] = m_childCount[slot];
+        local[target] = m_local[slot];
+        world[target] = m_world[slot];
+        dirty[target] = m_dirty[slot];
+        changed[target] = m_changed[slot];
+        slotNode[target] = m_slotNode[slot];
+        m_nodeSlot[m_slotNode[slot]] = target;
+    }
+
+    m_parentSlot.swap(parentSlot);
+    m_depth.swap(sortedDepth);
+    m_local.swap(local);
+    m_world.swap(world);
+    m_dirty.swap(dirty);
+    m_changed.swap(changed);
+    m_childCount.swap(childCount);
+    m_slotNode.swap(slotNode);
+    m_freeSlots.clear();
+
+    m_orderDirty = false;
+}
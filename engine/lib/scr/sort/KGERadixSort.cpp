@@ -0,0 +1,50 @@
+#include "sort/KGERadixSort.h"
+
+void kge::sort::RadixSort(std::vector<uint64_t> &keys,
+                          std::vector<uint32_t> &values,
+                          std::vector<uint64_t> &keysScratch,
+                          std::vector<uint32_t> &valuesScratch)
+{
+    const std::size_t count = keys.size();
+    if (count < 2) {
+        return;
+    }
+
+    keysScratch.resize(count);
+    valuesScratch.resize(count);
+
+    // Гистограммы всех 8 байт за один проход по ключам
+    uint32_t histograms[8][256] = {};
+    for (std::size_t i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (int byte = 0; byte < 8; byte++) {
+            histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    for (int byte = 0; byte < 8; byte++) {
+        uint32_t* histogram = histograms[byte];
+
+        // Все ключи имеют одинаковый байт - проход ничего не меняет
+        if (histogram[(keys[0] >> (byte * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        // Начала корзин
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            uint32_t bucketSize = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketSize;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            uint32_t target = histogram[(keys[i] >> (byte * 8)) & 0xFF]++;
+            keysScratch[target] = keys[i];
+            valuesScratch[target] = values[i];
+        }
+
+        keys.swap(keysScratch);
+        values.swap(valuesScratch);
+    }
+}
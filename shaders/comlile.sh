@@ -1,4 +1,10 @@
 #!/bin/bash
-/home/vxuser/vulkansdk-linux-x86_64-1.1.126.0/1.1.126.0/x86_64/bin/glslc shader.vert -o vert.spv
-/home/vxuser/vulkansdk-linux-x86_64-1.1.126.0/1.1.126.0/x86_64/bin/glslc shader.frag -o frag.spv
+# glslc из PATH, либо из Vulkan SDK (переменная VULKAN_SDK)
+GLSLC=$(command -v glslc || echo "${VULKAN_SDK}/bin/glslc")
+cd "$(dirname "$0")" || exit 1
 
+"$GLSLC" shader.vert -o vert.spv
+"$GLSLC" shader_push.vert -o vert_push.spv
+"$GLSLC" shader_instanced.vert -o vert_instanced.spv
+"$GLSLC" shader.frag -o frag.spv
+"$GLSLC" cull.comp -o cull_comp.spv
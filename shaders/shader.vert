@@ -11,6 +11,11 @@ layout(set = 0, binding = 1) uniform UniformBufferObjectModel {
     mat4 model;
 } uboModel;
 
+// Распаковка позиций геометрии: xyz - центр, w - масштаб (см. kge::vkutility::PositionDequantization)
+layout(push_constant) uniform PushConstantsMesh {
+    layout(offset = 64) vec4 positionDequantization;
+} pushMesh;
+
 
 layout(location = 0) in vec3 inputPosition;
 layout(location = 1) in vec3 inputColor;
@@ -24,7 +29,8 @@ out gl_PerVertex {
 };
 
 void main() {
-	gl_Position = uboWorld.proj * uboWorld.view * uboWorld.world * uboModel.model * vec4(inputPosition, 1.0);
+	vec3 position = inputPosition * pushMesh.positionDequantization.w + pushMesh.positionDequantization.xyz;
+	gl_Position = uboWorld.proj * uboWorld.view * uboWorld.world * uboModel.model * vec4(position, 1.0);
 	fragmentColor = inputColor;
 	fragmentTexCoord = inputTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform UniformBufferObjectWorld {
+    mat4 world;
+    mat4 view;
+    mat4 proj;
+} uboWorld;
+
+// Распаковка позиций геометрии: xyz - центр, w - масштаб (см. kge::vkutility::PositionDequantization)
+layout(push_constant) uniform PushConstantsMesh {
+    layout(offset = 64) vec4 positionDequantization;
+} pushMesh;
+
+
+layout(location = 0) in vec3 inputPosition;
+layout(location = 1) in vec3 inputColor;
+layout(location = 2) in vec2 inputTexCoord;
+
+// Матрица модели экземпляра (буфер экземпляров, занимает location 4-7)
+layout(location = 4) in mat4 instanceModel;
+
+layout(location = 0) out vec3 fragmentColor;
+layout(location = 1) out vec2 fragmentTexCoord;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+void main() {
+	vec3 position = inputPosition * pushMesh.positionDequantization.w + pushMesh.positionDequantization.xyz;
+	gl_Position = uboWorld.proj * uboWorld.view * uboWorld.world * instanceModel * vec4(position, 1.0);
+	fragmentColor = inputColor;
+	fragmentTexCoord = inputTexCoord;
+}
\ No newline at end of file
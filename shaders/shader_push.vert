@@ -0,0 +1,33 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform UniformBufferObjectWorld {
+    mat4 world;
+    mat4 view;
+    mat4 proj;
+} uboWorld;
+
+// Матрица модели и распаковка позиций геометрии: xyz - центр, w - масштаб (см. kge::vkutility::PositionDequantization)
+layout(push_constant) uniform PushConstantsModel {
+    mat4 model;
+    vec4 positionDequantization;
+} pushModel;
+
+
+layout(location = 0) in vec3 inputPosition;
+layout(location = 1) in vec3 inputColor;
+layout(location = 2) in vec2 inputTexCoord;
+
+layout(location = 0) out vec3 fragmentColor;
+layout(location = 1) out vec2 fragmentTexCoord;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+void main() {
+	vec3 position = inputPosition * pushModel.positionDequantization.w + pushModel.positionDequantization.xyz;
+	gl_Position = uboWorld.proj * uboWorld.view * uboWorld.world * pushModel.model * vec4(position, 1.0);
+	fragmentColor = inputColor;
+	fragmentTexCoord = inputTexCoord;
+}
\ No newline at end of file